@@ -0,0 +1,224 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Compares the polling backends with many keep-alive connections open.
+
+   A single client thread opens the given number of connections and, in
+   rounds, sends one request on every connection, then waits until each of
+   them has been answered. The server answers with an empty response. The
+   request rate is reported for the backend asked for.
+
+   Usage: run_connections [epoll|io_uring] [connections] [rounds] [threads]
+*/
+
+#include <pistache/endpoint.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Pistache;
+
+class EmptyHandler : public Http::Handler
+{
+public:
+    HTTP_PROTOTYPE(EmptyHandler)
+
+    void onRequest(const Http::Request& /*request*/, Http::ResponseWriter response) override
+    {
+        response.send(Http::Code::Ok);
+    }
+};
+
+namespace
+{
+    int connectTo(Port port)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        sockaddr_in addr     = {};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+
+    // Responses have no body, so each one ends with an empty line
+    struct Connection
+    {
+        int fd         = -1;
+        size_t matched = 0;
+
+        // Returns whether a whole response came in
+        bool consume(const char* data, ssize_t size)
+        {
+            static const char Terminator[] = "\r\n\r\n";
+
+            bool done = false;
+            for (ssize_t i = 0; i < size; ++i)
+            {
+                matched = (data[i] == Terminator[matched]) ? matched + 1
+                                                           : (data[i] == '\r' ? 1 : 0);
+                if (matched == 4)
+                {
+                    matched = 0;
+                    done    = true;
+                }
+            }
+            return done;
+        }
+    };
+
+    void raiseFdLimit(size_t connections)
+    {
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) != 0)
+            return;
+
+        // Both ends of every connection are in this process
+        const rlim_t wanted = static_cast<rlim_t>(connections * 2 + 256);
+        if (limit.rlim_cur < wanted)
+        {
+            limit.rlim_cur = std::min(wanted, limit.rlim_max);
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string backendName = argc > 1 ? argv[1] : "epoll";
+    const size_t connections      = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    const size_t rounds           = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100;
+    const int threads             = argc > 4 ? std::atoi(argv[4]) : 1;
+
+    const bool validBackend = backendName == "epoll" || backendName == "io_uring";
+    if (!validBackend || connections == 0 || rounds == 0 || threads <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [epoll|io_uring] [connections] [rounds] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    raiseFdLimit(connections);
+
+    const auto backend = backendName == "io_uring" ? Polling::Backend::IoUring
+                                                   : Polling::Backend::Epoll;
+
+    Http::Endpoint endpoint(Address(IP::loopback(), Port(0)));
+    auto opts = Http::Endpoint::options()
+                    .threads(threads)
+                    .flags(Tcp::Options::NoDelay)
+                    .backlog(static_cast<int>(std::min<size_t>(connections, 65535)))
+                    .pollingBackend(backend);
+
+    endpoint.init(opts);
+    endpoint.setHandler(Http::make_handler<EmptyHandler>());
+    endpoint.serveThreaded();
+
+    int epfd = ::epoll_create1(0);
+    std::vector<Connection> conns(connections);
+    for (size_t i = 0; i < connections; ++i)
+    {
+        conns[i].fd = connectTo(endpoint.getPort());
+        if (conns[i].fd < 0)
+        {
+            std::perror("connect");
+            return 1;
+        }
+
+        epoll_event ev = {};
+        ev.events      = EPOLLIN;
+        ev.data.u64    = i;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev);
+    }
+
+    const std::string request = "GET / HTTP/1.1\r\n"
+                                "Host: localhost\r\n"
+                                "Connection: keep-alive\r\n\r\n";
+
+    auto runRound = [&]() {
+        for (auto& conn : conns)
+        {
+            if (::send(conn.fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size()))
+                return false;
+        }
+
+        size_t pending = connections;
+        epoll_event events[256];
+        char buffer[4096];
+        while (pending > 0)
+        {
+            int ready = ::epoll_wait(epfd, events, 256, 10000);
+            if (ready <= 0)
+                return false;
+
+            for (int i = 0; i < ready; ++i)
+            {
+                auto& conn = conns[events[i].data.u64];
+                auto n     = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+                if (n <= 0)
+                    return false;
+                if (conn.consume(buffer, n))
+                    --pending;
+            }
+        }
+        return true;
+    };
+
+    // Warm up, so that every connection has been accepted and set up
+    if (!runRound())
+    {
+        std::fprintf(stderr, "warm-up round failed\n");
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+    {
+        if (!runRound())
+        {
+            std::fprintf(stderr, "round %zu failed\n", i);
+            return 1;
+        }
+    }
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    for (auto& conn : conns)
+        ::close(conn.fd);
+    ::close(epfd);
+    endpoint.shutdown();
+
+    const size_t sent = connections * rounds;
+    std::printf("backend:              %s\n", backendName.c_str());
+    std::printf("connections:          %zu\n", connections);
+    std::printf("server threads:       %d\n", threads);
+    std::printf("requests:             %zu\n", sent);
+    std::printf("requests/s:           %.0f\n", static_cast<double>(sent) / elapsed.count());
+
+    return 0;
+}
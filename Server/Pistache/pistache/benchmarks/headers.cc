@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Measures the cost of the headers of a response.
+
+   The headers an API server typically answers with are added to a
+   collection, which is then written out to a stream buffer the way a
+   response is put on the wire. The time taken per response to build the
+   collection, and to write it, is reported along with the bytes written.
+
+   Usage: run_headers [iterations]
+*/
+
+#include <pistache/http.h>
+#include <pistache/http_headers.h>
+#include <pistache/mime.h>
+#include <pistache/stream.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+
+using namespace Pistache;
+using namespace Pistache::Http;
+
+namespace
+{
+    Header::Collection makeHeaders(const FullDate& date)
+    {
+        Header::Collection headers;
+        headers.add<Header::Server>("pistache/0.4")
+            .add<Header::Date>(date)
+            .add<Header::ContentType>(MIME(Application, Json))
+            .add<Header::ContentLength>(uint64_t(1234))
+            .add<Header::Connection>(ConnectionControl::KeepAlive)
+            .add<Header::CacheControl>(CacheDirective(CacheDirective::MaxAge, std::chrono::seconds(3600)))
+            .add<Header::ETag>("\"5d8c72a5edda8d6a\"")
+            .add<Header::LastModified>(date)
+            .add<Header::AccessControlAllowOrigin>("*");
+        return headers;
+    }
+
+    // As the headers of a response are written
+    bool writeHeaders(const Header::Collection& headers, std::streambuf& buf)
+    {
+        std::ostream os(&buf);
+        for (const auto& header : headers.list())
+        {
+            os << header->name() << ": ";
+            header->write(os);
+            os << "\r\n";
+        }
+        return static_cast<bool>(os);
+    }
+
+    double nsSince(std::chrono::steady_clock::time_point start, size_t iterations)
+    {
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000;
+    if (iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    const FullDate date(std::chrono::system_clock::now());
+
+    size_t count = 0;
+    auto start   = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        count += makeHeaders(date).list().size();
+    const double buildNs = nsSince(start, iterations);
+
+    const auto headers = makeHeaders(date);
+    DynamicStreamBuf buf(ResponseWriter::DefaultStreamSize, Const::DefaultMaxResponseSize);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        buf.clear();
+        if (!writeHeaders(headers, buf))
+        {
+            std::fprintf(stderr, "the headers did not fit in the buffer\n");
+            return 1;
+        }
+    }
+    const double writeNs = nsSince(start, iterations);
+    const size_t bytes   = buf.buffer().size();
+
+    std::printf("headers/response:     %zu\n", count / iterations);
+    std::printf("bytes/response:       %zu\n", bytes);
+    std::printf("build ns/response:    %.1f\n", buildNs);
+    std::printf("write ns/response:    %.1f\n", writeNs);
+    std::printf("write ns/header:      %.1f\n", writeNs / static_cast<double>(headers.list().size()));
+
+    return 0;
+}
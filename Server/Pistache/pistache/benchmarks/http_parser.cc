@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Measures the cost of parsing requests, with no connection involved.
+
+   The same input is fed to a request parser over and over: a small GET, a
+   GET with the headers a browser sends behind a proxy, a POST with a chunked
+   body, and a batch of small GETs pipelined in one read. The time taken per
+   request and the rate at which the input is gone through are reported for
+   each.
+
+   Usage: run_http_parser [iterations]
+*/
+
+#include <pistache/http.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace Pistache;
+
+namespace
+{
+    constexpr size_t ParserSize    = 64 * 1024;
+    constexpr size_t PipelineDepth = 16;
+    constexpr size_t ChunkCount    = 8;
+    constexpr size_t ChunkSize     = 512;
+    constexpr size_t ExtraHeaders  = 24;
+
+    std::string smallRequest()
+    {
+        return "GET /api/v1/items/12345?fields=name HTTP/1.1\r\n"
+               "Host: localhost:9080\r\n"
+               "User-Agent: pistache-bench\r\n"
+               "Accept: */*\r\n"
+               "\r\n";
+    }
+
+    std::string largeHeaderRequest()
+    {
+        std::string request = "GET /static/app/main.js HTTP/1.1\r\n"
+                              "Host: www.example.com\r\n"
+                              "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+                              "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+                              "Accept-Encoding: gzip, deflate, br\r\n"
+                              "Accept-Language: en-US,en;q=0.9,fr;q=0.8\r\n"
+                              "Cache-Control: no-cache\r\n"
+                              "Cookie: session=0123456789abcdef0123456789abcdef; theme=dark; tracking=";
+        request += std::string(600, 'x');
+        request += "\r\n";
+
+        for (size_t i = 0; i < ExtraHeaders; ++i)
+            request += "X-Forwarded-Header-" + std::to_string(i) + ": " + std::string(48, 'a' + static_cast<char>(i % 26)) + "\r\n";
+
+        request += "\r\n";
+        return request;
+    }
+
+    std::string chunkedRequest()
+    {
+        std::string request = "POST /api/v1/upload HTTP/1.1\r\n"
+                              "Host: localhost:9080\r\n"
+                              "Content-Type: application/octet-stream\r\n"
+                              "Transfer-Encoding: chunked\r\n"
+                              "\r\n";
+
+        char size[16];
+        std::snprintf(size, sizeof(size), "%zx\r\n", ChunkSize);
+        for (size_t i = 0; i < ChunkCount; ++i)
+        {
+            request += size;
+            request += std::string(ChunkSize, 'b');
+            request += "\r\n";
+        }
+
+        request += "0\r\n\r\n";
+        return request;
+    }
+
+    std::string pipelinedRequests()
+    {
+        std::string requests;
+        for (size_t i = 0; i < PipelineDepth; ++i)
+            requests += smallRequest();
+        return requests;
+    }
+
+    // Feeds the input once per iteration and parses all the requests it
+    // holds. Returns the nanoseconds taken per request, or a negative value
+    // when the input did not parse into the requests expected.
+    double measure(const std::string& input, size_t requestsPerInput, size_t iterations)
+    {
+        Http::RequestParser parser(ParserSize);
+
+        size_t parsed    = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            if (!parser.feed(input.data(), input.size()))
+                return -1;
+
+            while (parser.parse() == Http::Private::State::Done)
+            {
+                ++parsed;
+                parser.resetForNextRequest();
+            }
+
+            parser.reset();
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+        if (parsed != iterations * requestsPerInput)
+            return -1;
+        return elapsed.count() / static_cast<double>(parsed);
+    }
+
+    bool report(const char* name, const std::string& input, size_t requestsPerInput, size_t iterations)
+    {
+        const double ns = measure(input, requestsPerInput, iterations);
+        if (ns < 0)
+        {
+            std::fprintf(stderr, "%s: the input did not parse\n", name);
+            return false;
+        }
+
+        const double bytesPerRequest = static_cast<double>(input.size()) / static_cast<double>(requestsPerInput);
+        std::printf("%-16s %8.0f bytes %10.1f ns/request %10.1f MB/s\n",
+                    name, bytesPerRequest, ns, bytesPerRequest * 1e3 / ns);
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    // All of them are run, even when one fails
+    const bool ok = report("small", smallRequest(), 1, iterations)
+        & report("large headers", largeHeaderRequest(), 1, iterations)
+        & report("chunked", chunkedRequest(), 1, iterations)
+        & report("pipelined", pipelinedRequests(), PipelineDepth, iterations / PipelineDepth + 1);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,667 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Generates load against a local endpoint and reports how it held up.
+
+   An endpoint is started on the loopback interface, answering every request
+   with a body of the given size. Client threads then share the connections
+   asked for between them and, for the duration given, keep each connection
+   busy: as soon as a response comes in, another request is sent, so that
+   the given number of requests are always in flight on it. Without
+   keep-alive, a connection is opened for each request instead.
+
+   The request rate, the errors and the percentiles of the latency (from a
+   request being queued to its response being read in full) are written to
+   stdout as a JSON object, for CI to compare against a previous run.
+
+   Usage: run_load [--connections=N] [--threads=N] [--server-threads=N]
+                   [--duration=SECONDS] [--pipeline=N] [--no-keep-alive]
+                   [--body=BYTES] [--response=BYTES]
+                   [--tls --cert=FILE --key=FILE]
+*/
+
+#include <pistache/endpoint.h>
+#include <pistache/metrics.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef PISTACHE_USE_SSL
+#include <openssl/ssl.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        size_t connections  = 64;
+        size_t threads      = 2;
+        int serverThreads   = 2;
+        double duration     = 5.0;
+        size_t pipeline     = 1;
+        bool keepAlive      = true;
+        size_t bodySize     = 0;
+        size_t responseSize = 64;
+        bool tls            = false;
+        std::string cert;
+        std::string key;
+    };
+
+    bool parseOptions(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg   = argv[i];
+            const auto equals       = arg.find('=');
+            const std::string name  = arg.substr(0, equals);
+            const std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+            const size_t number     = std::strtoul(value.c_str(), nullptr, 10);
+
+            if (name == "--connections")
+                options.connections = number;
+            else if (name == "--threads")
+                options.threads = number;
+            else if (name == "--server-threads")
+                options.serverThreads = static_cast<int>(number);
+            else if (name == "--duration")
+                options.duration = std::strtod(value.c_str(), nullptr);
+            else if (name == "--pipeline")
+                options.pipeline = number;
+            else if (name == "--no-keep-alive")
+                options.keepAlive = false;
+            else if (name == "--body")
+                options.bodySize = number;
+            else if (name == "--response")
+                options.responseSize = number;
+            else if (name == "--tls")
+                options.tls = true;
+            else if (name == "--cert")
+                options.cert = value;
+            else if (name == "--key")
+                options.key = value;
+            else
+                return false;
+        }
+
+        // Without keep-alive there is only ever one request on a connection
+        if (!options.keepAlive)
+            options.pipeline = 1;
+        options.threads = std::min(options.threads, options.connections);
+
+        return options.connections > 0 && options.threads > 0 && options.serverThreads > 0
+            && options.duration > 0 && options.pipeline > 0
+            && (!options.tls || (!options.cert.empty() && !options.key.empty()));
+    }
+
+    class BodyHandler : public Http::Handler
+    {
+    public:
+        HTTP_PROTOTYPE(BodyHandler)
+
+        explicit BodyHandler(size_t size)
+            : body_(size, 'x')
+        { }
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter response) override
+        {
+            response.send(Http::Code::Ok, body_);
+        }
+
+    private:
+        std::string body_;
+    };
+
+    // Follows the responses coming in on a connection. Only those with a
+    // Content-Length, as the endpoint sends them, are understood.
+    class ResponseReader
+    {
+    public:
+        // Calls onResponse with the status of each response read in full.
+        // Returns false if what came in is not a response.
+        template <typename OnResponse>
+        bool consume(const char* data, size_t size, OnResponse onResponse)
+        {
+            static const char Terminator[] = "\r\n\r\n";
+
+            while (size > 0)
+            {
+                if (bodyLeft_ > 0)
+                {
+                    const size_t n = std::min(size, bodyLeft_);
+                    bodyLeft_ -= n;
+                    data += n;
+                    size -= n;
+                    if (bodyLeft_ == 0)
+                        onResponse(status_);
+                    continue;
+                }
+
+                size_t i = 0;
+                while (i < size && matched_ < 4)
+                {
+                    matched_ = (data[i] == Terminator[matched_]) ? matched_ + 1
+                                                                 : (data[i] == '\r' ? 1 : 0);
+                    ++i;
+                }
+
+                head_.append(data, i);
+                data += i;
+                size -= i;
+
+                if (matched_ < 4)
+                    return head_.size() <= MaxHeadSize;
+
+                matched_ = 0;
+                if (!parseHead())
+                    return false;
+                head_.clear();
+
+                if (bodyLeft_ == 0)
+                    onResponse(status_);
+            }
+
+            return true;
+        }
+
+        void reset()
+        {
+            head_.clear();
+            matched_  = 0;
+            bodyLeft_ = 0;
+        }
+
+    private:
+        static constexpr size_t MaxHeadSize = 64 * 1024;
+
+        bool parseHead()
+        {
+            if (head_.compare(0, 5, "HTTP/") != 0 || head_.size() < 12)
+                return false;
+            status_ = std::atoi(head_.c_str() + 9);
+
+            bool hasLength = false;
+            for (size_t pos = head_.find("\r\n"); pos != std::string::npos && pos + 2 < head_.size();
+                 pos = head_.find("\r\n", pos + 2))
+            {
+                const char* line = head_.c_str() + pos + 2;
+                if (::strncasecmp(line, "Content-Length:", 15) == 0)
+                {
+                    bodyLeft_ = std::strtoul(line + 15, nullptr, 10);
+                    hasLength = true;
+                }
+                else if (::strncasecmp(line, "Transfer-Encoding:", 18) == 0)
+                {
+                    return false;
+                }
+            }
+
+            return hasLength;
+        }
+
+        std::string head_;
+        size_t matched_  = 0;
+        size_t bodyLeft_ = 0;
+        int status_      = 0;
+    };
+
+    struct Connection
+    {
+        int fd = -1;
+#ifdef PISTACHE_USE_SSL
+        SSL* ssl = nullptr;
+#endif
+        std::string out;
+        size_t written = 0;
+        // When each request in flight was queued
+        std::deque<Clock::time_point> sent;
+        ResponseReader reader;
+        bool pollingOut = false;
+    };
+
+    struct Results
+    {
+        uint64_t responses  = 0;
+        uint64_t errors     = 0;
+        uint64_t reconnects = 0;
+        uint64_t bytesRead  = 0;
+        Metrics::Histogram latency;
+    };
+
+    class Client
+    {
+    public:
+        Client(const Options& options, Port port, void* tlsContext)
+            : options_(options)
+            , port_(port)
+            , tlsContext_(tlsContext)
+        {
+            if (options.bodySize > 0)
+            {
+                request_ = "POST /load HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                           "Content-Type: application/octet-stream\r\n"
+                           "Content-Length: "
+                    + std::to_string(options.bodySize) + "\r\n";
+            }
+            else
+            {
+                request_ = "GET /load HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+            }
+            request_ += options.keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+            request_ += std::string(options.bodySize, 'y');
+        }
+
+        void run(size_t connections, Clock::time_point deadline, Results& results)
+        {
+            epfd_ = ::epoll_create1(0);
+            conns_.resize(connections);
+
+            for (size_t i = 0; i < conns_.size(); ++i)
+            {
+                if (!open(i))
+                    ++results.errors;
+            }
+
+            std::vector<epoll_event> events(256);
+            std::vector<char> buffer(64 * 1024);
+
+            while (Clock::now() < deadline)
+            {
+                const int ready = ::epoll_wait(epfd_, events.data(), static_cast<int>(events.size()), 10);
+                for (int e = 0; e < ready; ++e)
+                {
+                    const size_t index = events[e].data.u64;
+                    auto& conn         = conns_[index];
+                    if (conn.fd < 0)
+                        continue;
+
+                    bool ok = !(events[e].events & EPOLLERR) && flush(conn);
+
+                    bool reconnect = false;
+                    while (ok)
+                    {
+                        const ssize_t n = receive(conn, buffer.data(), buffer.size());
+                        if (n == 0)
+                            break;
+                        if (n < 0)
+                        {
+                            ok = false;
+                            break;
+                        }
+
+                        results.bytesRead += static_cast<uint64_t>(n);
+                        ok = conn.reader.consume(buffer.data(), static_cast<size_t>(n), [&](int status) {
+                            const auto now = Clock::now();
+                            if (!conn.sent.empty())
+                            {
+                                const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - conn.sent.front());
+                                results.latency.record(static_cast<uint64_t>(latency.count()));
+                                conn.sent.pop_front();
+                            }
+
+                            ++results.responses;
+                            if (status < 200 || status >= 300)
+                                ++results.errors;
+
+                            if (options_.keepAlive)
+                                queue(conn, now);
+                            else
+                                reconnect = true;
+                        });
+
+                        // Without keep-alive the server closes the connection
+                        // next, which is no error
+                        if (reconnect)
+                            break;
+                    }
+
+                    if (!ok)
+                    {
+                        ++results.errors;
+                        reconnect = true;
+                    }
+
+                    if (reconnect)
+                    {
+                        ++results.reconnects;
+                        close(conn);
+                        if (!open(index))
+                            ++results.errors;
+                    }
+                    else if (!flush(conn) || !watch(index))
+                    {
+                        ++results.errors;
+                    }
+                }
+            }
+
+            for (auto& conn : conns_)
+                close(conn);
+            ::close(epfd_);
+        }
+
+    private:
+        bool open(size_t index)
+        {
+            auto& conn = conns_[index];
+
+            conn.fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (conn.fd < 0)
+                return false;
+
+            sockaddr_in addr     = {};
+            addr.sin_family      = AF_INET;
+            addr.sin_port        = htons(static_cast<uint16_t>(port_));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (::connect(conn.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            {
+                close(conn);
+                return false;
+            }
+
+            int one = 1;
+            ::setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+#ifdef PISTACHE_USE_SSL
+            // The handshake is done blocking, before the socket is handed to
+            // the event loop
+            if (tlsContext_)
+            {
+                conn.ssl = SSL_new(static_cast<SSL_CTX*>(tlsContext_));
+                SSL_set_fd(conn.ssl, conn.fd);
+                if (SSL_connect(conn.ssl) != 1)
+                {
+                    close(conn);
+                    return false;
+                }
+            }
+#endif
+
+            ::fcntl(conn.fd, F_SETFL, ::fcntl(conn.fd, F_GETFL) | O_NONBLOCK);
+
+            const auto now = Clock::now();
+            for (size_t i = 0; i < options_.pipeline; ++i)
+                queue(conn, now);
+
+            epoll_event event = {};
+            event.events      = EPOLLIN;
+            event.data.u64    = index;
+            if (::epoll_ctl(epfd_, EPOLL_CTL_ADD, conn.fd, &event) < 0)
+            {
+                close(conn);
+                return false;
+            }
+            conn.pollingOut = false;
+
+            return flush(conn) && watch(index);
+        }
+
+        void close(Connection& conn)
+        {
+#ifdef PISTACHE_USE_SSL
+            if (conn.ssl)
+            {
+                SSL_free(conn.ssl);
+                conn.ssl = nullptr;
+            }
+#endif
+            if (conn.fd >= 0)
+                ::close(conn.fd);
+
+            conn.fd = -1;
+            conn.out.clear();
+            conn.written = 0;
+            conn.sent.clear();
+            conn.reader.reset();
+        }
+
+        void queue(Connection& conn, Clock::time_point now)
+        {
+            conn.out += request_;
+            conn.sent.push_back(now);
+        }
+
+        // Writes what it can of the requests queued
+        bool flush(Connection& conn)
+        {
+            while (conn.written < conn.out.size())
+            {
+                const ssize_t n = send(conn, conn.out.data() + conn.written, conn.out.size() - conn.written);
+                if (n < 0)
+                    return false;
+                if (n == 0)
+                    break;
+                conn.written += static_cast<size_t>(n);
+            }
+
+            if (conn.written == conn.out.size())
+            {
+                conn.out.clear();
+                conn.written = 0;
+            }
+            return true;
+        }
+
+        // Has the event loop wait for the socket to be writable only while
+        // requests are left to write
+        bool watch(size_t index)
+        {
+            auto& conn         = conns_[index];
+            const bool pending = !conn.out.empty();
+            if (conn.fd < 0 || pending == conn.pollingOut)
+                return true;
+
+            epoll_event event = {};
+            event.events      = pending ? EPOLLIN | EPOLLOUT : EPOLLIN;
+            event.data.u64    = index;
+            conn.pollingOut   = pending;
+            return ::epoll_ctl(epfd_, EPOLL_CTL_MOD, conn.fd, &event) == 0;
+        }
+
+        // Both return the bytes moved, 0 when the socket would block, and -1
+        // on an error or once the server closed the connection
+        ssize_t send(Connection& conn, const char* data, size_t size)
+        {
+#ifdef PISTACHE_USE_SSL
+            if (conn.ssl)
+            {
+                const int n = SSL_write(conn.ssl, data, static_cast<int>(std::min<size_t>(size, 1 << 30)));
+                if (n > 0)
+                    return n;
+                const int err = SSL_get_error(conn.ssl, n);
+                return (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) ? 0 : -1;
+            }
+#endif
+            const ssize_t n = ::send(conn.fd, data, size, MSG_NOSIGNAL);
+            if (n < 0)
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+            return n;
+        }
+
+        ssize_t receive(Connection& conn, char* data, size_t size)
+        {
+#ifdef PISTACHE_USE_SSL
+            if (conn.ssl)
+            {
+                const int n = SSL_read(conn.ssl, data, static_cast<int>(size));
+                if (n > 0)
+                    return n;
+                const int err = SSL_get_error(conn.ssl, n);
+                return (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) ? 0 : -1;
+            }
+#endif
+            const ssize_t n = ::recv(conn.fd, data, size, 0);
+            if (n == 0)
+                return -1;
+            if (n < 0)
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+            return n;
+        }
+
+        const Options& options_;
+        Port port_;
+        void* tlsContext_;
+        std::string request_;
+
+        int epfd_ = -1;
+        std::vector<Connection> conns_;
+    };
+
+    void raiseFdLimit(size_t connections)
+    {
+        rlimit limit;
+        if (::getrlimit(RLIMIT_NOFILE, &limit) != 0)
+            return;
+
+        // Both ends of every connection are in this process
+        const rlim_t wanted = static_cast<rlim_t>(connections * 2 + 256);
+        if (limit.rlim_cur < wanted)
+        {
+            limit.rlim_cur = std::min(wanted, limit.rlim_max);
+            ::setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--connections=N] [--threads=N] [--server-threads=N]\n"
+                     "       [--duration=SECONDS] [--pipeline=N] [--no-keep-alive]\n"
+                     "       [--body=BYTES] [--response=BYTES] [--tls --cert=FILE --key=FILE]\n",
+                     argv[0]);
+        return 1;
+    }
+
+#ifndef PISTACHE_USE_SSL
+    if (options.tls)
+    {
+        std::fprintf(stderr, "pistache was built without TLS support\n");
+        return 1;
+    }
+#endif
+
+    raiseFdLimit(options.connections);
+
+    Http::Endpoint endpoint(Address(IP::loopback(), Port(0)));
+    auto opts = Http::Endpoint::options()
+                    .threads(options.serverThreads)
+                    .flags(Tcp::Options::NoDelay)
+                    .backlog(static_cast<int>(std::min<size_t>(options.connections, 65535)))
+                    .maxRequestSize(std::max(Const::DefaultMaxRequestSize, options.bodySize + 4096));
+    endpoint.init(opts);
+    endpoint.setHandler(std::make_shared<BodyHandler>(options.responseSize));
+
+    void* tlsContext = nullptr;
+#ifdef PISTACHE_USE_SSL
+    if (options.tls)
+    {
+        endpoint.useSSL(options.cert, options.key);
+
+        SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        tlsContext = ctx;
+    }
+#endif
+
+    endpoint.serveThreaded();
+
+    std::vector<Results> results(options.threads);
+    std::vector<std::thread> threads;
+
+    const auto start    = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+    for (size_t t = 0; t < options.threads; ++t)
+    {
+        // The connections are spread as evenly as they can be
+        const size_t connections = options.connections / options.threads
+            + (t < options.connections % options.threads ? 1 : 0);
+
+        threads.emplace_back([&, t, connections] {
+            Client client(options, endpoint.getPort(), tlsContext);
+            client.run(connections, deadline, results[t]);
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    endpoint.shutdown();
+
+#ifdef PISTACHE_USE_SSL
+    if (tlsContext)
+        SSL_CTX_free(static_cast<SSL_CTX*>(tlsContext));
+#endif
+
+    Results total;
+    for (const auto& result : results)
+    {
+        total.responses += result.responses;
+        total.errors += result.errors;
+        total.reconnects += result.reconnects;
+        total.bytesRead += result.bytesRead;
+        total.latency += result.latency;
+    }
+
+    const auto& latency = total.latency;
+    const double mean   = latency.count() ? static_cast<double>(latency.sum()) / static_cast<double>(latency.count()) : 0.0;
+
+    std::printf("{\n");
+    std::printf("  \"connections\": %zu,\n", options.connections);
+    std::printf("  \"client_threads\": %zu,\n", options.threads);
+    std::printf("  \"server_threads\": %d,\n", options.serverThreads);
+    std::printf("  \"pipeline\": %zu,\n", options.pipeline);
+    std::printf("  \"keep_alive\": %s,\n", options.keepAlive ? "true" : "false");
+    std::printf("  \"tls\": %s,\n", options.tls ? "true" : "false");
+    std::printf("  \"body_bytes\": %zu,\n", options.bodySize);
+    std::printf("  \"response_bytes\": %zu,\n", options.responseSize);
+    std::printf("  \"duration_s\": %.3f,\n", elapsed);
+    std::printf("  \"requests\": %llu,\n", static_cast<unsigned long long>(total.responses));
+    std::printf("  \"errors\": %llu,\n", static_cast<unsigned long long>(total.errors));
+    std::printf("  \"reconnects\": %llu,\n", static_cast<unsigned long long>(total.reconnects));
+    std::printf("  \"rps\": %.1f,\n", static_cast<double>(total.responses) / elapsed);
+    std::printf("  \"read_mb_per_s\": %.2f,\n", static_cast<double>(total.bytesRead) / elapsed / 1e6);
+    std::printf("  \"latency_us\": {\n");
+    std::printf("    \"mean\": %.1f,\n", mean);
+    std::printf("    \"p50\": %llu,\n", static_cast<unsigned long long>(latency.quantile(0.5)));
+    std::printf("    \"p90\": %llu,\n", static_cast<unsigned long long>(latency.quantile(0.9)));
+    std::printf("    \"p99\": %llu,\n", static_cast<unsigned long long>(latency.quantile(0.99)));
+    std::printf("    \"p999\": %llu,\n", static_cast<unsigned long long>(latency.quantile(0.999)));
+    std::printf("    \"max\": %llu\n", static_cast<unsigned long long>(latency.max()));
+    std::printf("  }\n");
+    std::printf("}\n");
+
+    return total.responses > 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Measures MPMCQueue under contention.
+
+   For each thread count from 1 to the maximum, doubling each time, half of the
+   threads produce and half consume (a single thread does both in turn). Each
+   producer pushes the same number of values, one at a time or in batches, and
+   the consumers either poll the queue or block in wait_dequeue_bulk(). The
+   rate at which values go through the queue is reported for each run.
+
+   Usage: run_mpmc_queue [values per producer] [max threads] [batch size]
+*/
+
+#include <pistache/mailbox.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    using Queue = MPMCQueue<size_t, 1024>;
+
+    enum class Consume { Poll,
+                         Wait };
+
+    void produce(Queue& queue, size_t values, size_t batch)
+    {
+        std::vector<size_t> buffer(batch);
+        size_t sent = 0;
+        while (sent < values)
+        {
+            const size_t count = std::min(batch, values - sent);
+            for (size_t i = 0; i < count; ++i)
+                buffer[i] = sent + i;
+
+            size_t done = 0;
+            while (done < count)
+            {
+                const size_t n = batch == 1
+                    ? (queue.enqueue(buffer[done]) ? 1 : 0)
+                    : queue.enqueue_bulk(buffer.begin() + static_cast<std::ptrdiff_t>(done), count - done);
+                if (n == 0)
+                    std::this_thread::yield();
+                done += n;
+            }
+            sent += count;
+        }
+    }
+
+    void consume(Queue& queue, size_t values, size_t batch, Consume mode)
+    {
+        std::vector<size_t> buffer(batch);
+        size_t received = 0;
+        while (received < values)
+        {
+            const size_t max = std::min(batch, values - received);
+            size_t n;
+            if (mode == Consume::Wait)
+                n = queue.wait_dequeue_bulk(buffer.begin(), max);
+            else if (batch == 1)
+                n = queue.dequeue(buffer[0]) ? 1 : 0;
+            else
+                n = queue.dequeue_bulk(buffer.begin(), max);
+
+            if (n == 0)
+                std::this_thread::yield();
+            received += n;
+        }
+    }
+
+    double run(size_t threads, size_t values, size_t batch, Consume mode)
+    {
+        auto queue = std::make_unique<Queue>();
+        const auto start = std::chrono::steady_clock::now();
+
+        if (threads == 1)
+        {
+            // Fills then drains the queue, in as many rounds as needed
+            for (size_t done = 0; done < values;)
+            {
+                const size_t round = std::min(Queue::capacity(), values - done);
+                produce(*queue, round, batch);
+                consume(*queue, round, batch, Consume::Poll);
+                done += round;
+            }
+        }
+        else
+        {
+            std::vector<std::thread> workers;
+            for (size_t i = 0; i < threads / 2; ++i)
+            {
+                workers.emplace_back([&] { produce(*queue, values, batch); });
+                workers.emplace_back([&] { consume(*queue, values, batch, mode); });
+            }
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const size_t total = threads == 1 ? values : values * (threads / 2);
+        return static_cast<double>(total) / elapsed.count();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t values     = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t maxThreads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    const size_t batch      = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 16;
+
+    if (values == 0 || maxThreads == 0 || batch == 0)
+    {
+        std::fprintf(stderr, "usage: %s [values per producer] [max threads] [batch size]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%8s %16s %16s %16s\n", "threads", "single/s", "bulk/s", "bulk+wait/s");
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        const double single  = run(threads, values, 1, Consume::Poll);
+        const double bulk    = run(threads, values, batch, Consume::Poll);
+        const double waiting = threads == 1 ? bulk : run(threads, values, batch, Consume::Wait);
+        std::printf("%8zu %16.0f %16.0f %16.0f\n", threads, single, bulk, waiting);
+    }
+
+    return 0;
+}
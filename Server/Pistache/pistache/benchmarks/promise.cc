@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Measures the cost of chaining promises.
+
+   Chains of continuations are built on a promise that is already resolved,
+   on one that is resolved once the whole chain is attached, and on one that
+   is rejected, the rejection then going down the chain. Promises are also
+   joined with whenAll. The time taken per continuation (or per promise
+   joined) is reported for each.
+
+   Usage: run_promise [chain length] [iterations]
+*/
+
+#include <pistache/async.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    template <typename Body>
+    double measure(size_t iterations, size_t perIteration, Body body)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            body(i);
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        return elapsed.count() / static_cast<double>(iterations * perIteration);
+    }
+
+    Async::Promise<int> chain(Async::Promise<int> promise, size_t length)
+    {
+        for (size_t i = 0; i < length; ++i)
+            promise = promise.then([](int value) { return value + 1; }, Async::Throw);
+        return promise;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t length     = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+
+    if (length == 0 || iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [chain length] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    // Results are summed up, and checked, so that nothing is optimized away
+    size_t sum = 0;
+
+    const double resolvedNs = measure(iterations, length, [&](size_t i) {
+        auto promise = chain(Async::Promise<int>::resolved(static_cast<int>(i & 0xff)), length);
+        promise.then([&](int value) { sum += static_cast<size_t>(value); }, Async::NoExcept);
+    });
+
+    const double pendingNs = measure(iterations, length, [&](size_t i) {
+        Async::Deferred<int> deferred;
+        Async::Promise<int> promise([&](Async::Deferred<int> d) { deferred = std::move(d); });
+
+        promise = chain(std::move(promise), length);
+        promise.then([&](int value) { sum += static_cast<size_t>(value); }, Async::NoExcept);
+        deferred.resolve(static_cast<int>(i & 0xff));
+    });
+
+    size_t rejections     = 0;
+    const double rejectNs = measure(iterations, length, [&](size_t) {
+        auto promise = chain(Async::Promise<int>::rejected(std::runtime_error("failed")), length);
+        promise.then([&](int) {}, [&](std::exception_ptr) { ++rejections; });
+    });
+
+    const double whenAllNs = measure(iterations / length + 1, length, [&](size_t) {
+        std::vector<Async::Promise<int>> promises;
+        promises.reserve(length);
+        for (size_t j = 0; j < length; ++j)
+            promises.push_back(Async::Promise<int>::resolved(static_cast<int>(j)));
+
+        Async::whenAll(promises.begin(), promises.end())
+            .then([&](const std::vector<int>& values) { sum += values.size(); }, Async::NoExcept);
+    });
+
+    if (rejections != iterations)
+    {
+        std::fprintf(stderr, "%zu rejections went down the chains, %zu expected\n",
+                     rejections, iterations);
+        return 1;
+    }
+
+    std::printf("chain length:               %zu\n", length);
+    std::printf("iterations:                 %zu\n", iterations);
+    std::printf("resolved ns/continuation:   %.1f\n", resolvedNs);
+    std::printf("pending ns/continuation:    %.1f\n", pendingNs);
+    std::printf("rejected ns/continuation:   %.1f\n", rejectNs);
+    std::printf("whenAll ns/promise:         %.1f\n", whenAllNs);
+    std::printf("checksum:                   %zu\n", sum);
+
+    return 0;
+}
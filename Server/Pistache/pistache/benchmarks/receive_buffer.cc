@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Measures the cost of receiving requests on a keep-alive connection.
+
+   A single client sends requests over one connection, either one at a time or
+   in pipelined batches, to an endpoint answering with an empty response. The
+   heap allocations done by the whole process (glibc only) are counted and reported per
+   request, along with the request rate.
+
+   Usage: run_receive_buffer [requests] [pipeline depth] [body size]
+*/
+
+#include <pistache/endpoint.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace Pistache;
+
+namespace
+{
+    std::atomic<size_t> allocations { 0 };
+    std::atomic<size_t> allocatedBytes { 0 };
+}
+
+// Counting at the malloc level also catches the allocations made from within
+// the C++ runtime, which do not all go through a replaced operator new
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+
+    void* malloc(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(count * size, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+}
+
+class EmptyHandler : public Http::Handler
+{
+public:
+    HTTP_PROTOTYPE(EmptyHandler)
+
+    void onRequest(const Http::Request& /*request*/, Http::ResponseWriter response) override
+    {
+        response.send(Http::Code::Ok);
+    }
+};
+
+namespace
+{
+    int connectTo(Port port)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        sockaddr_in addr     = {};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    bool sendAll(int fd, const std::string& data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            auto n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+            if (n <= 0)
+                return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Reads until count responses have come in. Responses have no body, so
+    // each one ends with an empty line.
+    bool receiveResponses(int fd, size_t count)
+    {
+        static const char Terminator[] = "\r\n\r\n";
+
+        char buffer[Const::MaxBuffer];
+        size_t matched = 0;
+        while (count > 0)
+        {
+            auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                return false;
+
+            for (ssize_t i = 0; i < n; ++i)
+            {
+                matched = (buffer[i] == Terminator[matched]) ? matched + 1
+                                                             : (buffer[i] == '\r' ? 1 : 0);
+                if (matched == 4)
+                {
+                    matched = 0;
+                    --count;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const size_t depth    = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1;
+    const size_t bodySize = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+
+    if (requests == 0 || depth == 0)
+    {
+        std::fprintf(stderr, "usage: %s [requests] [pipeline depth] [body size]\n", argv[0]);
+        return 1;
+    }
+
+    Http::Endpoint endpoint(Address(IP::loopback(), Port(0)));
+    auto opts = Http::Endpoint::options()
+                    .threads(1)
+                    .flags(Tcp::Options::NoDelay)
+                    .maxRequestSize(bodySize + 1024);
+
+    endpoint.init(opts);
+    endpoint.setHandler(Http::make_handler<EmptyHandler>());
+    endpoint.serveThreaded();
+
+    int fd = connectTo(endpoint.getPort());
+    if (fd < 0)
+    {
+        std::perror("connect");
+        return 1;
+    }
+
+    std::string request = "POST / HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "Connection: keep-alive\r\n"
+                          "Content-Length: "
+        + std::to_string(bodySize) + "\r\n\r\n" + std::string(bodySize, 'A');
+
+    std::string batch;
+    for (size_t i = 0; i < depth; ++i)
+        batch += request;
+
+    // Warm up the connection so that one-off allocations are not counted
+    if (!sendAll(fd, request) || !receiveResponses(fd, 1))
+    {
+        std::fprintf(stderr, "warm-up request failed\n");
+        return 1;
+    }
+
+    const size_t batches = (requests + depth - 1) / depth;
+    const size_t sent    = batches * depth;
+
+    const size_t allocationsBefore = allocations.load();
+    const size_t bytesBefore       = allocatedBytes.load();
+    const auto start               = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < batches; ++i)
+    {
+        if (!sendAll(fd, batch) || !receiveResponses(fd, depth))
+        {
+            std::fprintf(stderr, "connection lost after %zu batches\n", i);
+            return 1;
+        }
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    const size_t allocationsDone = allocations.load() - allocationsBefore;
+    const size_t bytesDone       = allocatedBytes.load() - bytesBefore;
+
+    ::close(fd);
+    endpoint.shutdown();
+
+    std::printf("requests:             %zu\n", sent);
+    std::printf("pipeline depth:       %zu\n", depth);
+    std::printf("body size:            %zu\n", bodySize);
+    std::printf("requests/s:           %.0f\n", static_cast<double>(sent) / elapsed.count());
+    std::printf("allocations/request:  %.2f\n", static_cast<double>(allocationsDone) / static_cast<double>(sent));
+    std::printf("allocated B/request:  %.0f\n", static_cast<double>(bytesDone) / static_cast<double>(sent));
+
+    return 0;
+}
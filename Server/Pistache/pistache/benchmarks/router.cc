@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+   Measures the cost of finding the route of a request.
+
+   Routes shaped like those of a REST API gateway are added for a number of
+   services: collections, items by id, nested collections and a few splats.
+   Paths requested from all of them, along with some that match no route,
+   are then looked up, both by walking the tree of segments and with the
+   routes compiled as they are when the router serves requests.
+
+   Usage: run_router [routes] [lookups]
+*/
+
+#include <pistache/router.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Pistache;
+using namespace Pistache::Rest;
+
+namespace
+{
+    // Each service has this many routes
+    constexpr size_t RoutesPerService = 6;
+
+    std::vector<std::string> makeRoutes(size_t count)
+    {
+        std::vector<std::string> routes;
+        for (size_t service = 0; routes.size() < count; ++service)
+        {
+            const std::string prefix = "/api/v" + std::to_string(service % 3 + 1) + "/service" + std::to_string(service);
+
+            routes.push_back(prefix + "/items");
+            routes.push_back(prefix + "/items/:id");
+            routes.push_back(prefix + "/items/:id/history");
+            routes.push_back(prefix + "/items/:id/tags/:tag?");
+            routes.push_back(prefix + "/static/*");
+            routes.push_back(prefix + "/health");
+        }
+        routes.resize(count);
+        return routes;
+    }
+
+    std::vector<std::string> makePaths(size_t routes)
+    {
+        std::vector<std::string> paths;
+        const size_t services = (routes + RoutesPerService - 1) / RoutesPerService;
+        for (size_t service = 0; service < services; ++service)
+        {
+            const std::string prefix = "/api/v" + std::to_string(service % 3 + 1) + "/service" + std::to_string(service);
+
+            paths.push_back(prefix + "/items");
+            paths.push_back(prefix + "/items/12345");
+            paths.push_back(prefix + "/items/12345/history");
+            paths.push_back(prefix + "/items/12345/tags/blue");
+            paths.push_back(prefix + "/static/app.js");
+            paths.push_back(prefix + "/nothing/here");
+        }
+        return paths;
+    }
+
+    template <typename Lookup>
+    double measure(const std::vector<std::string>& paths, size_t lookups, size_t& found,
+                   Lookup lookup)
+    {
+        found            = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; ++i)
+        {
+            if (lookup(paths[i % paths.size()]))
+                ++found;
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        return elapsed.count() / static_cast<double>(lookups);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3000;
+    const size_t lookups = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+    if (count == 0 || lookups == 0)
+    {
+        std::fprintf(stderr, "usage: %s [routes] [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    const auto resources = makeRoutes(count);
+
+    // The tree views into the resources
+    std::vector<std::string> sanitized;
+    sanitized.reserve(resources.size());
+    for (const auto& resource : resources)
+        sanitized.push_back(SegmentTreeNode::sanitizeResource(resource));
+
+    SegmentTreeNode tree;
+    for (const auto& path : sanitized)
+        tree.addRoute(path, nullptr, nullptr);
+
+    const auto compileStart = std::chrono::steady_clock::now();
+    RouteMatcher matcher(tree);
+    const auto compileTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileStart);
+
+    const auto paths = makePaths(count);
+
+    size_t treeFound = 0;
+    const double treeNs = measure(paths, lookups, treeFound, [&](const std::string& resource) {
+        std::string buffer;
+        const auto path = SegmentTreeNode::sanitizeResource(resource, buffer);
+        return std::get<0>(tree.findRoute(path)) != nullptr;
+    });
+
+    size_t compiledFound = 0;
+    std::vector<TypedParam> params, splats;
+    const double compiledNs = measure(paths, lookups, compiledFound, [&](const std::string& resource) {
+        std::string buffer;
+        const auto path = SegmentTreeNode::sanitizeResource(resource, buffer);
+
+        params.clear();
+        splats.clear();
+        return matcher.match(path, params, splats) != nullptr;
+    });
+
+    if (treeFound != compiledFound)
+    {
+        std::fprintf(stderr, "the tree found %zu routes, the compiled routes %zu\n",
+                     treeFound, compiledFound);
+        return 1;
+    }
+
+    std::printf("routes:               %zu\n", resources.size());
+    std::printf("lookups:              %zu\n", lookups);
+    std::printf("matched:              %.1f%%\n", 100.0 * static_cast<double>(compiledFound) / static_cast<double>(lookups));
+    std::printf("compiled nodes:       %zu\n", matcher.nodeCount());
+    std::printf("compile time (ms):    %.2f\n", compileTime.count());
+    std::printf("tree ns/lookup:       %.1f\n", treeNs);
+    std::printf("compiled ns/lookup:   %.1f\n", compiledNs);
+
+    return 0;
+}
@@ -17,10 +17,14 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
 #include <typeinfo>
 #include <vector>
@@ -191,6 +195,63 @@ namespace Pistache::Async
             }
         };
 
+        // Promise cores and continuations are allocated from blocks kept on a
+        // free list by each thread, as most of them only live for the time of
+        // a single write. A block can be given back on another thread than
+        // the one it came from.
+        void* allocateBlock(size_t size);
+        void deallocateBlock(void* block, size_t size) noexcept;
+
+        struct PoolStats
+        {
+            // Blocks taken from the heap, and from the free list
+            uint64_t allocated;
+            uint64_t reused;
+        };
+
+        // Of the calling thread
+        PoolStats poolStats();
+
+        template <typename T>
+        struct PoolAllocator
+        {
+            typedef T value_type;
+
+            PoolAllocator() = default;
+
+            template <typename U>
+            PoolAllocator(const PoolAllocator<U>&) noexcept
+            { }
+
+            T* allocate(size_t n)
+            {
+                if constexpr (alignof(T) > alignof(std::max_align_t))
+                    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+                else
+                    return static_cast<T*>(allocateBlock(n * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, size_t n) noexcept
+            {
+                if constexpr (alignof(T) > alignof(std::max_align_t))
+                    ::operator delete(ptr, std::align_val_t(alignof(T)));
+                else
+                    deallocateBlock(ptr, n * sizeof(T));
+            }
+
+            template <typename U>
+            bool operator==(const PoolAllocator<U>&) const { return true; }
+
+            template <typename U>
+            bool operator!=(const PoolAllocator<U>&) const { return false; }
+        };
+
+        template <typename C>
+        std::shared_ptr<C> makeCore()
+        {
+            return std::allocate_shared<C>(PoolAllocator<C>());
+        }
+
         struct Core;
 
         class Request
@@ -199,36 +260,37 @@ namespace Pistache::Async
             virtual void resolve(const std::shared_ptr<Core>& core) = 0;
             virtual void reject(const std::shared_ptr<Core>& core)  = 0;
             virtual ~Request()                                      = default;
+
+        private:
+            friend struct Core;
+
+            // The continuation attached after this one
+            Request* next_ = nullptr;
+            // The size of the block this lives in, 0 when it lives in the core
+            uint32_t blockSize_ = 0;
+            bool heap_          = false;
         };
 
         struct Core
         {
+            // Most continuations are small enough to be kept in the core of
+            // the promise they are attached to, rather than in a block of
+            // their own; one made of two std::function does
+            static constexpr size_t InlineRequestSize = 112;
+
             Core(State _state, TypeId _id)
                 : allocated(false)
                 , state(_state)
                 , exc()
-                , mtx()
-                , requests()
                 , id(_id)
             { }
 
+            Core(const Core&)            = delete;
+            Core& operator=(const Core&) = delete;
+
             bool allocated;
             std::atomic<State> state;
             std::exception_ptr exc;
-
-            /*
-             * We need this lock because a Promise might be resolved or rejected from a
-             * thread A while a continuation to the same Promise (Core) might be attached
-             * at the same from a thread B. If that's the case, then we need to serialize
-             * operations so that we avoid a race-condition.
-             *
-             * Since we have a lock, we have a blocking progress guarantee but I don't
-             * expect this to be a major bottleneck as I don't expect major contention on
-             * the lock If it ends up being a bottlenick, try @improving it by
-             * experimenting with a lock-free scheme
-             */
-            std::mutex mtx;
-            std::vector<std::shared_ptr<Request>> requests;
             TypeId id;
 
             virtual void* memory() = 0;
@@ -259,7 +321,213 @@ namespace Pistache::Async
                 state     = State::Fulfilled;
             }
 
-            virtual ~Core() = default;
+            /*
+             * A promise is usually settled by a single producer, and its
+             * continuations attached from a single thread, but both may
+             * happen at the same time on two threads. Instead of a lock, the
+             * first continuation and the settlement meet on the sync_ flags:
+             * whichever side comes last runs the continuation, so that it
+             * runs exactly once. Further continuations are rare; they are
+             * kept in a list guarded by a spin lock, those attached before
+             * the settlement being run by the producer, and the others
+             * where they are attached.
+             *
+             * As with a lock, a continuation attached once the promise is
+             * seen settled runs before then() returns.
+             */
+
+            // Runs the continuations attached so far, once the state and
+            // the value or exception have been set
+            static void settle(const std::shared_ptr<Core>& core)
+            {
+                const auto prev = core->sync_.fetch_or(Settled, std::memory_order_acq_rel);
+                if (prev & Settled)
+                    return;
+
+                if (prev & Attached)
+                    run(core->first_, core);
+
+                // None is added to the list once Settled is seen, and only
+                // last->next_ may change in the meantime
+                core->lock();
+                Request* req  = core->head_;
+                Request* last = core->tail_;
+                core->unlock();
+
+                while (req)
+                {
+                    run(req, core);
+                    if (req == last)
+                        break;
+                    req = req->next_;
+                }
+            }
+
+            static void fulfill(const std::shared_ptr<Core>& core)
+            {
+                core->state = State::Fulfilled;
+                settle(core);
+            }
+
+            static void reject(const std::shared_ptr<Core>& core, std::exception_ptr exc)
+            {
+                core->exc   = std::move(exc);
+                core->state = State::Rejected;
+                settle(core);
+            }
+
+            // Constructs a continuation of type R and attaches it to core,
+            // running it right away when core has been settled already
+            template <typename R, typename... Args>
+            static void attach(const std::shared_ptr<Core>& core, Args&&... args)
+            {
+                static_assert(std::is_base_of<Request, R>::value, "Attached continuations must be requests");
+
+                // Settled, but the producer has yet to say so, which it is
+                // about to do
+                if (core->state != State::Pending)
+                {
+                    while (!(core->sync_.load(std::memory_order_acquire) & Settled))
+                        std::this_thread::yield();
+                }
+
+                core->lock();
+
+                const bool first = core->first_ == nullptr;
+                Request* req     = nullptr;
+                try
+                {
+                    req = core->create<R>(first, std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    core->unlock();
+                    throw;
+                }
+
+                if (first)
+                {
+                    core->first_ = req;
+                    core->unlock();
+
+                    if (core->sync_.fetch_or(Attached, std::memory_order_acq_rel) & Settled)
+                        run(req, core);
+                    return;
+                }
+
+                const bool settled = core->sync_.load(std::memory_order_acquire) & Settled;
+                auto& list         = settled ? core->late_ : core->head_;
+                if (settled || !core->tail_)
+                {
+                    req->next_ = list;
+                    list       = req;
+                    if (!settled)
+                        core->tail_ = req;
+                }
+                else
+                {
+                    core->tail_->next_ = req;
+                    core->tail_        = req;
+                }
+                core->unlock();
+
+                if (settled)
+                    run(req, core);
+            }
+
+            virtual ~Core()
+            {
+                if (first_)
+                    destroy(first_);
+
+                for (auto* list : { head_, late_ })
+                {
+                    for (auto* req = list; req;)
+                    {
+                        auto* next = req->next_;
+                        destroy(req);
+                        req = next;
+                    }
+                }
+            }
+
+        private:
+            enum : uint8_t { Settled  = 1,
+                             Attached = 2 };
+
+            static void run(Request* req, const std::shared_ptr<Core>& core)
+            {
+                if (core->state == State::Fulfilled)
+                    req->resolve(core);
+                else
+                    req->reject(core);
+            }
+
+            template <typename R, typename... Args>
+            Request* create(bool first, Args&&... args)
+            {
+                if constexpr (alignof(R) > alignof(std::max_align_t))
+                {
+                    auto* req  = new R(std::forward<Args>(args)...);
+                    req->heap_ = true;
+                    return req;
+                }
+                else
+                {
+                    if constexpr (sizeof(R) <= InlineRequestSize)
+                    {
+                        if (first)
+                            return new (inlineRequest_) R(std::forward<Args>(args)...);
+                    }
+
+                    void* block = allocateBlock(sizeof(R));
+                    try
+                    {
+                        auto* req       = new (block) R(std::forward<Args>(args)...);
+                        req->blockSize_ = static_cast<uint32_t>(sizeof(R));
+                        return req;
+                    }
+                    catch (...)
+                    {
+                        deallocateBlock(block, sizeof(R));
+                        throw;
+                    }
+                }
+            }
+
+            static void destroy(Request* req)
+            {
+                if (req->heap_)
+                {
+                    delete req;
+                    return;
+                }
+
+                const auto size = req->blockSize_;
+                req->~Request();
+                if (size > 0)
+                    deallocateBlock(req, size);
+            }
+
+            void lock()
+            {
+                while (lock_.test_and_set(std::memory_order_acquire))
+                    std::this_thread::yield();
+            }
+
+            void unlock() { lock_.clear(std::memory_order_release); }
+
+            std::atomic<uint8_t> sync_ { 0 };
+            std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+            Request* first_ = nullptr;
+            // Run by the producer
+            Request* head_ = nullptr;
+            Request* tail_ = nullptr;
+            // Run where they were attached, once settled
+            Request* late_ = nullptr;
+
+            alignas(std::max_align_t) std::byte inlineRequest_[InlineRequestSize];
         };
 
         template <typename T>
@@ -319,41 +587,35 @@ namespace Pistache::Async
         struct Continuable : public Request
         {
             explicit Continuable(const std::shared_ptr<Core>& chain)
-                : resolveCount_(0)
-                , rejectCount_(0)
+                : resolved_(false)
+                , rejected_(false)
                 , chain_(chain)
             { }
 
             void resolve(const std::shared_ptr<Core>& core) override
             {
-                if (resolveCount_ >= 1)
+                if (resolved_)
                     return; // TODO is this the right thing?
                             // throw Error("Resolve must not be called more than once");
 
-                ++resolveCount_;
+                resolved_ = true;
                 doResolve(coreCast(core));
             }
 
             void reject(const std::shared_ptr<Core>& core) override
             {
-                if (rejectCount_ >= 1)
+                if (rejected_)
                     return; // TODO is this the right thing?
                             // throw Error("Reject must not be called more than once");
 
-                ++rejectCount_;
+                rejected_ = true;
                 try
                 {
                     doReject(coreCast(core));
                 }
                 catch (const InternalRethrow& e)
                 {
-                    chain_->exc   = e.exc;
-                    chain_->state = State::Rejected;
-                    for (const auto& req : chain_->requests)
-                    {
-                        if (req)
-                            req->reject(chain_);
-                    }
+                    Core::reject(chain_, e.exc);
                 }
             }
 
@@ -367,8 +629,8 @@ namespace Pistache::Async
 
             ~Continuable() override = default;
 
-            size_t resolveCount_;
-            size_t rejectCount_;
+            bool resolved_;
+            bool rejected_;
             std::shared_ptr<Core> chain_;
         };
 
@@ -421,8 +683,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 void doResolve(const std::shared_ptr<CoreT<T>>& core) override
@@ -435,13 +697,9 @@ namespace Pistache::Async
                     reject_(core->exc);
                     /*
                      * reject_ is guaranteed to throw ("[[noreturn]]") so
-                     * doing this "for" loop is pointless
+                     * rejecting chain_ here is pointless
                      *
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->reject(this->chain_);
-                    }
+                    Core::reject(this->chain_, core->exc);
                     */
                 }
 
@@ -450,11 +708,7 @@ namespace Pistache::Async
                 {
                     typedef typename std::decay<Ret>::type CleanRet;
                     this->chain_->template construct<CleanRet>(std::forward<Ret>(ret));
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->resolve(this->chain_);
-                    }
+                    Core::settle(this->chain_);
                 }
 
                 Resolve resolve_;
@@ -470,8 +724,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 0,
@@ -485,11 +739,7 @@ namespace Pistache::Async
                 void doReject(const std::shared_ptr<CoreT<void>>& core) override
                 {
                     reject_(core->exc);
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->reject(this->chain_);
-                    }
+                    Core::reject(this->chain_, core->exc);
                 }
 
                 template <typename Ret>
@@ -497,11 +747,7 @@ namespace Pistache::Async
                 {
                     typedef typename std::remove_reference<Ret>::type CleanRet;
                     this->chain_->template construct<CleanRet>(std::forward<Ret>(ret));
-                    for (const auto& req : this->chain_->requests)
-                    {
-                        if (req)
-                            req->resolve(this->chain_);
-                    }
+                    Core::settle(this->chain_);
                 }
 
                 Resolve resolve_;
@@ -516,8 +762,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 1,
@@ -551,8 +797,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 static_assert(sizeof...(Args) == 0,
@@ -590,8 +836,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<T>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 void doResolve(const std::shared_ptr<CoreT<T>>& core) override
@@ -605,13 +851,9 @@ namespace Pistache::Async
                     reject_(core->exc);
                     /*
                      * reject_ is guaranteed to throw ("[[noreturn]]") so
-                     * doing this "for" loop is pointless
+                     * rejecting chain_ here is pointless
                      *
-                    for (const auto& req : core->requests)
-                    {
-                        if (req)
-                            req->reject(core);
-                    }
+                    Core::reject(this->chain_, core->exc);
                     */
                 }
 
@@ -625,11 +867,7 @@ namespace Pistache::Async
                     void operator()(const PromiseType& val)
                     {
                         chainCore->construct<PromiseType>(val);
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        Core::settle(chainCore);
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -649,16 +887,7 @@ namespace Pistache::Async
                     std::weak_ptr<Core> weakPtr = this->chain_;
                     promise.then(std::move(chainer), [weakPtr](std::exception_ptr exc) {
                         if (auto core = weakPtr.lock())
-                        {
-                            core->exc   = std::move(exc);
-                            core->state = State::Rejected;
-
-                            for (const auto& req : core->requests)
-                            {
-                                if (req)
-                                    req->reject(core);
-                            }
-                        }
+                            Core::reject(core, std::move(exc));
                     });
                 }
 
@@ -678,8 +907,8 @@ namespace Pistache::Async
                 Continuation(const std::shared_ptr<Core>& chain, Resolve resolve,
                              Reject reject)
                     : Continuable<void>(chain)
-                    , resolve_(resolve)
-                    , reject_(reject)
+                    , resolve_(std::move(resolve))
+                    , reject_(std::move(reject))
                 { }
 
                 void doResolve(const std::shared_ptr<CoreT<void>>& /*core*/) override
@@ -691,11 +920,7 @@ namespace Pistache::Async
                 void doReject(const std::shared_ptr<CoreT<void>>& core) override
                 {
                     reject_(core->exc);
-                    for (const auto& req : core->requests)
-                    {
-                        if (req)
-                            req->reject(core);
-                    }
+                    Core::reject(this->chain_, core->exc);
                 }
 
                 template <typename PromiseType, typename Dummy = void>
@@ -708,11 +933,7 @@ namespace Pistache::Async
                     void operator()(const PromiseType& val)
                     {
                         chainCore->construct<PromiseType>(val);
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        Core::settle(chainCore);
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -727,13 +948,7 @@ namespace Pistache::Async
 
                     void operator()()
                     {
-                        chainCore->state = State::Fulfilled;
-
-                        for (const auto& req : chainCore->requests)
-                        {
-                            if (req)
-                                req->resolve(chainCore);
-                        }
+                        Core::fulfill(chainCore);
                     }
 
                     std::shared_ptr<Core> chainCore;
@@ -749,17 +964,11 @@ namespace Pistache::Async
                 template <typename P>
                 void finishResolve(P& promise)
                 {
-                    auto chainer = makeChainer(promise);
-                    promise.then(std::move(chainer), [this](std::exception_ptr exc) {
-                        auto core   = this->chain_;
-                        core->exc   = std::move(exc);
-                        core->state = State::Rejected;
-
-                        for (const auto& req : core->requests)
-                        {
-                            if (req)
-                                req->reject(core);
-                        }
+                    auto chainer                = makeChainer(promise);
+                    std::weak_ptr<Core> weakPtr = this->chain_;
+                    promise.then(std::move(chainer), [weakPtr](std::exception_ptr exc) {
+                        if (auto core = weakPtr.lock())
+                            Core::reject(core, std::move(exc));
                     });
                 }
 
@@ -869,14 +1078,8 @@ namespace Pistache::Async
                 throw Error("Attempt to resolve a void promise with arguments");
             }
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
             core_->construct<Type>(std::forward<Arg>(arg));
-
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->resolve(core_);
-            }
+            Private::Core::settle(core_);
 
             return true;
         }
@@ -892,13 +1095,7 @@ namespace Pistache::Async
             if (!core_->isVoid())
                 throw Error("Attempt ro resolve a non-void promise with no argument");
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
-            core_->state = State::Fulfilled;
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->resolve(core_);
-            }
+            Private::Core::fulfill(core_);
 
             return true;
         }
@@ -933,14 +1130,7 @@ namespace Pistache::Async
             if (core_->state != State::Pending)
                 throw Error("Attempt to reject a fulfilled promise");
 
-            std::unique_lock<std::mutex> guard(core_->mtx);
-            core_->exc   = std::make_exception_ptr(exc);
-            core_->state = State::Rejected;
-            for (const auto& req : core_->requests)
-            {
-                if (req)
-                    req->reject(core_);
-            }
+            Private::Core::reject(core_, std::make_exception_ptr(exc));
 
             return true;
         }
@@ -1075,7 +1265,7 @@ namespace Pistache::Async
 
         template <typename Func>
         explicit Promise(Func func)
-            : core_(std::make_shared<Core>())
+            : core_(Private::makeCore<Core>())
             , resolver_(core_)
             , rejection_(core_)
         {
@@ -1098,8 +1288,9 @@ namespace Pistache::Async
             static_assert(std::is_same<T, U>::value || std::is_convertible<U, T>::value,
                           "Incompatible value type");
 
-            auto core = std::make_shared<Core>();
+            auto core = Private::makeCore<Core>();
             core->template construct<T>(std::forward<U>(value));
+            Private::Core::settle(core);
             return Promise<T>(std::move(core));
         }
 
@@ -1108,17 +1299,16 @@ namespace Pistache::Async
             static_assert(std::is_void<T>::value,
                           "Resolving a non-void promise requires parameters");
 
-            auto core   = std::make_shared<Core>();
-            core->state = State::Fulfilled;
+            auto core = Private::makeCore<Core>();
+            Private::Core::fulfill(core);
             return Promise<T>(std::move(core));
         }
 
         template <typename Exc>
         static Promise<T> rejected(Exc exc)
         {
-            auto core   = std::make_shared<Core>();
-            core->exc   = std::make_exception_ptr(exc);
-            core->state = State::Rejected;
+            auto core = Private::makeCore<Core>();
+            Private::Core::reject(core, std::make_exception_ptr(exc));
             return Promise<T>(std::move(core));
         }
 
@@ -1139,28 +1329,15 @@ namespace Pistache::Async
 
             typedef Private::Continuation<T, ResolveFunc, RejectFunc, ResolveFunc>
                 Continuation;
-            std::shared_ptr<Private::Request> req = std::make_shared<Continuation>(promise.core_, resolveFunc, rejectFunc);
-
-            std::unique_lock<std::mutex> guard(core_->mtx);
-            if (isFulfilled())
-            {
-                if (req)
-                    req->resolve(core_);
-            }
-            else if (isRejected())
-            {
-                if (req)
-                    req->reject(core_);
-            }
-
-            core_->requests.push_back(req);
+            Private::Core::attach<Continuation>(core_, promise.core_, std::move(resolveFunc),
+                                                std::move(rejectFunc));
 
             return promise;
         }
 
     private:
         Promise()
-            : core_(std::make_shared<Core>())
+            : core_(Private::makeCore<Core>())
             , resolver_(core_)
             , rejection_(core_)
         { }
@@ -1371,7 +1548,7 @@ namespace Pistache::Async
                 // Instead of allocating a new core, ideally we could share the same core as
                 // the relevant promise but we do not have access to the promise here is so
                 // meh
-                auto core = std::make_shared<Private::CoreT<T>>();
+                auto core = Private::makeCore<Private::CoreT<T>>();
                 core->template construct<T>(val);
                 data->resolve(Async::Any(core));
 
@@ -1386,7 +1563,7 @@ namespace Pistache::Async
                 if (data->done)
                     return;
 
-                auto core = std::make_shared<Private::CoreT<void>>();
+                auto core = Private::makeCore<Private::CoreT<void>>();
                 data->resolve(Async::Any(core));
 
                 data->done = true;
@@ -16,16 +16,20 @@
 #include <pistache/http.h>
 #include <pistache/os.h>
 #include <pistache/reactor.h>
+#include <pistache/resolver.h>
 #include <pistache/timer_pool.h>
+#include <pistache/timer_wheel.h>
 #include <pistache/view.h>
 
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace Pistache::Http::Experimental
 {
@@ -36,6 +40,12 @@ namespace Pistache::Http::Experimental
         constexpr int MaxConnectionsPerHost = 8;
         constexpr bool KeepAlive            = true;
         constexpr size_t MaxResponseSize    = std::numeric_limits<uint32_t>::max();
+        constexpr size_t PipelineDepth      = 1;
+        constexpr size_t MaxQueuedRequests  = 2048;
+        constexpr std::chrono::milliseconds ConnectTimeout(10000);
+        // How long an attempt to connect goes unanswered before the next
+        // address is tried alongside it, as RFC 8305 recommends
+        constexpr std::chrono::milliseconds ConnectionAttemptDelay(250);
     } // namespace Default
 
     class Transport;
@@ -47,36 +57,67 @@ namespace Pistache::Http::Experimental
 
         explicit Connection(size_t maxResponseSize);
 
+        // Where the body of a streamed response goes, and who waits for its
+        // headers
+        struct Stream
+        {
+            Stream(std::shared_ptr<BodyReader> reader, Async::Resolver headersResolve,
+                   Async::Rejection headersReject)
+                : reader(std::move(reader))
+                , headersResolve(std::move(headersResolve))
+                , headersReject(std::move(headersReject))
+            { }
+
+            std::shared_ptr<BodyReader> reader;
+            Async::Resolver headersResolve;
+            Async::Rejection headersReject;
+            // Set once the headers were handed over, or failed to come
+            bool headersDone = false;
+        };
+
         struct RequestData
         {
 
             RequestData(Async::Resolver resolve, Async::Rejection reject,
-                        const Http::Request& request, OnDone onDone)
+                        const Http::Request& request, OnDone onDone,
+                        std::shared_ptr<Stream> stream = nullptr)
                 : resolve(std::move(resolve))
                 , reject(std::move(reject))
                 , request(request)
                 , onDone(std::move(onDone))
+                , stream(std::move(stream))
             { }
             Async::Resolver resolve;
             Async::Rejection reject;
 
             Http::Request request;
             OnDone onDone;
+            std::shared_ptr<Stream> stream;
         };
 
-        enum State : uint32_t { Idle,
-                                Used };
-
         enum ConnectionState { NotConnected,
                                Connecting,
                                Connected };
 
+        // Resolves addr on the calling thread
         void connect(const Address& addr);
+        // Resolves host with resolver, then connects from the thread of the
+        // transport
+        void connect(const std::shared_ptr<Dns::Resolver>& resolver,
+                     const std::string& host, Port port);
+        // Races connections to addresses, in their order: the next one is
+        // tried when the last attempt fails, or goes unanswered for
+        // Default::ConnectionAttemptDelay, and the first to connect is kept.
+        // The requests queued are rejected when none does.
+        void connect(std::vector<IP> addresses);
+        // Rejects the requests queued, as the connection will not be made
+        void failConnect(const std::string& error);
         void close();
         bool isIdle() const;
-        bool tryUse();
-        void setAsIdle();
+        // The requests given to the connection by its pool and not done yet
+        size_t inFlight() const;
         bool isConnected() const;
+        bool isConnecting() const;
         bool hasTransport() const;
         void associateTransport(const std::shared_ptr<Transport>& transport);
 
@@ -86,56 +127,122 @@ namespace Pistache::Http::Experimental
                                               OnDone onDone);
 
         void performImpl(const Http::Request& request, Async::Resolver resolve,
-                         Async::Rejection reject, OnDone onDone);
+                         Async::Rejection reject, OnDone onDone,
+                         std::shared_ptr<Stream> stream = nullptr);
+        // Queues the request, to be sent once connected
+        void asyncPerformImpl(const Http::Request& request, Async::Resolver resolve,
+                              Async::Rejection reject, OnDone onDone,
+                              std::shared_ptr<Stream> stream = nullptr);
 
         Fd fd() const;
         void handleResponsePacket(const char* buffer, size_t totalBytes);
+        // Whether the response coming in is streamed, its body to be handed
+        // over as it is read rather than once all of it was
+        bool isStreaming() const;
+        // Whether the reader of the response coming in paused, for the
+        // socket not to be read until it resumes
+        bool isInputPaused() const;
+        // Hands over what was buffered while paused, then has the socket
+        // read again. Runs on the thread of the transport.
+        void resumeInput();
+        // Fails every request sent and not answered yet
         void handleError(const char* error);
-        void handleTimeout();
+        void handleTimeout(const std::shared_ptr<TimerPool::Entry>& timer);
+        // Closes the socket from the thread of the transport, which goes on
+        // handling its other connections, unlike with close()
+        void disconnect();
 
         std::string dump() const;
 
     private:
+        friend class ConnectionPool;
+        friend class Transport;
+
         void processRequestQueue();
 
+        // A socket being connected to one of candidates_
+        struct Attempt
+        {
+            Fd fd;
+            size_t index;
+            TimerWheel::TimerId timeout;
+        };
+
+        // Runs on the thread of the transport, as do the three below
+        void startAttempt();
+        void attemptConnected(Fd fd);
+        void attemptFailed(Fd fd);
+        // Closes the sockets of the attempts under way
+        void abandonAttempts();
+
         struct RequestEntry
         {
             RequestEntry(Async::Resolver resolve, Async::Rejection reject,
-                         std::shared_ptr<TimerPool::Entry> timer, OnDone onDone)
+                         std::shared_ptr<TimerPool::Entry> timer, OnDone onDone,
+                         std::shared_ptr<Stream> stream)
                 : resolve(std::move(resolve))
                 , reject(std::move(reject))
                 , timer(std::move(timer))
                 , onDone(std::move(onDone))
+                , stream(std::move(stream))
             { }
 
             Async::Resolver resolve;
             Async::Rejection reject;
             std::shared_ptr<TimerPool::Entry> timer;
             OnDone onDone;
+            std::shared_ptr<Stream> stream;
         };
 
+        // Parses what came in, completing the requests it answers
+        void parseResponses();
+
+        // Takes the requests sent, for them to be failed
+        std::deque<std::unique_ptr<RequestEntry>> takeRequestEntries();
+
         Fd fd_;
 
         struct sockaddr_storage saddr;
-        std::unique_ptr<RequestEntry> requestEntry;
-        std::atomic<uint32_t> state_;
+        // The requests sent, in order, their responses coming in the same one
+        std::deque<std::unique_ptr<RequestEntry>> requestEntries;
+        std::atomic<size_t> inFlight_;
+        // Those of the requests in flight that may not be pipelined behind
+        size_t unsafeInFlight_;
+        // The socket is not being read, for a paused reader
+        bool inputStalled_;
         std::atomic<ConnectionState> connectionState_;
         std::shared_ptr<Transport> transport_;
         Queue<RequestData> requestsQueue;
 
+        // The addresses being tried, by connect(), and the attempts under
+        // way to connect to them
+        std::vector<IP> candidates_;
+        size_t nextCandidate_;
+        std::vector<Attempt> attempts_;
+        TimerWheel::TimerId staggerTimer_;
+
         TimerPool timerPool_;
         ResponseParser parser;
     };
 
+    // The connections of a transport to the hosts it sends requests to. A
+    // pool belongs to one transport, and is only used from its thread.
     class ConnectionPool
     {
     public:
         ConnectionPool() = default;
 
-        void init(size_t maxConnectionsPerHost, size_t maxResponseSize);
+        void init(size_t maxConnectionsPerHost, size_t maxResponseSize,
+                  size_t pipelineDepth = Default::PipelineDepth);
 
-        std::shared_ptr<Connection> pickConnection(const std::string& domain);
-        static void releaseConnection(const std::shared_ptr<Connection>& connection);
+        // A connection to send a request to domain on, in use until released:
+        // an idle one, else a new one while there are fewer than
+        // maxConnectionsPerHost, else, when pipelining an idempotent request,
+        // the least busy one that is not full. nullptr when there is none.
+        std::shared_ptr<Connection> pickConnection(const std::string& domain,
+                                                   bool idempotent = true);
+        static void releaseConnection(const std::shared_ptr<Connection>& connection,
+                                      bool idempotent = true);
 
         size_t usedConnections(const std::string& domain) const;
         size_t idleConnections(const std::string& domain) const;
@@ -143,22 +250,33 @@ namespace Pistache::Http::Experimental
         size_t availableConnections(const std::string& domain) const;
 
         void closeIdleConnections(const std::string& domain);
+        // Closes the connections, failing the requests on them, and drops them
         void shutdown();
 
     private:
         using Connections = std::vector<std::shared_ptr<Connection>>;
-        using Lock        = std::mutex;
-        using Guard       = std::lock_guard<Lock>;
 
-        mutable Lock connsLock;
         std::unordered_map<std::string, Connections> conns;
-        size_t maxConnectionsPerHost;
-        size_t maxResponseSize;
+        size_t maxConnectionsPerHost = Default::MaxConnectionsPerHost;
+        size_t maxResponseSize       = Default::MaxResponseSize;
+        size_t pipelineDepth         = Default::PipelineDepth;
     };
 
     class Client;
     class RequestBuilder;
 
+    // A request whose response has its body handed to a reader as it comes
+    // in, rather than kept in the response
+    struct StreamedResponse
+    {
+        // Resolved as soon as the status line and headers are in, with a
+        // response whose body is empty
+        Async::Promise<Response> headers;
+        // Resolved, with that same response, once all of the body was handed
+        // over, or rejected when it could not be
+        Async::Promise<Response> done;
+    };
+
     namespace RequestBuilderAddOns
     {
         std::size_t bodySize(RequestBuilder & rb);
@@ -190,6 +308,14 @@ namespace Pistache::Http::Experimental
 
         Async::Promise<Response> send();
 
+        // Sends the request, having the body of the response handed to reader
+        // as it comes in. The connection holds no more of it than a read
+        // brings, and is not read while the reader is paused. A timeout only
+        // covers the wait for the headers.
+        StreamedResponse stream(std::shared_ptr<BodyReader> reader);
+        // Same, handing each part of the body to onData
+        StreamedResponse stream(std::function<void(const char* data, size_t len)> onData);
+
     private:
         explicit RequestBuilder(Client* const client)
             : client_(client)
@@ -215,18 +341,40 @@ namespace Pistache::Http::Experimental
                 , maxConnectionsPerHost_(Default::MaxConnectionsPerHost)
                 , keepAlive_(Default::KeepAlive)
                 , maxResponseSize_(Default::MaxResponseSize)
+                , pipelineDepth_(Default::PipelineDepth)
+                , maxQueuedRequests_(Default::MaxQueuedRequests)
+                , resolver_(nullptr)
+                , connectTimeout_(Default::ConnectTimeout)
             { }
 
             Options& threads(int val);
             Options& keepAlive(bool val);
             Options& maxConnectionsPerHost(int val);
             Options& maxResponseSize(size_t val);
+            // How many idempotent requests may be sent on a keep-alive
+            // connection before the first one is answered. 1, the default,
+            // disables HTTP/1.1 pipelining.
+            Options& pipelineDepth(size_t val);
+            // How many requests each thread keeps waiting for a connection.
+            // Beyond that, send() blocks until one is sent, or, called from a
+            // thread of the client, rejects the request.
+            Options& maxQueuedRequests(size_t val);
+            // Resolves the hosts requests are sent to. By default, each
+            // client has its own.
+            Options& resolver(std::shared_ptr<Dns::Resolver> val);
+            // How long each address of a host is given to accept a
+            // connection
+            Options& connectTimeout(std::chrono::milliseconds val);
 
         private:
             int threads_;
             int maxConnectionsPerHost_;
             bool keepAlive_;
             size_t maxResponseSize_;
+            size_t pipelineDepth_;
+            size_t maxQueuedRequests_;
+            std::shared_ptr<Dns::Resolver> resolver_;
+            std::chrono::milliseconds connectTimeout_;
         };
 
         Client();
@@ -241,42 +389,28 @@ namespace Pistache::Http::Experimental
         RequestBuilder patch(const std::string& resource);
         RequestBuilder del(const std::string& resource);
 
+        // The requests waiting for a connection, on all threads
+        size_t queuedRequests() const;
+
         void shutdown();
 
     private:
-        using Lock  = std::mutex;
-        using Guard = std::lock_guard<Lock>;
-
         std::shared_ptr<Aio::Reactor> reactor_;
+        std::shared_ptr<Dns::Resolver> resolver_;
 
-        ConnectionPool pool;
+        // One per thread, each with its own connections
+        std::vector<std::shared_ptr<Transport>> transports_;
         Aio::Reactor::Key transportKey;
 
         std::atomic<uint64_t> ioIndex;
-
-        // Note: queuesLock is declared before requestsQueues. This means that
-        // when Client destructor is called, since members are destroyed in
-        // reverse order of their declaration, requestsQueues will be destroyed
-        // before queuesLock. Since we use queuesLock and
-        // stopProcessRequestQueues to determine if we're allowed to access the
-        // queues, we want to make sure they still exist at the moment we have
-        // to make that determination.
-        // I'm not sure if this ordering is necessary, but it may provide some
-        // protection if destructor tries (indirectly) to access requestsQueues
-        Lock queuesLock;
-        bool stopProcessRequestQueues;
-
-        std::unordered_map<std::string,
-                           MPMCQueue<std::shared_ptr<Connection::RequestData>, 2048>>
-            requestsQueues;
+        std::atomic<bool> stopped_;
 
     private:
         RequestBuilder prepareRequest(const std::string& resource,
                                       Http::Method method);
 
-        Async::Promise<Response> doRequest(Http::Request request);
-
-        void processRequestQueue();
+        Async::Promise<Response> doRequest(Http::Request request,
+                                           std::shared_ptr<Connection::Stream> stream = nullptr);
     };
 
 } // namespace Pistache::Http
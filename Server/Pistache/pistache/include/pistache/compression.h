@@ -0,0 +1,188 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* compression.h
+
+   Compression of response bodies with a content encoding.
+
+   compress() encodes a body with any of the encodings Pistache was built
+   with. A Compressor, set on an endpoint, decides how responses get there:
+   bodies below a minimum size are sent as they are, as compressing them
+   costs more than it saves. Compressed bodies are kept in a cache of
+   bounded size, keyed by a hash of their content along with the encoding
+   and level, so that the same body is only compressed once; a hit is
+   compared with the body it was made from, and never served for another.
+   Bodies above a larger size are compressed on the Compressor's own
+   threads instead of the transport's, the response being queued on the
+   peer's transport once they are.
+*/
+
+#pragma once
+
+#include <pistache/http_header.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Pistache::Http
+{
+
+    // Throws a std::runtime_error for an encoding Pistache was not built
+    // with, or when the encoder fails. The level is the encoder's own, as
+    // set on a ResponseWriter.
+    std::string compress(Header::Encoding encoding, int level,
+                         const char* data, size_t size);
+
+    class Compressor
+    {
+    public:
+        static constexpr size_t DefaultMinSize      = 1024;
+        static constexpr size_t DefaultAsyncMinSize = 256 * 1024;
+        static constexpr size_t DefaultThreads      = 1;
+
+        static constexpr size_t DefaultMaxCachedBodies = 256;
+        static constexpr size_t DefaultMaxCacheMemory  = 16 * 1024 * 1024;
+        static constexpr size_t DefaultMaxCachedSize   = 1024 * 1024;
+
+        struct Options
+        {
+            friend class Compressor;
+
+            // Smaller bodies are sent uncompressed
+            Options& minSize(size_t val);
+            // Bodies this large or larger are compressed on the Compressor's
+            // threads
+            Options& asyncMinSize(size_t val);
+            // With no threads, every body is compressed where it is sent
+            Options& threads(size_t val);
+
+            // The memory counts both the bodies and their compressed form.
+            // Larger bodies are not cached.
+            Options& maxCachedBodies(size_t val);
+            Options& maxCacheMemory(size_t val);
+            Options& maxCachedSize(size_t val);
+
+        private:
+            Options();
+
+            size_t minSize_;
+            size_t asyncMinSize_;
+            size_t threads_;
+
+            size_t maxCachedBodies_;
+            size_t maxCacheMemory_;
+            size_t maxCachedSize_;
+        };
+
+        static Options options();
+
+        explicit Compressor(const Options& options = Compressor::options());
+        // Runs what was posted, then joins the threads
+        ~Compressor();
+
+        Compressor(const Compressor&)            = delete;
+        Compressor& operator=(const Compressor&) = delete;
+
+        bool shouldCompress(size_t size) const { return size >= minSize_; }
+        bool compressesAsync(size_t size) const
+        {
+            return threads_ > 0 && size >= asyncMinSize_;
+        }
+
+        // The cached compressed form of data, nullptr when there is none
+        std::shared_ptr<const std::string> find(Header::Encoding encoding, int level,
+                                                const char* data, size_t size);
+
+        // Compresses data unless found in the cache, then caches it when it
+        // is small enough
+        std::shared_ptr<const std::string> compress(Header::Encoding encoding, int level,
+                                                    const char* data, size_t size);
+
+        // Has task run on one of the threads, or right away when there are
+        // none
+        void post(std::function<void()> task);
+        // Until everything posted so far has run
+        void wait();
+
+        size_t cacheSize() const;
+        size_t cacheMemoryUsage() const;
+        uint64_t cacheHits() const;
+        void clearCache();
+
+    private:
+        struct Key
+        {
+            uint64_t hash;
+            size_t size;
+            Header::Encoding encoding;
+            int level;
+
+            bool operator==(const Key& other) const
+            {
+                return hash == other.hash && size == other.size && encoding == other.encoding && level == other.level;
+            }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct Entry
+        {
+            Key key;
+            std::string body;
+            std::shared_ptr<const std::string> compressed;
+        };
+
+        using Lru = std::list<Entry>;
+
+        static Key makeKey(Header::Encoding encoding, int level,
+                           const char* data, size_t size);
+
+        std::shared_ptr<const std::string> lookup(const Key& key, std::string_view body);
+        void insert(const Key& key, std::string_view body,
+                    std::shared_ptr<const std::string> compressed);
+        void erase(Lru::iterator it);
+
+        void start();
+        void run();
+
+        size_t minSize_;
+        size_t asyncMinSize_;
+        size_t threads_;
+
+        size_t maxCachedBodies_;
+        size_t maxCacheMemory_;
+        size_t maxCachedSize_;
+
+        Lru lru_;
+        std::unordered_map<Key, Lru::iterator, KeyHash> index_;
+        size_t memory_ = 0;
+        uint64_t hits_ = 0;
+        mutable std::mutex cacheMutex_;
+
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> tasks_;
+        size_t running_ = 0;
+        bool stopping_  = false;
+        std::mutex tasksMutex_;
+        std::condition_variable tasksCond_;
+        std::condition_variable idleCond_;
+    };
+
+} // namespace Pistache::Http
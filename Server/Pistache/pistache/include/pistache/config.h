@@ -28,8 +28,14 @@ namespace Pistache::Const
     static constexpr auto DefaultHeaderTimeout       = std::chrono::seconds(60);
     static constexpr auto DefaultBodyTimeout         = std::chrono::seconds(60);
     static constexpr auto DefaultKeepaliveTimeout    = std::chrono::seconds(300);
+    static constexpr auto DefaultIdleTimeout         = std::chrono::seconds(60);
     static constexpr auto DefaultSSLHandshakeTimeout = std::chrono::seconds(10);
     static constexpr size_t ChunkSize                = 1024;
 
+    // Bytes queued for a peer past which a ResponseStream stops being
+    // writable, and down to which they must drain for it to be again
+    static constexpr size_t DefaultStreamHighWaterMark = 1024 * 1024;
+    static constexpr size_t DefaultStreamLowWaterMark  = 256 * 1024;
+
     static constexpr uint16_t HTTP_STANDARD_PORT = 80;
 } // namespace Pistache::Const
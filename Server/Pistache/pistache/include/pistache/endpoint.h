@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <pistache/compression.h>
 #include <pistache/http.h>
 #include <pistache/listener.h>
+#include <pistache/metrics.h>
 #include <pistache/net.h>
 #include <pistache/transport.h>
 
@@ -43,6 +45,9 @@ namespace Pistache::Http
 
             Options& maxRequestSize(size_t val);
             Options& maxResponseSize(size_t val);
+            // Initial size of each connection's receive buffer, which then
+            // grows as needed up to maxRequestSize
+            Options& receiveBufferSize(size_t val);
 
             template <typename Duration>
             Options& headerTimeout(Duration timeout)
@@ -65,6 +70,18 @@ namespace Pistache::Http
                 return *this;
             }
 
+            // How long a connection may go without anything being read from
+            // or written to it while a request body is being received, or
+            // while a response the client does not take is waiting to be
+            // written. Unlike the body timeout, it starts again with every
+            // byte that goes through.
+            template <typename Duration>
+            Options& idleTimeout(Duration timeout)
+            {
+                idleTimeout_ = std::chrono::duration_cast<std::chrono::milliseconds>(timeout);
+                return *this;
+            }
+
             template <typename Duration>
             Options& sslHandshakeTimeout(Duration timeout)
             {
@@ -74,6 +91,23 @@ namespace Pistache::Http
 
             Options& logger(PISTACHE_STRING_LOGGER_T logger);
 
+            // Each worker accepts on its own SO_REUSEPORT socket instead of
+            // having connections accepted on one thread and dispatched to it.
+            // See Tcp::Listener::setPerWorkerAccept.
+            Options& perWorkerAccept(bool val);
+            // In per-worker accept mode, have the kernel hand a connection to
+            // the worker matching the CPU it arrived on
+            Options& acceptCpuSteering(bool val);
+            // How accepted connections are spread over the worker threads.
+            // See Tcp::DispatchPolicy.
+            Options& dispatchPolicy(Tcp::DispatchPolicy val);
+            // What the worker threads poll connections with. See
+            // Polling::Backend.
+            Options& pollingBackend(Polling::Backend val);
+            // What the bodies of responses given a content encoding are
+            // compressed through. See Compressor.
+            Options& compressor(std::shared_ptr<Compressor> val);
+
             [[deprecated("Replaced by maxRequestSize(val)")]] Options&
             maxPayload(size_t val);
 
@@ -99,6 +133,16 @@ namespace Pistache::Http
             PISTACHE_STRING_LOGGER_T logger_;
             // This should be moved after "keepaliveTimeout_" in the next ABI change
             std::chrono::milliseconds sslHandshakeTimeout_;
+
+            bool perWorkerAccept_;
+            bool acceptCpuSteering_;
+            Tcp::DispatchPolicy dispatchPolicy_;
+            // This should be moved after "maxResponseSize_" in the next ABI change
+            size_t receiveBufferSize_;
+            Polling::Backend pollingBackend_;
+            std::shared_ptr<Compressor> compressor_;
+            // This should be moved after "keepaliveTimeout_" in the next ABI change
+            std::chrono::milliseconds idleTimeout_;
             Options();
         };
         Endpoint();
@@ -197,6 +241,10 @@ namespace Pistache::Http
         Async::Promise<Tcp::Listener::Load>
         requestLoad(const Tcp::Listener::Load& old);
 
+        // The metrics of each worker, as recorded so far. Cheap enough to be
+        // called on every scrape: see Rest::Routes::Prometheus.
+        Metrics::Snapshot metrics();
+
         static Options options();
 
         std::vector<std::shared_ptr<Tcp::Peer>> getAllPeer();
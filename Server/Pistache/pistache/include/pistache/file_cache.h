@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* file_cache.h
+
+   The files served by Http::serveFile, kept open along with what their
+   responses need: size, validators and media type.
+
+   Files are looked up by path in a cache of bounded size, the least
+   recently used being dropped first. Small files that are asked for again
+   are also read into memory, within a memory budget, so that they are sent
+   along with the headers in a single write.
+
+   On Linux, cached files are watched with inotify and dropped from the
+   cache as soon as they are modified, replaced or removed. Elsewhere, or
+   when a file can not be watched, the file is stat'ed on every lookup, and
+   dropped when it no longer is the one cached.
+
+   A cache can also have serveFile look for precompressed versions of the
+   files next to them: foo.js.br, foo.js.zst and foo.js.gz, which are
+   served in place of foo.js to the clients that accept their encoding.
+   Where inotify watches the directory, those found missing are remembered
+   with foo.js until a file is created there, rather than looked for on
+   every request.
+*/
+
+#pragma once
+
+#include <pistache/http_defs.h>
+#include <pistache/mime.h>
+#include <pistache/stream.h>
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Pistache::Http
+{
+
+    struct CachedFile
+    {
+        std::shared_ptr<const OpenFile> file;
+        size_t size = 0;
+
+        FullDate lastModified;
+        // Strong, as it changes with the size and the modification time,
+        // with a nanosecond resolution where the platform has it
+        std::string etag;
+
+        Mime::MediaType mime;
+
+        // The whole file when it is held in memory, nullptr otherwise
+        std::shared_ptr<const std::string> content;
+    };
+
+    class FileCache
+    {
+    public:
+        static constexpr size_t DefaultMaxFiles            = 1024;
+        static constexpr size_t DefaultMaxMemory           = 16 * 1024 * 1024;
+        static constexpr size_t DefaultMaxInMemoryFileSize = 64 * 1024;
+
+        // Lookups of a file before it is read into memory
+        static constexpr unsigned HotAfter = 2;
+
+        explicit FileCache(size_t maxFiles            = DefaultMaxFiles,
+                           size_t maxMemory           = DefaultMaxMemory,
+                           size_t maxInMemoryFileSize = DefaultMaxInMemoryFileSize);
+        ~FileCache();
+
+        FileCache(const FileCache&)            = delete;
+        FileCache& operator=(const FileCache&) = delete;
+
+        // Throws an HttpError, Not_Found when there is no regular file at path
+        std::shared_ptr<const CachedFile> get(const std::string& path);
+        // nullptr when there is no regular file at path
+        std::shared_ptr<const CachedFile> tryGet(const std::string& path);
+        // tryGet(path + extension), e.g. ".br", for the cached file at path
+        std::shared_ptr<const CachedFile> tryGetSidecar(const std::string& path,
+                                                        const std::string& extension);
+
+        // Off by default. Sidecars older than their file are ignored.
+        void setPrecompressed(bool enabled) { precompressed_ = enabled; }
+        bool isPrecompressed() const { return precompressed_; }
+
+        void invalidate(const std::string& path);
+        void clear();
+
+        size_t size() const;
+        // Bytes of the files held in memory
+        size_t memoryUsage() const;
+
+        // The one used by serveFile when not given another
+        static FileCache& global();
+
+    private:
+        struct Entry
+        {
+            std::string path;
+            std::shared_ptr<const CachedFile> file;
+
+            // Identify the file opened, to tell whether path still names it
+            uint64_t device = 0;
+            uint64_t inode  = 0;
+
+            int watch     = -1;
+            unsigned hits = 0;
+
+            // Of the directory, while sidecars are known to be missing
+            int dirWatch = -1;
+            std::vector<std::string> missingSidecars;
+            // Counts the creations reported in the directory
+            unsigned dirChanges = 0;
+        };
+
+        using Lru = std::list<Entry>;
+
+        std::shared_ptr<const CachedFile> load(const std::string& path, Entry& entry);
+        bool isCurrent(const Entry& entry) const;
+        void promote(Entry& entry);
+
+        void watch(Entry& entry);
+        void unwatch(Entry& entry);
+        bool watchDirectory(Entry& entry);
+        void unwatchDirectory(Entry& entry);
+        void processEvents();
+
+        void erase(Lru::iterator it);
+        void evict();
+
+        size_t maxFiles_;
+        size_t maxMemory_;
+        size_t maxInMemoryFileSize_;
+        std::atomic<bool> precompressed_ { false };
+
+        Lru lru_;
+        std::unordered_map<std::string, Lru::iterator> index_;
+        size_t memory_ = 0;
+
+        // inotify watch descriptor => paths of the entries it watches
+        int inotifyFd_ = -1;
+        std::unordered_map<int, std::vector<std::string>> watches_;
+        // Likewise for the directories watched for sidecars to show up
+        std::unordered_map<int, std::vector<std::string>> dirWatches_;
+
+        mutable std::mutex mutex_;
+    };
+
+} // namespace Pistache::Http
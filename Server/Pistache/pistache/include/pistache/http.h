@@ -14,7 +14,9 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
@@ -88,8 +90,14 @@ namespace Pistache
             class ResponseLineStep;
             class HeadersStep;
             class BodyStep;
+            class PipelineSlot;
+            struct FileResponse;
         } // namespace Private
 
+        class BodyReader;
+        class Compressor;
+        class FileCache;
+
         template <class CharT, class Traits>
         std::basic_ostream<CharT, Traits>& crlf(std::basic_ostream<CharT, Traits>& os)
         {
@@ -189,6 +197,7 @@ namespace Pistache
         namespace Experimental
         {
             class RequestBuilder;
+            struct Connection;
         }
 
         // 5. Request
@@ -272,26 +281,25 @@ namespace Pistache
 
             explicit Timeout(Timeout&& other)
                 : handler(other.handler)
+                , version(other.version)
                 , transport(other.transport)
-                , armed(other.armed)
-                , timerFd(other.timerFd)
+                , timer(other.timer)
                 , peer(std::move(other.peer))
             {
                 // cppcheck-suppress useInitializationList
-                other.timerFd = PS_FD_EMPTY;
-                // For libevent, don't need to free, passed to this->timerFd
+                other.timer = TimerWheel::NoTimer;
             }
 
             Timeout& operator=(Timeout&& other)
             {
+                disarm();
+
                 handler   = other.handler;
-                transport = other.transport;
                 version   = other.version;
-                armed     = other.armed;
-                timerFd   = other.timerFd;
+                transport = other.transport;
+                timer     = other.timer;
 
-                other.timerFd = PS_FD_EMPTY;
-                // For libevent, don't need to free, passed to this->timerFd
+                other.timer = TimerWheel::NoTimer;
 
                 peer = std::move(other.peer);
                 return *this;
@@ -302,35 +310,7 @@ namespace Pistache
             template <typename Duration>
             void arm(Duration duration)
             {
-                Async::Promise<uint64_t> p([duration, this](Async::Deferred<uint64_t> deferred) {
-#ifdef _USE_LIBEVENT
-                    std::shared_ptr<EventMethEpollEquiv>
-                        event_meth_epoll_equiv(
-                            transport->getEventMethEpollEquiv());
-                    if (!event_meth_epoll_equiv)
-                        throw std::runtime_error(
-                            "event_meth_epoll_equiv null");
-
-                    timerFd = TRY_NULL_RET(EventMethFns::em_timer_new(
-                        PST_CLOCK_MONOTONIC,
-                        F_SETFDL_NOTHING, PST_O_NONBLOCK,
-                        event_meth_epoll_equiv.get()));
-#else
-                    timerFd = TRY_RET(timerfd_create(PST_CLOCK_MONOTONIC, TFD_NONBLOCK));
-#endif
-                    transport->armTimer(timerFd, duration, std::move(deferred));
-                });
-
-                p.then(
-                    [this](uint64_t numWakeup) {
-                        this->armed = false;
-                        this->onTimeout(numWakeup);
-                        CLOSE_FD(timerFd);
-                        timerFd = PS_FD_EMPTY;
-                    },
-                    [](std::exception_ptr exc) { std::rethrow_exception(exc); });
-
-                armed = true;
+                armMs(std::chrono::duration_cast<std::chrono::milliseconds>(duration));
             }
 
             void disarm();
@@ -338,18 +318,19 @@ namespace Pistache
             bool isArmed() const;
 
         private:
-            Timeout(const Timeout& other) = default;
+            // The copy is not armed, even when other is
+            Timeout(const Timeout& other);
 
             Timeout(Tcp::Transport* transport_, Http::Version version, Handler* handler_,
                     std::weak_ptr<Tcp::Peer> peer_);
 
+            void armMs(std::chrono::milliseconds value);
             void onTimeout(uint64_t numWakeup);
 
             Handler* handler;
             Http::Version version;
             Tcp::Transport* transport;
-            bool armed;
-            Fd timerFd;
+            TimerWheel::TimerId timer;
             std::weak_ptr<Tcp::Peer> peer;
         };
 
@@ -367,8 +348,27 @@ namespace Pistache
 
             std::streamsize write(const char* data, std::streamsize sz);
 
-            void flush();
-            void ends();
+            // Queues what was written so far. The promise is resolved once it
+            // has all been written to the socket.
+            Async::Promise<PST_SSIZE_T> flush();
+            Async::Promise<PST_SSIZE_T> ends();
+
+            // A producer that outpaces the client should hold off once the
+            // stream is not writable, and go on from onWritable(). Bytes are
+            // counted as queued for the connection, by this stream or by
+            // whatever was sent on it before.
+            void setWaterMarks(size_t high, size_t low);
+            size_t highWaterMark() const { return highWaterMark_; }
+            size_t lowWaterMark() const { return lowWaterMark_; }
+
+            size_t queuedBytes() const;
+            // Whether fewer than the high water mark bytes are queued
+            bool isWritable() const;
+
+            // Calls callback once no more than the low water mark bytes are
+            // queued, on the transport thread, or right away if that is
+            // already the case. Only the last callback set is kept.
+            void onWritable(std::function<void()> callback);
 
         private:
             ResponseStream(Message&& other, std::weak_ptr<Tcp::Peer> peer,
@@ -382,6 +382,10 @@ namespace Pistache
             DynamicStreamBuf buf_;
             Tcp::Transport* transport_;
             Timeout timeout_;
+            std::shared_ptr<Private::PipelineSlot> pipelineSlot_;
+
+            size_t highWaterMark_ = Const::DefaultStreamHighWaterMark;
+            size_t lowWaterMark_  = Const::DefaultStreamLowWaterMark;
         };
 
         inline ResponseStream& ends(ResponseStream& stream)
@@ -435,8 +439,7 @@ namespace Pistache
         public:
             static constexpr size_t DefaultStreamSize = 512;
 
-            friend Async::Promise<PST_SSIZE_T>
-            serveFile(ResponseWriter&, const std::string&, const Mime::MediaType&);
+            friend struct Private::FileResponse;
 
             friend class Handler;
             friend class Timeout;
@@ -467,6 +470,10 @@ namespace Pistache
             Async::Promise<PST_SSIZE_T>
             sendMethodNotAllowed(const std::vector<Http::Method>& supportedMethods);
 
+            // When the body is compressed on the threads of the handler's
+            // Compressor (see Compressor::compressesAsync), the writer is
+            // handed over to them: as after stream(), it is left moved-from
+            // and must not be used anymore once send() returns.
             Async::Promise<PST_SSIZE_T> send(Code code, const std::string& body = "",
                                              const Mime::MediaType& mime = Mime::MediaType());
 
@@ -510,6 +517,8 @@ namespace Pistache
 
             DynamicStreamBuf* rdbuf();
 
+            // Adopts the storage of other, which is left empty, so that the
+            // response is serialized into a buffer provided by the caller
             DynamicStreamBuf* rdbuf(DynamicStreamBuf* other);
 
             ResponseWriter clone() const;
@@ -562,6 +571,13 @@ namespace Pistache
 
             Async::Promise<PST_SSIZE_T> putOnWire(const char* data, size_t len);
 
+            // Of the encoder of contentEncoding_
+            int compressionLevel() const;
+            // Hands the writer over to a task of the compressor, *this
+            // being left moved-from
+            Async::Promise<PST_SSIZE_T> compressAsync(int level, const char* data,
+                                                      size_t size);
+
             Response response_;
             std::weak_ptr<Tcp::Peer> peer_;
             DynamicStreamBuf buf_;
@@ -569,7 +585,13 @@ namespace Pistache
             Timeout timeout_;
             PST_SSIZE_T sent_bytes_ = 0;
 
+            // Keeps the next pipelined request on this connection waiting
+            // until this response has been queued for writing
+            std::shared_ptr<Private::PipelineSlot> pipelineSlot_;
+
             Http::Header::Encoding contentEncoding_ = Http::Header::Encoding::Identity;
+            // The handler's, when bodies are to be compressed through one
+            std::shared_ptr<Compressor> compressor_;
 
 #ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
             int contentEncodingBrotliLevel_ = BROTLI_DEFAULT_QUALITY;
@@ -586,10 +608,25 @@ namespace Pistache
 #endif
         };
 
+        // The media type is guessed from the file's extension when not given.
+        // Files are looked up in FileCache::global() unless given a cache.
         Async::Promise<PST_SSIZE_T>
         serveFile(ResponseWriter& writer, const std::string& fileName,
                   const Mime::MediaType& contentType = Mime::MediaType());
 
+        // Also answers conditional GET and HEAD requests with 304 Not
+        // Modified, and requests for ranges of the file with 206 Partial
+        // Content, or 416 when none of the ranges can be satisfied
+        Async::Promise<PST_SSIZE_T>
+        serveFile(const Request& request, ResponseWriter& writer,
+                  const std::string& fileName,
+                  const Mime::MediaType& contentType = Mime::MediaType());
+
+        Async::Promise<PST_SSIZE_T>
+        serveFile(const Request& request, ResponseWriter& writer,
+                  const std::string& fileName, const Mime::MediaType& contentType,
+                  FileCache& cache);
+
         namespace Private
         {
 
@@ -659,13 +696,17 @@ namespace Pistache
 
                 explicit BodyStep(Message* message_)
                     : Step(message_)
-                    , chunk(message_)
+                    , chunk(this)
                     , bytesRead(0)
                 { }
 
                 StepId id() const override { return Id; }
                 State apply(StreamCursor& cursor) override;
 
+                // When set, the body is handed to the reader as it comes in
+                // instead of being kept in the message
+                void setReader(BodyReader* reader) { reader_ = reader; }
+
             private:
                 struct Chunk
                 {
@@ -673,8 +714,8 @@ namespace Pistache
                                   Incomplete,
                                   Final };
 
-                    explicit Chunk(Message* message_)
-                        : message(message_)
+                    explicit Chunk(BodyStep* step_)
+                        : step(step_)
                         , bytesRead(0)
                         , size(-1)
                     { }
@@ -688,7 +729,7 @@ namespace Pistache
                     }
 
                 private:
-                    Message* message;
+                    BodyStep* step;
                     size_t bytesRead;
                     PST_SSIZE_T size;
                     PST_SSIZE_T alreadyAppendedChunkBytes;
@@ -700,8 +741,12 @@ namespace Pistache
                 parseTransferEncoding(StreamCursor& cursor,
                                       const std::shared_ptr<Header::TransferEncoding>& te);
 
+                void consume(const char* data, size_t len);
+                bool paused() const;
+
                 Chunk chunk;
                 size_t bytesRead;
+                BodyReader* reader_ = nullptr;
             };
 
             class ParserBase
@@ -710,6 +755,9 @@ namespace Pistache
                 static constexpr size_t StepsCount = 3;
 
                 explicit ParserBase(size_t maxDataSize);
+                // Parses input straight out of the given buffer, which the
+                // caller fills, rather than out of a copy fed to the parser
+                explicit ParserBase(ArrayStreamBuf<char>& input);
 
                 ParserBase(const ParserBase&)            = delete;
                 ParserBase& operator=(const ParserBase&) = delete;
@@ -721,15 +769,30 @@ namespace Pistache
                 bool feed(const char* data, size_t len);
                 virtual void reset();
                 State parse();
+                // Runs the steps that come before the body; Next once they
+                // all are done
+                State parseHeaders();
 
                 Step* step();
 
+                // Whether the input buffer holds as much as it can
+                bool inputFull() const;
+                // Drops the input already parsed
+                void compactInput();
+
             protected:
+                // Drops up to count bytes of input; returns how many were
+                size_t discardInput(size_t count);
+
+                // Like reset(), but keeps the bytes past the parsed message
+                void resetKeepingUnread();
+
                 std::array<std::unique_ptr<Step>, StepsCount> allSteps;
                 size_t currentStep = 0;
 
             private:
-                ArrayStreamBuf<char> buffer;
+                ArrayStreamBuf<char> ownBuffer;
+                ArrayStreamBuf<char>* buffer;
                 StreamCursor cursor;
             };
 
@@ -741,18 +804,61 @@ namespace Pistache
             {
             public:
                 explicit ParserImpl(size_t maxDataSize);
+                explicit ParserImpl(ArrayStreamBuf<char>& input);
 
                 void reset() override;
 
+                // Gets ready for the next request on the connection, keeping
+                // the bytes of it that were already received
+                void resetForNextRequest();
+
+                // Drops the request being parsed. If the rest of its body is
+                // still to come and its length is known, it is then skipped
+                // as it comes in rather than taken for another request.
+                void discardRequest();
+                // Skips what is left of a discarded request. Returns whether
+                // parsing can go on.
+                bool skipDiscarded();
+
                 std::chrono::steady_clock::time_point time() const
                 {
                     return time_;
                 }
 
+                // While the response to a request is in flight, following
+                // pipelined requests are buffered but not parsed, so that
+                // responses go out in order
+                void setInFlight(const std::shared_ptr<PipelineSlot>& slot)
+                {
+                    inFlight_ = slot;
+                }
+                bool awaitingResponse() const { return !inFlight_.expired(); }
+
+                // Whether the handler was given the headers of the request
+                // being parsed, and chose whether to stream its body
+                bool headersHandled() const { return headersHandled_; }
+                void setBodyReader(std::shared_ptr<BodyReader> reader);
+                const std::shared_ptr<BodyReader>& bodyReader() const
+                {
+                    return bodyReader_;
+                }
+
+                // The body of a streamed request is only timed out when none
+                // of it came in for a while, rather than for the whole of it
+                // taking long
+                void touch() { time_ = std::chrono::steady_clock::now(); }
+
                 Request request;
 
             private:
+                BodyStep* bodyStep() const;
+
                 std::chrono::steady_clock::time_point time_;
+                std::weak_ptr<PipelineSlot> inFlight_;
+                size_t bytesToSkip_ = 0;
+
+                bool headersHandled_ = false;
+                std::shared_ptr<BodyReader> bodyReader_;
             };
 
             template <>
@@ -761,7 +867,29 @@ namespace Pistache
             public:
                 explicit ParserImpl(size_t maxDataSize);
 
+                void reset() override;
+
+                // Gets ready for the next response on the connection, keeping
+                // the bytes of it that were already received, as pipelined
+                // requests get
+                void resetForNextResponse();
+
+                // Whether the headers of the response being parsed were handed
+                // over, and the reader of its body set if it is streamed
+                bool headersHandled() const { return headersHandled_; }
+                void setBodyReader(std::shared_ptr<BodyReader> reader);
+                const std::shared_ptr<BodyReader>& bodyReader() const
+                {
+                    return bodyReader_;
+                }
+
                 Response response;
+
+            private:
+                BodyStep* bodyStep() const;
+
+                bool headersHandled_ = false;
+                std::shared_ptr<BodyReader> bodyReader_;
             };
 
         } // namespace Private
@@ -770,19 +898,75 @@ namespace Pistache
         using RequestParser  = Private::ParserImpl<Http::Request>;
         using ResponseParser = Private::ParserImpl<Http::Response>;
 
+        // Receives the body of a request as it comes in, decoded when it is
+        // chunked, rather than the request holding all of it. Only the input
+        // buffer of the connection is used, however large the body is.
+        //
+        // While paused, nothing more is read from the connection: what was
+        // already received stays buffered, and once the buffer is full the
+        // socket is not read anymore, leaving the client to wait. resume() may
+        // be called from any thread.
+        //
+        // The client takes the body of a response the same way, see
+        // Experimental::RequestBuilder::stream().
+        class BodyReader
+        {
+        public:
+            virtual ~BodyReader() = default;
+
+            // Called on the transport thread; pausing from here stops the
+            // data that follows from being handed over until resumed
+            virtual void onData(const char* data, size_t len) = 0;
+
+            void pause();
+            void resume();
+            bool isPaused() const;
+
+        private:
+            friend class Handler;
+            friend struct Experimental::Connection;
+
+            std::atomic<bool> paused_ { false };
+            // Has the connection read again, set by whoever reads it
+            std::function<void()> resumeInput_;
+        };
+
         class Handler : public Tcp::Handler
         {
         public:
             static constexpr const char* ParserData = "__Parser";
 
+            // Called once the headers of a request are in, before its body.
+            // Returning a reader has the body handed to it as it comes in;
+            // onRequest() is then called once all of it has been, with a
+            // request whose body() is empty. Returning nullptr, as is done by
+            // default, has the whole body kept in the request, which must then
+            // fit in the max request size.
+            virtual std::shared_ptr<BodyReader> onRequestHeaders(const Request& request);
+
             virtual void onRequest(const Request& request, ResponseWriter response) = 0;
 
+            // Called with the request the connection parsed, which it is done
+            // with once this returns: unlike with onRequest(), the request may
+            // be modified in place or moved from rather than copied. Calls
+            // onRequest() by default.
+            virtual void onMutableRequest(Request& request, ResponseWriter response);
+
             virtual void onTimeout(const Request& request, ResponseWriter response);
 
             void setMaxRequestSize(size_t value);
             size_t getMaxRequestSize() const;
             void setMaxResponseSize(size_t value);
             size_t getMaxResponseSize() const;
+            // Initial size of the buffer a connection's input is read into.
+            // It grows as needed up to the max request size.
+            void setReceiveBufferSize(size_t value);
+            size_t getReceiveBufferSize() const;
+            // Has the bodies of the responses given a content encoding be
+            // compressed through compressor. See Compressor. Without one, as
+            // by default, every such body is compressed as it is sent.
+            void setCompressor(std::shared_ptr<Compressor> compressor);
+            const std::shared_ptr<Compressor>& getCompressor() const;
 
             template <typename Duration>
             void setHeaderTimeout(Duration timeout)
@@ -816,8 +1000,10 @@ namespace Pistache
                          const std::shared_ptr<Tcp::Peer>& peer) override;
 
         private:
-            size_t maxRequestSize_  = Const::DefaultMaxRequestSize;
-            size_t maxResponseSize_ = Const::DefaultMaxResponseSize;
+            size_t maxRequestSize_    = Const::DefaultMaxRequestSize;
+            size_t maxResponseSize_   = Const::DefaultMaxResponseSize;
+            size_t receiveBufferSize_ = Const::MaxBuffer;
+            std::shared_ptr<Compressor> compressor_;
 
             std::chrono::milliseconds headerTimeout_ = Const::DefaultHeaderTimeout;
             std::chrono::milliseconds bodyTimeout_   = Const::DefaultBodyTimeout;
@@ -551,6 +551,30 @@ namespace Pistache::Http::Header
         FullDate fullDate_;
     };
 
+    // The entity tag is kept as sent, quotes and weakness indicator included
+    class ETag : public Header
+    {
+    public:
+        NAME("ETag")
+
+        ETag()
+            : tag_()
+        { }
+
+        explicit ETag(std::string tag)
+            : tag_(std::move(tag))
+        { }
+
+        void parse(const std::string& data) override;
+        void write(std::ostream& os) const override;
+
+        std::string tag() const { return tag_; }
+        bool isWeak() const { return tag_.compare(0, 2, "W/") == 0; }
+
+    private:
+        std::string tag_;
+    };
+
     class Expect : public Header
     {
     public:
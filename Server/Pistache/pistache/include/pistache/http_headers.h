@@ -14,7 +14,10 @@
 
 #include <algorithm>
 #include <functional>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -52,6 +55,7 @@ namespace Pistache::Http::Header
 
     bool LowercaseEqualStatic(const std::string& dynamic,
                               const std::string& statik);
+    bool LowercaseEqualStatic(std::string_view dynamic, std::string_view statik);
 
     struct LowercaseEqual
     {
@@ -88,13 +92,13 @@ namespace Pistache::Http::Header
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<const H>>::type
         tryGet() const
         {
-            return std::static_pointer_cast<const H>(tryGet(H::Name));
+            return std::static_pointer_cast<const H>(getImpl(H::Name).second);
         }
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, std::shared_ptr<H>>::type
         tryGet()
         {
-            return std::static_pointer_cast<H>(tryGet(H::Name));
+            return std::static_pointer_cast<H>(getImpl(H::Name).second);
         }
 
         Collection& add(const std::shared_ptr<Header>& header);
@@ -124,31 +128,73 @@ namespace Pistache::Http::Header
         template <typename H>
         typename std::enable_if<IsHeader<H>::value, bool>::type has() const
         {
-            return has(H::Name);
+            return getImpl(H::Name).first;
         }
         bool has(const std::string& name) const;
 
         std::vector<std::shared_ptr<Header>> list() const;
 
         const std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>&
-        rawList() const
-        {
-            return rawHeaders;
-        }
+        rawList() const;
 
         bool remove(const std::string& name);
 
         void clear();
 
+        // Used when parsing a message. The header section is kept as a
+        // single copy, and each header line is only recorded as where its
+        // name and value lie in it: the typed header is built when it is
+        // first looked up, and the Raw one when it is asked for.
+        std::string_view keepRawSection(const char* data, size_t len);
+        // name and value must lie in the last section kept
+        void addLazy(std::string_view name, std::string_view value);
+
     private:
+        struct LazyHeader
+        {
+            uint32_t name;
+            uint32_t nameLen;
+            uint32_t value;
+            uint32_t valueLen;
+            // Among the names known to Pistache, or -1
+            int8_t known;
+            bool typedRemoved;
+            // Removed, or moved to rawHeaders
+            bool rawRemoved;
+            // Built by the const getters, which may be called from several
+            // threads at once: only read and set with std::atomic_load and
+            // std::atomic_compare_exchange_strong
+            std::shared_ptr<Header> typed;
+        };
+
+        // Guards the Raw headers rawList() makes of the lazy ones. A copy of
+        // the collection gets a mutex of its own.
+        struct RawMutex
+        {
+            RawMutex() = default;
+            RawMutex(const RawMutex&) { }
+            RawMutex& operator=(const RawMutex&) { return *this; }
+
+            std::mutex mutex;
+        };
+
         std::pair<bool, std::shared_ptr<Header>>
-        getImpl(const std::string& name) const;
+        getImpl(std::string_view name) const;
+
+        LazyHeader* findLazy(std::string_view name) const;
+        std::shared_ptr<Header> makeTyped(LazyHeader& lazy) const;
+        std::string_view lazyName(const LazyHeader& lazy) const;
+        std::string_view lazyValue(const LazyHeader& lazy) const;
 
         std::unordered_map<std::string, std::shared_ptr<Header>, LowercaseHash,
                            LowercaseEqual>
             headers;
-        std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>
+        mutable std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>
             rawHeaders;
+
+        std::string rawSection_;
+        mutable std::vector<LazyHeader> lazyHeaders_;
+        mutable RawMutex rawMutex_;
     };
 
     class Registry
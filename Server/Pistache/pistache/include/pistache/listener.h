@@ -18,6 +18,7 @@
 #include <pistache/config.h>
 #include <pistache/flags.h>
 #include <pistache/log.h>
+#include <pistache/metrics.h>
 #include <pistache/net.h>
 #include <pistache/os.h>
 #include <pistache/reactor.h>
@@ -27,6 +28,7 @@
 #include PST_SYS_RESOURCE_HDR
 
 #include <memory>
+#include <random>
 #include <thread>
 #include <vector>
 
@@ -42,6 +44,16 @@ namespace Pistache::Tcp
 
     void setSocketOptions(Fd fd, Flags<Options> options);
 
+    // How the listener picks the worker a newly accepted peer goes to
+    enum class DispatchPolicy {
+        // Spread by fd number (or by a counter on Windows), regardless of load
+        RoundRobin,
+        // Worker with the fewest live peers, ties going to the least busy one
+        LeastConnections,
+        // The less loaded of two workers picked at random
+        PowerOfTwoChoices
+    };
+
     class Listener
     {
     public:
@@ -53,6 +65,10 @@ namespace Pistache::Tcp
 
             std::vector<PST_RUSAGE> raw;
             TimePoint tick;
+
+            // Per worker, live peers and total time spent handling events
+            std::vector<size_t> connections;
+            std::vector<std::chrono::nanoseconds> busy;
         };
 
         using TransportFactory = std::function<std::shared_ptr<Transport>()>;
@@ -70,6 +86,24 @@ namespace Pistache::Tcp
         void setTransportFactory(TransportFactory factory);
         void setHandler(const std::shared_ptr<Handler>& handler);
 
+        // When enabled, every worker gets its own SO_REUSEPORT listening
+        // socket and accepts connections itself, instead of having them
+        // accepted on a single thread and dispatched. With cpuSteering, a
+        // BPF program makes the kernel pick the socket of the worker matching
+        // the CPU the connection arrived on. Must be called before bind().
+        // Falls back to a single acceptor where unsupported (non-Linux
+        // platforms, unix domain sockets).
+        void setPerWorkerAccept(bool enable, bool cpuSteering = false);
+
+        // Defaults to DispatchPolicy::RoundRobin. Has no effect on
+        // connections accepted by the workers themselves (see
+        // setPerWorkerAccept).
+        void setDispatchPolicy(DispatchPolicy policy);
+
+        // What the workers poll their fds with, Polling::Backend::Epoll by
+        // default. Must be called before bind().
+        void setPollingBackend(Polling::Backend backend);
+
         void bind();
         void bind(const Address& address);
 
@@ -83,6 +117,10 @@ namespace Pistache::Tcp
 
         Async::Promise<Load> requestLoad(const Load& old);
 
+        // The metrics of each worker, read without waiting for it. Empty
+        // until the listener runs.
+        std::vector<Metrics::Worker> metrics();
+
         Options options() const;
         Address address() const;
 
@@ -117,10 +155,20 @@ namespace Pistache::Tcp
         TransportFactory defaultTransportFactory() const;
 
         bool bindListener(const struct addrinfo* addr);
+        bool usePerWorkerAccept(int family) const;
+        void setupWorkerAcceptors(const struct addrinfo* addr, int socktype,
+                                  Flags<Options> options);
 
         void handleNewConnection();
-        em_socket_t acceptConnection(struct sockaddr_storage& peer_addr) const;
+        std::shared_ptr<Peer> acceptPeer(Fd listenFd);
+        std::shared_ptr<Peer> adoptPeer(em_socket_t actual_cli_fd);
+        std::shared_ptr<Peer> makePeer(em_socket_t actual_cli_fd,
+                                       struct sockaddr_storage& peer_addr);
+        em_socket_t acceptConnection(Fd listenFd,
+                                     struct sockaddr_storage& peer_addr) const;
         void dispatchPeer(const std::shared_ptr<Peer>& peer);
+        size_t pickWorker(const std::vector<std::shared_ptr<Aio::Handler>>& handlers,
+                          em_socket_t actual_fd);
 
 #ifdef _IS_WINDOWS
         std::atomic<em_socket_t> idxCtr_ = 1;
@@ -132,6 +180,18 @@ namespace Pistache::Tcp
 
         // This should be moved after "ssl_ctx_" in the next ABI change
         std::chrono::milliseconds sslHandshakeTimeout_ = Const::DefaultSSLHandshakeTimeout;
+
+        bool perWorkerAccept_  = false;
+        bool acceptCpuSteering_ = false;
+        // Listening sockets of workers 1..n in per-worker accept mode; worker
+        // 0 uses listen_fd
+        std::vector<Fd> workerListenFds_;
+
+        DispatchPolicy dispatchPolicy_ = DispatchPolicy::RoundRobin;
+        // Only used from the accepting thread
+        std::minstd_rand dispatchRng_ { std::random_device {}() };
+
+        Polling::Backend pollingBackend_ = Polling::Backend::Epoll;
     };
 
 } // namespace Pistache::Tcp
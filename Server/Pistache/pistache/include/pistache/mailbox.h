@@ -11,6 +11,11 @@
 #include <stdexcept>
 
 #include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 
 #include <pistache/winornix.h>
 
@@ -448,6 +453,14 @@ namespace Pistache
     // A Multi-Producer Multi-Consumer bounded queue
     // taken from
     // http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+    //
+    // Each cell sits on a cache line of its own, so that producers and
+    // consumers working on neighbouring cells do not invalidate each other's
+    // lines. The bulk operations claim a whole run of cells with a single CAS.
+    //
+    // wait_dequeue() spins for a while, then parks the consumer on a
+    // condition variable. Producers only take the lock when a consumer is
+    // parked, so the non-blocking operations never make a system call.
     template <typename T, size_t Size>
     class MPMCQueue
     {
@@ -456,6 +469,9 @@ namespace Pistache
                       "The size must be a power of 2");
         static constexpr size_t Mask = Size - 1;
 
+        // Failed attempts before a waiting consumer parks
+        static constexpr size_t SpinCount = 256;
+
     public:
         MPMCQueue(const MPMCQueue& other)            = delete;
         MPMCQueue& operator=(const MPMCQueue& other) = delete;
@@ -465,7 +481,11 @@ namespace Pistache
          * otherwise the client won't compile
          * @Investigate why
          */
-        MPMCQueue(MPMCQueue&& other) { *this = std::move(other); }
+        MPMCQueue(MPMCQueue&& other)
+            : MPMCQueue()
+        {
+            *this = std::move(other);
+        }
 
         MPMCQueue& operator=(MPMCQueue&& other)
         {
@@ -478,7 +498,7 @@ namespace Pistache
             }
 
             enqueueIndex.store(other.enqueueIndex.load(), std::memory_order_relaxed);
-            dequeueIndex.store(other.enqueueIndex.load(), std::memory_order_relaxed);
+            dequeueIndex.store(other.dequeueIndex.load(), std::memory_order_relaxed);
             return *this;
         }
 
@@ -486,6 +506,7 @@ namespace Pistache
             : cells_()
             , enqueueIndex()
             , dequeueIndex()
+            , sleepers_(0)
         {
             for (size_t i = 0; i < Size; ++i)
             {
@@ -496,64 +517,97 @@ namespace Pistache
             dequeueIndex.store(0, std::memory_order_relaxed);
         }
 
+        static constexpr size_t capacity() { return Size; }
+
         template <typename U>
         bool enqueue(U&& data)
         {
-            Cell* target;
-            size_t index = enqueueIndex.load(std::memory_order_relaxed);
-            for (;;)
-            {
-                target     = cell(index);
-                size_t seq = target->sequence.load(std::memory_order_acquire);
-                auto diff  = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(index);
-                if (diff == 0)
-                {
-                    if (enqueueIndex.compare_exchange_weak(index, index + 1,
-                                                           std::memory_order_relaxed))
-                        break;
-                }
+            size_t index;
+            if (claim(enqueueIndex, 0, 1, index) == 0)
+                return false;
 
-                else if (diff < 0)
-                    return false;
-                else
-                {
-                    index = enqueueIndex.load(std::memory_order_relaxed);
-                }
-            }
+            Cell* target = cell(index);
             target->data = std::forward<U>(data);
             target->sequence.store(index + 1, std::memory_order_release);
+
+            wakeConsumers();
             return true;
         }
 
-        bool dequeue(T& data)
+        // Enqueues up to count values, moved from first onwards, and returns
+        // how many were. They stay contiguous in the queue.
+        template <typename It>
+        size_t enqueue_bulk(It first, size_t count)
         {
-            Cell* target;
-            size_t index = dequeueIndex.load(std::memory_order_relaxed);
-            for (;;)
+            size_t index;
+            const size_t claimed = claim(enqueueIndex, 0, count, index);
+
+            for (size_t i = 0; i < claimed; ++i, ++first)
             {
-                target     = cell(index);
-                size_t seq = target->sequence.load(std::memory_order_acquire);
-                auto diff  = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(index + 1);
-                if (diff == 0)
-                {
-                    if (dequeueIndex.compare_exchange_weak(index, index + 1,
-                                                           std::memory_order_relaxed))
-                        break;
-                }
-                else if (diff < 0)
-                    return false;
-                else
-                {
-                    index = dequeueIndex.load(std::memory_order_relaxed);
-                }
+                Cell* target = cell(index + i);
+                target->data = std::move(*first);
+                target->sequence.store(index + i + 1, std::memory_order_release);
             }
-            data = target->data;
+
+            if (claimed > 0)
+                wakeConsumers();
+            return claimed;
+        }
+
+        bool dequeue(T& data)
+        {
+            size_t index;
+            if (claim(dequeueIndex, 1, 1, index) == 0)
+                return false;
+
+            Cell* target = cell(index);
+            data         = std::move(target->data);
             target->sequence.store(index + Mask + 1, std::memory_order_release);
             return true;
         }
 
+        // Moves up to max values out to out onwards and returns how many were
+        template <typename It>
+        size_t dequeue_bulk(It out, size_t max)
+        {
+            size_t index;
+            const size_t claimed = claim(dequeueIndex, 1, max, index);
+
+            for (size_t i = 0; i < claimed; ++i, ++out)
+            {
+                Cell* target = cell(index + i);
+                *out         = std::move(target->data);
+                target->sequence.store(index + i + Mask + 1, std::memory_order_release);
+            }
+
+            return claimed;
+        }
+
+        // Blocks until a value can be dequeued
+        void wait_dequeue(T& data)
+        {
+            waitFor([&] { return dequeue(data); }, nullptr);
+        }
+
+        // Returns false when the queue stayed empty for timeout
+        template <typename Rep, typename Period>
+        bool wait_dequeue_for(T& data, const std::chrono::duration<Rep, Period>& timeout)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            return waitFor([&] { return dequeue(data); }, &deadline);
+        }
+
+        // Blocks until at least one value can be dequeued, then takes up to max
+        template <typename It>
+        size_t wait_dequeue_bulk(It out, size_t max)
+        {
+            size_t dequeued = 0;
+            waitFor([&] { return (dequeued = dequeue_bulk(out, max)) > 0; }, nullptr);
+            return dequeued;
+        }
+
     private:
-        struct Cell
+        struct alignas(CachelineSize) Cell
         {
             Cell()
                 : sequence()
@@ -567,13 +621,102 @@ namespace Pistache
 
         Cell* cell(size_t index) { return &cells_[cellIndex(index)]; }
 
+        // Claims up to count consecutive cells whose sequence is that of
+        // their position plus offset (0 for free cells, 1 for full ones) by
+        // moving position forward. Returns how many were claimed, the first
+        // one being at index.
+        size_t claim(std::atomic<size_t>& position, size_t offset, size_t count,
+                     size_t& index)
+        {
+            if (count == 0)
+                return 0;
+            if (count > Size)
+                count = Size;
+
+            index = position.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                size_t seq = cell(index)->sequence.load(std::memory_order_acquire);
+                auto diff  = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(index + offset);
+                if (diff == 0)
+                {
+                    // A cell ready for its position can only be taken by
+                    // whoever moves position past it, so the run found here
+                    // is ours if the CAS succeeds
+                    size_t ready = 1;
+                    while (ready < count
+                           && cell(index + ready)->sequence.load(std::memory_order_acquire) == index + ready + offset)
+                        ++ready;
+
+                    if (position.compare_exchange_weak(index, index + ready,
+                                                       std::memory_order_relaxed))
+                        return ready;
+                }
+                else if (diff < 0)
+                    return 0;
+                else
+                {
+                    index = position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        template <typename Attempt>
+        bool waitFor(Attempt&& attempt,
+                     const std::chrono::steady_clock::time_point* deadline)
+        {
+            for (size_t i = 0; i < SpinCount; ++i)
+            {
+                if (attempt())
+                    return true;
+                std::this_thread::yield();
+            }
+
+            std::unique_lock<std::mutex> guard(sleepLock_);
+            ++sleepers_;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool done = false;
+            for (;;)
+            {
+                // Checked with the lock held, as producers take it before
+                // notifying: a value enqueued from here on wakes us up
+                if ((done = attempt()))
+                    break;
+
+                if (!deadline)
+                    sleepCond_.wait(guard);
+                else if (sleepCond_.wait_until(guard, *deadline) == std::cv_status::timeout)
+                {
+                    done = attempt();
+                    break;
+                }
+            }
+            --sleepers_;
+            return done;
+        }
+
+        void wakeConsumers()
+        {
+            // Orders the publication of the cell before the read of
+            // sleepers_, which a consumer increments before checking again
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleepers_.load(std::memory_order_relaxed) == 0)
+                return;
+
+            {
+                std::lock_guard<std::mutex> guard(sleepLock_);
+            }
+            sleepCond_.notify_all();
+        }
+
         std::array<Cell, Size> cells_;
 
-        cacheline_pad_t pad0;
-        std::atomic<size_t> enqueueIndex;
+        alignas(CachelineSize) std::atomic<size_t> enqueueIndex;
+        alignas(CachelineSize) std::atomic<size_t> dequeueIndex;
 
-        cacheline_pad_t pad1;
-        std::atomic<size_t> dequeueIndex;
+        alignas(CachelineSize) std::atomic<size_t> sleepers_;
+        std::mutex sleepLock_;
+        std::condition_variable sleepCond_;
     };
 
 } // namespace Pistache
@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* metrics.h
+
+   Runtime metrics of a server.
+
+   Each worker (Tcp::Transport) records what it does in a Recorder of its
+   own: requests, responses by status class, bytes moved, connections,
+   timeouts, and the latency of requests. A Recorder only holds relaxed
+   atomics, so recording costs no lock and no allocation, and it can be read
+   from any thread. The workers' figures are only gathered, and merged, when
+   asked for: see Http::Endpoint::metrics().
+
+   Latencies go into a Histogram whose buckets have a constant relative
+   width, as HdrHistogram has them, so that both short and long ones are
+   known to within a few percent.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Pistache::Metrics
+{
+
+    class Histogram
+    {
+    public:
+        // Each power of two is split in SubBuckets buckets, so a value is
+        // known to within 1 / SubBuckets
+        static constexpr size_t SubBucketBits = 3;
+        static constexpr size_t SubBuckets    = size_t(1) << SubBucketBits;
+        static constexpr size_t BucketCount   = (64 - SubBucketBits + 1) * SubBuckets;
+
+        static size_t bucketOf(uint64_t value);
+        // The values counted in a bucket, both bounds included
+        static uint64_t lowerBound(size_t bucket);
+        static uint64_t upperBound(size_t bucket);
+
+        void record(uint64_t value, uint64_t count = 1);
+        Histogram& operator+=(const Histogram& other);
+
+        uint64_t count() const { return count_; }
+        uint64_t sum() const { return sum_; }
+        uint64_t max() const { return max_; }
+        uint64_t countAt(size_t bucket) const { return counts_[bucket]; }
+
+        // The value that a fraction q (between 0 and 1) of those recorded
+        // are at most, rounded up to the bound of its bucket
+        uint64_t quantile(double q) const;
+        // How many of the values recorded are at most value. Exact when
+        // value is the upper bound of a bucket.
+        uint64_t countAtMost(uint64_t value) const;
+
+    private:
+        friend class Recorder;
+
+        std::array<uint64_t, BucketCount> counts_ {};
+        uint64_t count_ = 0;
+        uint64_t sum_   = 0;
+        uint64_t max_   = 0;
+    };
+
+    // What a worker did since it started
+    struct Worker
+    {
+        uint64_t requests = 0;
+        // Responses by status class, 1xx to 5xx
+        std::array<uint64_t, 5> responses {};
+
+        uint64_t bytesRead    = 0;
+        uint64_t bytesWritten = 0;
+
+        // Connections handed to the worker, and those still open
+        uint64_t connections       = 0;
+        uint64_t activeConnections = 0;
+        // Buffers waiting to be written, to all of its connections
+        uint64_t writeQueueDepth = 0;
+
+        // Requests answered with a 408 for taking too long, and idle
+        // connections dropped by the keep-alive timeout
+        uint64_t requestTimeouts = 0;
+        uint64_t idleTimeouts    = 0;
+
+        // From the request being received in full to the response being
+        // queued, in microseconds
+        Histogram latency;
+
+        Worker& operator+=(const Worker& other);
+    };
+
+    struct Snapshot
+    {
+        std::vector<Worker> workers;
+
+        // All the workers' figures merged
+        Worker total() const;
+    };
+
+    class Recorder
+    {
+    public:
+        void requestReceived() { add(requests_, 1); }
+        void responseSent(int code);
+        void responseSent(int code, std::chrono::steady_clock::duration latency);
+
+        void bytesRead(size_t bytes) { add(bytesRead_, bytes); }
+        void bytesWritten(size_t bytes) { add(bytesWritten_, bytes); }
+        void connectionAccepted() { add(connections_, 1); }
+
+        void requestTimedOut() { add(requestTimeouts_, 1); }
+        void idleTimedOut() { add(idleTimeouts_, 1); }
+
+        // What the counters held when read. Connection and queue figures,
+        // which the recorder does not know, are left to the caller.
+        Worker snapshot() const;
+
+    private:
+        using Counter = std::atomic<uint64_t>;
+
+        static void add(Counter& counter, uint64_t value)
+        {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        Counter requests_ { 0 };
+        std::array<Counter, 5> responses_ {};
+        Counter bytesRead_ { 0 };
+        Counter bytesWritten_ { 0 };
+        Counter connections_ { 0 };
+        Counter requestTimeouts_ { 0 };
+        Counter idleTimeouts_ { 0 };
+
+        std::array<Counter, Histogram::BucketCount> latency_ {};
+        Counter latencySum_ { 0 };
+        Counter latencyMax_ { 0 };
+    };
+
+    // The snapshot in the Prometheus text exposition format, with the
+    // counters of each worker labelled by its index and the latency
+    // histogram of all of them
+    std::string toPrometheus(const Snapshot& snapshot, const std::string& prefix = "pistache");
+
+    // The content type to serve toPrometheus() with
+    extern const char* const PrometheusContentType;
+
+} // namespace Pistache::Metrics
@@ -129,25 +129,82 @@ namespace Pistache
         {
             explicit Event(Tag _tag);
 
+            // Set instead of flags when the poller did the I/O itself
+            enum class Completion { None,
+                                    Received,
+                                    Sent,
+                                    Accepted };
+
             Flags<NotifyOn> flags;
             Tag tag;
+
+            Completion completion = Completion::None;
+            // Received: the bytes, valid until the next poll
+            const char* received = nullptr;
+            // Bytes received or sent, 0 at the end of the stream, the fd of
+            // the connection accepted, or -errno
+            int64_t result = 0;
+        };
+
+        // Bytes handed to Epoll::send
+        struct SendBuffer
+        {
+            const char* data;
+            size_t size;
         };
 
+        // What an Epoll waits for events with. IoUring arms a poll request
+        // per fd on an io_uring, and submits the (re)arming of fds together
+        // with the wait for events instead of with an epoll_ctl each. It can
+        // also accept connections on, receive from, and send to, fds itself
+        // (see addFdAccepting, addFdReceiving and send), the requests for all
+        // the fds of a wakeup then going to the kernel with a single call. It
+        // needs Linux 5.13 or later (5.19 for accepting, 6.0 for receiving)
+        // and a build with PISTACHE_USE_IO_URING; epoll is used instead where
+        // it is not available.
+        enum class Backend { Epoll,
+                             IoUring };
+
         class Epoll
         {
         public:
-            Epoll();
+            explicit Epoll(Backend backend = Backend::Epoll);
             ~Epoll();
 
+            // The backend actually in use
+            Backend backend() const;
+
             void addFd(Fd fd, Flags<NotifyOn> interest, Tag tag,
                        [[maybe_unused]] Mode mode = Mode::Level);
             void addFdOneShot(Fd fd, Flags<NotifyOn> interest, Tag tag,
                               Mode mode = Mode::Level);
 
+            // Has the poller receive from fd itself, into buffers of its own:
+            // each chunk is reported as a Received event, along with the end
+            // of the stream or an error, while interest is only polled for
+            // once fd is rearmed. Returns false, fd being left alone, where
+            // the backend cannot; addFd is then to be used instead.
+            bool addFdReceiving(Fd fd, Flags<NotifyOn> interest, Tag tag);
+
+            // Has the poller accept connections on fd, a listening socket,
+            // itself: each is reported as an Accepted event, its fd being
+            // non-blocking and close-on-exec. Where the backend cannot, false
+            // is returned, fd being left alone; or, should it find out later,
+            // fd is polled for interest, level-triggered, instead.
+            bool addFdAccepting(Fd fd, Flags<NotifyOn> interest, Tag tag);
+
             void removeFd(Fd fd);
             void rearmFd(Fd fd, Flags<NotifyOn> interest, Tag tag,
                          [[maybe_unused]] Mode mode = Mode::Level);
 
+            // Has the poller send buffers to fd, an fd it polls, with the
+            // next wait for events: once done, how much was sent is reported
+            // as a Sent event with the fd's tag. hold is kept until then, for
+            // the bytes to stay valid. Returns false, nothing being sent,
+            // where the backend cannot, or a send is already on its way.
+            bool send(Fd fd, const std::vector<SendBuffer>& buffers, int flags,
+                      std::shared_ptr<const void> hold);
+
             int poll(std::vector<Event>& events, const std::chrono::milliseconds timeout = std::chrono::milliseconds(-1)) const;
 
             // reg_unreg_mutex_ must be locked for a call to poll(...) and
@@ -210,6 +267,11 @@ namespace Pistache
 #else
             Fd epoll_fd;
 #endif
+
+            // Set when the io_uring backend is in use, in which case there is
+            // no epoll_fd
+            class IoUring;
+            std::unique_ptr<IoUring> uring_;
         };
 
     } // namespace Polling
@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include <pistache/async.h>
@@ -50,6 +54,9 @@ namespace Pistache::Tcp
         void setIdle(bool bIdle);
         bool isIdle() const;
 
+        // When something was last read from, or written to, the peer
+        std::chrono::steady_clock::time_point lastActivity() const;
+
         const Address& address() const;
         const std::string& hostname();
         Fd fd() const; // can return PS_FD_EMPTY
@@ -67,6 +74,26 @@ namespace Pistache::Tcp
                                          int flags = 0);
         size_t getID() const;
 
+        // Bytes queued for this peer through Transport::asyncWrite(peer, ...)
+        // and not yet written to the socket, or failed to be
+        size_t queuedBytes() const;
+
+        // Has callback called once no more than lowWaterMark bytes are
+        // queued: on the transport thread as writes complete, or right away
+        // when that is already the case. Replaces any callback not called yet.
+        void onWritable(size_t lowWaterMark, std::function<void()> callback);
+
+        // The buffer the transport reads this peer's input into. Unless
+        // retained, it is emptied after each call to the handler's onInput.
+        ArrayStreamBuf<char>& inputBuffer();
+
+        // Has the input stay buffered across onInput calls, for handlers
+        // that parse it in place and consume it themselves. The buffer then
+        // grows from initialSize up to maxSize; the transport stops reading
+        // from the peer while it is full. Must be called before any input.
+        void retainInput(size_t initialSize, size_t maxSize);
+        bool isInputRetained() const;
+
     protected:
         // (provide default constructor so child class ConcretePeer can have
         //  default constructor)
@@ -81,6 +108,11 @@ namespace Pistache::Tcp
         Transport* transport() const;
         static size_t getUniqueId();
 
+        void addQueued(size_t bytes);
+        void removeQueued(size_t bytes);
+
+        void touch();
+
         Transport* transport_ = nullptr;
 
         Fd fd_ = PS_FD_EMPTY;
@@ -93,6 +125,23 @@ namespace Pistache::Tcp
         void* ssl_ = nullptr;
         const size_t id_;
         bool isIdle_ = false;
+        // Only touched from the transport thread
+        std::chrono::steady_clock::time_point lastActivity_ = std::chrono::steady_clock::now();
+
+        ArrayStreamBuf<char> input_ { Const::MaxBuffer };
+        bool inputRetained_ = false;
+        // Set by the transport when it stopped reading for lack of room
+        bool inputStalled_ = false;
+        // Set while the poller receives the input itself, rather than the
+        // transport reading it once told it is there
+        bool inputReceived_ = false;
+        // Received, but not handed over yet for lack of room
+        std::string heldInput_;
+
+        std::atomic<size_t> queuedBytes_ { 0 };
+        std::mutex writableMutex_;
+        std::function<void()> onWritable_;
+        size_t lowWaterMark_ = 0;
     };
 
     std::ostream& operator<<(std::ostream& os, Peer& peer);
@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/******************************************************************************
+ * pist_asynclog.h
+ *
+ * Asynchronous backend for the PS_LOG_... macros
+ *
+ * Once PSLogStartAsync has been called, a message logged by a thread is not
+ * formatted there: its format string, location and arguments are copied, as
+ * they are, into a record of a ring buffer belonging to that thread, with no
+ * lock taken and no allocation made. A background thread takes the records
+ * out of the rings of all threads, formats them, and has them written to
+ * the sink chosen. When a thread's ring is full its messages are dropped,
+ * and counted, rather than having the thread wait.
+ *
+ * String arguments are copied, up to the room left in the record; other
+ * pointers are only kept as addresses. Messages with arguments the record
+ * can not hold (too many, or of a type printf does not take) are formatted
+ * and written right away, as without the backend.
+ *
+ * #include <pistache/pist_syslog.h>
+ *
+ */
+
+#ifndef INCLUDED_PS_ASYNCLOG_H
+#define INCLUDED_PS_ASYNCLOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*****************************************************************************/
+
+enum class PSLogSink
+{
+    // Through the same path as synchronous messages: syslog, os_log or the
+    // Windows event log
+    Syslog,
+    Stdout,
+    // Appended to the file given to PSLogStartAsync
+    File
+};
+
+// Starts the background thread. _ringRecords is the number of messages each
+// thread may have waiting. Returns false if the file could not be opened, or
+// if the backend is already running.
+bool PSLogStartAsync(PSLogSink _sink, const char * _path = nullptr,
+                     size_t _ringRecords = 256);
+
+// Writes whatever is waiting, then stops the background thread. Messages
+// logged while it stops may be lost.
+void PSLogStopAsync();
+
+// Returns once the messages logged so far, by any thread, are written
+void PSLogFlushAsync();
+
+// Messages dropped because the ring of their thread was full
+uint64_t PSLogAsyncDropped();
+
+/*****************************************************************************/
+
+namespace Pistache::AsyncLog
+{
+    enum class ArgType : uint8_t { Int,
+                                   UInt,
+                                   LongLong,
+                                   ULongLong,
+                                   Double,
+                                   Pointer,
+                                   String };
+
+    static constexpr size_t MaxArgs  = 12;
+    static constexpr size_t TextSize = 320;
+
+    struct Record
+    {
+        int pri;
+        bool andPrintf;
+        int line;
+        const char * file;
+        const char * function;
+        // A string literal, as are file and function, so that it can be
+        // kept by address
+        const char * format;
+        int64_t time; // microseconds since the epoch
+
+        uint8_t argCount;
+        ArgType types[MaxArgs];
+        // Strings are an offset into text, where they are nul-terminated
+        uint64_t values[MaxArgs];
+
+        uint16_t textUsed;
+        char text[TextSize];
+    };
+
+    extern std::atomic<bool> gRunning;
+
+    inline bool isRunning() { return(gRunning.load(std::memory_order_relaxed)); }
+
+    // The next free record of the calling thread's ring, with its time set,
+    // or null if the ring is full. publish() hands it to the background
+    // thread.
+    Record * claim();
+    void publish();
+
+    // Walks the format along with the arguments being encoded, so that a
+    // string is read no further than printf would: up to its precision, if
+    // it has one. The string need not be nul-terminated then. A char
+    // pointer given for anything but a %s is not read at all.
+    class FormatCursor
+    {
+    public:
+        enum class Use : uint8_t { Width,
+                                   Precision,
+                                   Conversion,
+                                   Unknown };
+
+        explicit FormatCursor(const char * _format)
+            : pos_(_format)
+        { }
+
+        // What the next argument is taken for
+        Use next();
+
+        // For a '.*' argument, once its value is known
+        void setPrecision(int _precision) { precision_ = _precision; }
+
+        // Of the conversion just reached, or -1 if it has none
+        int precision() const { return(precision_); }
+
+        // The letter of the conversion just reached, e.g. 's' or 'p'
+        char conversion() const { return(conversion_); }
+
+    private:
+        enum class Stage : uint8_t { Start,
+                                     AfterWidth,
+                                     AfterPrecision };
+
+        const char * pos_;
+        Stage stage_     = Stage::Start;
+        int precision_   = -1;
+        char conversion_ = 0;
+    };
+
+    template <typename T>
+    struct Encodable
+    {
+        using Type = std::decay_t<T>;
+        static constexpr bool value =
+            std::is_integral_v<Type> || std::is_enum_v<Type> ||
+            std::is_same_v<Type, float> || std::is_same_v<Type, double> ||
+            std::is_pointer_v<Type> || std::is_null_pointer_v<Type>;
+    };
+
+    template <typename T>
+    inline void encode(Record & _rec, FormatCursor & _cursor, T _arg)
+    {
+        if constexpr (std::is_enum_v<T>)
+        {
+            encode(_rec, _cursor, static_cast<std::underlying_type_t<T>>(_arg));
+        }
+        else
+        {
+            const uint8_t i = _rec.argCount++;
+            const FormatCursor::Use use = _cursor.next();
+
+            if constexpr (std::is_integral_v<T>)
+            {
+                // As printf gets them: promoted to int, or as wide as they are
+                if constexpr (sizeof(T) <= sizeof(int))
+                    _rec.types[i] = (std::is_signed_v<T> || sizeof(T) < sizeof(int))
+                        ? ArgType::Int : ArgType::UInt;
+                else
+                    _rec.types[i] = std::is_signed_v<T> ? ArgType::LongLong
+                                                        : ArgType::ULongLong;
+                _rec.values[i] = static_cast<uint64_t>(_arg);
+                if (use == FormatCursor::Use::Precision)
+                    _cursor.setPrecision(static_cast<int>(_arg));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                const double value = _arg;
+                _rec.types[i] = ArgType::Double;
+                std::memcpy(&_rec.values[i], &value, sizeof(value));
+            }
+            else if constexpr (std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>)
+            {
+                if ((use != FormatCursor::Use::Conversion) ||
+                    (_cursor.conversion() != 's'))
+                {
+                    // E.g. a buffer logged with %p
+                    _rec.types[i]  = ArgType::Pointer;
+                    _rec.values[i] = reinterpret_cast<uintptr_t>(_arg);
+                    return;
+                }
+
+                // The last byte of text is always left for the nul of a
+                // string that finds no room
+                const char * str = _arg ? _arg : "(null)";
+                const size_t room = TextSize - _rec.textUsed;
+                size_t limit = room - 1;
+                if (_arg && (_cursor.precision() >= 0))
+                    limit = std::min(limit, static_cast<size_t>(_cursor.precision()));
+                const void * nul = std::memchr(str, 0, limit);
+                const size_t len = nul ? static_cast<size_t>(static_cast<const char *>(nul) - str)
+                                       : limit;
+
+                _rec.types[i]  = ArgType::String;
+                _rec.values[i] = _rec.textUsed;
+                std::memcpy(&_rec.text[_rec.textUsed], str, len);
+                _rec.text[_rec.textUsed + len] = 0;
+                _rec.textUsed = static_cast<uint16_t>(
+                    std::min(_rec.textUsed + len + 1, TextSize - 1));
+            }
+            else
+            {
+                _rec.types[i]  = ArgType::Pointer;
+                _rec.values[i] = reinterpret_cast<uintptr_t>(_arg);
+            }
+        }
+    }
+
+    // Queues the message for the background thread. Returns false if it
+    // can not be, for the caller to log it itself.
+    template <typename... Args>
+    inline bool record(int _pri, bool _andPrintf,
+                       const char * f, int l, const char * m,
+                       const char * _format, Args... _args)
+    {
+        if constexpr (sizeof...(Args) > MaxArgs ||
+                      !(Encodable<Args>::value && ...))
+        {
+            return(false);
+        }
+        else
+        {
+            Record * rec = claim();
+            if (!rec)
+                return(true); // counted as dropped
+
+            rec->pri       = _pri;
+            rec->andPrintf = _andPrintf;
+            rec->line      = l;
+            rec->file      = f;
+            rec->function  = m;
+            rec->format    = _format;
+            rec->argCount  = 0;
+            rec->textUsed  = 0;
+            FormatCursor cursor(_format);
+            (encode(*rec, cursor, _args), ...);
+
+            publish();
+            return(true);
+        }
+    }
+
+} // namespace Pistache::AsyncLog
+
+/*****************************************************************************/
+
+#endif // of ifndef INCLUDED_PS_ASYNCLOG_H
@@ -19,11 +19,13 @@
 
 /*****************************************************************************/
 
+#include <atomic>
 #include <ostream>
 
 /*****************************************************************************/
 
 #include <pistache/winornix.h>
+#include <pistache/pist_asynclog.h>
 
 #ifndef _IS_WINDOWS
 
@@ -101,26 +103,60 @@
 #define PS_LOG_AND_STDOUT false
 #endif
 
+// Messages less important than PS_LOG_LEVEL are compiled out altogether,
+// along with the evaluation of their arguments. It defaults to LOG_DEBUG in
+// DEBUG builds and to LOG_INFO otherwise; e.g. -DPS_LOG_LEVEL=LOG_WARNING
+// also removes the INFO messages. Debug messages are only ever compiled in
+// DEBUG builds.
+#ifndef PS_LOG_LEVEL
+#ifdef DEBUG
+#define PS_LOG_LEVEL LOG_DEBUG
+#else
+#define PS_LOG_LEVEL LOG_INFO
+#endif
+#endif
+
+// Those compiled in are then checked against the level set with
+// PSLogSetLevel before anything else is done with them
+#define PS_LOG_WITH_LOC(__pri, __fmt, ...)                              \
+    do                                                                  \
+    {                                                                   \
+        if (PSLogIsEnabled(__pri))                                      \
+            PSLogWrite(__pri, PS_LOG_AND_STDOUT, __FILE__, __LINE__,    \
+                       __FUNCTION__, __fmt, __VA_ARGS__);               \
+    } while (0)
+
+#if PS_LOG_LEVEL >= LOG_ALERT
 #define PS_LOG_ALERT_ARGS(__fmt, ...)                                   \
-    PSLogFn(LOG_ALERT, PS_LOG_AND_STDOUT, __FILE__, __LINE__, __FUNCTION__, \
-            __fmt, __VA_ARGS__)
+    PS_LOG_WITH_LOC(LOG_ALERT, __fmt, __VA_ARGS__)
+#else
+#define PS_LOG_ALERT_ARGS(__fmt, ...) { }
+#endif
 
+#if PS_LOG_LEVEL >= LOG_ERR
 #define PS_LOG_ERR_ARGS(__fmt, ...)                                     \
-    PSLogFn(LOG_ERR, PS_LOG_AND_STDOUT, __FILE__, __LINE__, __FUNCTION__, \
-            __fmt, __VA_ARGS__)
+    PS_LOG_WITH_LOC(LOG_ERR, __fmt, __VA_ARGS__)
+#else
+#define PS_LOG_ERR_ARGS(__fmt, ...) { }
+#endif
 
+#if PS_LOG_LEVEL >= LOG_WARNING
 #define PS_LOG_WARNING_ARGS(__fmt, ...)                                 \
-    PSLogFn(LOG_WARNING, PS_LOG_AND_STDOUT, __FILE__, __LINE__, __FUNCTION__, \
-            __fmt, __VA_ARGS__)
+    PS_LOG_WITH_LOC(LOG_WARNING, __fmt, __VA_ARGS__)
+#else
+#define PS_LOG_WARNING_ARGS(__fmt, ...) { }
+#endif
 
+#if PS_LOG_LEVEL >= LOG_INFO
 #define PS_LOG_INFO_ARGS(__fmt, ...)                                    \
-    PSLogFn(LOG_INFO, PS_LOG_AND_STDOUT, __FILE__, __LINE__, __FUNCTION__, \
-            __fmt, __VA_ARGS__)
+    PS_LOG_WITH_LOC(LOG_INFO, __fmt, __VA_ARGS__)
+#else
+#define PS_LOG_INFO_ARGS(__fmt, ...) { }
+#endif
 
-#ifdef DEBUG
+#if defined(DEBUG) && PS_LOG_LEVEL >= LOG_DEBUG
 #define PS_LOG_DEBUG_ARGS(__fmt, ...)                                   \
-    PSLogFn(LOG_DEBUG, PS_LOG_AND_STDOUT, __FILE__, __LINE__, __FUNCTION__, \
-            __fmt, __VA_ARGS__)
+    PS_LOG_WITH_LOC(LOG_DEBUG, __fmt, __VA_ARGS__)
 #else
 #define PS_LOG_DEBUG_ARGS(__fmt, ...) { }
 #endif
@@ -144,6 +180,32 @@ extern "C" void PSLogFn(int _pri, bool _andPrintf,
 extern "C" void PSLogNoLocFn(int _pri, bool _andPrintf,
                              const char * _format, ...);
 
+// Messages less important than _pri are dropped, as soon as they are logged.
+// Defaults to LOG_DEBUG, i.e. to whatever PS_LOG_LEVEL compiled in.
+extern "C" void PSLogSetLevel(int _pri);
+extern "C" int PSLogGetLevel();
+
+extern std::atomic<int> gPSLogLevel;
+
+inline bool PSLogIsEnabled(int _pri)
+{
+    return(_pri <= gPSLogLevel.load(std::memory_order_relaxed));
+}
+
+// Has the message go through the asynchronous backend when it is running
+// (see pist_asynclog.h), or be formatted and written right away otherwise
+template <typename... Args>
+inline void PSLogWrite(int _pri, bool _andPrintf,
+                       const char * f, int l, const char * m,
+                       const char * _format, Args... _args)
+{
+    if (Pistache::AsyncLog::isRunning() &&
+        Pistache::AsyncLog::record(_pri, _andPrintf, f, l, m, _format, _args...))
+        return;
+
+    PSLogFn(_pri, _andPrintf, f, l, m, _format, _args...);
+}
+
 // If using SysLog (i.e. on Linux), if setPsLogCategory is called with NULL or
 // zero-length string then pistachio does not call openlog; and if
 // setPsLogCategory is called with a non-empty string before pistachio logs
@@ -54,6 +54,16 @@ namespace Pistache::Aio
             bool isWritable() const { return flags.hasFlag(Polling::NotifyOn::Write); }
             bool isHangup() const { return flags.hasFlag(Polling::NotifyOn::Hangup); }
 
+            // The poller received from, or sent to, the fd itself
+            bool isReceived() const { return completion == Completion::Received; }
+            bool isSent() const { return completion == Completion::Sent; }
+            // The poller accepted a connection on the fd itself
+            bool isAccepted() const { return completion == Completion::Accepted; }
+            const char* receivedData() const { return received; }
+            // Bytes received or sent, 0 at the end of the stream, the fd of
+            // the connection accepted, or -errno
+            int64_t transferred() const { return result; }
+
             Polling::Tag getTag() const { return this->tag; }
         };
 
@@ -136,8 +146,18 @@ namespace Pistache::Aio
         void modifyFd(const Key& key, Fd fd, Polling::NotifyOn interest,
                       Polling::Tag tag, Polling::Mode mode = Polling::Mode::Level);
 
+        // See Polling::Epoll::addFdReceiving; the fd is its own tag
+        bool registerFdReceiving(const Key& key, Fd fd, Polling::NotifyOn interest);
+
+        // See Polling::Epoll::addFdAccepting; the fd is its own tag
+        bool registerFdAccepting(const Key& key, Fd fd);
+
         void removeFd(const Key& key, Fd fd);
 
+        // See Polling::Epoll::send
+        bool send(const Key& key, Fd fd, const std::vector<Polling::SendBuffer>& buffers,
+                  int flags, std::shared_ptr<const void> hold);
+
         void runOnce();
         void run();
 
@@ -165,9 +185,11 @@ namespace Pistache::Aio
     class AsyncContext : public ExecutionContext
     {
     public:
-        explicit AsyncContext(size_t threads, const std::string& threadsName = "")
+        explicit AsyncContext(size_t threads, const std::string& threadsName = "",
+                              Polling::Backend backend = Polling::Backend::Epoll)
             : threads_(threads)
             , threadsName_(threadsName)
+            , backend_(backend)
         { }
 
         ~AsyncContext() override = default;
@@ -179,6 +201,8 @@ namespace Pistache::Aio
     private:
         size_t threads_;
         std::string threadsName_;
+        // What the worker threads poll with
+        Polling::Backend backend_;
     };
 
     class Handler : public Prototype<Handler>
@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* resolver.h
+
+   Asynchronous resolution of host names, for the client.
+
+   A Resolver looks hosts up with getaddrinfo() on threads of its own, so
+   that neither the caller nor a reactor thread blocks on a slow DNS server.
+   Concurrent lookups of the same host share the same query. Answers are
+   cached for a configured time, and failures for a shorter one, as
+   getaddrinfo() does not tell the TTL of the records it found. Static
+   entries, as set with addHost(), are answered first and never expire,
+   which is what tests need to point a host name at a local server.
+
+   The addresses are handed out in the order they are to be tried in, the
+   two families alternating as RFC 8305 (Happy Eyeballs) has them.
+*/
+
+#pragma once
+
+#include <pistache/async.h>
+#include <pistache/net.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Pistache::Dns
+{
+
+    class Resolver
+    {
+    public:
+        static constexpr size_t DefaultThreads    = 2;
+        static constexpr size_t DefaultMaxEntries = 1024;
+
+        static constexpr std::chrono::milliseconds DefaultPositiveTtl { 60 * 1000 };
+        static constexpr std::chrono::milliseconds DefaultNegativeTtl { 5 * 1000 };
+
+        struct Options
+        {
+            friend class Resolver;
+
+            // With no threads, hosts are looked up by the caller of resolve()
+            Options& threads(size_t val);
+
+            // How long answers, and failures to find any, are kept
+            Options& positiveTtl(std::chrono::milliseconds val);
+            Options& negativeTtl(std::chrono::milliseconds val);
+            Options& maxEntries(size_t val);
+
+        private:
+            Options();
+
+            size_t threads_;
+            std::chrono::milliseconds positiveTtl_;
+            std::chrono::milliseconds negativeTtl_;
+            size_t maxEntries_;
+        };
+
+        static Options options();
+
+        explicit Resolver(const Options& options = Resolver::options());
+        // Lookups still queued are rejected, those running are waited for
+        ~Resolver();
+
+        Resolver(const Resolver&)            = delete;
+        Resolver& operator=(const Resolver&) = delete;
+
+        // The addresses of host, with port set. Numeric addresses and static
+        // entries resolve right away, as do cached answers; a failure to
+        // resolve rejects the promise with a Pistache::Error.
+        Async::Promise<std::vector<IP>> resolve(const std::string& host, Port port);
+
+        // Has host resolve to addresses, whose ports are ignored, until
+        // removed
+        void addHost(const std::string& host, std::vector<IP> addresses);
+        void removeHost(const std::string& host);
+
+        size_t cacheSize() const;
+        // The queries made to getaddrinfo()
+        uint64_t lookups() const;
+        uint64_t cacheHits() const;
+        void clearCache();
+
+        // Reorders addresses so that the families alternate, starting with
+        // that of the first one
+        static std::vector<IP> interleave(std::vector<IP> addresses);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            std::vector<IP> addresses;
+            // Set when the host could not be resolved
+            std::string error;
+            Clock::time_point expires;
+        };
+
+        struct Waiter
+        {
+            Async::Resolver resolve;
+            Async::Rejection reject;
+        };
+
+        struct Query
+        {
+            std::string key;
+            std::string host;
+            Port port;
+        };
+
+        void lookup(const Query& query);
+        void insert(const std::string& key, Entry entry);
+
+        void start();
+        void run();
+
+        size_t threads_;
+        std::chrono::milliseconds positiveTtl_;
+        std::chrono::milliseconds negativeTtl_;
+        size_t maxEntries_;
+
+        std::unordered_map<std::string, std::vector<IP>> hosts_;
+        std::unordered_map<std::string, Entry> cache_;
+        std::unordered_map<std::string, std::vector<Waiter>> waiters_;
+        uint64_t lookups_ = 0;
+        uint64_t hits_    = 0;
+
+        std::vector<std::thread> workers_;
+        std::deque<Query> queries_;
+        bool stopping_ = false;
+        std::condition_variable queriesCond_;
+
+        mutable std::mutex mutex_;
+    };
+
+} // namespace Pistache::Dns
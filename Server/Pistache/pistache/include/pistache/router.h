@@ -12,16 +12,30 @@
 
 #pragma once
 
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <locale>
 #include <memory>
-#include <regex>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <pistache/flags.h>
 #include <pistache/http.h>
 #include <pistache/http_defs.h>
+#include <pistache/metrics.h>
+
+namespace Pistache::Http
+{
+    class Endpoint;
+}
 
 namespace Pistache::Rest
 {
@@ -30,32 +44,104 @@ namespace Pistache::Rest
 
     namespace details
     {
+        template <typename T>
+        constexpr bool IsCharacter = std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char> || std::is_same_v<T, wchar_t> || std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+        // Numbers that are read as such, rather than as characters or as
+        // booleans would be by a stream
+        template <typename T>
+        constexpr bool IsNumber = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !IsCharacter<T>;
+
+        /**
+         * Converts the whole of value, without allocating, returning false
+         * when it is not a T. Integers, even those of a character type, and
+         * floating-point numbers are read in base 10, booleans as true, false,
+         * 1 or 0.
+         */
+        template <typename T>
+        bool fromChars(std::string_view value, T& out)
+        {
+            const char* first = value.data();
+            const char* last  = value.data() + value.size();
+
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                if (value == "true" || value == "1")
+                    out = true;
+                else if (value == "false" || value == "0")
+                    out = false;
+                else
+                    return false;
+                return true;
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                auto [ptr, ec] = std::from_chars(first, last, out);
+                return ec == std::errc() && ptr == last;
+            }
+            else
+            {
+                static_assert(std::is_floating_point_v<T>, "Not a number");
+#ifdef __cpp_lib_to_chars
+                auto [ptr, ec] = std::from_chars(first, last, out);
+                return ec == std::errc() && ptr == last;
+#else
+                // Where floating-point numbers can not be read with
+                // from_chars yet
+                std::istringstream iss { std::string(value) };
+                iss.imbue(std::locale::classic());
+                return (iss >> out) && iss.peek() == std::char_traits<char>::eof();
+#endif
+            }
+        }
+
         template <typename T>
         struct LexicalCast
         {
-            static T cast(const std::string& value)
+            static T cast(std::string_view value)
             {
-                std::istringstream iss(value);
-                T out;
-                if (!(iss >> out))
-                    throw std::runtime_error("Bad lexical cast");
-                return out;
+                if constexpr (IsNumber<T>)
+                {
+                    T out {};
+                    if (!fromChars(value, out))
+                        throw std::runtime_error("Bad lexical cast");
+                    return out;
+                }
+                else
+                {
+                    std::istringstream iss { std::string(value) };
+                    T out;
+                    if (!(iss >> out))
+                        throw std::runtime_error("Bad lexical cast");
+                    return out;
+                }
             }
         };
 
         template <>
         struct LexicalCast<std::string>
         {
-            static std::string cast(const std::string& value) { return value; }
+            static std::string cast(std::string_view value) { return std::string(value); }
+        };
+
+        template <>
+        struct LexicalCast<std::string_view>
+        {
+            static std::string_view cast(std::string_view value) { return value; }
         };
     } // namespace details
 
+    /**
+     * A parameter, or splat, of a route. Its name and value are views: into
+     * the router's copy of the route, and into the resource of the request it
+     * was matched against. A TypedParam must therefore not outlive either.
+     */
     class TypedParam
     {
     public:
-        TypedParam(std::string name, std::string value)
-            : name_(std::move(name))
-            , value_(std::move(value))
+        TypedParam(std::string_view name, std::string_view value)
+            : name_(name)
+            , value_(value)
         { }
 
         template <typename T>
@@ -64,11 +150,14 @@ namespace Pistache::Rest
             return details::LexicalCast<T>::cast(value_);
         }
 
-        const std::string& name() const { return name_; }
+        std::string_view name() const { return name_; }
+        std::string_view value() const { return value_; }
 
     private:
-        const std::string name_;
-        const std::string value_;
+        friend class Request;
+
+        std::string_view name_;
+        std::string_view value_;
     };
 
     class Request;
@@ -82,7 +171,7 @@ namespace Pistache::Rest
                             NotFound,
                             NotAllowed };
 
-        typedef std::function<Result(const Request, Http::ResponseWriter)> Handler;
+        typedef std::function<Result(const Request&, Http::ResponseWriter)> Handler;
 
         typedef std::function<bool(Http::Request& req, Http::ResponseWriter& resp)> Middleware;
 
@@ -122,6 +211,8 @@ namespace Pistache::Rest
     class SegmentTreeNode
     {
     private:
+        friend class RouteMatcher;
+
         enum class SegmentType { Fixed,
                                  Param,
                                  Optional,
@@ -144,13 +235,6 @@ namespace Pistache::Rest
         std::shared_ptr<SegmentTreeNode> splat_;
         std::shared_ptr<Route> route_;
 
-        /**
-         * Common web servers (nginx, httpd, IIS) collapse multiple
-         * forward slashes to a single one. This regex is used to
-         * obtain the same result.
-         */
-        static std::regex multiple_slash;
-
         static SegmentType getSegmentType(const std::string_view& fragment);
 
         /**
@@ -184,6 +268,17 @@ namespace Pistache::Rest
          */
         static std::string sanitizeResource(const std::string& path);
 
+        /**
+         * Like sanitizeResource, without allocating unless there are
+         * duplicate slashes to collapse, which is then done into buffer.
+         * Common web servers (nginx, httpd, IIS) collapse them too.
+         * @param path URL to sanitize.
+         * @param buffer Storage for the URL once collapsed.
+         * @return Sanitized URL, viewing into path or buffer.
+         */
+        static std::string_view sanitizeResource(std::string_view path,
+                                                 std::string& buffer);
+
         /**
          * Associates a route handler to a given path.
          * \param[in] path Requested resource path. Must have no leading and trailing
@@ -229,6 +324,117 @@ namespace Pistache::Rest
         findRoute(const std::string_view& path) const;
     };
 
+    /**
+     * The routes of a SegmentTreeNode, compiled into an immutable structure
+     * for matching requests against.
+     * Nodes are held contiguously. Chains of fixed segments that lead to no
+     * route, and to nothing else than the next fixed segment, are merged
+     * into a single edge. The fixed edges of a node are found through a radix
+     * tree of jump tables, each indexed by the next byte in which their
+     * first segments differ. Matching then
+     * only recurses where a node has other alternatives to backtrack to,
+     * and never allocates other than to grow the vectors of params and
+     * splats.
+     * Routes are matched as by SegmentTreeNode::findRoute, with params and
+     * optionals tried in the order of their names.
+     */
+    class RouteMatcher
+    {
+    public:
+        RouteMatcher() = default;
+        explicit RouteMatcher(const SegmentTreeNode& root);
+
+        /**
+         * Finds the route for the given path, as sanitized by
+         * SegmentTreeNode::sanitizeResource.
+         * \param[in] path Requested resource path.
+         * \param[out] params Parameters of the route, names viewing into this
+         * matcher and values into path.
+         * \param[out] splats Splats of the route, viewing into path.
+         * \return The route found, or nullptr (params and splats are then
+         * left empty).
+         */
+        const Route* match(std::string_view path, std::vector<TypedParam>& params,
+                           std::vector<TypedParam>& splats) const;
+
+        size_t nodeCount() const { return nodes_.size(); }
+
+    private:
+        static constexpr uint32_t Nil = UINT32_MAX;
+
+        struct Label
+        {
+            uint32_t offset = 0;
+            uint32_t size   = 0;
+            // Of the first segment, fixed edges spanning several of them
+            uint32_t headSize = 0;
+        };
+
+        struct Edge
+        {
+            Label label;
+            uint32_t child = Nil;
+        };
+
+        struct Range
+        {
+            uint32_t begin = 0;
+            uint32_t end   = 0;
+        };
+
+        // Of edges whose first segments are the same up to offset, by
+        // their byte there, from first on. A first segment ending there is
+        // indexed by '/', which no segment holds.
+        struct JumpTable
+        {
+            uint32_t offset = 0;
+            uint32_t begin  = 0;
+            uint16_t size   = 0;
+            uint8_t first   = 0;
+        };
+
+        // To the one edge with that byte, or to the table telling apart
+        // those that have it
+        struct Jump
+        {
+            uint32_t edge  = Nil;
+            uint32_t table = Nil;
+        };
+
+        struct Node
+        {
+            Range fixed;
+            Range params;
+            Range optionals;
+
+            // Jump table of the fixed edges
+            uint32_t jumps = Nil;
+
+            uint32_t splat = Nil;
+            uint32_t route = Nil;
+        };
+
+        uint32_t compile(const SegmentTreeNode& node);
+        uint32_t jumpTable(Range edges, uint32_t offset);
+        Label store(std::string_view label, size_t headSize);
+        std::string_view view(const Label& label) const;
+        std::string_view head(const Label& label) const;
+
+        // Index of the only fixed edge whose first segment may be segment,
+        // or Nil
+        uint32_t findFixed(const Node& node, std::string_view segment) const;
+
+        bool match(uint32_t index, std::string_view path, std::vector<TypedParam>& params,
+                   std::vector<TypedParam>& splats, const Route*& route) const;
+
+        std::vector<Node> nodes_;
+        std::vector<Edge> edges_;
+        std::vector<JumpTable> tables_;
+        std::vector<Jump> jumps_;
+        std::vector<std::shared_ptr<Route>> routes_;
+        std::string labels_;
+    };
+
     class Router
     {
     public:
@@ -262,17 +468,40 @@ namespace Pistache::Rest
 
         void disconnectPeer(const std::shared_ptr<Tcp::Peer>& peer);
 
+        /**
+         * Routes a request the caller is done with, without copying it:
+         * middlewares modify it in place, then it is moved into the
+         * Rest::Request the handler is given.
+         */
+        Route::Status route(Http::Request&& request,
+                            Http::ResponseWriter response) const;
+        /**
+         * Routes a copy of the request.
+         */
         Route::Status route(const Http::Request& request,
                             Http::ResponseWriter response) const;
 
+        /**
+         * Compiles the routes into the RouteMatchers requests are routed
+         * with. Done when the router's handler is created, and otherwise on
+         * the first request routed after routes were added or removed.
+         */
+        void compile() const;
+
         Router()
             : routes()
             , customHandlers()
             , middlewares()
             , notFoundHandler()
+            , compiled_()
         { }
 
     private:
+        using CompiledRoutes = std::unordered_map<Http::Method, RouteMatcher>;
+
+        std::shared_ptr<const CompiledRoutes> compiled() const;
+        void invalidate();
+
         std::unordered_map<Http::Method, SegmentTreeNode> routes;
 
         std::vector<Route::Handler> customHandlers;
@@ -282,6 +511,9 @@ namespace Pistache::Rest
         std::vector<Route::DisconnectHandler> disconnectHandlers;
 
         Route::Handler notFoundHandler;
+
+        // Replaced as a whole, atomically, and reset whenever routes change
+        mutable std::shared_ptr<const CompiledRoutes> compiled_;
     };
 
     namespace Private
@@ -308,6 +540,8 @@ namespace Pistache::Rest
 
             void onRequest(const Http::Request& req,
                            Http::ResponseWriter response) override;
+            void onMutableRequest(Http::Request& req,
+                                  Http::ResponseWriter response) override;
 
             void onDisconnection(const std::shared_ptr<Tcp::Peer>& peer) override;
 
@@ -321,6 +555,12 @@ namespace Pistache::Rest
     public:
         friend class Router;
 
+        // The params and splats of a copy view into the copy
+        Request(const Request& other);
+        Request(Request&& other);
+        Request& operator=(const Request& other);
+        Request& operator=(Request&& other);
+
         bool hasParam(const std::string& name) const;
         TypedParam param(const std::string& name) const;
 
@@ -328,12 +568,22 @@ namespace Pistache::Rest
         std::vector<TypedParam> splat() const;
 
     private:
-        explicit Request(Http::Request request,
-                         std::vector<TypedParam>&& params,
-                         std::vector<TypedParam>&& splats);
+        explicit Request(Http::Request&& request);
+        Request(Request&& other, std::string_view resource, std::string_view path);
+
+        // Makes the values of the params and splats, which view into the
+        // resource and path given, view into those of this request instead
+        void rebase(std::string_view resource, std::string_view path);
 
         std::vector<TypedParam> params_;
         std::vector<TypedParam> splats_;
+
+        // The resource once sanitized, when it could not just be viewed
+        // into
+        std::string path_;
+
+        // What the names of the params view into
+        std::shared_ptr<const void> routes_;
     };
 
     namespace Routes
@@ -352,6 +602,14 @@ namespace Pistache::Rest
 
         void NotFound(Router& router, Route::Handler handler);
 
+        // Serves what source returns, in the Prometheus text format, on GET
+        // resource. The endpoint's metrics are read on every request, so it
+        // must outlive the router.
+        void Prometheus(Router& router, const std::string& resource,
+                        std::function<Pistache::Metrics::Snapshot()> source);
+        void Prometheus(Router& router, const std::string& resource,
+                        Http::Endpoint& endpoint);
+
         namespace details
         {
             template <typename... Args>
@@ -495,5 +753,327 @@ namespace Pistache::Rest
             };
         }
 
+        /**
+         * Typed routes
+         *
+         * The params of a route may be given a type in its template, as in
+         * /users/:id<uint64>/posts/:slug, and a handler be bound to it that
+         * takes the value of each param, already converted, after the request
+         * and the response:
+         *
+         *     void getPost(const Rest::Request&, Http::ResponseWriter,
+         *                  uint64_t id, std::string_view slug);
+         *
+         *     static constexpr char UserPost[] = "/users/:id<uint64>/posts/:slug";
+         *     Routes::Get(router, Routes::bind<UserPost>(&Api::getPost, &api));
+         *
+         * The template is a template argument so that the types of the params
+         * are checked against those the handler takes at compile time. Types
+         * are int8 to int64, uint8 to uint64, float, double, bool and string,
+         * which untyped params are; strings are std::string_views, into the
+         * request, that handlers may take as std::strings instead. Optional
+         * params, as in :page<uint32>?, are std::optionals.
+         *
+         * Values are converted as by details::fromChars. A request with a
+         * value that is not of the type of its param is answered with a 400.
+         */
+        struct TypedRoute
+        {
+            // Without the types of the params, as the router matches it
+            std::string resource;
+            Route::Handler handler;
+        };
+
+        void Get(Router& router, TypedRoute route);
+        void Post(Router& router, TypedRoute route);
+        void Put(Router& router, TypedRoute route);
+        void Patch(Router& router, TypedRoute route);
+        void Delete(Router& router, TypedRoute route);
+        void Options(Router& router, TypedRoute route);
+        void Head(Router& router, TypedRoute route);
+
+        namespace details
+        {
+            enum class ParamType { String,
+                                   Int8,
+                                   Int16,
+                                   Int32,
+                                   Int64,
+                                   Uint8,
+                                   Uint16,
+                                   Uint32,
+                                   Uint64,
+                                   Float,
+                                   Double,
+                                   Bool,
+                                   Unknown };
+
+            struct ParamSpec
+            {
+                std::string_view name;
+                ParamType type = ParamType::String;
+                bool optional  = false;
+            };
+
+            constexpr ParamType paramType(std::string_view name)
+            {
+                constexpr std::pair<std::string_view, ParamType> Types[] = {
+                    { "string", ParamType::String },
+                    { "int8", ParamType::Int8 },
+                    { "int16", ParamType::Int16 },
+                    { "int32", ParamType::Int32 },
+                    { "int64", ParamType::Int64 },
+                    { "uint8", ParamType::Uint8 },
+                    { "uint16", ParamType::Uint16 },
+                    { "uint32", ParamType::Uint32 },
+                    { "uint64", ParamType::Uint64 },
+                    { "float", ParamType::Float },
+                    { "double", ParamType::Double },
+                    { "bool", ParamType::Bool },
+                };
+
+                for (const auto& [typeName, type] : Types)
+                {
+                    if (typeName == name)
+                        return type;
+                }
+                return ParamType::Unknown;
+            }
+
+            // Calls f with each segment of path that is a param, until it
+            // returns false
+            template <typename F>
+            constexpr void forEachParam(std::string_view path, F f)
+            {
+                size_t pos = 0;
+                while (pos < path.size())
+                {
+                    auto end = path.find('/', pos);
+                    if (end == std::string_view::npos)
+                        end = path.size();
+
+                    const auto segment = path.substr(pos, end - pos);
+                    if (!segment.empty() && segment.front() == ':' && !f(segment))
+                        return;
+
+                    pos = end + 1;
+                }
+            }
+
+            constexpr size_t paramCount(std::string_view path)
+            {
+                size_t count = 0;
+                forEachParam(path, [&](std::string_view) {
+                    ++count;
+                    return true;
+                });
+                return count;
+            }
+
+            constexpr ParamSpec paramSpec(std::string_view path, size_t index)
+            {
+                std::string_view segment;
+                forEachParam(path, [&](std::string_view param) {
+                    segment = param;
+                    return index-- != 0;
+                });
+
+                ParamSpec spec;
+                if (!segment.empty() && segment.back() == '?')
+                {
+                    spec.optional = true;
+                    segment.remove_suffix(1);
+                }
+
+                const auto open = segment.find('<');
+                if (open == std::string_view::npos)
+                {
+                    spec.name = segment;
+                    return spec;
+                }
+
+                spec.name = segment.substr(0, open);
+                spec.type = segment.back() == '>'
+                    ? paramType(segment.substr(open + 1, segment.size() - open - 2))
+                    : ParamType::Unknown;
+                return spec;
+            }
+
+            // Removes the types of the params
+            std::string untypedResource(std::string_view path);
+
+            template <ParamType Type>
+            struct ParamValue;
+
+#define PISTACHE_PARAM_VALUE(Type, T) \
+    template <>                       \
+    struct ParamValue<ParamType::Type> \
+    {                                 \
+        using Value = T;              \
+    };
+
+            PISTACHE_PARAM_VALUE(String, std::string_view)
+            PISTACHE_PARAM_VALUE(Int8, int8_t)
+            PISTACHE_PARAM_VALUE(Int16, int16_t)
+            PISTACHE_PARAM_VALUE(Int32, int32_t)
+            PISTACHE_PARAM_VALUE(Int64, int64_t)
+            PISTACHE_PARAM_VALUE(Uint8, uint8_t)
+            PISTACHE_PARAM_VALUE(Uint16, uint16_t)
+            PISTACHE_PARAM_VALUE(Uint32, uint32_t)
+            PISTACHE_PARAM_VALUE(Uint64, uint64_t)
+            PISTACHE_PARAM_VALUE(Float, float)
+            PISTACHE_PARAM_VALUE(Double, double)
+            PISTACHE_PARAM_VALUE(Bool, bool)
+
+#undef PISTACHE_PARAM_VALUE
+
+            template <const char* Path, size_t Index>
+            struct ParamAt
+            {
+                static constexpr ParamSpec Spec = paramSpec(Path, Index);
+
+                static_assert(Spec.type != ParamType::Unknown,
+                              "Unknown type of route parameter, or missing '>'");
+
+                using Value = typename ParamValue<Spec.type>::Value;
+                using Type  = std::conditional_t<Spec.optional, std::optional<Value>, Value>;
+            };
+
+            // Whether a handler taking Arg can be given a param of type Type
+            template <typename Arg, typename Type>
+            constexpr bool Accepts = std::is_same_v<std::decay_t<Arg>, Type> || (std::is_same_v<Type, std::string_view> && std::is_same_v<std::decay_t<Arg>, std::string>) || (std::is_same_v<Type, std::optional<std::string_view>> && std::is_same_v<std::decay_t<Arg>, std::optional<std::string>>);
+
+            template <const char* Path, typename... Args, size_t... Index>
+            constexpr void typed_checks(std::index_sequence<Index...>)
+            {
+                static_assert(sizeof...(Args) == sizeof...(Index) + 2,
+                              "Function should take (const Rest::Request&, Http::ResponseWriter) followed by each parameter of the route");
+
+                using Arguments = TypeList<Args...>;
+
+                [[maybe_unused]] constexpr BindChecks<typename Arguments::template At<0>::Type,
+                                                      typename Arguments::template At<1>::Type>
+                    checks;
+
+                static_assert((Accepts<typename Arguments::template At<Index + 2>::Type,
+                                       typename ParamAt<Path, Index>::Type>
+                               && ...),
+                              "Function parameters should be of the types of the route parameters");
+            }
+
+            template <typename T>
+            bool convertParam(const Rest::Request& request, const std::string& name, T& out)
+            {
+                if (!request.hasParam(name))
+                    return false;
+
+                const auto value = request.param(name).value();
+                if constexpr (std::is_same_v<T, std::string_view>)
+                {
+                    out = value;
+                    return true;
+                }
+                else if constexpr (std::is_same_v<T, std::string>)
+                {
+                    out.assign(value.data(), value.size());
+                    return true;
+                }
+                else
+                {
+                    return Rest::details::fromChars(value, out);
+                }
+            }
+
+            template <typename T>
+            bool convertParam(const Rest::Request& request, const std::string& name,
+                              std::optional<T>& out)
+            {
+                // Absent is fine, of another type is not
+                if (!request.hasParam(name))
+                    return true;
+
+                return convertParam(request, name, out.emplace());
+            }
+
+            // Arguments are those of the handler, whose params are converted
+            // to the types it takes rather than to those of the route
+            template <const char* Path, typename Arguments, typename Invoke, size_t... Index>
+            TypedRoute typedRoute(Invoke invoke, std::index_sequence<Index...>)
+            {
+                std::array<std::string, sizeof...(Index)> names = { std::string(ParamAt<Path, Index>::Spec.name)... };
+
+                TypedRoute route;
+                route.resource = untypedResource(Path);
+                route.handler  = [invoke, names](const Rest::Request& request,
+                                                Http::ResponseWriter response) {
+                    std::tuple<std::decay_t<typename Arguments::template At<Index + 2>::Type>...> values;
+                    if (!(convertParam(request, names[Index], std::get<Index>(values)) && ...))
+                    {
+                        response.send(Http::Code::Bad_Request, "Invalid route parameter");
+                        return Route::Result::Ok;
+                    }
+
+                    invoke(request, std::move(response), std::move(std::get<Index>(values))...);
+                    return Route::Result::Ok;
+                };
+                return route;
+            }
+        } // namespace details
+
+        template <const char* Path, typename Result, typename Cls, typename... Args, typename Obj>
+        TypedRoute bind(Result (Cls::*func)(Args...), Obj obj)
+        {
+            using Params = std::make_index_sequence<details::paramCount(Path)>;
+            details::typed_checks<Path, Args...>(Params {});
+
+            return details::typedRoute<Path, details::TypeList<Args...>>(
+                [=](auto&&... args) { (obj->*func)(std::forward<decltype(args)>(args)...); },
+                Params {});
+        }
+
+        template <const char* Path, typename Result, typename Cls, typename... Args, typename Obj>
+        TypedRoute bind(Result (Cls::*func)(Args...) const, Obj obj)
+        {
+            using Params = std::make_index_sequence<details::paramCount(Path)>;
+            details::typed_checks<Path, Args...>(Params {});
+
+            return details::typedRoute<Path, details::TypeList<Args...>>(
+                [=](auto&&... args) { (obj->*func)(std::forward<decltype(args)>(args)...); },
+                Params {});
+        }
+
+        template <const char* Path, typename Result, typename Cls, typename... Args, typename Obj>
+        TypedRoute bind(Result (Cls::*func)(Args...), std::shared_ptr<Obj> objPtr)
+        {
+            using Params = std::make_index_sequence<details::paramCount(Path)>;
+            details::typed_checks<Path, Args...>(Params {});
+
+            return details::typedRoute<Path, details::TypeList<Args...>>(
+                [=](auto&&... args) { (objPtr.get()->*func)(std::forward<decltype(args)>(args)...); },
+                Params {});
+        }
+
+        template <const char* Path, typename Result, typename Cls, typename... Args, typename Obj>
+        TypedRoute bind(Result (Cls::*func)(Args...) const, std::shared_ptr<Obj> objPtr)
+        {
+            using Params = std::make_index_sequence<details::paramCount(Path)>;
+            details::typed_checks<Path, Args...>(Params {});
+
+            return details::typedRoute<Path, details::TypeList<Args...>>(
+                [=](auto&&... args) { (objPtr.get()->*func)(std::forward<decltype(args)>(args)...); },
+                Params {});
+        }
+
+        template <const char* Path, typename Result, typename... Args>
+        TypedRoute bind(Result (*func)(Args...))
+        {
+            using Params = std::make_index_sequence<details::paramCount(Path)>;
+            details::typed_checks<Path, Args...>(Params {});
+
+            return details::typedRoute<Path, details::TypeList<Args...>>(
+                [=](auto&&... args) { func(std::forward<decltype(args)>(args)...); },
+                Params {});
+        }
+
     } // namespace Routes
 } // namespace Pistache::Rest
@@ -14,10 +14,12 @@
 
 #include <pistache/os.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <streambuf>
 #include <string>
@@ -100,54 +102,133 @@ namespace Pistache
     public:
         using Base = StreamBuf<CharT>;
 
-        explicit ArrayStreamBuf(size_t maxSize)
+        // The storage is only allocated, initialSize bytes of it, when the
+        // first bytes come in. It then grows as needed up to maxSize, and is
+        // kept across reset() and compact() so that a long-lived buffer stops
+        // allocating.
+        explicit ArrayStreamBuf(size_t maxSize,
+                                size_t initialSize = Const::MaxBuffer)
             : StreamBuf<CharT>()
-            , bytes()
             , maxSize_(maxSize)
+            , initialSize_(std::min(initialSize, maxSize))
         {
-            bytes.clear();
-            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            updateArea(0);
         }
 
         template <size_t M>
         explicit ArrayStreamBuf(char (&arr)[M])
+            : maxSize_(std::max(M, Const::MaxBuffer))
         {
-            bytes.clear();
-            std::copy(arr, arr + M, std::back_inserter(bytes));
-            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            feed(arr, M);
         }
 
         bool feed(const char* data, size_t len)
         {
-            if (bytes.size() + len > maxSize_)
+            if (prepare(len) < len)
             {
                 return false;
             }
-            // persist current offset
-            size_t readOffset = static_cast<size_t>(this->gptr() - this->eback());
-            std::copy(data, data + len, std::back_inserter(bytes));
-            Base::setg(bytes.data(), bytes.data() + readOffset,
-                       bytes.data() + bytes.size());
+            if (len > 0)
+                std::memcpy(writePtr(), data, len * sizeof(CharT));
+            commit(len);
             return true;
         }
 
+        // Makes room for len more bytes, as far as maxSize allows, and
+        // returns how many can be written at writePtr()
+        size_t prepare(size_t len)
+        {
+            const size_t wanted = (len > maxSize_ - size_) ? maxSize_ : size_ + len;
+            if (wanted > capacity_)
+                grow(wanted);
+
+            return capacity_ - size_;
+        }
+
+        CharT* writePtr() { return data_.get() + size_; }
+
+        // Appends the len bytes written at writePtr()
+        void commit(size_t len)
+        {
+            const size_t readOffset = this->readOffset();
+            size_ += len;
+            updateArea(readOffset);
+        }
+
+        bool full() const { return size_ >= maxSize_; }
+
+        size_t maxSize() const { return maxSize_; }
+
         void reset()
         {
-            std::vector<CharT> nbytes;
-            bytes.swap(nbytes);
-            Base::setg(bytes.data(), bytes.data(), bytes.data() + bytes.size());
+            size_ = 0;
+            updateArea(0);
+        }
+
+        // Drops the bytes that have already been read, keeping the others
+        void compact()
+        {
+            const size_t readOffset = this->readOffset();
+            if (readOffset == size_)
+            {
+                reset();
+                return;
+            }
+
+            std::memmove(data_.get(), data_.get() + readOffset,
+                         (size_ - readOffset) * sizeof(CharT));
+            size_ -= readOffset;
+            updateArea(0);
         }
 
     private:
-        std::vector<CharT> bytes;
-        size_t maxSize_ = Const::MaxBuffer;
+        size_t readOffset() const
+        {
+            // The area may have been cleared from a cursor
+            if (this->eback() == nullptr)
+                return 0;
+            return static_cast<size_t>(this->gptr() - this->eback());
+        }
+
+        void updateArea(size_t readOffset)
+        {
+            Base::setg(data_.get(), data_.get() + readOffset, data_.get() + size_);
+        }
+
+        void grow(size_t wanted)
+        {
+            size_t capacity = std::max({ capacity_ * 2, initialSize_, wanted });
+            capacity        = std::min(capacity, maxSize_);
+
+            // Not value-initialized: the bytes are about to be written over
+            std::unique_ptr<CharT[]> data(new CharT[capacity]);
+            if (size_ > 0)
+                std::memcpy(data.get(), data_.get(), size_ * sizeof(CharT));
+
+            const size_t readOffset = this->readOffset();
+            data_                   = std::move(data);
+            capacity_               = capacity;
+            updateArea(readOffset);
+        }
+
+        std::unique_ptr<CharT[]> data_;
+        size_t size_        = 0;
+        size_t capacity_    = 0;
+        size_t maxSize_     = Const::MaxBuffer;
+        size_t initialSize_ = Const::MaxBuffer;
     };
 
+    // Bytes on their way to the wire. Copies share the same storage, which
+    // is never modified once in a RawBuffer, so that a buffer can be handed
+    // around and retried after a partial write without its bytes being
+    // copied.
     struct RawBuffer final
     {
         RawBuffer() = default;
         RawBuffer(std::string data, size_t length);
         RawBuffer(const char* data, size_t length);
+        // Shares bytes that are already held elsewhere
+        explicit RawBuffer(std::shared_ptr<const std::string> data);
 
         RawBuffer(const RawBuffer&)            = default;
         RawBuffer& operator=(const RawBuffer&) = default;
@@ -161,20 +242,45 @@ namespace Pistache
         size_t size() const;
 
     private:
-        std::string data_;
+        std::shared_ptr<const std::string> data_;
         size_t length_ = 0;
     };
 
+    // An open file, closed once nothing refers to it anymore
+    class OpenFile
+    {
+    public:
+        explicit OpenFile(int fd)
+            : fd_(fd)
+        { }
+        ~OpenFile();
+
+        OpenFile(const OpenFile&)            = delete;
+        OpenFile& operator=(const OpenFile&) = delete;
+
+        int fd() const { return fd_; }
+
+    private:
+        int fd_; // regular old file descriptor ("int") even in libevent case
+    };
+
     struct FileBuffer
     {
         explicit FileBuffer(const std::string& fileName);
 
+        // size bytes of an already open file, from offset on. The file stays
+        // open for as long as the buffer, or a copy of it, is around.
+        FileBuffer(std::shared_ptr<const OpenFile> file, off_t offset, size_t size);
+
         int fd() const;
         size_t size() const;
+        off_t offset() const;
+
+        const std::shared_ptr<const OpenFile>& file() const;
 
     private:
-        std::string fileName_;
-        int fd_; // regular old file descriptor ("int") even in libevent case
+        std::shared_ptr<const OpenFile> file_;
+        off_t offset_;
         size_t size_;
     };
 
@@ -193,7 +299,11 @@ namespace Pistache
         DynamicStreamBuf(DynamicStreamBuf&& other);
         DynamicStreamBuf& operator=(DynamicStreamBuf&& other);
 
+        // A copy of what was written
         RawBuffer buffer() const;
+        // Hands over what was written without copying it, leaving the
+        // buffer empty; new storage is only allocated once written to again
+        RawBuffer release();
 
         void clear();
 
@@ -204,9 +314,11 @@ namespace Pistache
 
     private:
         void reserve(size_t size);
+        size_t written() const;
 
-        std::vector<char> data_;
-        size_t maxSize_ = Const::MaxBuffer;
+        std::string data_;
+        size_t maxSize_     = Const::MaxBuffer;
+        size_t initialSize_ = 0;
     };
 
     class StreamCursor
@@ -7,26 +7,24 @@
 /* timer_pool.h
    Mathieu Stefani, 09 février 2016
 
-   A pool of timer fd to avoid creating fds everytime we need a timer and
-   thus reduce the total number of system calls.
+   A pool of timers, so that they can be reused from one request to the
+   next.
 
-   Most operations are lock-free except resize operations needed when the
-   pool is empty, in which case it's blocking but we expect it to be rare.
+   Timers run on a TimerWheel, which makes arming and disarming one cheap
+   and keeps the kernel out of it. Picking and releasing a timer are
+   lock-free.
 */
 
 #pragma once
 
 #include <pistache/config.h>
-#include <pistache/os.h>
-#include <pistache/reactor.h>
+#include <pistache/timer_wheel.h>
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <vector>
 
-#include <cassert>
-#include PST_MISC_IO_HDR // e.g. unistd.h
-
 namespace Pistache
 {
 
@@ -43,29 +41,27 @@ namespace Pistache
             Entry();
             ~Entry();
 
-            Fd fd() const;
-
-            void initialize();
-
+            // Has callback called, from the thread driving wheel, once
+            // duration has elapsed, unless the entry is disarmed first
             template <typename Duration>
-            void arm(Duration duration)
+            void arm(TimerWheel& wheel, Duration duration, TimerWheel::Callback callback)
             {
-                assert(fd_ != PS_FD_EMPTY && "Entry is not initialized");
-
-                armMs(std::chrono::duration_cast<std::chrono::milliseconds>(duration));
+                armMs(wheel, std::chrono::duration_cast<std::chrono::milliseconds>(duration),
+                      std::move(callback));
             }
 
             void disarm();
 
-            void registerReactor(const Aio::Reactor::Key& key, Aio::Reactor* reactor);
+            bool isArmed() const;
 
         private:
-            void armMs(std::chrono::milliseconds value);
+            void armMs(TimerWheel& wheel, std::chrono::milliseconds value,
+                       TimerWheel::Callback callback);
             enum class State : uint32_t { Idle,
                                           Used };
             std::atomic<uint32_t> state;
-            Fd fd_;
-            bool registered;
+            TimerWheel* wheel_;
+            TimerWheel::TimerId timer_;
         };
 
         std::shared_ptr<Entry> pickTimer();
@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* timer_wheel.h
+
+   A hierarchical timing wheel, so that any number of timers can be kept
+   by a transport with a single kernel timer.
+
+   Timers are kept with a 1ms resolution in levels of 64 slots, each level
+   covering 64 times the span of the one below it. Deadlines are rounded up
+   to the next millisecond, so that a timer never fires early. Scheduling and cancelling
+   a timer are O(1). Empty slots are skipped using a bitmap per level, and a
+   timer is moved down a level at most once per level on its way to expiry.
+
+   The wheel can be driven by calling advance() directly, or be bound to a
+   poller, in which case it keeps its own timer fd armed to the earliest
+   deadline and handleReady() must be called when that fd is reported ready.
+   Timers may be scheduled and cancelled from any thread; callbacks run on
+   the thread driving the wheel, outside of the wheel's lock.
+*/
+
+#pragma once
+
+#include <pistache/os.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Pistache
+{
+
+    class TimerWheel
+    {
+    public:
+        using Clock    = std::chrono::steady_clock;
+        using Callback = std::function<void()>;
+
+        // Names a scheduled timer. NoTimer never names one, and an id is not
+        // reused once its timer has fired or been cancelled.
+        using TimerId                  = uint64_t;
+        static constexpr TimerId NoTimer = 0;
+
+        TimerWheel();
+        ~TimerWheel();
+
+        TimerWheel(const TimerWheel&)            = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        template <typename Duration>
+        TimerId schedule(Duration delay, Callback callback)
+        {
+            return scheduleAt(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay),
+                              std::move(callback));
+        }
+
+        TimerId scheduleAt(Clock::time_point deadline, Callback callback);
+
+        // Returns false when the timer already fired, or was cancelled
+        bool cancel(TimerId id);
+        bool isScheduled(TimerId id) const;
+
+        size_t size() const;
+
+        // Runs the callbacks of the timers due at the given time, returning
+        // how many ran. Timers overdue when scheduled are due on the next
+        // millisecond.
+        size_t advance(Clock::time_point now = Clock::now());
+
+        // No later than the earliest deadline; empty when there is no timer
+        std::optional<Clock::time_point> nextDeadline() const;
+
+        // Only to be called from the thread polling the wheel
+        Polling::Tag bind(Polling::Epoll& poller);
+        void unbind(Polling::Epoll& poller);
+        bool isBound() const;
+
+        Polling::Tag tag() const;
+
+        void handleReady();
+
+    private:
+        static constexpr size_t SlotBits  = 6;
+        static constexpr size_t SlotCount = size_t(1) << SlotBits;
+        static constexpr size_t Levels    = 8;
+        static constexpr uint32_t Nil     = UINT32_MAX;
+
+        // Level of the timers that are due, but whose callback has yet to run
+        static constexpr uint8_t DueLevel = Levels;
+
+        // Far enough never to be reached, and low enough for every tick to
+        // fall within the top level
+        static constexpr uint64_t MaxTick = (uint64_t(1) << (SlotBits * Levels)) - 1;
+
+        struct Node
+        {
+            Callback callback;
+            uint64_t expiry = 0;
+            uint32_t prev   = Nil;
+            uint32_t next   = Nil;
+            uint32_t gen    = 1;
+            uint8_t level   = 0;
+            uint8_t slot    = 0;
+            bool active     = false;
+        };
+
+        uint64_t toTick(Clock::time_point time, bool roundUp) const;
+        Clock::time_point fromTick(uint64_t tick) const;
+
+        void link(uint32_t index);
+        void unlink(uint32_t index);
+        void appendDue(uint32_t index);
+        void release(uint32_t index);
+        uint32_t find(TimerId id) const;
+
+        // Tick of the next slot to be fired or cascaded, if any
+        std::optional<uint64_t> nextEvent(size_t* level) const;
+        void advanceTo(uint64_t tick);
+
+        void rearm();
+
+        Clock::time_point origin_;
+        uint64_t now_ = 0;
+
+        std::vector<Node> nodes_;
+        uint32_t free_ = Nil;
+        size_t size_   = 0;
+
+        std::array<std::array<uint32_t, SlotCount>, Levels> slots_;
+        std::array<uint64_t, Levels> occupied_;
+
+        uint32_t dueHead_ = Nil;
+        uint32_t dueTail_ = Nil;
+
+        Fd timerFd_         = PS_FD_EMPTY;
+        uint64_t armedTick_ = UINT64_MAX;
+
+        mutable std::mutex mutex_;
+    };
+
+} // namespace Pistache
@@ -18,13 +18,17 @@
 
 #include <pistache/async.h>
 #include <pistache/mailbox.h>
+#include <pistache/metrics.h>
 #include <pistache/pist_quote.h>
 #include <pistache/pist_timelog.h>
 #include <pistache/reactor.h>
 #include <pistache/stream.h>
+#include <pistache/timer_wheel.h>
 
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -39,6 +43,13 @@ namespace Pistache::Tcp
     class Transport : public Aio::Handler
     {
     public:
+        // Accepts one connection from the given listening socket. Returns a
+        // null peer once there is nothing left to accept.
+        using Acceptor = std::function<std::shared_ptr<Peer>(Fd listenFd)>;
+        // Makes a peer of a connection the poller accepted itself. Returns a
+        // null peer, having closed it, when it cannot.
+        using Adopter = std::function<std::shared_ptr<Peer>(em_socket_t fd)>;
+
         explicit Transport(const std::shared_ptr<Tcp::Handler>& handler);
 
         Transport(const Transport&)            = delete;
@@ -54,6 +65,19 @@ namespace Pistache::Tcp
         void handleNewPeer(const std::shared_ptr<Peer>& peer);
         void onReady(const Aio::FdSet& fds) override;
 
+        // Makes this transport accept connections on its own listening
+        // socket rather than being handed peers by the Listener. Must be
+        // called once the transport is registered with a reactor, but before
+        // the reactor runs. The transport does not take ownership of listenFd.
+        // Given an adopter, connections are accepted by the poller itself
+        // where its backend can (see Polling::Epoll::addFdAccepting).
+        void setAcceptor(Fd listenFd, Acceptor acceptor, Adopter adopter = {});
+
+        // Has the handler's onInput called again for this peer, with no new
+        // data, from the transport thread. Used by handlers that hold back
+        // input they already received (e.g. pipelined HTTP requests).
+        void resumeInput(const std::shared_ptr<Peer>& peer);
+
         template <typename Buf>
         Async::Promise<PST_SSIZE_T> asyncWrite(Fd fd, const Buf& buffer,
                                            int flags = 0
@@ -82,6 +106,23 @@ namespace Pistache::Tcp
                 });
         }
 
+        // Like the above, with the bytes counted as queued for the peer until
+        // they are written, or fail to be. See Peer::queuedBytes().
+        Async::Promise<PST_SSIZE_T> asyncWrite(const std::shared_ptr<Peer>& peer,
+                                               const RawBuffer& buffer, int flags = 0
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                               ,
+                                               bool msg_more_style = false
+#endif
+        );
+        Async::Promise<PST_SSIZE_T> asyncWrite(const std::shared_ptr<Peer>& peer,
+                                               const FileBuffer& buffer, int flags = 0
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                               ,
+                                               bool msg_more_style = false
+#endif
+        );
+
         Async::Promise<PST_RUSAGE> load()
         {
             return Async::Promise<PST_RUSAGE>([this](Async::Deferred<PST_RUSAGE> deferred) {
@@ -92,6 +133,13 @@ namespace Pistache::Tcp
             });
         }
 
+        // The timers of this transport, whose callbacks run on the transport
+        // thread
+        TimerWheel& timers() { return timers_; }
+
+        // Resolves deferred once timeout has elapsed, unless disarmTimer is
+        // called first. fd only names the timer: it is not armed, nor
+        // polled, and it is up to the caller to close it.
         template <typename Duration>
         void armTimer(Fd fd, Duration timeout, Async::Deferred<uint64_t> deferred)
         {
@@ -104,12 +152,37 @@ namespace Pistache::Tcp
 
         void disarmTimer(Fd fd);
 
+        // Upper bound on how long a TLS peer may stay in the handshaking
+        // state before it is dropped. Zero means no bound. Must be set before
+        // the transport is registered with a reactor.
+        void setSslHandshakeTimeout(std::chrono::milliseconds timeout);
+        std::chrono::milliseconds sslHandshakeTimeout() const;
+
         std::shared_ptr<Aio::Handler> clone() const override;
 
         void flush();
 
         std::deque<std::shared_ptr<Peer>> getAllPeer();
 
+        // Load indicators, maintained without locking so that they can be
+        // sampled from any thread (e.g. to pick a worker for a new peer).
+        //
+        // Number of peers handed to this transport and not yet removed,
+        // including those still handshaking
+        size_t activePeers() const;
+        // Total time spent handling events
+        std::chrono::nanoseconds busyTime() const;
+        // Moving average of the time spent per wakeup, recent wakeups
+        // weighing most
+        std::chrono::nanoseconds recentBusyTime() const;
+
+        // What this worker records of its activity, from the transport
+        // thread and from the threads of handlers responding asynchronously
+        Metrics::Recorder& metrics() { return metrics_; }
+        // What was recorded, along with the live connections and the
+        // buffers waiting to be written. May be called from any thread.
+        Metrics::Worker metricsSnapshot();
+
 #ifdef _USE_LIBEVENT
         std::shared_ptr<EventMethEpollEquiv> getEventMethEpollEquiv()
         {
@@ -139,7 +212,7 @@ namespace Pistache::Tcp
             { }
 
             explicit BufferHolder(const FileBuffer& buffer, off_t offset = 0)
-                : _fd(buffer.fd())
+                : _file(buffer)
                 , size_(buffer.size())
                 , offset_(offset)
                 , type(File)
@@ -150,40 +223,36 @@ namespace Pistache::Tcp
             size_t size() const { return size_; }
             size_t offset() const { return static_cast<size_t>(offset_); }
 
-            int fd() const
+            const FileBuffer& file() const
             {
                 if (!isFile())
-                    throw std::runtime_error("Tried to retrieve fd of a non-filebuffer");
-                return _fd;
+                    throw std::runtime_error("Tried to retrieve file of a non-filebuffer");
+                return *_file;
             }
 
-            RawBuffer raw() const
+            const RawBuffer& raw() const
             {
                 if (!isRaw())
                     throw std::runtime_error("Tried to retrieve raw data of a non-buffer");
                 return _raw;
             }
 
+            // Marks the bytes before offset as written
+            void setOffset(size_t offset) { offset_ = static_cast<off_t>(offset); }
+
             BufferHolder detach(off_t offset = 0)
             {
+                // The bytes, or the file, are shared, only the offset is moved
                 if (!isRaw())
-                    return BufferHolder(_fd, size_, offset);
+                    return BufferHolder(*_file, offset);
 
-                auto detached = _raw.copy(static_cast<size_t>(offset));
-                return BufferHolder(detached);
+                return BufferHolder(_raw, offset);
             }
 
         private:
-            BufferHolder(int fd, // regular file desc ("int") even for libevent
-                         size_t size, off_t offset = 0)
-                : _fd(fd)
-                , size_(size)
-                , offset_(offset)
-                , type(File)
-            { }
-
             RawBuffer _raw;
-            int _fd; // regular old file desc ("int") even in libevent case
+            // Keeps the file open until it has been sent
+            std::optional<FileBuffer> _file;
 
             size_t size_  = 0;
             off_t offset_ = 0;
@@ -217,43 +286,26 @@ namespace Pistache::Tcp
             Fd peerFd = PS_FD_EMPTY;
         };
 
-        struct TimerEntry
+        struct PeerEntry
         {
-            TimerEntry(Fd fd_, std::chrono::milliseconds value_,
-                       Async::Deferred<uint64_t> deferred_)
-                : fd(fd_)
-                , value(value_)
-                , deferred(std::move(deferred_))
-                , active()
-            {
-                active.store(true, std::memory_order_relaxed);
-            }
-
-            TimerEntry(TimerEntry&& other)
-                : fd(other.fd)
-                , value(other.value)
-                , deferred(std::move(other.deferred))
-                , active(other.active.load())
+            explicit PeerEntry(std::shared_ptr<Peer> peer_)
+                : peer(std::move(peer_))
             { }
 
-            void disable() { active.store(false, std::memory_order_relaxed); }
-
-            bool isActive() const { return active.load(std::memory_order_relaxed); }
-
-            Fd fd;
-            std::chrono::milliseconds value;
-            Async::Deferred<uint64_t> deferred;
-            std::atomic<bool> active;
+            std::shared_ptr<Peer> peer;
         };
 
-        struct PeerEntry
+        struct HandshakeEntry
         {
-            explicit PeerEntry(std::shared_ptr<Peer> peer_)
+            HandshakeEntry(std::shared_ptr<Peer> peer_, TimerWheel::TimerId timer_)
                 : peer(std::move(peer_))
+                , timer(timer_)
             { }
 
             std::shared_ptr<Peer> peer;
+            TimerWheel::TimerId timer;
         };
+
         using Lock  = std::mutex;
         using Guard = std::lock_guard<Lock>;
 
@@ -263,12 +315,36 @@ namespace Pistache::Tcp
 
         PollableQueue<WriteEntry> writesQueue;
         std::unordered_map<Fd, std::deque<WriteEntry>> toWrite;
+        // Written by the poller, until it reports how much was sent (see
+        // Polling::Epoll::send). The fd's later writes wait in toWrite.
+        std::unordered_map<Fd, std::deque<WriteEntry>> sending_;
         Lock toWriteLock;
 
-        PollableQueue<TimerEntry> timersQueue;
-        std::unordered_map<FdConst, TimerEntry> timers;
+        TimerWheel timers_;
+
+        // Timers armed through armTimer, by the fd naming them
+        std::unordered_map<Fd, TimerWheel::TimerId> fdTimers;
+        Lock fdTimersLock;
 
         PollableQueue<PeerEntry> peersQueue;
+        PollableQueue<PeerEntry> resumeQueue;
+
+        // TLS peers whose handshake is still being driven by this transport.
+        // They are only moved into peers_, and announced to the handler,
+        // once SSL_accept completes. Only touched from the transport thread.
+        std::unordered_map<Fd, HandshakeEntry> handshakes_;
+        std::chrono::milliseconds sslHandshakeTimeout_ { 0 };
+
+        Fd acceptFd_ = PS_FD_EMPTY;
+        Acceptor acceptor_;
+        Adopter adopter_;
+
+        std::atomic<size_t> activePeers_ { 0 };
+        // Only written from the transport thread
+        std::atomic<int64_t> busyNs_ { 0 };
+        std::atomic<int64_t> recentBusyNs_ { 0 };
+
+        Metrics::Recorder metrics_;
 
         Async::Deferred<PST_RUSAGE> loadRequest_;
         NotifyFd notifier;
@@ -282,6 +358,10 @@ namespace Pistache::Tcp
     protected:
         void removePeer(const std::shared_ptr<Peer>& peer);
 
+        // Called on the transport thread once a peer is ready for I/O, right
+        // before the handler is told about it
+        virtual void onPeerAdded(const std::shared_ptr<Peer>& peer);
+
         // Without the use of peers_mutex_ to protect peers_, http_server_test
         // multiple_client_with_requests_to_multithreaded_server fails
         // intermittently (~1 time in 10 - likely highly environment
@@ -295,9 +375,7 @@ namespace Pistache::Tcp
     private:
         bool isPeerFd(FdConst fd) const;
         bool isPeerFdNoPeersMutexLock(FdConst fd) const;
-        bool isTimerFd(FdConst fd) const;
         bool isPeerFd(Polling::Tag tag) const;
-        bool isTimerFd(Polling::Tag tag) const;
 
         std::shared_ptr<Peer> getPeer(FdConst fd);
         std::shared_ptr<Peer> getPeer(Polling::Tag tag);
@@ -305,11 +383,42 @@ namespace Pistache::Tcp
         void armTimerMs(Fd fd, std::chrono::milliseconds value,
                         Async::Deferred<uint64_t> deferred);
 
-        void armTimerMsImpl(TimerEntry entry);
-
         // This will attempt to drain the write queue for the fd
         void asyncWriteImpl(Fd fd);
 
+        template <typename Buf>
+        Async::Promise<PST_SSIZE_T> asyncWriteQueued(const std::shared_ptr<Peer>& peer,
+                                                     const Buf& buffer, int flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                                     ,
+                                                     bool msg_more_style
+#endif
+        );
+#ifndef _IS_WINDOWS
+        // Sends the raw buffers at the front of wq with a single sendmsg
+        // call. Returns 0 when there are not several of them to gather.
+        PST_SSIZE_T sendGathered(Fd fd, const std::deque<WriteEntry>& wq);
+
+        // Has the poller send the raw buffers at the front of wq, moving
+        // them to sending_. toWriteLock must be held. Returns false when it
+        // cannot, nothing being moved.
+        bool submitSend(Fd fd, std::deque<WriteEntry>& wq);
+#endif
+        void handleSent(Fd fd, int64_t result);
+
+        // Some of what was queued for fd was written. toWriteLock is
+        // held, peers_mutex_ is taken.
+        void touchPeer(Fd fd);
+
+        // The promises of writes that will not be made, taken out of wq for
+        // rejectWrites() to reject once toWriteLock is released: their
+        // continuations, which release the bytes queued for the peer, may
+        // well queue more writes
+        static void takeWrites(std::deque<WriteEntry>& wq,
+                               std::vector<Async::Deferred<PST_SSIZE_T>>& deferreds);
+        static void rejectWrites(std::vector<Async::Deferred<PST_SSIZE_T>>& deferreds,
+                                 int error);
+
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         void configureMsgMoreStyle(Fd fd, bool msg_more_style);
 #endif
@@ -324,12 +433,29 @@ namespace Pistache::Tcp
 
         void handlePeerDisconnection(const std::shared_ptr<Peer>& peer);
         void handleIncoming(const std::shared_ptr<Peer>& peer);
+        void handleReceived(const std::shared_ptr<Peer>& peer, const char* data,
+                            int64_t result);
+        // Hands bytes already received over to the handler, holding back
+        // those there is no room for
+        void feedInput(const std::shared_ptr<Peer>& peer, const char* data,
+                       size_t size);
         void handleWriteQueue(bool flush = false);
-        void handleTimerQueue();
         void handlePeerQueue();
+        void handleResumeQueue();
         void handleNotify();
-        void handleTimer(TimerEntry entry);
         void handlePeer(const std::shared_ptr<Peer>& peer);
+        void addPeer(const std::shared_ptr<Peer>& peer);
+
+        bool isHandshakeFd(Polling::Tag tag) const;
+        void startHandshake(const std::shared_ptr<Peer>& peer);
+        void driveHandshake(const std::shared_ptr<Peer>& peer);
+        void abortHandshake(const std::shared_ptr<Peer>& peer);
+
+        void handleAcceptor();
+        void handleAccepted(int64_t fd);
+        void handleAcceptedPeer(const std::shared_ptr<Peer>& peer);
+
+        void recordBusy(std::chrono::nanoseconds elapsed);
     };
 
 } // namespace Pistache::Tcp
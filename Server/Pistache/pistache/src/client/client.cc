@@ -31,9 +31,14 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 #include <cstring> // for std::memcpy
 
 namespace Pistache::Http::Experimental
@@ -164,35 +169,139 @@ namespace Pistache::Http::Experimental
                 streamBuf << body;
             }
         }
+
+        // Rejects a request, and the wait for the headers of its response
+        // when it is streamed and they did not come
+        template <typename Request, typename Exc>
+        void rejectRequest(Request& request, const Exc& exc)
+        {
+            const auto& stream = request.stream;
+            if (stream && !stream->headersDone)
+            {
+                stream->headersDone = true;
+                stream->headersReject(exc);
+            }
+
+            request.reject(exc);
+        }
+
+        // Hands each part of the body over to a function
+        class CallbackReader : public BodyReader
+        {
+        public:
+            explicit CallbackReader(std::function<void(const char*, size_t)> onData)
+                : onData_(std::move(onData))
+            { }
+
+            void onData(const char* data, size_t len) override { onData_(data, len); }
+
+        private:
+            std::function<void(const char*, size_t)> onData_;
+        };
     } // namespace
 
-    class Transport : public Aio::Handler
+    class Transport : public Aio::Handler,
+                      public std::enable_shared_from_this<Transport>
     {
     public:
         PROTOTYPE_OF(Aio::Handler, Transport)
 
-        Transport()
-            : stopHandling(false) {};
-        Transport(const Transport&)
-            : requestsQueue()
+        // A request given to the transport, to send on one of its connections
+        struct Submission
+        {
+            Submission(Async::Resolver resolve, Async::Rejection reject,
+                       Http::Request request, std::string domain, bool https,
+                       std::shared_ptr<Connection::Stream> stream)
+                : resolve(std::move(resolve))
+                , reject(std::move(reject))
+                , request(std::move(request))
+                , domain(std::move(domain))
+                , https(https)
+                , stream(std::move(stream))
+            { }
+
+            Async::Resolver resolve;
+            Async::Rejection reject;
+            Http::Request request;
+            std::string domain;
+            bool https;
+            std::shared_ptr<Connection::Stream> stream;
+        };
+
+        Transport(std::shared_ptr<Dns::Resolver> resolver,
+                  size_t maxConnectionsPerHost, size_t maxResponseSize,
+                  size_t pipelineDepth, size_t maxQueuedRequests,
+                  std::chrono::milliseconds connectTimeout)
+            : resolver_(std::move(resolver))
+            , maxConnectionsPerHost_(maxConnectionsPerHost)
+            , maxResponseSize_(maxResponseSize)
+            , pipelineDepth_(pipelineDepth)
+            , connectTimeout_(connectTimeout)
+            , maxQueued_(maxQueuedRequests)
+            , queued_(0)
+            , roomWaiters_(0)
+            , stopped_(false)
+            , stopHandling(false)
+        {
+            pool_.init(maxConnectionsPerHost_, maxResponseSize_, pipelineDepth_);
+        }
+
+        // Clones get the settings, and connections of their own
+        Transport(const Transport& other)
+            : Aio::Handler()
+            , std::enable_shared_from_this<Transport>()
+            , resolver_(other.resolver_)
+            , maxConnectionsPerHost_(other.maxConnectionsPerHost_)
+            , maxResponseSize_(other.maxResponseSize_)
+            , pipelineDepth_(other.pipelineDepth_)
+            , connectTimeout_(other.connectTimeout_)
+            , maxQueued_(other.maxQueued_)
+            , queued_(0)
+            , roomWaiters_(0)
+            , stopped_(false)
+            , requestsQueue()
             , connectionsQueue()
             , connections()
-            , timeouts()
-            , timeoutsLock()
             , stopHandling(false)
-        { }
+        {
+            pool_.init(maxConnectionsPerHost_, maxResponseSize_, pipelineDepth_);
+        }
 
         void onReady(const Aio::FdSet& fds) override;
         void registerPoller(Polling::Epoll& poller) override;
         void unregisterPoller(Polling::Epoll& poller) override;
 
-        Async::Promise<void> asyncConnect(std::shared_ptr<Connection> connection,
+        // Connects fd, a socket of connection, to address
+        Async::Promise<void> asyncConnect(std::shared_ptr<Connection> connection, Fd fd,
                                           const struct sockaddr* address,
                                           PST_SOCKLEN_T addr_len);
 
         Async::Promise<PST_SSIZE_T>
-        asyncSendRequest(std::shared_ptr<Connection> connection,
-                         std::shared_ptr<TimerPool::Entry> timer, std::string buffer);
+        asyncSendRequest(std::shared_ptr<Connection> connection, std::string buffer);
+
+        // Has the request sent by this transport. Other threads wait for
+        // room in the queue; the transport's own cannot, and have the request
+        // rejected instead when the queue is full.
+        void submit(Submission submission);
+        // Runs task on the thread of the transport
+        void post(std::function<void()> task);
+        // Forgets about fd, which its connection is closing
+        void forget(Fd fd) { connections.erase(fd); }
+        // Stops, then starts again, reading fd, for flow control
+        void pauseReading(Fd fd) { reactor()->modifyFd(key(), fd, NotifyOn::None); }
+        void resumeReading(Fd fd) { reactor()->modifyFd(key(), fd, NotifyOn::Read); }
+
+        bool isOwnThread() const { return std::this_thread::get_id() == context().thread(); }
+        size_t queued() const { return queued_.load(); }
+        std::chrono::milliseconds connectTimeout() const { return connectTimeout_; }
+
+        // Fails the requests not sent yet, and closes the connections. The
+        // reactor must have been shut down.
+        void shutdown();
+
+        // The timers of this transport, whose callbacks run on the transport
+        // thread
+        TimerWheel& timers() { return timers_; }
 
 #ifdef _USE_LIBEVENT
         std::shared_ptr<EventMethEpollEquiv> getEventMethEpollEquiv()
@@ -211,11 +320,12 @@ namespace Pistache::Http::Experimental
         struct ConnectionEntry
         {
             ConnectionEntry(Async::Resolver resolve, Async::Rejection reject,
-                            std::shared_ptr<Connection> connection,
+                            std::shared_ptr<Connection> connection, Fd _fd,
                             const struct sockaddr* _addr, socklen_t _addr_len)
                 : resolve(std::move(resolve))
                 , reject(std::move(reject))
                 , connection(connection)
+                , fd(_fd)
                 , addr_len(_addr_len)
             {
                 std::memcpy(&addr, _addr, addr_len);
@@ -229,6 +339,8 @@ namespace Pistache::Http::Experimental
             Async::Resolver resolve;
             Async::Rejection reject;
             std::weak_ptr<Connection> connection;
+            // One of the sockets the connection is racing
+            Fd fd;
             sockaddr_storage addr;
             socklen_t addr_len;
         };
@@ -236,31 +348,58 @@ namespace Pistache::Http::Experimental
         struct RequestEntry
         {
             RequestEntry(Async::Resolver resolve, Async::Rejection reject,
-                         std::shared_ptr<Connection> connection,
-                         std::shared_ptr<TimerPool::Entry> timer, std::string buf)
+                         std::shared_ptr<Connection> connection, std::string buf)
                 : resolve(std::move(resolve))
                 , reject(std::move(reject))
                 , connection(connection)
-                , timer(timer)
                 , buffer(std::move(buf))
             { }
 
             Async::Resolver resolve;
             Async::Rejection reject;
             std::weak_ptr<Connection> connection;
-            std::shared_ptr<TimerPool::Entry> timer;
             std::string buffer;
         };
 
+        // The requests to a host that wait for one of its connections
+        struct Waiting
+        {
+            std::deque<Submission> submissions;
+            // Set while they are being sent, for the requests completed
+            // meanwhile not to send them again
+            bool sending = false;
+        };
+
+        std::shared_ptr<Dns::Resolver> resolver_;
+        size_t maxConnectionsPerHost_;
+        size_t maxResponseSize_;
+        size_t pipelineDepth_;
+        std::chrono::milliseconds connectTimeout_;
+
+        // Only used from the thread of the transport
+        ConnectionPool pool_;
+        std::unordered_map<std::string, Waiting> waiting_;
+
+        // The requests submitted from other threads and not sent yet, and
+        // those waiting for a connection
+        size_t maxQueued_;
+        std::atomic<size_t> queued_;
+        std::mutex roomLock_;
+        std::condition_variable roomCond_;
+        std::atomic<size_t> roomWaiters_;
+        std::atomic<bool> stopped_;
+
         PollableQueue<RequestEntry> requestsQueue;
         PollableQueue<ConnectionEntry> connectionsQueue;
+        PollableQueue<Submission> submissionsQueue;
+        PollableQueue<std::function<void()>> tasksQueue;
 
         std::unordered_map<Fd, ConnectionEntry> connections;
-        std::unordered_map<Fd, std::weak_ptr<Connection>> timeouts;
+
+        TimerWheel timers_;
 
         using Lock  = std::mutex;
         using Guard = std::lock_guard<Lock>;
-        Lock timeoutsLock;
 
         std::mutex handlingMutex;
         bool stopHandling;
@@ -275,10 +414,24 @@ namespace Pistache::Http::Experimental
 
         void handleRequestsQueue();
         void handleConnectionQueue();
+        void connectEntry(ConnectionEntry entry);
+        void handleSubmissionsQueue();
+        void handleTasksQueue();
         void handleReadableEntry(const Aio::FdSet::Entry& entry);
         void handleWritableEntry(const Aio::FdSet::Entry& entry);
         void handleHangupEntry(const Aio::FdSet::Entry& entry);
         void handleIncoming(std::shared_ptr<Connection> connection);
+
+        // reserved tells whether the submission holds a place in the queue
+        void dispatch(Submission submission, bool reserved);
+        // Sends the submission on a connection of the pool, when one is free
+        bool send(Submission& submission);
+        void sendWaiting(const std::string& domain);
+
+        bool reserve();
+        void release(size_t count);
+
+        static int connectError(Fd fd);
     };
 
     void Transport::onReady(const Aio::FdSet& fds)
@@ -306,6 +459,18 @@ namespace Pistache::Http::Experimental
             {
                 handleRequestsQueue();
             }
+            else if (entry.getTag() == submissionsQueue.tag())
+            {
+                handleSubmissionsQueue();
+            }
+            else if (entry.getTag() == tasksQueue.tag())
+            {
+                handleTasksQueue();
+            }
+            else if (entry.getTag() == timers_.tag())
+            {
+                timers_.handleReady();
+            }
             else if (entry.isReadable())
             {
                 handleReadableEntry(entry);
@@ -332,6 +497,9 @@ namespace Pistache::Http::Experimental
 
         requestsQueue.bind(poller);
         connectionsQueue.bind(poller);
+        submissionsQueue.bind(poller);
+        tasksQueue.bind(poller);
+        timers_.bind(poller);
 
 #ifdef _USE_LIBEVENT
         epoll_fd = poller.getEventMethEpollEquiv();
@@ -344,30 +512,37 @@ namespace Pistache::Http::Experimental
         epoll_fd = nullptr;
 #endif
 
+        timers_.unbind(poller);
+        tasksQueue.unbind(poller);
+        submissionsQueue.unbind(poller);
         connectionsQueue.unbind(poller);
         requestsQueue.unbind(poller);
     }
 
     Async::Promise<void>
-    Transport::asyncConnect(std::shared_ptr<Connection> connection,
+    Transport::asyncConnect(std::shared_ptr<Connection> connection, Fd fd,
                             const struct sockaddr* address,
                             PST_SOCKLEN_T addr_len)
     {
         PS_TIMEDBG_START_THIS;
 
         return Async::Promise<void>(
-            [connection, address, addr_len, this](Async::Resolver& resolve, Async::Rejection& reject) {
+            [connection, fd, address, addr_len, this](Async::Resolver& resolve, Async::Rejection& reject) {
                 PS_TIMEDBG_START;
 
                 ConnectionEntry entry(std::move(resolve), std::move(reject), connection,
-                                      address, addr_len);
-                connectionsQueue.push(std::move(entry));
+                                      fd, address, addr_len);
+                // Connected at once from the thread of the transport, so that
+                // an attempt given up on meanwhile is not left queued
+                if (isOwnThread())
+                    connectEntry(std::move(entry));
+                else
+                    connectionsQueue.push(std::move(entry));
             });
     }
 
     Async::Promise<PST_SSIZE_T>
     Transport::asyncSendRequest(std::shared_ptr<Connection> connection,
-                                std::shared_ptr<TimerPool::Entry> timer,
                                 std::string buffer)
     {
         PS_TIMEDBG_START_THIS;
@@ -377,7 +552,7 @@ namespace Pistache::Http::Experimental
                 PS_TIMEDBG_START;
                 auto ctx = context();
                 RequestEntry req(std::move(resolve), std::move(reject), connection,
-                                 timer, std::move(buffer));
+                                 std::move(buffer));
                 if (std::this_thread::get_id() != ctx.thread())
                 {
                     requestsQueue.push(std::move(req));
@@ -436,12 +611,6 @@ namespace Pistache::Http::Experimental
                 totalWritten += bytesWritten;
                 if (totalWritten == len)
                 {
-                    if (req.timer)
-                    {
-                        Guard guard(timeoutsLock);
-                        timeouts.insert(std::make_pair(req.timer->fd(), conn));
-                        req.timer->registerReactor(key(), reactor());
-                    }
                     req.resolve(totalWritten);
                     break;
                 }
@@ -474,52 +643,322 @@ namespace Pistache::Http::Experimental
             if (!data)
                 break;
 
-            auto conn = data->connection.lock();
-            if (!conn)
-            {
-                data->reject(Error::system("Failed to connect"));
-                continue;
-            }
+            connectEntry(std::move(*data));
+        }
+    }
 
-            Fd fd = conn->fd();
-            if (fd == PS_FD_EMPTY)
-            {
-                PS_LOG_DEBUG_ARGS("Connection %p has empty fd", conn.get());
-                data->reject(Error::system("Failed to connect, fd now empty"));
-                continue;
-            }
+    void Transport::connectEntry(ConnectionEntry entry)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto conn = entry.connection.lock();
+        if (!conn)
+        {
+            entry.reject(Error::system("Failed to connect"));
+            return;
+        }
+
+        Fd fd = entry.fd;
+        if (fd == PS_FD_EMPTY)
+        {
+            PS_LOG_DEBUG_ARGS("Connection %p has empty fd", conn.get());
+            entry.reject(Error::system("Failed to connect, fd now empty"));
+            return;
+        }
+
+        PS_LOG_DEBUG_ARGS("Calling ::connect fs %d", GET_ACTUAL_FD(fd));
+
+        int res = PST_SOCK_CONNECT(GET_ACTUAL_FD(fd), entry.getAddr(), entry.addr_len);
+        PST_DBG_DECL_SE_ERR_P_EXTRA;
+        PS_LOG_DEBUG_ARGS("::connect res %d, errno on fail %d (%s)",
+                          res, (res < 0) ? errno : 0,
+                          (res < 0) ?
+                          PST_STRERROR_R_ERRNO : "success");
+
+        if ((res == 0) || ((res == -1) && (errno == EINPROGRESS))
+            #ifdef _IS_WINDOWS
+            || ((res == -1) && (errno == EWOULDBLOCK))
+            // In Linux, EWOULDBLOCK can be set by ::connect, but only for
+            // Unix domain sockets (i.e. sockets being used for
+            // inter-process communication) which is not our situation
+            //
+            // In Windows, EWOULDBLOCK is typically set here for
+            // non-blocking sockets
+            #endif
+            )
+        {
+            reactor()->registerFdOneShot(key(), fd,
+                                         NotifyOn::Write | NotifyOn::Hangup | NotifyOn::Shutdown);
+        }
+        else
+        {
+            entry.reject(Error::system("Failed to connect"));
+            return;
+        }
+        connections.insert(std::make_pair(fd, std::move(entry)));
+    }
+
+    void Transport::handleSubmissionsQueue()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        for (;;)
+        {
+            auto submission = submissionsQueue.popSafe();
+            if (!submission)
+                break;
+
+            dispatch(std::move(*submission), true);
+        }
+    }
+
+    void Transport::handleTasksQueue()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        for (;;)
+        {
+            auto task = tasksQueue.popSafe();
+            if (!task)
+                break;
+
+            (*task)();
+        }
+    }
+
+    void Transport::submit(Submission submission)
+    {
+        PS_TIMEDBG_START_THIS;
 
-            PS_LOG_DEBUG_ARGS("Calling ::connect fs %d", GET_ACTUAL_FD(fd));
-
-            int res = PST_SOCK_CONNECT(GET_ACTUAL_FD(fd), data->getAddr(), data->addr_len);
-            PST_DBG_DECL_SE_ERR_P_EXTRA;
-            PS_LOG_DEBUG_ARGS("::connect res %d, errno on fail %d (%s)",
-                              res, (res < 0) ? errno : 0,
-                              (res < 0) ?
-                              PST_STRERROR_R_ERRNO : "success");
-
-            if ((res == 0) || ((res == -1) && (errno == EINPROGRESS))
-                #ifdef _IS_WINDOWS
-                || ((res == -1) && (errno == EWOULDBLOCK))
-                // In Linux, EWOULDBLOCK can be set by ::connect, but only for
-                // Unix domain sockets (i.e. sockets being used for
-                // inter-process communication) which is not our situation
-                //
-                // In Windows, EWOULDBLOCK is typically set here for
-                // non-blocking sockets
-                #endif
-                )
+        if (stopped_.load())
+        {
+            rejectRequest(submission, Error("Client is shut down"));
+            return;
+        }
+
+        // Already where it is to be sent from, as is a request made from
+        // the continuation of another one
+        if (isOwnThread())
+        {
+            dispatch(std::move(submission), false);
+            return;
+        }
+
+        if (!reserve())
+        {
+            rejectRequest(submission, Error("Client is shut down"));
+            return;
+        }
+
+        submissionsQueue.push(std::move(submission));
+    }
+
+    void Transport::post(std::function<void()> task)
+    {
+        tasksQueue.push(std::move(task));
+    }
+
+    bool Transport::reserve()
+    {
+        auto tryReserve = [this]() {
+            size_t queued = queued_.load();
+            while (queued < maxQueued_)
             {
-                reactor()->registerFdOneShot(key(), fd,
-                                             NotifyOn::Write | NotifyOn::Hangup | NotifyOn::Shutdown);
+                if (queued_.compare_exchange_weak(queued, queued + 1))
+                    return true;
             }
-            else
+            return false;
+        };
+
+        if (tryReserve())
+            return true;
+
+        PS_LOG_DEBUG_ARGS("Transport %p has %zu requests queued, waiting",
+                          this, queued_.load());
+
+        // Whoever frees room checks for waiters after doing so, and we
+        // check for room after counting ourselves in: one of us sees the
+        // other
+        std::unique_lock<std::mutex> guard(roomLock_);
+        ++roomWaiters_;
+        bool reserved = false;
+        roomCond_.wait(guard, [&]() {
+            if (stopped_.load())
+                return true;
+            reserved = tryReserve();
+            return reserved;
+        });
+        --roomWaiters_;
+
+        return reserved;
+    }
+
+    void Transport::release(size_t count)
+    {
+        if (count == 0)
+            return;
+
+        queued_.fetch_sub(count);
+        if (roomWaiters_.load() > 0)
+        {
+            std::lock_guard<std::mutex> guard(roomLock_);
+            roomCond_.notify_all();
+        }
+    }
+
+    void Transport::dispatch(Submission submission, bool reserved)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        if (stopped_.load())
+        {
+            rejectRequest(submission, Error("Client is shut down"));
+            release(reserved ? 1 : 0);
+            return;
+        }
+
+        // Behind the requests already waiting, for them to keep their order
+        auto& waiting = waiting_[submission.domain];
+        if (waiting.submissions.empty() && send(submission))
+        {
+            release(reserved ? 1 : 0);
+            return;
+        }
+
+        if (!reserved)
+        {
+            // Called from the thread of the transport, which could not wait
+            // for room
+            if (queued_.fetch_add(1) >= maxQueued_)
             {
-                data->reject(Error::system("Failed to connect"));
-                continue;
+                queued_.fetch_sub(1);
+                PS_LOG_WARNING_ARGS("Too many requests queued for %s",
+                                    submission.domain.c_str());
+                rejectRequest(submission, Error("Too many requests queued for " + submission.domain));
+                return;
             }
-            connections.insert(std::make_pair(fd, std::move(*data)));
         }
+
+        PS_LOG_DEBUG_ARGS("No connection to %s is free, queueing",
+                          submission.domain.c_str());
+        waiting.submissions.push_back(std::move(submission));
+    }
+
+    bool Transport::send(Submission& submission)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        const auto method     = submission.request.method();
+        const bool idempotent = method == Http::Method::Get
+            || method == Http::Method::Head
+            || method == Http::Method::Put
+            || method == Http::Method::Delete
+            || method == Http::Method::Options
+            || method == Http::Method::Trace;
+
+        auto conn = pool_.pickConnection(submission.domain, idempotent);
+        if (!conn)
+            return false;
+
+        PS_LOG_DEBUG_ARGS("Connection found %p", conn.get());
+        if (!conn->hasTransport())
+            conn->associateTransport(shared_from_this());
+
+        std::weak_ptr<Connection> weakConn = conn;
+        auto onDone = [this, weakConn, idempotent, domain = submission.domain]() {
+            if (auto conn = weakConn.lock())
+                pool_.releaseConnection(conn, idempotent);
+            sendWaiting(domain);
+        };
+
+        if (conn->isConnected())
+        {
+            conn->performImpl(submission.request, std::move(submission.resolve),
+                              std::move(submission.reject), std::move(onDone),
+                              std::move(submission.stream));
+            return true;
+        }
+
+        conn->asyncPerformImpl(submission.request, std::move(submission.resolve),
+                               std::move(submission.reject), std::move(onDone),
+                               std::move(submission.stream));
+        if (conn->isConnecting())
+            return true;
+
+        PS_LOG_DEBUG_ARGS("Connection %p not connected yet", conn.get());
+
+        const AddressParser parser { submission.domain };
+        const Port port = parser.rawPort().empty()
+            ? Port(submission.https ? 443 : 80)
+            : Port(parser.rawPort());
+
+        conn->connect(resolver_, parser.rawHost(), port);
+        return true;
+    }
+
+    void Transport::sendWaiting(const std::string& domain)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto it = waiting_.find(domain);
+        if (it == std::end(waiting_))
+            return;
+
+        // Further up the stack, the loop below goes on
+        auto& waiting = it->second;
+        if (waiting.sending || stopped_.load())
+            return;
+
+        waiting.sending = true;
+        size_t sent     = 0;
+        while (!waiting.submissions.empty())
+        {
+            if (!send(waiting.submissions.front()))
+                break;
+
+            waiting.submissions.pop_front();
+            ++sent;
+        }
+        waiting.sending = false;
+
+        release(sent);
+    }
+
+    void Transport::shutdown()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        {
+            Guard guard(handlingMutex);
+            stopHandling = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(roomLock_);
+            stopped_.store(true);
+        }
+        roomCond_.notify_all();
+
+        // Nothing is handled anymore, the requests not sent yet will not be
+        for (;;)
+        {
+            auto submission = submissionsQueue.popSafe();
+            if (!submission)
+                break;
+
+            rejectRequest(*submission, Error("Client is shut down"));
+        }
+
+        auto waiting = std::move(waiting_);
+        waiting_.clear();
+        for (auto& [domain, requests] : waiting)
+        {
+            for (auto& submission : requests.submissions)
+                rejectRequest(submission, Error("Client is shut down"));
+        }
+        queued_.store(0);
+
+        pool_.shutdown();
     }
 
     void Transport::handleReadableEntry(const Aio::FdSet::Entry& entry)
@@ -555,20 +994,6 @@ namespace Pistache::Http::Experimental
                     "Connection error: problem with reading data from server");
             }
         }
-        else
-        {
-            Guard guard(timeoutsLock);
-            auto timerIt = timeouts.find(fd_for_find);
-            if (timerIt != std::end(timeouts))
-            {
-                auto connection = timerIt->second.lock();
-                if (connection)
-                {
-                    connection->handleTimeout();
-                    timeouts.erase(fd_for_find);
-                }
-            }
-        }
     }
 
     void Transport::handleWritableEntry(const Aio::FdSet::Entry& entry)
@@ -592,13 +1017,23 @@ namespace Pistache::Http::Experimental
             auto connection       = connIt->second.connection.lock();
             if (connection)
             {
-                Fd conn_fd = connection->fd();
+                // While connecting, fd is one of the sockets the connection
+                // races, rather than its own
+                Fd conn_fd = connectionEntry.fd;
                 if (conn_fd == PS_FD_EMPTY)
                 {
                     PS_LOG_DEBUG_ARGS("Connection %p has empty fd",
                                       connection.get());
                     connectionEntry.reject(Error::system("Connection lost"));
                 }
+                else if (!connection->isConnected() && connectError(conn_fd) != 0)
+                {
+                    // Refused or unreachable, which some systems report as
+                    // the socket becoming writable
+                    auto entry = std::move(connectionEntry);
+                    connections.erase(connIt);
+                    entry.reject(Error("Could not connect"));
+                }
                 else
                 {
                     connectionEntry.resolve();
@@ -613,10 +1048,23 @@ namespace Pistache::Http::Experimental
         }
         else
         {
-            throw std::runtime_error("Unknown fd");
+            // Closed by its connection, as another event came in
+            PS_LOG_DEBUG_ARGS("Unknown fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
         }
     }
 
+    int Transport::connectError(Fd fd)
+    {
+        int err              = 0;
+        PST_SOCKLEN_T errLen = static_cast<PST_SOCKLEN_T>(sizeof(err));
+        if (::getsockopt(GET_ACTUAL_FD(fd), SOL_SOCKET, SO_ERROR,
+                         reinterpret_cast<PST_SOCK_OPT_VAL_T*>(&err), &errLen)
+            != 0)
+            return errno;
+
+        return err;
+    }
+
     void Transport::handleHangupEntry(const Aio::FdSet::Entry& entry)
     {
         PS_TIMEDBG_START_THIS;
@@ -634,12 +1082,24 @@ namespace Pistache::Http::Experimental
         auto connIt = connections.find(fd);
         if (connIt != std::end(connections))
         {
-            auto& connectionEntry = connIt->second;
-            connectionEntry.reject(Error::system("Could not connect"));
+            auto connection = connIt->second.connection.lock();
+            if (connection && !connection->isConnected())
+            {
+                // The fd is closed by the connection, and may well be
+                // reused for the next address it tries
+                auto entry = std::move(connIt->second);
+                connections.erase(connIt);
+                entry.reject(Error::system("Could not connect"));
+            }
+            else
+            {
+                connIt->second.reject(Error::system("Could not connect"));
+            }
         }
         else
         {
-            throw std::runtime_error("Unknown fd");
+            // Closed by its connection, as another event came in
+            PS_LOG_DEBUG_ARGS("Unknown fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
         }
     }
 
@@ -661,6 +1121,14 @@ namespace Pistache::Http::Experimental
             if (conn_fd == PS_FD_EMPTY)
                 break; // can happen if fd was closed meanwhile
 
+            // Until its reader resumes, what is left stays in the socket
+            if (totalBytes == 0 && connection->isInputPaused())
+            {
+                connection->inputStalled_ = true;
+                pauseReading(conn_fd);
+                break;
+            }
+
             const PST_SSIZE_T bytes = PST_SOCK_RECV(
                 GET_ACTUAL_FD(conn_fd), buffer+totalBytes,
                 max_buffer - totalBytes, 0);
@@ -693,18 +1161,29 @@ namespace Pistache::Http::Experimental
             }
             else if (bytes == 0)
             {
-                if (totalBytes == 0)
-                {
-                    connection->handleError("Remote closed connection");
-                }
-                connections.erase(conn_fd);
-                connection->close();
+                // Closed first, for the requests completed here to be sent
+                // again on a connection of their own
+                connection->disconnect();
+                if (totalBytes)
+                    connection->handleResponsePacket(buffer, totalBytes);
+
+                // What remains will not be answered
+                connection->handleError("Remote closed connection");
                 break;
             }
             else
             {
                 PS_LOG_DEBUG_ARGS("Rxed %d bytes", bytes);
                 totalBytes += bytes;
+
+                // A streamed body is handed over a read at a time, rather
+                // than gathered first
+                if (connection->isStreaming())
+                {
+                    connection->handleResponsePacket(buffer, totalBytes);
+                    totalBytes = 0;
+                    continue;
+                }
             }
             if (totalBytes >= max_buffer)
             {
@@ -732,10 +1211,14 @@ namespace Pistache::Http::Experimental
 
     Connection::Connection(size_t maxResponseSize)
         : fd_(PS_FD_EMPTY)
-        , requestEntry(nullptr)
+        , requestEntries()
+        , inFlight_(0)
+        , unsafeInFlight_(0)
+        , inputStalled_(false)
+        , nextCandidate_(0)
+        , staggerTimer_(TimerWheel::NoTimer)
         , parser(maxResponseSize)
     {
-        state_.store(static_cast<uint32_t>(State::Idle));
         connectionState_.store(NotConnected);
     }
 
@@ -753,27 +1236,121 @@ namespace Pistache::Http::Experimental
         AddrInfo addressInfo;
 
         TRY(addressInfo.invoke(host.c_str(), port.c_str(), &hints));
-        const addrinfo* addrs = addressInfo.get_info_ptr();
 
-        em_socket_t sfd = -1;
-
-        for (const addrinfo* an_addr = addrs; an_addr;
+        std::vector<IP> addresses;
+        for (const addrinfo* an_addr = addressInfo.get_info_ptr(); an_addr;
              an_addr = an_addr->ai_next)
         {
-            sfd = PST_SOCK_SOCKET(an_addr->ai_family, an_addr->ai_socktype,
-                           an_addr->ai_protocol);
+            addresses.emplace_back(an_addr->ai_addr);
+        }
+
+        connect(std::move(addresses));
+    }
+
+    void Connection::connect(const std::shared_ptr<Dns::Resolver>& resolver,
+                             const std::string& host, Port port)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        PS_LOG_DEBUG_ARGS("Connection %p resolving %s", this, host.c_str());
+        connectionState_.store(Connecting);
+
+        // Whether or not the address was known already, the connection goes
+        // on from the thread of the transport, as all else it does
+        // Neither is kept alive by the lookup: the transport owns the
+        // resolver, which must not be destroyed from one of its own threads
+        std::weak_ptr<Connection> weakConn     = shared_from_this();
+        std::weak_ptr<Transport> weakTransport = transport_;
+        resolver->resolve(host, port)
+            .then(
+                [weakConn, weakTransport](std::vector<IP> addresses) {
+                    auto transport = weakTransport.lock();
+                    if (!transport)
+                        return;
+
+                    transport->post([weakConn, addresses = std::move(addresses)]() mutable {
+                        if (auto conn = weakConn.lock())
+                            conn->connect(std::move(addresses));
+                    });
+                },
+                [weakConn, weakTransport](std::exception_ptr exc) {
+                    auto transport = weakTransport.lock();
+                    if (!transport)
+                        return;
+
+                    std::string error;
+                    try
+                    {
+                        std::rethrow_exception(exc);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        error = e.what();
+                    }
+
+                    transport->post([weakConn, error]() {
+                        if (auto conn = weakConn.lock())
+                        {
+                            conn->connectionState_.store(NotConnected);
+                            conn->failConnect(error);
+                        }
+                    });
+                });
+    }
+
+    void Connection::connect(std::vector<IP> addresses)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        connectionState_.store(Connecting);
+
+        // The attempts are only ever touched from the thread of the
+        // transport, as are its timers' callbacks
+        if (!transport_->isOwnThread())
+        {
+            std::weak_ptr<Connection> weakConn = shared_from_this();
+            transport_->post([weakConn, addresses = std::move(addresses)]() mutable {
+                if (auto conn = weakConn.lock())
+                    conn->connect(std::move(addresses));
+            });
+            return;
+        }
+
+        abandonAttempts();
+        candidates_    = std::move(addresses);
+        nextCandidate_ = 0;
+        startAttempt();
+    }
+
+    void Connection::startAttempt()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto& timers = transport_->timers();
+        if (staggerTimer_ != TimerWheel::NoTimer)
+        {
+            timers.cancel(staggerTimer_);
+            staggerTimer_ = TimerWheel::NoTimer;
+        }
+
+        while (nextCandidate_ < candidates_.size())
+        {
+            const size_t index  = nextCandidate_++;
+            const auto& address = candidates_[index].getSockAddr();
+            const auto addr_len = static_cast<PST_SOCKLEN_T>(
+                address.sa_family == AF_INET ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6));
+
+            em_socket_t sfd = PST_SOCK_SOCKET(address.sa_family, SOCK_STREAM, 0);
             PS_LOG_DEBUG_ARGS("::socket actual_fd %d", sfd);
             if (sfd < 0)
                 continue;
 
             make_non_blocking(sfd);
 
-            connectionState_.store(Connecting);
-
 #ifdef _USE_LIBEVENT
             // We're openning a connection to a remote resource - I guess it
             // makes sense to allow either read or write?
-            fd_ = TRY_NULL_RET(
+            Fd fd = TRY_NULL_RET(
                 EventMethFns::em_event_new(
                     sfd, // pre-allocated file desc
                     EVM_READ | EVM_WRITE | EVM_PERSIST | EVM_ET,
@@ -781,30 +1358,149 @@ namespace Pistache::Http::Experimental
                     PST_O_NONBLOCK // setfl
                     ));
 #else
-            fd_ = sfd;
+            Fd fd = sfd;
 #endif
 
+            std::weak_ptr<Connection> weakConn = shared_from_this();
+            const auto timeout                 = timers.schedule(
+                transport_->connectTimeout(), [weakConn, fd, index]() {
+                    if (auto conn = weakConn.lock())
+                    {
+                        PS_LOG_DEBUG_ARGS("Connection %p, address %zu: timed out",
+                                          conn.get(), index);
+                        conn->attemptFailed(fd);
+                    }
+                });
+            attempts_.push_back(Attempt { fd, index, timeout });
+
+            // Raced by the next address if this one is slow to answer. Set
+            // before connecting, which may fail at once and start the next
+            // attempt itself.
+            if (nextCandidate_ < candidates_.size())
+            {
+                staggerTimer_ = timers.schedule(Default::ConnectionAttemptDelay, [weakConn]() {
+                    if (auto conn = weakConn.lock())
+                    {
+                        conn->staggerTimer_ = TimerWheel::NoTimer;
+                        conn->startAttempt();
+                    }
+                });
+            }
+
             transport_
-                ->asyncConnect(shared_from_this(), an_addr->ai_addr,
-                               static_cast<PST_SOCKLEN_T>(an_addr->ai_addrlen))
+                ->asyncConnect(shared_from_this(), fd, &address, addr_len)
                 // Note: We cast to PST_SOCKLEN_T for Windows because Windows
                 // uses "int" for PST_SOCKLEN_T, whereas Linux uses size_t. In
                 // general, even for Windows we use size_t for addresses'
                 // lengths in Pistache (e.g. in struct ifaddr), hence why we
                 // cast here
                 .then(
-                    [sfd, this]() {
-                        socklen_t len = sizeof(saddr);
-                        PST_SOCK_GETSOCKNAME(sfd, reinterpret_cast<struct sockaddr*>(&saddr), &len);
-                        connectionState_.store(Connected);
-                        processRequestQueue();
+                    [weakConn, fd]() {
+                        if (auto conn = weakConn.lock())
+                            conn->attemptConnected(fd);
                     },
-                    PrintException());
-            break;
+                    [weakConn, fd, index](std::exception_ptr exc) {
+                        auto conn = weakConn.lock();
+                        if (!conn)
+                            return;
+
+                        try
+                        {
+                            std::rethrow_exception(exc);
+                        }
+                        catch (const std::exception& e)
+                        {
+                            PS_LOG_DEBUG_ARGS("Connection %p, address %zu: %s",
+                                              conn.get(), index, e.what());
+                        }
+
+                        conn->attemptFailed(fd);
+                    });
+            return;
+        }
+
+        // Out of addresses: done once the attempts under way are
+        if (attempts_.empty())
+        {
+            connectionState_.store(NotConnected);
+            failConnect("Failed to connect");
+        }
+    }
+
+    void Connection::attemptConnected(Fd fd)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto it = std::find_if(attempts_.begin(), attempts_.end(),
+                               [fd](const Attempt& attempt) { return attempt.fd == fd; });
+        // Given up on meanwhile
+        if (it == attempts_.end())
+            return;
+
+        transport_->timers().cancel(it->timeout);
+        attempts_.erase(it);
+        // The others lost the race
+        abandonAttempts();
+
+        fd_ = fd;
+        socklen_t len = sizeof(saddr);
+        PST_SOCK_GETSOCKNAME(GET_ACTUAL_FD(fd_), reinterpret_cast<struct sockaddr*>(&saddr), &len);
+        connectionState_.store(Connected);
+        processRequestQueue();
+    }
+
+    void Connection::attemptFailed(Fd fd)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto it = std::find_if(attempts_.begin(), attempts_.end(),
+                               [fd](const Attempt& attempt) { return attempt.fd == fd; });
+        if (it == attempts_.end())
+            return;
+
+        transport_->timers().cancel(it->timeout);
+        transport_->forget(fd);
+        CLOSE_FD(it->fd);
+        attempts_.erase(it);
+
+        // The next address is tried at once, rather than after the delay
+        startAttempt();
+    }
+
+    void Connection::abandonAttempts()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto& timers = transport_->timers();
+        if (staggerTimer_ != TimerWheel::NoTimer)
+        {
+            timers.cancel(staggerTimer_);
+            staggerTimer_ = TimerWheel::NoTimer;
+        }
+
+        for (auto& attempt : attempts_)
+        {
+            timers.cancel(attempt.timeout);
+            transport_->forget(attempt.fd);
+            CLOSE_FD(attempt.fd);
         }
+        attempts_.clear();
+    }
+
+    void Connection::failConnect(const std::string& error)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        for (;;)
+        {
+            auto req = requestsQueue.popSafe();
+            if (!req)
+                break;
 
-        if (sfd < 0)
-            throw std::runtime_error("Failed to connect");
+            rejectRequest(*req, Error(error));
+            if (req->onDone)
+                req->onDone();
+        }
     }
 
     std::string Connection::dump() const
@@ -827,26 +1523,18 @@ namespace Pistache::Http::Experimental
         return oss.str();
     }
 
-    bool Connection::isIdle() const
-    {
-        return static_cast<Connection::State>(state_.load()) == Connection::State::Idle;
-    }
+    bool Connection::isIdle() const { return inFlight_.load() == 0; }
 
-    bool Connection::tryUse()
-    {
-        auto curState = static_cast<uint32_t>(Connection::State::Idle);
-        auto newState = static_cast<uint32_t>(Connection::State::Used);
-        return state_.compare_exchange_strong(curState, newState);
-    }
+    size_t Connection::inFlight() const { return inFlight_.load(); }
 
-    void Connection::setAsIdle()
+    bool Connection::isConnected() const
     {
-        state_.store(static_cast<uint32_t>(Connection::State::Idle));
+        return connectionState_.load() == Connected;
     }
 
-    bool Connection::isConnected() const
+    bool Connection::isConnecting() const
     {
-        return connectionState_.load() == Connected;
+        return connectionState_.load() == Connecting;
     }
 
     void Connection::close()
@@ -869,6 +1557,16 @@ namespace Pistache::Http::Experimental
 
             connectionState_.store(NotConnected);
             CLOSE_FD(fd_);
+            // As is all the rest, the attempts are no longer handled
+            for (auto& attempt : attempts_)
+            {
+                transport_->timers().cancel(attempt.timeout);
+                CLOSE_FD(attempt.fd);
+            }
+            attempts_.clear();
+            if (staggerTimer_ != TimerWheel::NoTimer)
+                transport_->timers().cancel(staggerTimer_);
+            staggerTimer_ = TimerWheel::NoTimer;
 
             PS_LOG_DEBUG_ARGS("Unlocking handling_mutex %p",
                               &handling_mutex);
@@ -882,6 +1580,18 @@ namespace Pistache::Http::Experimental
         }
     }
 
+    void Connection::disconnect()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        if (fd_ != PS_FD_EMPTY && transport_)
+            transport_->forget(fd_);
+
+        connectionState_.store(NotConnected);
+        inputStalled_ = false;
+        CLOSE_FD(fd_);
+    }
+
     void Connection::associateTransport(
         const std::shared_ptr<Transport>& transport)
     {
@@ -918,74 +1628,173 @@ namespace Pistache::Http::Experimental
                 handleError("Client: Too long packet");
                 return;
             }
-            if (parser.parse() == Private::State::Done)
+
+            parseResponses();
+        }
+        catch (const std::exception& ex)
+        {
+            handleError(ex.what());
+        }
+    }
+
+    void Connection::parseResponses()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        // Pipelined, the packet may hold more than one response
+        while (!requestEntries.empty())
+        {
+            auto* entry = requestEntries.front().get();
+            if (const auto& stream = entry->stream)
             {
-                if (requestEntry)
+                if (!parser.headersHandled())
                 {
-                    if (requestEntry->timer)
+                    if (parser.parseHeaders() != Private::State::Next)
+                        break;
+
+                    // The body takes as long as it takes
+                    if (entry->timer)
                     {
-                        requestEntry->timer->disarm();
-                        timerPool_.releaseTimer(requestEntry->timer);
+                        entry->timer->disarm();
+                        timerPool_.releaseTimer(entry->timer);
+                        entry->timer = nullptr;
                     }
 
-                    requestEntry->resolve(std::move(parser.response));
-                    parser.reset();
+                    std::weak_ptr<Connection> weakConn = shared_from_this();
+                    stream->reader->resumeInput_       = [weakConn]() {
+                        if (auto conn = weakConn.lock())
+                        {
+                            conn->transport_->post([weakConn]() {
+                                if (auto conn = weakConn.lock())
+                                    conn->resumeInput();
+                            });
+                        }
+                    };
+                    parser.setBodyReader(stream->reader);
+
+                    stream->headersDone = true;
+                    stream->headersResolve(Response(parser.response));
+                }
+
+                // The input is left buffered until the reader is resumed
+                if (stream->reader->isPaused())
+                    break;
+
+                const auto state = parser.parse();
 
-                    auto onDone = requestEntry->onDone;
+                // What was handed to the reader is not needed anymore
+                parser.compactInput();
+                if (state != Private::State::Done)
+                    break;
+            }
+            else if (parser.parse() != Private::State::Done)
+            {
+                break;
+            }
 
-                    requestEntry.reset(nullptr);
+            auto done = std::move(requestEntries.front());
+            requestEntries.pop_front();
 
-                    if (onDone)
-                        onDone();
-                }
+            if (done->timer)
+            {
+                done->timer->disarm();
+                timerPool_.releaseTimer(done->timer);
             }
+
+            done->resolve(std::move(parser.response));
+            parser.resetForNextResponse();
+
+            if (done->onDone)
+                done->onDone();
+        }
+    }
+
+    bool Connection::isStreaming() const
+    {
+        return !requestEntries.empty() && requestEntries.front()->stream;
+    }
+
+    bool Connection::isInputPaused() const
+    {
+        return isStreaming() && requestEntries.front()->stream->reader->isPaused();
+    }
+
+    void Connection::resumeInput()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        try
+        {
+            parseResponses();
         }
         catch (const std::exception& ex)
         {
             handleError(ex.what());
         }
+
+        if (inputStalled_ && !isInputPaused())
+        {
+            inputStalled_ = false;
+            if (fd_ != PS_FD_EMPTY)
+                transport_->resumeReading(fd_);
+        }
     }
 
-    void Connection::handleError(const char* error)
+    std::deque<std::unique_ptr<Connection::RequestEntry>> Connection::takeRequestEntries()
     {
-        PS_TIMEDBG_START_THIS;
-
-        PS_LOG_DEBUG_ARGS("Error string %s", error);
+        std::deque<std::unique_ptr<RequestEntry>> entries;
+        entries.swap(requestEntries);
 
-        if (requestEntry)
+        for (auto& entry : entries)
         {
-            if (requestEntry->timer)
+            if (entry->timer)
             {
-                requestEntry->timer->disarm();
-                timerPool_.releaseTimer(requestEntry->timer);
+                entry->timer->disarm();
+                timerPool_.releaseTimer(entry->timer);
             }
+        }
+
+        // Whatever part of a response came in is no use anymore
+        parser.reset();
 
-            auto onDone = requestEntry->onDone;
+        return entries;
+    }
 
-            requestEntry->reject(Error(error));
+    void Connection::handleError(const char* error)
+    {
+        PS_TIMEDBG_START_THIS;
 
-            requestEntry.reset(nullptr);
+        PS_LOG_DEBUG_ARGS("Error string %s", error);
+
+        for (auto& entry : takeRequestEntries())
+        {
+            auto onDone = entry->onDone;
+
+            rejectRequest(*entry, Error(error));
 
             if (onDone)
                 onDone();
         }
     }
 
-    void Connection::handleTimeout()
+    void Connection::handleTimeout(const std::shared_ptr<TimerPool::Entry>& timer)
     {
         PS_TIMEDBG_START_THIS;
 
-        if (requestEntry)
-        {
-            requestEntry->timer->disarm();
-            timerPool_.releaseTimer(requestEntry->timer);
+        // The response, coming later, would be taken for that of the next
+        // request: the connection is closed, and the requests sent after
+        // this one fail with it
+        disconnect();
 
-            auto onDone = requestEntry->onDone;
+        for (auto& entry : takeRequestEntries())
+        {
+            auto onDone = entry->onDone;
 
             /* @API: create a TimeoutException */
-            requestEntry->reject(std::runtime_error("Timeout"));
-
-            requestEntry.reset(nullptr);
+            if (entry->timer == timer)
+                rejectRequest(*entry, std::runtime_error("Timeout"));
+            else
+                rejectRequest(*entry, Error("Connection closed, another request on it timed out"));
 
             if (onDone)
                 onDone();
@@ -1021,7 +1830,8 @@ namespace Pistache::Http::Experimental
 
     void Connection::performImpl(const Http::Request& request,
                                  Async::Resolver resolve, Async::Rejection reject,
-                                 Connection::OnDone onDone)
+                                 Connection::OnDone onDone,
+                                 std::shared_ptr<Stream> stream)
     {
         PS_TIMEDBG_START_THIS;
 
@@ -1034,14 +1844,44 @@ namespace Pistache::Http::Experimental
         std::shared_ptr<TimerPool::Entry> timer(nullptr);
         auto timeout = request.timeout();
         if (timeout.count() > 0)
-        {
             timer = timerPool_.pickTimer();
-            timer->arm(timeout);
+
+        requestEntries.push_back(std::make_unique<RequestEntry>(std::move(resolve), std::move(reject),
+                                                                timer, std::move(onDone),
+                                                                std::move(stream)));
+
+        if (timer)
+        {
+            std::weak_ptr<Connection> weakConn = shared_from_this();
+            std::weak_ptr<TimerPool::Entry> weakTimer = timer;
+            timer->arm(transport_->timers(), timeout, [weakConn, weakTimer]() {
+                auto conn = weakConn.lock();
+                auto expired = weakTimer.lock();
+
+                // The request may have completed, and the timer be in use for
+                // the next one, by the time this runs
+                if (!conn || !expired)
+                    return;
+
+                const auto& entries = conn->requestEntries;
+                if (std::any_of(std::begin(entries), std::end(entries),
+                                [&](const auto& entry) { return entry->timer == expired; }))
+                    conn->handleTimeout(expired);
+            });
         }
 
-        requestEntry = std::make_unique<RequestEntry>(std::move(resolve), std::move(reject),
-                                                      timer, std::move(onDone));
-        transport_->asyncSendRequest(shared_from_this(), timer, std::move(buffer));
+        transport_->asyncSendRequest(shared_from_this(), std::move(buffer));
+    }
+
+    void Connection::asyncPerformImpl(const Http::Request& request,
+                                      Async::Resolver resolve, Async::Rejection reject,
+                                      Connection::OnDone onDone,
+                                      std::shared_ptr<Stream> stream)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        requestsQueue.push(RequestData(std::move(resolve), std::move(reject),
+                                       request, std::move(onDone), std::move(stream)));
     }
 
     void Connection::processRequestQueue()
@@ -1055,72 +1895,93 @@ namespace Pistache::Http::Experimental
                 break;
 
             performImpl(req->request, std::move(req->resolve), std::move(req->reject),
-                        std::move(req->onDone));
+                        std::move(req->onDone), std::move(req->stream));
         }
     }
 
     void ConnectionPool::init(size_t maxConnectionsPerHostParm,
-                              size_t maxResponseSizeParm)
+                              size_t maxResponseSizeParm,
+                              size_t pipelineDepthParm)
     {
         this->maxConnectionsPerHost = maxConnectionsPerHostParm;
         this->maxResponseSize       = maxResponseSizeParm;
+        this->pipelineDepth         = std::max<size_t>(pipelineDepthParm, 1);
     }
 
     std::shared_ptr<Connection>
-    ConnectionPool::pickConnection(const std::string& domain)
+    ConnectionPool::pickConnection(const std::string& domain, bool idempotent)
     {
         PS_TIMEDBG_START_THIS;
 
-        Connections pool;
+        auto& pool = conns[domain];
 
+        // Idle, connected ones first
+        std::shared_ptr<Connection> picked;
+        for (auto& conn : pool)
         {
-            Guard guard(connsLock);
-            auto poolIt = conns.find(domain);
-            if (poolIt == std::end(conns))
-            {
-                Connections connections;
-                for (size_t i = 0; i < maxConnectionsPerHost; ++i)
-                {
-                    connections.push_back(std::make_shared<Connection>(maxResponseSize));
-                }
+            if (!conn->isIdle())
+                continue;
 
-                poolIt = conns.insert(std::make_pair(domain, std::move(connections))).first;
+            if (conn->isConnected())
+            {
+                picked = conn;
+                break;
             }
-            pool = poolIt->second;
+            if (!picked)
+                picked = conn;
         }
 
-        for (auto& conn : pool)
+        if (!picked && pool.size() < maxConnectionsPerHost)
+        {
+            pool.push_back(std::make_shared<Connection>(maxResponseSize));
+            picked = pool.back();
+        }
+
+        // Nothing may be pipelined behind a request that is not idempotent,
+        // nor be, one that is not (RFC 9112, 9.3.2)
+        if (!picked && pipelineDepth > 1 && idempotent)
         {
-            if (conn->tryUse())
+            for (auto& conn : pool)
             {
-                return conn;
+                if (conn->inFlight() >= pipelineDepth || conn->unsafeInFlight_ > 0)
+                    continue;
+                if (!conn->isConnected() && !conn->isConnecting())
+                    continue;
+
+                if (!picked || conn->inFlight() < picked->inFlight())
+                    picked = conn;
             }
         }
 
-        return nullptr;
+        if (picked)
+        {
+            picked->inFlight_.fetch_add(1, std::memory_order_relaxed);
+            if (!idempotent)
+                ++picked->unsafeInFlight_;
+        }
+
+        return picked;
     }
 
     void ConnectionPool::releaseConnection(
-        const std::shared_ptr<Connection>& connection)
+        const std::shared_ptr<Connection>& connection, bool idempotent)
     {
         PS_TIMEDBG_START_ARGS("connection %p", connection.get());
 
-        connection->setAsIdle();
+        connection->inFlight_.fetch_sub(1, std::memory_order_relaxed);
+        if (!idempotent)
+            --connection->unsafeInFlight_;
     }
 
     size_t ConnectionPool::usedConnections(const std::string& domain) const
     {
-        Connections pool;
+        auto it = conns.find(domain);
+        if (it == std::end(conns))
         {
-            Guard guard(connsLock);
-            auto it = conns.find(domain);
-            if (it == std::end(conns))
-            {
-                return 0;
-            }
-            pool = it->second;
+            return 0;
         }
 
+        const auto& pool = it->second;
         return std::count_if(pool.begin(), pool.end(),
                              [](const std::shared_ptr<Connection>& conn) {
                                  return conn->isConnected();
@@ -1129,17 +1990,13 @@ namespace Pistache::Http::Experimental
 
     size_t ConnectionPool::idleConnections(const std::string& domain) const
     {
-        Connections pool;
+        auto it = conns.find(domain);
+        if (it == std::end(conns))
         {
-            Guard guard(connsLock);
-            auto it = conns.find(domain);
-            if (it == std::end(conns))
-            {
-                return 0;
-            }
-            pool = it->second;
+            return 0;
         }
 
+        const auto& pool = it->second;
         return std::count_if(
             pool.begin(), pool.end(),
             [](const std::shared_ptr<Connection>& conn) { return conn->isIdle(); });
@@ -1158,16 +2015,22 @@ namespace Pistache::Http::Experimental
     {
         PS_TIMEDBG_START_THIS;
 
+        // The connections hold their transport, which holds the pool
+        auto pools = std::move(conns);
+        conns.clear();
+
         // close all connections
-        Guard guard(connsLock);
-        for (auto& it : conns)
+        for (auto& it : pools)
         {
             for (auto& conn : it.second)
             {
-                if (conn->isConnected())
+                if (conn->fd() != PS_FD_EMPTY)
                 {
                     conn->close();
                 }
+
+                conn->failConnect("Client is shut down");
+                conn->handleError("Client is shut down");
             }
         }
     }
@@ -1236,6 +2099,27 @@ namespace Pistache::Http::Experimental
         return client_->doRequest(request_);
     }
 
+    StreamedResponse RequestBuilder::stream(std::shared_ptr<BodyReader> reader)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        std::shared_ptr<Connection::Stream> stream;
+        Async::Promise<Response> headers(
+            [&](Async::Resolver& resolve, Async::Rejection& reject) {
+                stream = std::make_shared<Connection::Stream>(
+                    std::move(reader), std::move(resolve), std::move(reject));
+            });
+
+        auto done = client_->doRequest(request_, std::move(stream));
+        return StreamedResponse { std::move(headers), std::move(done) };
+    }
+
+    StreamedResponse
+    RequestBuilder::stream(std::function<void(const char* data, size_t len)> onData)
+    {
+        return stream(std::make_shared<CallbackReader>(std::move(onData)));
+    }
+
     Client::Options& Client::Options::threads(int val)
     {
         threads_ = val;
@@ -1260,75 +2144,92 @@ namespace Pistache::Http::Experimental
         return *this;
     }
 
+    Client::Options& Client::Options::pipelineDepth(size_t val)
+    {
+        pipelineDepth_ = val;
+        return *this;
+    }
+
+    Client::Options& Client::Options::maxQueuedRequests(size_t val)
+    {
+        maxQueuedRequests_ = val;
+        return *this;
+    }
+
+    Client::Options& Client::Options::resolver(std::shared_ptr<Dns::Resolver> val)
+    {
+        resolver_ = std::move(val);
+        return *this;
+    }
+
+    Client::Options& Client::Options::connectTimeout(std::chrono::milliseconds val)
+    {
+        connectTimeout_ = val;
+        return *this;
+    }
+
     Client::Client()
         : reactor_(Aio::Reactor::create())
-        , pool()
+        , resolver_(nullptr)
+        , transports_()
         , transportKey()
         , ioIndex(0)
-        , queuesLock()
-        , stopProcessRequestQueues(false)
-        , requestsQueues()
+        , stopped_(false)
     { }
 
     Client::~Client()
     {
         PS_TIMEDBG_START_THIS;
 
-        Guard guard(queuesLock);
-        assert(stopProcessRequestQueues == true && "You must explicitly call shutdown method of Client object");
+        assert(stopped_.load() == true && "You must explicitly call shutdown method of Client object");
     }
 
     Client::Options Client::options() { return Client::Options(); }
 
     void Client::init(const Client::Options& options)
     {
-        pool.init(options.maxConnectionsPerHost_, options.maxResponseSize_);
+        resolver_ = options.resolver_ ? options.resolver_ : std::make_shared<Dns::Resolver>();
         reactor_->init(Aio::AsyncContext(options.threads_));
-        transportKey = reactor_->addHandler(std::make_shared<Transport>());
+        transportKey = reactor_->addHandler(std::make_shared<Transport>(
+            resolver_, options.maxConnectionsPerHost_, options.maxResponseSize_,
+            options.pipelineDepth_, options.maxQueuedRequests_, options.connectTimeout_));
+
+        for (const auto& handler : reactor_->handlers(transportKey))
+            transports_.push_back(std::static_pointer_cast<Transport>(handler));
+
         reactor_->run();
     }
 
+    size_t Client::queuedRequests() const
+    {
+        size_t queued = 0;
+        for (const auto& transport : transports_)
+            queued += transport->queued();
+        return queued;
+    }
+
     void Client::shutdown()
     {
         PS_TIMEDBG_START_THIS;
 
         reactor_->shutdown();
-
-        { // encapsulate
-            GUARD_AND_DBG_LOG(queuesLock);
-            stopProcessRequestQueues = true;
-
-            // Note: Do not hold queuesLock locked beyond here - otherwise you
-            // can get into a deadlock with a transport_'s handling_mutex. Here
-            // we are locking queuesLock and then during shutdown we'll lock
-            // the handling_mutex. Conversely in onReady (handling), we'll
-            // lock handling_mutex first and may subsequently lock queuesLock
-            // to allow us to change a queue. By doing the locking in opposite
-            // order, without unlocking queuesLock here thanks to this
-            // encapsulate, we'd create a race-condition/deadlock.
-        }
-
-        // Note about the shutdown procedure. pool.shutdown()
-        // (ConnectionPool::shutdown()) calls Connection::close() for each
-        // connection in ConnectionPool::conns. Connection::close() claims and
-        // holds the transport_'s handling_mutex before excuting the connection
-        // and Fd close.
-        //
-        // Meanwhile, Transport::onReady claims and holds the handling_mutex
-        // while executing. So a connection close (which includes an Fd close)
-        // cannot happen while handling is going on - i.e. the Fd cannot be
-        // closed just when the handling needs it (which might otherwise happen
-        // when Transport::onReady called handleReadableEntry which in turn
-        // called handleIncoming(...)).
+        stopped_.store(true);
+
+        // Note about the shutdown procedure. Transport::shutdown() stops
+        // the handling of events, which Transport::onReady does holding the
+        // transport's handling_mutex. From then on, the transport's
+        // connections, and the requests waiting for them, can be used from
+        // here: the requests not sent are rejected, and the connections
+        // closed, failing those they had sent.
         //
-        // If the close() gets possession of the handling_mutex first, that is
-        // also managed - the close will remove the Fd that is being closed
-        // from the set of ready Fds before releasing the mutex and allowing
-        // onReady to proceed.
-
-        pool.shutdown();
-
-        PS_LOG_DEBUG_ARGS("Unlocking queuesLock %p", &queuesLock);
+        // Connection::close() claims the handling_mutex in turn before
+        // closing the connection's Fd, so that the Fd cannot be closed just
+        // when the handling needs it (which might otherwise happen when
+        // Transport::onReady called handleReadableEntry which in turn called
+        // handleIncoming(...)).
+
+        for (auto& transport : transports_)
+            transport->shutdown();
     }
 
     RequestBuilder Client::get(const std::string& resource)
@@ -1371,7 +2272,8 @@ namespace Pistache::Http::Experimental
         return builder;
     }
 
-    Async::Promise<Response> Client::doRequest(Http::Request request)
+    Async::Promise<Response> Client::doRequest(Http::Request request,
+                                               std::shared_ptr<Connection::Stream> stream)
     {
         PS_TIMEDBG_START_THIS;
 
@@ -1390,129 +2292,39 @@ namespace Pistache::Http::Experimental
                                 resourceData.c_str());
         }
 
-        auto conn = pool.pickConnection(std::string(resource.first));
-
-        if (conn == nullptr)
+        if (stopped_.load() || transports_.empty())
         {
-            PS_LOG_DEBUG("No connection found");
-
-            return Async::Promise<Response>([this, resource = std::move(resource),
-                                             request](Async::Resolver& resolve,
-                                                      Async::Rejection& reject) {
-                PS_TIMEDBG_START;
-
-                PS_LOG_DEBUG_ARGS("Locking queuesLock %p", &queuesLock);
-                Guard guard(queuesLock);
-
-                auto data = std::make_shared<Connection::RequestData>(
-                    std::move(resolve), std::move(reject), std::move(request), nullptr);
-                auto& queue = requestsQueues[std::string(resource.first)];
-                if (!queue.enqueue(data))
-                    data->reject(std::runtime_error("Queue is full"));
-
-                PS_LOG_DEBUG_ARGS("Unlocking queuesLock %p", &queuesLock);
-            });
+            if (stream)
+                stream->headersReject(Error("Client is not running"));
+            return Async::Promise<Response>::rejected(Error("Client is not running"));
         }
-        else
-        {
-            PS_LOG_DEBUG_ARGS("Connection found %p", conn.get());
-            if (!conn->hasTransport())
-            {
-                PS_LOG_DEBUG("No transport yet on connection");
-
-                auto transports = reactor_->handlers(transportKey);
-                auto index  = ioIndex.fetch_add(1) % transports.size();
-
-                auto transport = std::static_pointer_cast<Transport>(transports[static_cast<unsigned int>(index)]);
-                PS_LOG_DEBUG_ARGS("Associating transport %p on connection %p",
-                                  transport.get(), conn.get());
-                conn->associateTransport(transport);
-            }
 
-            if (!conn->isConnected())
+        // Sent by the thread it is made from when that is one of ours, as
+        // when made from the continuation of another request, so that its
+        // connections stay there. Otherwise, the threads take turns.
+        std::shared_ptr<Transport> transport;
+        for (const auto& candidate : transports_)
+        {
+            if (candidate->isOwnThread())
             {
-                PS_LOG_DEBUG_ARGS("Connection %p not connected yet",
-                                  conn.get());
-
-                std::weak_ptr<Connection> weakConn = conn;
-                auto res                           = conn->asyncPerform(request, [this, weakConn]() {
-                    auto conn = weakConn.lock();
-                    if (conn)
-                    {
-                        pool.releaseConnection(conn);
-                        processRequestQueue();
-                    }
-                });
-
-                PS_LOG_DEBUG("Making addr");
-                Address addr(helpers::httpAddr(resource.first,
-                                               https_url ? 443 : 0 /* default port*/));
-
-                PS_LOG_DEBUG_ARGS("Connection %p calling connect", conn.get());
-                conn->connect(addr);
-                return res;
+                transport = candidate;
+                break;
             }
-
-            std::weak_ptr<Connection> weakConn = conn;
-            return conn->perform(request, [this, weakConn]() {
-                auto conn = weakConn.lock();
-                if (conn)
-                {
-                    PS_LOG_DEBUG("Release connection");
-                    pool.releaseConnection(conn);
-                    processRequestQueue();
-                }
-                PS_LOG_DEBUG("Request performed");
-            });
         }
-    }
-
-    void Client::processRequestQueue()
-    {
-        PS_TIMEDBG_START_THIS;
-
-        if (stopProcessRequestQueues)
+        if (!transport)
         {
-            PS_LOG_DEBUG("Already shutting down, skip processRequestQueue");
-            return;
+            const auto index = ioIndex.fetch_add(1) % transports_.size();
+            transport        = transports_[static_cast<size_t>(index)];
         }
 
-        PS_LOG_DEBUG_ARGS("Locking queuesLock %p", &queuesLock);
-        Guard guard(queuesLock);
-
-        if (stopProcessRequestQueues)
-        {
-            PS_LOG_DEBUG("Already shutting down, skip processRequestQueue");
-            PS_LOG_DEBUG_ARGS("Unlocking queuesLock %p", &queuesLock);
-            return;
-        }
-
-        for (auto& queues : requestsQueues)
-        {
-            for (;;)
-            {
-                const auto& domain = queues.first;
-                auto conn          = pool.pickConnection(domain);
-                if (!conn)
-                    break;
-
-                auto& queue = queues.second;
-                std::shared_ptr<Connection::RequestData> data;
-                if (!queue.dequeue(data))
-                {
-                    pool.releaseConnection(conn);
-                    break;
-                }
-
-                conn->performImpl(data->request, std::move(data->resolve),
-                                  std::move(data->reject), [this, conn]() {
-                                      pool.releaseConnection(conn);
-                                      processRequestQueue();
-                                  });
-            }
-        }
+        return Async::Promise<Response>(
+            [&](Async::Resolver& resolve, Async::Rejection& reject) {
+                PS_TIMEDBG_START;
 
-        PS_LOG_DEBUG_ARGS("Unlocking queuesLock %p", &queuesLock);
+                transport->submit(Transport::Submission(
+                    std::move(resolve), std::move(reject), std::move(request),
+                    std::string(resource.first), https_url, std::move(stream)));
+            });
     }
 
 } // namespace Pistache::Http
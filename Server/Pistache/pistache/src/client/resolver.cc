@@ -0,0 +1,409 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* resolver.cc
+
+   Implementation of the asynchronous resolution of host names
+*/
+
+#include <pistache/winornix.h>
+
+#include <pistache/pist_syslog.h>
+#include <pistache/resolver.h>
+
+#include PST_ARPA_INET_HDR
+#include PST_NETDB_HDR
+#include PST_SOCKET_HDR
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+
+namespace Pistache::Dns
+{
+
+    namespace
+    {
+        // Set on a worker that destroyed its own resolver, by dropping the
+        // last reference to it from a continuation
+        thread_local bool tResolverDestroyed = false;
+
+        IP withPort(const IP& ip, Port port)
+        {
+            struct sockaddr_storage storage = {};
+            const auto& addr                = ip.getSockAddr();
+
+            if (addr.sa_family == AF_INET6)
+            {
+                std::memcpy(&storage, &addr, sizeof(struct sockaddr_in6));
+                reinterpret_cast<struct sockaddr_in6*>(&storage)->sin6_port = htons(port);
+            }
+            else
+            {
+                std::memcpy(&storage, &addr, sizeof(struct sockaddr_in));
+                reinterpret_cast<struct sockaddr_in*>(&storage)->sin_port = htons(port);
+            }
+
+            return IP(reinterpret_cast<const struct sockaddr*>(&storage));
+        }
+
+        std::string toLower(const std::string& host)
+        {
+            std::string lower(host);
+            std::transform(lower.begin(), lower.end(), lower.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return lower;
+        }
+
+        int lookupHost(const std::string& host, Port port, int flags,
+                       std::vector<IP>& addresses)
+        {
+            struct addrinfo hints = {};
+            hints.ai_family       = AF_UNSPEC;
+            hints.ai_socktype     = SOCK_STREAM;
+            hints.ai_protocol     = IPPROTO_TCP;
+            hints.ai_flags        = flags;
+
+            AddrInfo addrInfo;
+            const int err = addrInfo.invoke(host.c_str(), port.toString().c_str(), &hints);
+            if (err != 0)
+                return err;
+
+            for (const addrinfo* info = addrInfo.get_info_ptr(); info; info = info->ai_next)
+            {
+                if (info->ai_family == AF_INET || info->ai_family == AF_INET6)
+                    addresses.emplace_back(info->ai_addr);
+            }
+
+            return 0;
+        }
+    }
+
+    Resolver::Options::Options()
+        : threads_(DefaultThreads)
+        , positiveTtl_(DefaultPositiveTtl)
+        , negativeTtl_(DefaultNegativeTtl)
+        , maxEntries_(DefaultMaxEntries)
+    { }
+
+    Resolver::Options& Resolver::Options::threads(size_t val)
+    {
+        threads_ = val;
+        return *this;
+    }
+
+    Resolver::Options& Resolver::Options::positiveTtl(std::chrono::milliseconds val)
+    {
+        positiveTtl_ = val;
+        return *this;
+    }
+
+    Resolver::Options& Resolver::Options::negativeTtl(std::chrono::milliseconds val)
+    {
+        negativeTtl_ = val;
+        return *this;
+    }
+
+    Resolver::Options& Resolver::Options::maxEntries(size_t val)
+    {
+        maxEntries_ = val;
+        return *this;
+    }
+
+    Resolver::Options Resolver::options() { return Options(); }
+
+    Resolver::Resolver(const Options& options)
+        : threads_(options.threads_)
+        , positiveTtl_(options.positiveTtl_)
+        , negativeTtl_(options.negativeTtl_)
+        , maxEntries_(options.maxEntries_)
+    { }
+
+    Resolver::~Resolver()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopping_ = true;
+        }
+        queriesCond_.notify_all();
+
+        const auto self = std::this_thread::get_id();
+        for (auto& worker : workers_)
+        {
+            // A thread can not join itself: it is let go instead, and leaves
+            // run() without touching the resolver again
+            if (worker.get_id() == self)
+            {
+                tResolverDestroyed = true;
+                worker.detach();
+            }
+            else
+            {
+                worker.join();
+            }
+        }
+
+        // Queued queries that no thread got to
+        std::unordered_map<std::string, std::vector<Waiter>> waiters;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            waiters.swap(waiters_);
+        }
+
+        for (auto& [key, list] : waiters)
+        {
+            for (auto& waiter : list)
+                waiter.reject(Error("Resolver shut down before resolving " + key));
+        }
+    }
+
+    Async::Promise<std::vector<IP>> Resolver::resolve(const std::string& host, Port port)
+    {
+        std::vector<IP> addresses;
+
+        // Numeric addresses need no query
+        if (lookupHost(host, port, AI_NUMERICHOST, addresses) == 0 && !addresses.empty())
+            return Async::Promise<std::vector<IP>>::resolved(std::move(addresses));
+
+        const auto name = toLower(host);
+        const auto key  = name + ':' + port.toString();
+
+        Query query;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            auto staticHost = hosts_.find(name);
+            if (staticHost != std::end(hosts_))
+            {
+                for (const auto& ip : staticHost->second)
+                    addresses.push_back(withPort(ip, port));
+                return Async::Promise<std::vector<IP>>::resolved(std::move(addresses));
+            }
+
+            auto cached = cache_.find(key);
+            if (cached != std::end(cache_))
+            {
+                if (cached->second.expires > Clock::now())
+                {
+                    ++hits_;
+                    if (!cached->second.error.empty())
+                        return Async::Promise<std::vector<IP>>::rejected(Error(cached->second.error));
+
+                    return Async::Promise<std::vector<IP>>::resolved(cached->second.addresses);
+                }
+
+                cache_.erase(cached);
+            }
+        }
+
+        bool runNow = false;
+        auto promise = Async::Promise<std::vector<IP>>(
+            [&](Async::Resolver& resolve, Async::Rejection& reject) {
+                std::lock_guard<std::mutex> guard(mutex_);
+
+                // Already being looked up for someone else
+                auto& waiters     = waiters_[key];
+                const bool queued = !waiters.empty();
+                waiters.push_back(Waiter { std::move(resolve), std::move(reject) });
+                if (queued)
+                    return;
+
+                ++lookups_;
+                query = Query { key, name, port };
+                if (threads_ == 0 || stopping_)
+                {
+                    runNow = true;
+                    return;
+                }
+
+                // The threads are only started once there is work for them
+                if (workers_.empty())
+                    start();
+
+                queries_.push_back(query);
+                queriesCond_.notify_one();
+            });
+
+        if (runNow)
+            lookup(query);
+
+        return promise;
+    }
+
+    void Resolver::lookup(const Query& query)
+    {
+        Entry entry;
+        const int err = lookupHost(query.host, query.port, 0, entry.addresses);
+        if (err != 0 || entry.addresses.empty())
+        {
+            entry.addresses.clear();
+            entry.error = "Could not resolve " + query.host + ": " + (err != 0 ? gai_strerror(err) : "no address found");
+            entry.expires = Clock::now() + negativeTtl_;
+            PS_LOG_DEBUG_ARGS("%s", entry.error.c_str());
+        }
+        else
+        {
+            entry.addresses = interleave(std::move(entry.addresses));
+            entry.expires   = Clock::now() + positiveTtl_;
+        }
+
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            auto found = waiters_.find(query.key);
+            if (found != std::end(waiters_))
+            {
+                waiters = std::move(found->second);
+                waiters_.erase(found);
+            }
+
+            insert(query.key, entry);
+        }
+
+        // Continuations run here, outside of the lock
+        for (auto& waiter : waiters)
+        {
+            if (entry.error.empty())
+                waiter.resolve(entry.addresses);
+            else
+                waiter.reject(Error(entry.error));
+        }
+    }
+
+    void Resolver::insert(const std::string& key, Entry entry)
+    {
+        if (maxEntries_ == 0)
+            return;
+
+        if (cache_.size() >= maxEntries_ && cache_.find(key) == std::end(cache_))
+        {
+            const auto now = Clock::now();
+            for (auto it = std::begin(cache_); it != std::end(cache_);)
+            {
+                if (it->second.expires <= now)
+                    it = cache_.erase(it);
+                else
+                    ++it;
+            }
+
+            // Then the one closest to expiring
+            if (cache_.size() >= maxEntries_)
+            {
+                auto first = std::min_element(std::begin(cache_), std::end(cache_),
+                                              [](const auto& lhs, const auto& rhs) {
+                                                  return lhs.second.expires < rhs.second.expires;
+                                              });
+                cache_.erase(first);
+            }
+        }
+
+        cache_[key] = std::move(entry);
+    }
+
+    void Resolver::addHost(const std::string& host, std::vector<IP> addresses)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        hosts_[toLower(host)] = std::move(addresses);
+    }
+
+    void Resolver::removeHost(const std::string& host)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        hosts_.erase(toLower(host));
+    }
+
+    size_t Resolver::cacheSize() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return cache_.size();
+    }
+
+    uint64_t Resolver::lookups() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return lookups_;
+    }
+
+    uint64_t Resolver::cacheHits() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return hits_;
+    }
+
+    void Resolver::clearCache()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        cache_.clear();
+    }
+
+    std::vector<IP> Resolver::interleave(std::vector<IP> addresses)
+    {
+        if (addresses.size() < 2)
+            return addresses;
+
+        const int first = addresses.front().getFamily();
+
+        std::vector<IP> preferred;
+        std::vector<IP> other;
+        for (auto& ip : addresses)
+        {
+            if (ip.getFamily() == first)
+                preferred.push_back(std::move(ip));
+            else
+                other.push_back(std::move(ip));
+        }
+
+        std::vector<IP> result;
+        result.reserve(addresses.size());
+        for (size_t i = 0; i < preferred.size() || i < other.size(); ++i)
+        {
+            if (i < preferred.size())
+                result.push_back(std::move(preferred[i]));
+            if (i < other.size())
+                result.push_back(std::move(other[i]));
+        }
+
+        return result;
+    }
+
+    void Resolver::start()
+    {
+        workers_.reserve(threads_);
+        for (size_t i = 0; i < threads_; ++i)
+            workers_.emplace_back([this] { run(); });
+    }
+
+    void Resolver::run()
+    {
+        std::unique_lock<std::mutex> guard(mutex_);
+        for (;;)
+        {
+            queriesCond_.wait(guard, [this] { return stopping_ || !queries_.empty(); });
+            if (stopping_)
+                break;
+
+            auto query = std::move(queries_.front());
+            queries_.pop_front();
+
+            guard.unlock();
+            try
+            {
+                lookup(query);
+            }
+            catch (const std::exception& e)
+            {
+                PS_LOG_WARNING_ARGS("Resolving %s failed: %s", query.host.c_str(), e.what());
+            }
+
+            if (tResolverDestroyed)
+                return;
+            guard.lock();
+        }
+    }
+
+} // namespace Pistache::Dns
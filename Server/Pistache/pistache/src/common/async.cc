@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* async.cc
+
+   Implementation of the per-thread pool of promise cores and continuations
+*/
+
+#include <pistache/async.h>
+
+#include <new>
+
+namespace Pistache::Async::Private
+{
+
+    namespace
+    {
+        // Blocks are pooled in size classes of Granularity bytes. Larger
+        // ones, which no core or continuation of Pistache's own comes close
+        // to, go to the heap.
+        constexpr size_t Granularity   = 32;
+        constexpr size_t MaxPooledSize = 512;
+        constexpr size_t Classes       = MaxPooledSize / Granularity;
+
+        // Past that many free blocks of a class, the thread gives them back
+        // to the heap. A thread that settles promises made by another one
+        // would otherwise keep every block it is given back.
+        constexpr size_t MaxFreeBlocks = 128;
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        // Trivially destructible, so that it can still be used once the
+        // thread's Reaper has gone
+        struct Pool
+        {
+            FreeBlock* free[Classes];
+            size_t count[Classes];
+            PoolStats stats;
+            bool armed;
+            bool gone;
+        };
+
+        thread_local Pool pool = {};
+
+        size_t sizeClass(size_t size) { return (size + Granularity - 1) / Granularity - 1; }
+
+        // Gives the free blocks of the thread back when it exits. Blocks
+        // freed after that, by the destructors of other thread locals, go
+        // to the heap right away.
+        struct Reaper
+        {
+            ~Reaper()
+            {
+                for (size_t i = 0; i < Classes; ++i)
+                {
+                    while (auto* block = pool.free[i])
+                    {
+                        pool.free[i] = block->next;
+                        ::operator delete(block);
+                    }
+                    pool.count[i] = 0;
+                }
+                pool.gone = true;
+            }
+        };
+
+        thread_local Reaper reaper;
+
+        // Blocks may be given back on a thread that never took one
+        void arm()
+        {
+            if (!pool.armed)
+            {
+                pool.armed = true;
+                (void)&reaper;
+            }
+        }
+    }
+
+    void* allocateBlock(size_t size)
+    {
+        if (size == 0 || size > MaxPooledSize || pool.gone)
+            return ::operator new(size);
+
+        const auto cls = sizeClass(size);
+        if (auto* block = pool.free[cls])
+        {
+            pool.free[cls] = block->next;
+            --pool.count[cls];
+            ++pool.stats.reused;
+            return block;
+        }
+
+        ++pool.stats.allocated;
+        return ::operator new((cls + 1) * Granularity);
+    }
+
+    void deallocateBlock(void* block, size_t size) noexcept
+    {
+        if (size == 0 || size > MaxPooledSize || pool.gone)
+        {
+            ::operator delete(block);
+            return;
+        }
+
+        const auto cls = sizeClass(size);
+        if (pool.count[cls] >= MaxFreeBlocks)
+        {
+            ::operator delete(block);
+            return;
+        }
+
+        arm();
+
+        auto* free     = static_cast<FreeBlock*>(block);
+        free->next     = pool.free[cls];
+        pool.free[cls] = free;
+        ++pool.count[cls];
+    }
+
+    PoolStats poolStats() { return pool.stats; }
+
+} // namespace Pistache::Async::Private
@@ -0,0 +1,354 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* compression.cc
+
+   Implementation of the compression of response bodies
+*/
+
+#include <pistache/compression.h>
+#include <pistache/pist_syslog.h>
+
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+#include <zlib.h>
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Pistache::Http
+{
+
+    std::string compress(Header::Encoding encoding, [[maybe_unused]] int level,
+                         [[maybe_unused]] const char* data, [[maybe_unused]] size_t size)
+    {
+        switch (encoding)
+        {
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        case Header::Encoding::Br: {
+            // Upper bound on the size of the compressed data, which the
+            // encoder then updates to the size it used
+            size_t compressedSize = ::BrotliEncoderMaxCompressedSize(size);
+            if (compressedSize == 0)
+                throw std::runtime_error("BrotliEncoderMaxCompressedSize() failed");
+
+            std::string compressed(compressedSize, '\0');
+            const auto status = ::BrotliEncoderCompress(
+                level,
+                BROTLI_DEFAULT_WINDOW,
+                BROTLI_DEFAULT_MODE,
+                size,
+                reinterpret_cast<const uint8_t*>(data),
+                &compressedSize,
+                reinterpret_cast<uint8_t*>(compressed.data()));
+
+            if (status != BROTLI_TRUE)
+                throw std::runtime_error("BrotliEncoderCompress() failed");
+
+            compressed.resize(compressedSize);
+            return compressed;
+        }
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        case Header::Encoding::Zstd: {
+            std::string compressed(ZSTD_compressBound(size), '\0');
+
+            const auto compressedSize = ZSTD_compress(compressed.data(), compressed.size(),
+                                                      data, size, level);
+            if (ZSTD_isError(compressedSize))
+                throw std::runtime_error(
+                    std::string("failed to compress data to ZSTD on ZSTD_compress(), returning: ") + std::to_string(compressedSize));
+
+            compressed.resize(compressedSize);
+            return compressed;
+        }
+#endif
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        case Header::Encoding::Deflate: {
+            // Upper bound, updated by compress2()
+            uLongf compressedSize = static_cast<uLongf>(::compressBound(static_cast<uLong>(size)));
+
+            std::string compressed(compressedSize, '\0');
+            const auto status = ::compress2(
+                reinterpret_cast<unsigned char*>(compressed.data()),
+                &compressedSize,
+                reinterpret_cast<const unsigned char*>(data),
+                static_cast<uLong>(size),
+                level);
+
+            if (status != Z_OK)
+                throw std::runtime_error(
+                    std::string("compress2() failed, returning: ") + std::to_string(status));
+
+            compressed.resize(compressedSize);
+            return compressed;
+        }
+#endif
+
+        default:
+            throw std::runtime_error("Unsupported content encoding compression requested.");
+        }
+    }
+
+    Compressor::Options::Options()
+        : minSize_(DefaultMinSize)
+        , asyncMinSize_(DefaultAsyncMinSize)
+        , threads_(DefaultThreads)
+        , maxCachedBodies_(DefaultMaxCachedBodies)
+        , maxCacheMemory_(DefaultMaxCacheMemory)
+        , maxCachedSize_(DefaultMaxCachedSize)
+    { }
+
+    Compressor::Options& Compressor::Options::minSize(size_t val)
+    {
+        minSize_ = val;
+        return *this;
+    }
+
+    Compressor::Options& Compressor::Options::asyncMinSize(size_t val)
+    {
+        asyncMinSize_ = val;
+        return *this;
+    }
+
+    Compressor::Options& Compressor::Options::threads(size_t val)
+    {
+        threads_ = val;
+        return *this;
+    }
+
+    Compressor::Options& Compressor::Options::maxCachedBodies(size_t val)
+    {
+        maxCachedBodies_ = val;
+        return *this;
+    }
+
+    Compressor::Options& Compressor::Options::maxCacheMemory(size_t val)
+    {
+        maxCacheMemory_ = val;
+        return *this;
+    }
+
+    Compressor::Options& Compressor::Options::maxCachedSize(size_t val)
+    {
+        maxCachedSize_ = val;
+        return *this;
+    }
+
+    Compressor::Options Compressor::options() { return Options(); }
+
+    Compressor::Compressor(const Options& options)
+        : minSize_(options.minSize_)
+        , asyncMinSize_(options.asyncMinSize_)
+        , threads_(options.threads_)
+        , maxCachedBodies_(options.maxCachedBodies_)
+        , maxCacheMemory_(options.maxCacheMemory_)
+        , maxCachedSize_(options.maxCachedSize_)
+    { }
+
+    Compressor::~Compressor()
+    {
+        {
+            std::lock_guard<std::mutex> guard(tasksMutex_);
+            stopping_ = true;
+        }
+        tasksCond_.notify_all();
+
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    size_t Compressor::KeyHash::operator()(const Key& key) const
+    {
+        // The hash of the content is already well spread
+        return static_cast<size_t>(key.hash ^ (key.size * 0x9e3779b97f4a7c15ULL) ^ (static_cast<uint64_t>(key.encoding) << 56) ^ static_cast<uint64_t>(key.level));
+    }
+
+    Compressor::Key Compressor::makeKey(Header::Encoding encoding, int level,
+                                        const char* data, size_t size)
+    {
+        const auto hash = std::hash<std::string_view>()(std::string_view(data, size));
+        return Key { static_cast<uint64_t>(hash), size, encoding, level };
+    }
+
+    std::shared_ptr<const std::string> Compressor::find(Header::Encoding encoding, int level,
+                                                        const char* data, size_t size)
+    {
+        if (size > maxCachedSize_)
+            return nullptr;
+
+        return lookup(makeKey(encoding, level, data, size), std::string_view(data, size));
+    }
+
+    std::shared_ptr<const std::string> Compressor::compress(Header::Encoding encoding, int level,
+                                                            const char* data, size_t size)
+    {
+        if (size > maxCachedSize_)
+            return std::make_shared<const std::string>(Http::compress(encoding, level, data, size));
+
+        const auto key = makeKey(encoding, level, data, size);
+        const std::string_view body(data, size);
+        if (auto compressed = lookup(key, body))
+            return compressed;
+
+        auto compressed = std::make_shared<const std::string>(Http::compress(encoding, level, data, size));
+        insert(key, body, compressed);
+        return compressed;
+    }
+
+    std::shared_ptr<const std::string> Compressor::lookup(const Key& key, std::string_view body)
+    {
+        std::lock_guard<std::mutex> guard(cacheMutex_);
+
+        auto found = index_.find(key);
+        if (found == std::end(index_))
+            return nullptr;
+
+        // Another body with the same hash
+        auto it = found->second;
+        if (it->body != body)
+            return nullptr;
+
+        lru_.splice(std::begin(lru_), lru_, it);
+        ++hits_;
+        return it->compressed;
+    }
+
+    void Compressor::insert(const Key& key, std::string_view body,
+                            std::shared_ptr<const std::string> compressed)
+    {
+        const size_t memory = body.size() + compressed->size();
+        if (maxCachedBodies_ == 0 || memory > maxCacheMemory_)
+            return;
+
+        std::lock_guard<std::mutex> guard(cacheMutex_);
+
+        // Compressed on another thread in the meantime, or colliding with
+        // another body, which is then replaced
+        auto found = index_.find(key);
+        if (found != std::end(index_))
+            erase(found->second);
+
+        while (!lru_.empty() && (lru_.size() >= maxCachedBodies_ || memory_ + memory > maxCacheMemory_))
+            erase(std::prev(std::end(lru_)));
+
+        lru_.push_front(Entry { key, std::string(body), std::move(compressed) });
+        index_[key] = std::begin(lru_);
+        memory_ += memory;
+    }
+
+    void Compressor::erase(Lru::iterator it)
+    {
+        memory_ -= it->body.size() + it->compressed->size();
+        index_.erase(it->key);
+        lru_.erase(it);
+    }
+
+    size_t Compressor::cacheSize() const
+    {
+        std::lock_guard<std::mutex> guard(cacheMutex_);
+        return lru_.size();
+    }
+
+    size_t Compressor::cacheMemoryUsage() const
+    {
+        std::lock_guard<std::mutex> guard(cacheMutex_);
+        return memory_;
+    }
+
+    uint64_t Compressor::cacheHits() const
+    {
+        std::lock_guard<std::mutex> guard(cacheMutex_);
+        return hits_;
+    }
+
+    void Compressor::clearCache()
+    {
+        std::lock_guard<std::mutex> guard(cacheMutex_);
+
+        lru_.clear();
+        index_.clear();
+        memory_ = 0;
+    }
+
+    void Compressor::post(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> guard(tasksMutex_);
+            if (threads_ > 0 && !stopping_)
+            {
+                // The threads are only started once there is work for them
+                if (workers_.empty())
+                    start();
+
+                tasks_.push_back(std::move(task));
+                tasksCond_.notify_one();
+                return;
+            }
+        }
+
+        task();
+    }
+
+    void Compressor::wait()
+    {
+        std::unique_lock<std::mutex> guard(tasksMutex_);
+        idleCond_.wait(guard, [this] { return tasks_.empty() && running_ == 0; });
+    }
+
+    void Compressor::start()
+    {
+        workers_.reserve(threads_);
+        for (size_t i = 0; i < threads_; ++i)
+            workers_.emplace_back([this] { run(); });
+    }
+
+    void Compressor::run()
+    {
+        std::unique_lock<std::mutex> guard(tasksMutex_);
+        for (;;)
+        {
+            tasksCond_.wait(guard, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                break;
+
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++running_;
+
+            guard.unlock();
+            try
+            {
+                task();
+            }
+            catch (const std::exception& e)
+            {
+                PS_LOG_WARNING_ARGS("Compression task failed: %s", e.what());
+            }
+
+            // What the task held, such as a response writer, is let go of
+            // outside of the lock
+            task = nullptr;
+            guard.lock();
+
+            if (--running_ == 0 && tasks_.empty())
+                idleCond_.notify_all();
+        }
+    }
+
+} // namespace Pistache::Http
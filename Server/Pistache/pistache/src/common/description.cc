@@ -495,7 +495,7 @@ namespace Pistache::Rest
                 else
                 {
                     auto index = uiDir.join("index.html");
-                    Http::serveFile(response, index);
+                    Http::serveFile(req, response, index);
                 }
                 return Route::Result::Ok;
             }
@@ -509,7 +509,7 @@ namespace Pistache::Rest
                 // In C++20, use std::string::starts_with()
                 if (path.rfind(uiDirectory_, 0) == 0)
                 {
-                    Http::serveFile(response, path);
+                    Http::serveFile(req, response, path);
                     return Route::Result::Ok;
                 }
                 else
@@ -0,0 +1,548 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* file_cache.cc
+
+   Implementation of the cache of files served by Http::serveFile
+*/
+
+#include <pistache/winornix.h>
+
+#include <pistache/file_cache.h>
+#include <pistache/pist_syslog.h>
+
+#include PST_STRERROR_R_HDR
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <iterator>
+
+#include <fcntl.h> // for file-constants (_O_RDONLY etc.) in Windows
+#include PST_FCNTL_HDR
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include PST_MISC_IO_HDR // for close (io.h / unistd.h)
+#include PIST_FILEFNS_HDR // for PST_FILE_OPEN and PST_FILE_PREAD
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace Pistache::Http
+{
+
+    namespace
+    {
+        uint64_t modificationTimeNs(const struct stat& sb)
+        {
+#if defined(__APPLE__)
+            return static_cast<uint64_t>(sb.st_mtimespec.tv_sec) * 1000000000 + static_cast<uint64_t>(sb.st_mtimespec.tv_nsec);
+#elif defined(_IS_WINDOWS)
+            return static_cast<uint64_t>(sb.st_mtime) * 1000000000;
+#else
+            return static_cast<uint64_t>(sb.st_mtim.tv_sec) * 1000000000 + static_cast<uint64_t>(sb.st_mtim.tv_nsec);
+#endif
+        }
+
+        std::string makeETag(const struct stat& sb)
+        {
+            char etag[64];
+            std::snprintf(etag, sizeof etag, "\"%" PRIx64 "-%" PRIx64 "-%" PRIx64 "\"",
+                          static_cast<uint64_t>(sb.st_ino),
+                          static_cast<uint64_t>(sb.st_size),
+                          modificationTimeNs(sb));
+            return etag;
+        }
+
+        bool sameFile(const struct stat& lhs, const struct stat& rhs)
+        {
+            return lhs.st_dev == rhs.st_dev && lhs.st_ino == rhs.st_ino && lhs.st_size == rhs.st_size && modificationTimeNs(lhs) == modificationTimeNs(rhs);
+        }
+
+        // Of the directory and name of path
+        std::pair<std::string, std::string> splitPath(const std::string& path)
+        {
+            const auto slash = path.rfind('/');
+            if (slash == std::string::npos)
+                return { ".", path };
+            return { path.substr(0, std::max<size_t>(slash, 1)), path.substr(slash + 1) };
+        }
+
+#ifdef __linux__
+        // Anything that changes what would be served
+        constexpr uint32_t WatchMask = IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF;
+        // A file showing up in a directory
+        constexpr uint32_t DirWatchMask = IN_CREATE | IN_MOVED_TO | IN_ONLYDIR | IN_MASK_ADD;
+#endif
+    } // namespace
+
+    FileCache::FileCache(size_t maxFiles, size_t maxMemory, size_t maxInMemoryFileSize)
+        : maxFiles_(maxFiles)
+        , maxMemory_(maxMemory)
+        , maxInMemoryFileSize_(maxInMemoryFileSize)
+    {
+#ifdef __linux__
+        inotifyFd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd_ == -1)
+        {
+            PST_DECL_SE_ERR_P_EXTRA;
+            PS_LOG_WARNING_ARGS("inotify_init1 failed, files will be stat'ed instead: %s",
+                                PST_STRERROR_R_ERRNO);
+        }
+#endif
+    }
+
+    FileCache::~FileCache()
+    {
+        clear();
+
+        if (inotifyFd_ != -1)
+            ::close(inotifyFd_);
+    }
+
+    std::shared_ptr<const CachedFile> FileCache::get(const std::string& path)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        processEvents();
+
+        auto found = index_.find(path);
+        if (found != std::end(index_))
+        {
+            auto it = found->second;
+            if (isCurrent(*it))
+            {
+                lru_.splice(std::begin(lru_), lru_, it);
+
+                if (++it->hits == HotAfter)
+                    promote(*it);
+
+                return it->file;
+            }
+
+            erase(it);
+        }
+
+        Entry entry;
+        entry.path = path;
+        entry.hits = 1;
+
+        lru_.push_front(std::move(entry));
+        index_[path] = std::begin(lru_);
+
+        try
+        {
+            auto file = load(path, lru_.front());
+            evict();
+            return file;
+        }
+        catch (...)
+        {
+            erase(std::begin(lru_));
+            throw;
+        }
+    }
+
+    std::shared_ptr<const CachedFile> FileCache::tryGet(const std::string& path)
+    {
+        bool cached;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            processEvents();
+            cached = index_.count(path) > 0;
+        }
+
+        // Most files asked for this way do not exist, which is cheaper to
+        // find out than to have get() throw
+        struct stat sb;
+        if (!cached && (::stat(path.c_str(), &sb) == -1 || (sb.st_mode & S_IFMT) != S_IFREG))
+            return nullptr;
+
+        try
+        {
+            return get(path);
+        }
+        catch (const HttpError& error)
+        {
+            // Removed in the meantime
+            if (error.code() == static_cast<int>(Code::Not_Found))
+                return nullptr;
+            throw;
+        }
+    }
+
+    std::shared_ptr<const CachedFile> FileCache::tryGetSidecar(const std::string& path,
+                                                               const std::string& extension)
+    {
+        unsigned dirChanges = 0;
+        bool watched        = false;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            processEvents();
+
+            auto found = index_.find(path);
+            if (found != std::end(index_))
+            {
+                auto& entry = *found->second;
+                const auto& missing = entry.missingSidecars;
+                if (std::find(std::begin(missing), std::end(missing), extension) != std::end(missing))
+                    return nullptr;
+
+                // Before looking, so that no sidecar created after can go
+                // unnoticed
+                watched    = watchDirectory(entry);
+                dirChanges = entry.dirChanges;
+            }
+        }
+
+        auto sidecar = tryGet(path + extension);
+        if (sidecar || !watched)
+            return sidecar;
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        processEvents();
+
+        auto found = index_.find(path);
+        if (found != std::end(index_) && found->second->dirWatch != -1 && found->second->dirChanges == dirChanges)
+            found->second->missingSidecars.push_back(extension);
+
+        return nullptr;
+    }
+
+    void FileCache::invalidate(const std::string& path)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto found = index_.find(path);
+        if (found != std::end(index_))
+            erase(found->second);
+    }
+
+    void FileCache::clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        while (!lru_.empty())
+            erase(std::begin(lru_));
+    }
+
+    size_t FileCache::size() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return lru_.size();
+    }
+
+    size_t FileCache::memoryUsage() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return memory_;
+    }
+
+    FileCache& FileCache::global()
+    {
+        static FileCache cache;
+        return cache;
+    }
+
+    std::shared_ptr<const CachedFile> FileCache::load(const std::string& path, Entry& entry)
+    {
+        int fd = PST_FILE_OPEN(path.c_str(), PST_O_RDONLY);
+        if (fd == -1)
+        {
+            const int err = errno;
+
+            PST_DECL_SE_ERR_P_EXTRA;
+            std::string str_error(PST_STRERROR_R_ERRNO);
+            if (err == ENOENT || err == ENOTDIR)
+                throw HttpError(Code::Not_Found, std::move(str_error));
+
+            throw HttpError(Code::Internal_Server_Error, std::move(str_error));
+        }
+
+        auto file = std::make_shared<CachedFile>();
+        file->file = std::make_shared<const OpenFile>(fd);
+
+        // Watched before its stats are taken, so that no change made after
+        // them can go unnoticed
+        watch(entry);
+
+        struct stat sb;
+        if (::fstat(fd, &sb) == -1)
+            throw HttpError(Code::Internal_Server_Error, "Could not get file stats");
+
+        if ((sb.st_mode & S_IFMT) != S_IFREG)
+            throw HttpError(Code::Not_Found, "Not a regular file");
+
+        // The watch is on whatever path named when it was added, which may
+        // already not have been the file opened
+        struct stat current;
+        if (entry.watch != -1 && (::stat(path.c_str(), &current) == -1 || !sameFile(sb, current)))
+            unwatch(entry);
+
+        entry.device = static_cast<uint64_t>(sb.st_dev);
+        entry.inode  = static_cast<uint64_t>(sb.st_ino);
+
+        file->size         = static_cast<size_t>(sb.st_size);
+        file->lastModified = FullDate(std::chrono::system_clock::time_point(
+            std::chrono::seconds(sb.st_mtime)));
+        file->etag = makeETag(sb);
+        file->mime = Mime::MediaType::fromFile(path.c_str());
+
+        entry.file = file;
+        return file;
+    }
+
+    bool FileCache::isCurrent(const Entry& entry) const
+    {
+        // Any change would have been reported
+        if (entry.watch != -1)
+            return true;
+
+        struct stat sb;
+        if (::stat(entry.path.c_str(), &sb) == -1)
+            return false;
+
+        return static_cast<uint64_t>(sb.st_dev) == entry.device && static_cast<uint64_t>(sb.st_ino) == entry.inode && makeETag(sb) == entry.file->etag;
+    }
+
+    void FileCache::promote(Entry& entry)
+    {
+        const size_t size = entry.file->size;
+        if (entry.file->content || size > maxInMemoryFileSize_ || size > maxMemory_)
+            return;
+
+        // Room is made by dropping the content of the least recently used
+        // files, which stay open
+        for (auto it = lru_.rbegin(); memory_ + size > maxMemory_ && it != lru_.rend(); ++it)
+        {
+            if (!it->file->content)
+                continue;
+
+            auto file     = std::make_shared<CachedFile>(*it->file);
+            file->content = nullptr;
+            memory_ -= file->size;
+            it->file = std::move(file);
+        }
+
+        std::string content(size, '\0');
+        size_t read = 0;
+        while (read < size)
+        {
+            auto rv = PST_FILE_PREAD(entry.file->file->fd(), &content[read], size - read,
+                                     static_cast<off_t>(read));
+            if (rv <= 0)
+            {
+                if (rv < 0 && errno == EINTR)
+                    continue;
+
+                // Changed underneath us, it is served from the file instead
+                return;
+            }
+
+            read += static_cast<size_t>(rv);
+        }
+
+        auto file     = std::make_shared<CachedFile>(*entry.file);
+        file->content = std::make_shared<const std::string>(std::move(content));
+        entry.file    = std::move(file);
+        memory_ += size;
+    }
+
+    void FileCache::watch([[maybe_unused]] Entry& entry)
+    {
+#ifdef __linux__
+        if (inotifyFd_ == -1)
+            return;
+
+        const int wd = ::inotify_add_watch(inotifyFd_, entry.path.c_str(), WatchMask);
+        if (wd == -1)
+        {
+            PST_DBG_DECL_SE_ERR_P_EXTRA;
+            PS_LOG_DEBUG_ARGS("Could not watch %s, it will be stat'ed instead: %s",
+                              entry.path.c_str(), PST_STRERROR_R_ERRNO);
+            return;
+        }
+
+        entry.watch = wd;
+        watches_[wd].push_back(entry.path);
+#endif
+    }
+
+    void FileCache::unwatch(Entry& entry)
+    {
+        if (entry.watch == -1)
+            return;
+
+        auto found = watches_.find(entry.watch);
+        if (found != std::end(watches_))
+        {
+            auto& paths = found->second;
+            paths.erase(std::remove(std::begin(paths), std::end(paths), entry.path),
+                        std::end(paths));
+
+            // The same file may be watched under another path
+            if (paths.empty())
+            {
+#ifdef __linux__
+                ::inotify_rm_watch(inotifyFd_, entry.watch);
+#endif
+                watches_.erase(found);
+            }
+        }
+
+        entry.watch = -1;
+    }
+
+    bool FileCache::watchDirectory([[maybe_unused]] Entry& entry)
+    {
+        if (entry.dirWatch != -1)
+            return true;
+
+#ifdef __linux__
+        if (inotifyFd_ == -1)
+            return false;
+
+        const auto dir = splitPath(entry.path).first;
+        const int wd   = ::inotify_add_watch(inotifyFd_, dir.c_str(), DirWatchMask);
+        if (wd == -1)
+        {
+            PST_DBG_DECL_SE_ERR_P_EXTRA;
+            PS_LOG_DEBUG_ARGS("Could not watch %s, sidecars will be looked for instead: %s",
+                              dir.c_str(), PST_STRERROR_R_ERRNO);
+            return false;
+        }
+
+        entry.dirWatch = wd;
+        dirWatches_[wd].push_back(entry.path);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void FileCache::unwatchDirectory(Entry& entry)
+    {
+        if (entry.dirWatch == -1)
+            return;
+
+        auto found = dirWatches_.find(entry.dirWatch);
+        if (found != std::end(dirWatches_))
+        {
+            auto& paths = found->second;
+            paths.erase(std::remove(std::begin(paths), std::end(paths), entry.path),
+                        std::end(paths));
+
+            if (paths.empty())
+            {
+#ifdef __linux__
+                ::inotify_rm_watch(inotifyFd_, entry.dirWatch);
+#endif
+                dirWatches_.erase(found);
+            }
+        }
+
+        entry.dirWatch = -1;
+        entry.missingSidecars.clear();
+    }
+
+    void FileCache::processEvents()
+    {
+#ifdef __linux__
+        if (inotifyFd_ == -1)
+            return;
+
+        alignas(struct inotify_event) char buffer[4096];
+        for (;;)
+        {
+            const ssize_t len = ::read(inotifyFd_, buffer, sizeof buffer);
+            if (len <= 0)
+            {
+                if (len < 0 && errno == EINTR)
+                    continue;
+                break;
+            }
+
+            for (ssize_t pos = 0; pos < len;)
+            {
+                const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + pos);
+                pos += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+
+                auto dirFound = dirWatches_.find(event->wd);
+                if (dirFound != std::end(dirWatches_))
+                {
+                    // Whatever was created may be the sidecar of a file
+                    // named like its start
+                    const std::string name = event->len > 0 ? event->name : "";
+                    const auto paths       = dirFound->second;
+                    for (const auto& path : paths)
+                    {
+                        auto entry = index_.find(path);
+                        if (entry == std::end(index_) || entry->second->dirWatch != event->wd)
+                            continue;
+
+                        auto& cached    = *entry->second;
+                        const auto base = splitPath(path).second;
+                        if ((event->mask & IN_IGNORED) || name.compare(0, base.size(), base) == 0)
+                        {
+                            cached.missingSidecars.clear();
+                            ++cached.dirChanges;
+                        }
+                        if (event->mask & IN_IGNORED)
+                            cached.dirWatch = -1;
+                    }
+
+                    if (event->mask & IN_IGNORED)
+                        dirWatches_.erase(event->wd);
+                    continue;
+                }
+
+                auto found = watches_.find(event->wd);
+                if (found == std::end(watches_))
+                    continue;
+
+                // Erasing the entries unwatches them
+                const auto paths = found->second;
+                for (const auto& path : paths)
+                {
+                    auto entry = index_.find(path);
+                    if (entry != std::end(index_) && entry->second->watch == event->wd)
+                        erase(entry->second);
+                }
+
+                // The kernel already dropped the watch
+                if (event->mask & IN_IGNORED)
+                    watches_.erase(event->wd);
+            }
+        }
+#endif
+    }
+
+    void FileCache::erase(Lru::iterator it)
+    {
+        unwatch(*it);
+        unwatchDirectory(*it);
+
+        if (it->file && it->file->content)
+            memory_ -= it->file->size;
+
+        index_.erase(it->path);
+        lru_.erase(it);
+    }
+
+    void FileCache::evict()
+    {
+        while (lru_.size() > maxFiles_)
+            erase(std::prev(std::end(lru_)));
+    }
+
+} // namespace Pistache::Http
@@ -12,8 +12,10 @@
 
 #include <pistache/winornix.h>
 
+#include <pistache/compression.h>
 #include <pistache/config.h>
 #include <pistache/eventmeth.h>
+#include <pistache/file_cache.h>
 #include <pistache/http.h>
 #include <pistache/http_header.h>
 #include <pistache/net.h>
@@ -22,15 +24,24 @@
 
 #include PST_STRERROR_R_HDR
 
+#include <algorithm>
+#include <atomic>
 #include <charconv>
+#include <cinttypes>
+#include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <random>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
 #include <fcntl.h> // for file-constants (_O_RDONLY etc.) in Windows
 #include PST_FCNTL_HDR // for function fcntl()
@@ -60,7 +71,7 @@ namespace Pistache::Http
 
     namespace
     {
-        bool writeStatusLine(Version version, Code code, DynamicStreamBuf& buf)
+        bool writeStatusLine(Version version, Code code, std::streambuf& buf)
         {
 #define PST_OUT(...)      \
     do                    \
@@ -83,7 +94,7 @@ namespace Pistache::Http
 #undef PST_OUT
         }
 
-        bool writeHeaders(const Header::Collection& headers, DynamicStreamBuf& buf)
+        bool writeHeaders(const Header::Collection& headers, std::streambuf& buf)
         {
 #define PST_OUT(...)      \
     do                    \
@@ -107,7 +118,7 @@ namespace Pistache::Http
 #undef PST_OUT
         }
 
-        bool writeCookies(const CookieJar& cookies, DynamicStreamBuf& buf)
+        bool writeCookies(const CookieJar& cookies, std::streambuf& buf)
         {
 #define PST_OUT(...)      \
     do                    \
@@ -158,6 +169,11 @@ namespace Pistache::Http
 
             auto* request = static_cast<Request*>(message);
 
+            // RFC 7230 3.5: ignore empty lines ahead of the request-line,
+            // such as a stray CRLF after the body of a pipelined request
+            while (!cursor.eof() && (cursor.current() == '\r' || cursor.current() == '\n'))
+                cursor.advance(1);
+
             StreamCursor::Token methodToken(cursor);
             if (!match_until(' ', cursor))
                 return State::Again;
@@ -275,6 +291,10 @@ namespace Pistache::Http
 
             auto* response = static_cast<Response*>(message);
 
+            // Not all of the version is there yet, as when nothing is
+            if (cursor.remaining() < strlen("HTTP/1.1"))
+                return State::Again;
+
             if (match_raw("HTTP/1.1", strlen("HTTP/1.1"), cursor))
             {
                 // response->version = Version::Http11;
@@ -322,77 +342,127 @@ namespace Pistache::Http
             return State::Next;
         }
 
-        State HeadersStep::apply(StreamCursor& cursor)
+        namespace
         {
-            StreamCursor::Revert revert(cursor);
+            // Offset of the first CRLF in data at or after from, or npos
+            size_t findCrlf(const char* data, size_t size, size_t from)
+            {
+                while (from < size)
+                {
+                    const auto* cr = static_cast<const char*>(
+                        std::memchr(data + from, '\r', size - from));
+                    if (cr == nullptr)
+                        break;
+
+                    const auto at = static_cast<size_t>(cr - data);
+                    if (at + 1 >= size)
+                        break;
+                    if (data[at + 1] == '\n')
+                        return at;
+
+                    from = at + 1;
+                }
 
-            while (!cursor.eol())
+                return std::string_view::npos;
+            }
+
+            // Whether the header H, if any, parses: a lookup takes one that
+            // does not as absent
+            template <typename H>
+            bool parsesIfPresent(const Header::Collection& headers)
             {
-                StreamCursor::Revert headerRevert(cursor);
+                return headers.tryGet<H>() != nullptr || !headers.tryGetRaw(H::Name);
+            }
+        } // namespace
 
-                // Read the header name
-                size_t start = cursor;
+        State HeadersStep::apply(StreamCursor& cursor)
+        {
+            const char* data       = cursor.offset();
+            const size_t available = cursor.remaining();
+
+            // Take the complete header lines that have come in, found a line
+            // at a time with memchr rather than a byte at a time
+            size_t linesSize = 0;
+            bool done        = false;
+            for (;;)
+            {
+                const size_t eol = findCrlf(data, available, linesSize);
+                if (eol == std::string_view::npos)
+                    break;
 
-                while (cursor.current() != ':')
-                    if (!cursor.advance(1))
-                        return State::Again;
+                if (eol == linesSize)
+                {
+                    done = true;
+                    break;
+                }
+                linesSize = eol + 2;
+            }
 
-                // Skip the ':'
-                if (!cursor.advance(1))
-                    return State::Again;
+            // The headers are kept in a single copy of their lines, and only
+            // parsed into their typed form when looked up
+            const auto lines = message->headers_.keepRawSection(data, linesSize);
 
-                std::string name = std::string(cursor.offset(start), cursor.diff(start) - 1);
+            for (size_t lineStart = 0; lineStart < lines.size();)
+            {
+                const size_t eol = findCrlf(lines.data(), lines.size(), lineStart);
+                const auto line  = lines.substr(lineStart, eol - lineStart);
 
-                // Ignore spaces
-                while (cursor.current() == ' ')
-                    if (!cursor.advance(1))
-                        return State::Again;
+                const size_t colon = line.find(':');
+                if (colon == std::string_view::npos)
+                    raise("Invalid header");
 
-                // Read the header value
-                start = cursor;
-                while (!cursor.eol())
-                {
-                    if (!cursor.advance(1))
-                        return State::Again;
-                }
+                const auto name = line.substr(0, colon);
+
+                // Ignore spaces
+                size_t valueStart = colon + 1;
+                while (valueStart < line.size() && line[valueStart] == ' ')
+                    ++valueStart;
+                const auto value = line.substr(valueStart);
 
-                if (Header::LowercaseEqualStatic(name, "cookie"))
+                if (Header::LowercaseEqualStatic(name, std::string_view("cookie")))
                 {
                     message->cookies_.removeAllCookies(); // removing existing cookies before
                                                           // re-adding them.
-                    message->cookies_.addFromRaw(cursor.offset(start), cursor.diff(start));
+                    message->cookies_.addFromRaw(value.data(), value.size());
                 }
-                else if (Header::LowercaseEqualStatic(name, "set-cookie"))
+                else if (Header::LowercaseEqualStatic(name, std::string_view("set-cookie")))
                 {
-                    message->cookies_.add(
-                        Cookie::fromRaw(cursor.offset(start), cursor.diff(start)));
+                    message->cookies_.add(Cookie::fromRaw(value.data(), value.size()));
                 }
 
-                // If the header is registered with the Registry, add its strongly
-                //  typed form to the headers list...
-                else if (Header::Registry::instance().isRegistered(name))
-                {
-                    std::shared_ptr<Header::Header> header = Header::Registry::instance().makeHeader(name);
-                    header->parseRaw(cursor.offset(start), cursor.diff(start));
-                    message->headers_.add(header);
-                }
+                message->headers_.addLazy(name, value);
 
-                // But also preserve a raw header version too, regardless of whether
-                //  its type was known to the Registry...
-                std::string value(cursor.offset(start), cursor.diff(start));
-                message->headers_.addRaw(Header::Raw(std::move(name), std::move(value)));
+                lineStart = eol + 2;
+            }
 
-                // CRLF
-                if (!cursor.advance(2))
-                    return State::Again;
+            if (!done)
+            {
+                cursor.advance(linesSize);
+                return State::Again;
+            }
 
-                headerRevert.ignore();
+            // An unsupported media type is still refused while parsing,
+            // before the request makes it to a handler. The lookup takes a
+            // value that does not parse as absent: parsing it again throws
+            // the error to answer with.
+            if (!parsesIfPresent<Header::ContentType>(message->headers_))
+            {
+                if (auto raw = message->headers_.tryGetRaw(Header::ContentType::Name))
+                {
+                    Header::ContentType contentType;
+                    contentType.parseRaw(raw->value().data(), raw->value().size());
+                }
             }
 
-            if (!cursor.advance(2))
-                return State::Again;
+            // Nor can the length of the body be guessed at: the rest of it
+            // would be read as another request
+            if (!parsesIfPresent<Header::ContentLength>(message->headers_))
+                raise("Invalid Content-Length header");
+            if (!parsesIfPresent<Header::TransferEncoding>(message->headers_))
+                raise("Invalid Transfer-Encoding header");
 
-            revert.ignore();
+            // Final CRLF
+            cursor.advance(linesSize + 2);
             return State::Next;
         }
 
@@ -426,7 +496,7 @@ namespace Pistache::Http
                 if (available < size)
                 {
                     cursor.advance(available);
-                    message->body_.append(token.rawText(), token.size());
+                    consume(token.rawText(), token.size());
 
                     bytesRead += available;
 
@@ -434,7 +504,7 @@ namespace Pistache::Http
                 }
 
                 cursor.advance(size);
-                message->body_.append(token.rawText(), token.size());
+                consume(token.rawText(), token.size());
                 return true;
             };
 
@@ -450,8 +520,9 @@ namespace Pistache::Http
             // This is the first time we are reading the payload
             else
             {
-                message->body_.reserve(
-                    static_cast<unsigned int>(contentLength));
+                if (!reader_)
+                    message->body_.reserve(
+                        static_cast<unsigned int>(contentLength));
                 if (!readBody(static_cast<size_t>(contentLength)))
                     return State::Again;
             }
@@ -493,24 +564,26 @@ namespace Pistache::Http
             if (size == 0)
                 return Final;
 
-            message->body_.reserve(size);
-            StreamCursor::Token chunkData(cursor);
-            const PST_SSIZE_T available = cursor.remaining();
-
-            if (available + alreadyAppendedChunkBytes < size + 2)
+            const PST_SSIZE_T wanted = size - alreadyAppendedChunkBytes;
+            if (wanted > 0)
             {
+                StreamCursor::Token chunkData(cursor);
+                const PST_SSIZE_T available = std::min(
+                    static_cast<PST_SSIZE_T>(cursor.remaining()), wanted);
+
                 cursor.advance(available);
-                message->body_.append(chunkData.rawText(), available);
+                step->consume(chunkData.rawText(), available);
                 alreadyAppendedChunkBytes += available;
-                return Incomplete;
+
+                if (available < wanted)
+                    return Incomplete;
             }
-            cursor.advance(size - alreadyAppendedChunkBytes);
 
-            // trailing EOL
+            // trailing EOL, which may come in after the data
+            if (cursor.remaining() < 2)
+                return Incomplete;
             cursor.advance(2);
 
-            message->body_.append(chunkData.rawText(), size - alreadyAppendedChunkBytes);
-
             return Complete;
         }
 
@@ -529,7 +602,7 @@ namespace Pistache::Http
                             return State::Again;
 
                         chunk.reset();
-                        if (cursor.eof())
+                        if (cursor.eof() || paused())
                             return State::Again;
                     }
                     chunk.reset();
@@ -551,9 +624,29 @@ namespace Pistache::Http
             // reach here
         }
 
+        void BodyStep::consume(const char* data, size_t len)
+        {
+            if (len == 0)
+                return;
+
+            if (reader_)
+                reader_->onData(data, len);
+            else
+                message->body_.append(data, len);
+        }
+
+        bool BodyStep::paused() const { return reader_ && reader_->isPaused(); }
+
         ParserBase::ParserBase(size_t maxDataSize)
-            : buffer(maxDataSize)
-            , cursor(&buffer)
+            : ownBuffer(maxDataSize)
+            , buffer(&ownBuffer)
+            , cursor(buffer)
+        { }
+
+        ParserBase::ParserBase(ArrayStreamBuf<char>& input)
+            : ownBuffer(0)
+            , buffer(&input)
+            , cursor(buffer)
         { }
 
         State ParserBase::parse()
@@ -573,19 +666,123 @@ namespace Pistache::Http
             return state;
         }
 
+        State ParserBase::parseHeaders()
+        {
+            while (currentStep < StepsCount - 1)
+            {
+                if (allSteps[currentStep]->apply(cursor) != State::Next)
+                    return State::Again;
+                ++currentStep;
+            }
+
+            return State::Next;
+        }
+
         bool ParserBase::feed(const char* data, size_t len)
         {
-            return buffer.feed(data, len);
+            return buffer->feed(data, len);
         }
 
         void ParserBase::reset()
         {
-            buffer.reset();
+            buffer->reset();
             cursor.reset();
 
             currentStep = 0;
         }
 
+        void ParserBase::resetKeepingUnread()
+        {
+            buffer->compact();
+
+            currentStep = 0;
+        }
+
+        bool ParserBase::inputFull() const { return buffer->full(); }
+
+        void ParserBase::compactInput() { buffer->compact(); }
+
+        size_t ParserBase::discardInput(size_t count)
+        {
+            const size_t discarded = std::min(count, cursor.remaining());
+            cursor.advance(discarded);
+            buffer->compact();
+
+            return discarded;
+        }
+
+        // Shared by whatever produces the response to a request: the
+        // ResponseWriter, its clones, then the ResponseStream or file transfer
+        // it hands off to. The last holder to let go, once the response is
+        // queued, has the transport go on with the connection's input.
+        class PipelineSlot
+        {
+        public:
+            PipelineSlot(Tcp::Transport* transport, std::weak_ptr<Tcp::Peer> peer);
+            ~PipelineSlot();
+
+            PipelineSlot(const PipelineSlot&)            = delete;
+            PipelineSlot& operator=(const PipelineSlot&) = delete;
+
+            // Only armed slots resume the input; a request answered
+            // synchronously is followed right away by the next one
+            void arm() { armed_ = true; }
+
+            // When the request was received in full
+            std::chrono::steady_clock::time_point received() const { return received_; }
+
+        private:
+            Tcp::Transport* transport_;
+            std::weak_ptr<Tcp::Peer> peer_;
+            std::chrono::steady_clock::time_point received_;
+            bool armed_ = false;
+        };
+
+        PipelineSlot::PipelineSlot(Tcp::Transport* transport,
+                                   std::weak_ptr<Tcp::Peer> peer)
+            : transport_(transport)
+            , peer_(std::move(peer))
+            , received_(std::chrono::steady_clock::now())
+        { }
+
+        // Counts a response in the metrics of the transport, with the time
+        // the request waited for it when it answers one. Error responses
+        // sent outside of any request have no slot.
+        void recordResponse(Tcp::Transport* transport,
+                            const std::shared_ptr<PipelineSlot>& slot, Code code)
+        {
+            if (!transport)
+                return;
+
+            if (slot)
+                transport->metrics().responseSent(static_cast<int>(code),
+                                                  std::chrono::steady_clock::now() - slot->received());
+            else
+                transport->metrics().responseSent(static_cast<int>(code));
+        }
+
+        PipelineSlot::~PipelineSlot()
+        {
+            if (!armed_)
+                return;
+
+            // A peer whose fd is still open has not been dropped by its
+            // transport, which closes them all before going away
+            auto peer = peer_.lock();
+            if (!peer || peer->fd() == PS_FD_EMPTY)
+                return;
+
+            try
+            {
+                transport_->resumeInput(peer);
+            }
+            catch (const std::exception& e)
+            {
+                PS_LOG_WARNING_ARGS("Failed to resume input of peer %p: %s",
+                                    peer.get(), e.what());
+            }
+        }
+
         Step* ParserBase::step()
         {
             return allSteps[currentStep].get();
@@ -714,6 +911,9 @@ namespace Pistache::Http
         , buf_(std::move(other.buf_))
         , transport_(other.transport_)
         , timeout_(std::move(other.timeout_))
+        , pipelineSlot_(std::move(other.pipelineSlot_))
+        , highWaterMark_(other.highWaterMark_)
+        , lowWaterMark_(other.lowWaterMark_)
     { }
 
     ResponseStream::ResponseStream(Message&& other, std::weak_ptr<Tcp::Peer> peer,
@@ -758,6 +958,11 @@ namespace Pistache::Http
         transport_ = other.transport_;
         timeout_   = std::move(other.timeout_);
 
+        pipelineSlot_ = std::move(other.pipelineSlot_);
+
+        highWaterMark_ = other.highWaterMark_;
+        lowWaterMark_  = other.lowWaterMark_;
+
         return *this;
     }
 
@@ -780,19 +985,18 @@ namespace Pistache::Http
         return peer_.lock();
     }
 
-    void ResponseStream::flush()
+    Async::Promise<PST_SSIZE_T> ResponseStream::flush()
     {
         timeout_.disarm();
-        auto buf = buf_.buffer();
+        auto buf = buf_.release();
 
-        auto fd = peer()->fd();
-        transport_->asyncWrite(fd, buf);
+        auto written = transport_->asyncWrite(peer(), buf);
         transport_->flush();
 
-        buf_.clear();
+        return written;
     }
 
-    void ResponseStream::ends()
+    Async::Promise<PST_SSIZE_T> ResponseStream::ends()
     {
         std::ostream os(&buf_);
         os << "0" << crlf;
@@ -803,7 +1007,33 @@ namespace Pistache::Http
             throw Error("Response exceeded buffer size");
         }
 
-        flush();
+        Private::recordResponse(transport_, pipelineSlot_, response_.code());
+        auto written = flush();
+
+        // The whole response is queued, the next one may follow
+        pipelineSlot_.reset();
+        if (auto peer = peer_.lock())
+            peer->setIdle(true);
+
+        return written;
+    }
+
+    void ResponseStream::setWaterMarks(size_t high, size_t low)
+    {
+        if (low > high)
+            throw std::invalid_argument("Low water mark above the high one");
+
+        highWaterMark_ = high;
+        lowWaterMark_  = low;
+    }
+
+    size_t ResponseStream::queuedBytes() const { return peer()->queuedBytes(); }
+
+    bool ResponseStream::isWritable() const { return queuedBytes() < highWaterMark_; }
+
+    void ResponseStream::onWritable(std::function<void()> callback)
+    {
+        peer()->onWritable(lowWaterMark_, std::move(callback));
     }
 
     ResponseWriter::ResponseWriter(ResponseWriter&& other)
@@ -812,6 +1042,19 @@ namespace Pistache::Http
         , buf_(std::move(other.buf_))
         , transport_(other.transport_)
         , timeout_(std::move(other.timeout_))
+        , sent_bytes_(other.sent_bytes_)
+        , pipelineSlot_(std::move(other.pipelineSlot_))
+        , contentEncoding_(other.contentEncoding_)
+        , compressor_(std::move(other.compressor_))
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        , contentEncodingBrotliLevel_(other.contentEncodingBrotliLevel_)
+#endif
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        , contentEncodingZstdLevel_(other.contentEncodingZstdLevel_)
+#endif
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        , contentEncodingDeflateLevel_(other.contentEncodingDeflateLevel_)
+#endif
     { }
 
     ResponseWriter::ResponseWriter(Http::Version version, Tcp::Transport* transport,
@@ -821,6 +1064,7 @@ namespace Pistache::Http
         , buf_(DefaultStreamSize, handler->getMaxResponseSize())
         , transport_(transport)
         , timeout_(transport, version, handler, peer)
+        , compressor_(handler->getCompressor())
     { }
 
     ResponseWriter::ResponseWriter(const ResponseWriter& other)
@@ -829,6 +1073,18 @@ namespace Pistache::Http
         , buf_(DefaultStreamSize, other.buf_.maxSize())
         , transport_(other.transport_)
         , timeout_(other.timeout_)
+        , pipelineSlot_(other.pipelineSlot_)
+        , contentEncoding_(other.contentEncoding_)
+        , compressor_(other.compressor_)
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        , contentEncodingBrotliLevel_(other.contentEncodingBrotliLevel_)
+#endif
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        , contentEncodingZstdLevel_(other.contentEncodingZstdLevel_)
+#endif
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+        , contentEncodingDeflateLevel_(other.contentEncodingDeflateLevel_)
+#endif
     { }
 
     void ResponseWriter::setMime(const Mime::MediaType& mime)
@@ -895,127 +1151,117 @@ namespace Pistache::Http
             }
         }
 
-        // Compress data, if necessary, before sending over wire to user...
-        switch (contentEncoding_)
+        // No compression requested. Send uncompressed data to client...
+        if (contentEncoding_ == Http::Header::Encoding::Identity)
+            return putOnWire(data, size);
+
+        const int level = compressionLevel();
+        if (!compressor_)
         {
+            const auto compressed = compress(contentEncoding_, level, data, size);
 
-#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
-        // User requested Brotli compression...
-        case Http::Header::Encoding::Br: {
-
-            // Location for size of compressed buffer, initially set to upper
-            //  bound on the data after its been compressed...
-            size_t compressedSize = ::BrotliEncoderMaxCompressedSize(size);
-
-            // Failed...
-            if (compressedSize == 0)
-                throw std::runtime_error("BrotliEncoderMaxCompressedSize() failed");
-
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(compressedSize);
-
-            // Compress data. The encoder expects compressedSize to initially be
-            //  the size of the output buffer. After it completes writing it
-            //  will update its value to reflect actual size used...
-            const auto compressionStatus = ::BrotliEncoderCompress(
-                contentEncodingBrotliLevel_,
-                BROTLI_DEFAULT_WINDOW,
-                BROTLI_DEFAULT_MODE,
-                size,
-                reinterpret_cast<const uint8_t*>(data),
-                &compressedSize,
-                reinterpret_cast<uint8_t*>(compressedData.get()));
-
-            // Failed...
-            if (compressionStatus != BROTLI_TRUE)
-                throw std::runtime_error("BrotliEncoderCompress() failed");
-
-            // Notify client to expect Brotli compressed response...
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Br);
-
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compressedSize);
+            // Notify client to expect a compressed response...
+            headers().add<Http::Header::ContentEncoding>(contentEncoding_);
+            return putOnWire(compressed.data(), compressed.size());
         }
-#endif
 
-#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
-
-        case Http::Header::Encoding::Zstd: {
-            size_t estimated_size = ZSTD_compressBound(size);
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(estimated_size);
+        // Costs more than it saves
+        if (!compressor_->shouldCompress(size))
+            return putOnWire(data, size);
 
-            auto compress_size = ZSTD_compress(reinterpret_cast<void*>(compressedData.get()), estimated_size,
-                                               data, size, contentEncodingZstdLevel_);
-            if (ZSTD_isError(compress_size))
-            {
-                throw std::runtime_error(
-                    std::string("failed to compress data to ZSTD on ZSTD_compress(), returning: ") + std::to_string(compress_size));
-            }
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Zstd);
+        auto compressed = compressor_->find(contentEncoding_, level, data, size);
+        if (!compressed)
+        {
+            if (compressor_->compressesAsync(size))
+                return compressAsync(level, data, size);
 
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compress_size);
+            compressed = compressor_->compress(contentEncoding_, level, data, size);
         }
 
-#endif
+        headers().add<Http::Header::ContentEncoding>(contentEncoding_);
+        return putOnWire(compressed->data(), compressed->size());
+    }
 
+    int ResponseWriter::compressionLevel() const
+    {
+        switch (contentEncoding_)
+        {
+#ifdef PISTACHE_USE_CONTENT_ENCODING_BROTLI
+        case Http::Header::Encoding::Br:
+            return contentEncodingBrotliLevel_;
+#endif
+#ifdef PISTACHE_USE_CONTENT_ENCODING_ZSTD
+        case Http::Header::Encoding::Zstd:
+            return contentEncodingZstdLevel_;
+#endif
 #ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
-        // User requested deflate compression...
-        case Http::Header::Encoding::Deflate: {
-
-            // Compute upper bound on size of expected compressed data. This
-            //  will be updated by compress2()...
-            uLongf compressedSize = static_cast<uLongf>(::compressBound(static_cast<uLong>(size)));
-
-            // Allocate a smart buffer to contain compressed data...
-            std::unique_ptr compressedData = std::make_unique<std::byte[]>(compressedSize);
-
-            // Compress user data at requested level...
-            const auto compressionStatus = ::compress2(
-                reinterpret_cast<unsigned char*>(compressedData.get()),
-                &compressedSize,
-                reinterpret_cast<const unsigned char*>(data),
-                static_cast<uLong>(size),
-                contentEncodingDeflateLevel_);
-
-            // Failed...
-            if (compressionStatus != Z_OK)
-                throw std::runtime_error(
-                    std::string("compress2() failed, returning: ") + std::to_string(compressionStatus));
-
-            // Notify client to expect deflate compressed response...
-            headers().add<Http::Header::ContentEncoding>(
-                Http::Header::Encoding::Deflate);
-
-            // Send compressed data back to client...
-            return putOnWire(
-                reinterpret_cast<const char*>(compressedData.get()),
-                compressedSize);
-        }
+        case Http::Header::Encoding::Deflate:
+            return contentEncodingDeflateLevel_;
 #endif
-        // No compression requested. Send uncompressed data to client...
-        case Http::Header::Encoding::Identity:
-            return putOnWire(data, size);
-
-        // Unknown...
         default:
-            throw std::runtime_error("User requested unknown content encoding.");
+            return 0;
         }
     }
 
+    Async::Promise<PST_SSIZE_T> ResponseWriter::compressAsync(int level, const char* data,
+                                                              size_t size)
+    {
+        // Neither the data nor this writer outlive the call to send()
+        auto body   = std::make_shared<const std::string>(data, size);
+        auto writer = std::make_shared<ResponseWriter>(std::move(*this));
+
+        return Async::Promise<PST_SSIZE_T>([&](Async::Deferred<PST_SSIZE_T> deferred) {
+            // A Deferred can only be moved, which std::function does not allow
+            auto shared = std::make_shared<Async::Deferred<PST_SSIZE_T>>(std::move(deferred));
+
+            auto compressor = writer->compressor_;
+            compressor->post([writer, body, shared, level]() {
+                try
+                {
+                    // Gone while waiting for its turn
+                    if (writer->peer_.expired())
+                    {
+                        shared->reject(Error("Write failed: Broken pipe"));
+                        return;
+                    }
+
+                    auto compressed = writer->compressor_->compress(writer->contentEncoding_, level,
+                                                                    body->data(), body->size());
+                    writer->headers().add<Http::Header::ContentEncoding>(writer->contentEncoding_);
+
+                    // Queued on the peer's transport, which writes it
+                    // from its own thread
+                    writer->putOnWire(compressed->data(), compressed->size())
+                        .then(
+                            [shared](PST_SSIZE_T written) { shared->resolve(written); },
+                            [shared](std::exception_ptr& eptr) {
+                                try
+                                {
+                                    std::rethrow_exception(eptr);
+                                }
+                                catch (const std::exception& e)
+                                {
+                                    shared->reject(Error(e.what()));
+                                }
+                            });
+                }
+                catch (const std::exception& e)
+                {
+                    shared->reject(Error(e.what()));
+                }
+            });
+        });
+    }
+
     ResponseStream ResponseWriter::stream(Code code, size_t streamSize)
     {
         response_.code_ = code;
 
-        return ResponseStream(std::move(response_), peer_, transport_,
+        ResponseStream stream(std::move(response_), peer_, transport_,
                               std::move(timeout_), streamSize, buf_.maxSize());
+        stream.pipelineSlot_ = std::move(pipelineSlot_);
+
+        return stream;
     }
 
     const CookieJar& ResponseWriter::cookies() const { return response_.cookies(); }
@@ -1043,9 +1289,14 @@ namespace Pistache::Http
 
     DynamicStreamBuf* ResponseWriter::rdbuf() { return &buf_; }
 
-    DynamicStreamBuf* ResponseWriter::rdbuf(DynamicStreamBuf* /*other*/)
+    DynamicStreamBuf* ResponseWriter::rdbuf(DynamicStreamBuf* other)
     {
-        throw std::domain_error("Unimplemented");
+        // The response is serialized straight into the caller's storage,
+        // after whatever it already holds
+        if (other != nullptr && other != &buf_)
+            buf_ = std::move(*other);
+
+        return &buf_;
     }
 
     ResponseWriter ResponseWriter::clone() const { return ResponseWriter(*this); }
@@ -1087,25 +1338,31 @@ namespace Pistache::Http
                 PST_OUT(os.write(data, len));
             }
 
-            auto buffer = buf_.buffer();
+            auto buffer = buf_.release();
             sent_bytes_ += buffer.size();
 
             timeout_.disarm();
 
 #undef PST_OUT
 
-            auto fd = peer()->fd();
+            // Counted before it can reach the client
+            Private::recordResponse(transport_, pipelineSlot_, response_.code());
+
+            auto written = transport_->asyncWrite(peer(), buffer)
+                               .then<std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>,
+                                     std::function<void(std::exception_ptr&)>>(
+                                   [](PST_SSIZE_T data) {
+                                       return Async::Promise<PST_SSIZE_T>::resolved(data);
+                                   },
 
-            return transport_->asyncWrite(fd, buffer)
-                .then<std::function<Async::Promise<PST_SSIZE_T>(PST_SSIZE_T)>,
-                      std::function<void(std::exception_ptr&)>>(
-                    [](PST_SSIZE_T data) {
-                        return Async::Promise<PST_SSIZE_T>::resolved(data);
-                    },
+                                   [](std::exception_ptr& eptr) {
+                                       return Async::Promise<PST_SSIZE_T>::rejected(eptr);
+                                   });
 
-                    [](std::exception_ptr& eptr) {
-                        return Async::Promise<PST_SSIZE_T>::rejected(eptr);
-                    });
+            // The response is queued, the next one may follow
+            pipelineSlot_.reset();
+
+            return written;
         }
         catch (const std::runtime_error& e)
         {
@@ -1152,42 +1409,402 @@ namespace Pistache::Http
         }
     }
 
-    Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer,
-                                          const std::string& fileName,
-                                          const Mime::MediaType& contentType)
+    namespace
     {
-        struct stat sb;
+        // Inclusive, as in Content-Range
+        struct ByteRange
+        {
+            size_t first;
+            size_t last;
+
+            size_t length() const { return last - first + 1; }
+        };
+
+        enum class RangeStatus { Ignored,
+                                 Satisfiable,
+                                 Unsatisfiable };
 
-        int fd = PST_FILE_OPEN(fileName.c_str(), PST_O_RDONLY);
-        if (fd == -1)
+        // Asking for more makes for a full response, so that a request for a
+        // great many tiny ranges does not cost more than the whole file
+        constexpr size_t MaxRanges = 16;
+
+        std::string_view trim(std::string_view value)
+        {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+                value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+                value.remove_suffix(1);
+            return value;
+        }
+
+        bool parseSize(std::string_view str, size_t& value)
+        {
+            if (str.empty())
+                return false;
+
+            auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+            return ec == std::errc() && ptr == str.data() + str.size();
+        }
+
+        // RFC 9110 14.1.2. A malformed Range header is ignored, ranges that
+        // can not be satisfied are left out
+        RangeStatus parseRanges(std::string_view value, size_t size,
+                                std::vector<ByteRange>& ranges)
         {
-            PST_DECL_SE_ERR_P_EXTRA;
-            std::string str_error(PST_STRERROR_R_ERRNO);
-            if (errno == ENOENT)
+            value = trim(value);
+
+            const auto eq = value.find('=');
+            if (eq == std::string_view::npos || Header::toLowercase(std::string(trim(value.substr(0, eq)))) != "bytes")
+                return RangeStatus::Ignored;
+
+            size_t count = 0;
+            for (auto specs = value.substr(eq + 1); !specs.empty();)
             {
-                throw HttpError(Http::Code::Not_Found, std::move(str_error));
+                const auto comma = specs.find(',');
+                const auto spec  = trim(specs.substr(0, comma));
+                specs            = comma == std::string_view::npos ? std::string_view() : specs.substr(comma + 1);
+
+                if (spec.empty())
+                    continue;
+
+                const auto dash = spec.find('-');
+                if (dash == std::string_view::npos)
+                    return RangeStatus::Ignored;
+
+                if (++count > MaxRanges)
+                    return RangeStatus::Ignored;
+
+                const auto firstStr = spec.substr(0, dash);
+                const auto lastStr  = spec.substr(dash + 1);
+
+                size_t first, last;
+                if (firstStr.empty())
+                {
+                    // The last bytes of the file
+                    size_t suffix;
+                    if (!parseSize(lastStr, suffix))
+                        return RangeStatus::Ignored;
+
+                    if (suffix == 0 || size == 0)
+                        continue;
+
+                    first = size > suffix ? size - suffix : 0;
+                    last  = size - 1;
+                }
+                else
+                {
+                    if (!parseSize(firstStr, first))
+                        return RangeStatus::Ignored;
+
+                    if (lastStr.empty())
+                        last = std::numeric_limits<size_t>::max();
+                    else if (!parseSize(lastStr, last) || last < first)
+                        return RangeStatus::Ignored;
+
+                    if (first >= size)
+                        continue;
+
+                    last = std::min(last, size - 1);
+                }
+
+                ranges.push_back({ first, last });
             }
-            // eles if TODO
-            /* @Improvement: maybe could we check for errno here and emit a different
-       error message
-    */
-            else
+
+            if (count == 0)
+                return RangeStatus::Ignored;
+
+            return ranges.empty() ? RangeStatus::Unsatisfiable : RangeStatus::Satisfiable;
+        }
+
+        // Weak comparison, as for If-None-Match (RFC 9110 8.8.3.2)
+        bool matchesETag(std::string_view list, std::string_view etag)
+        {
+            list = trim(list);
+            if (list == "*")
+                return true;
+
+            if (etag.compare(0, 2, "W/") == 0)
+                etag.remove_prefix(2);
+
+            while (!list.empty())
+            {
+                const auto start = list.find('"');
+                if (start == std::string_view::npos)
+                    break;
+
+                const auto end = list.find('"', start + 1);
+                if (end == std::string_view::npos)
+                    break;
+
+                if (list.substr(start, end - start + 1) == etag)
+                    return true;
+
+                list.remove_prefix(end + 1);
+            }
+
+            return false;
+        }
+
+        bool isNotModified(const Request& request, const CachedFile& file)
+        {
+            const auto& headers = request.headers();
+
+            // If-Modified-Since is only looked at in the absence of
+            // If-None-Match (RFC 9110 13.1.3)
+            if (auto ifNoneMatch = headers.tryGetRaw("If-None-Match"))
+                return matchesETag(ifNoneMatch->value(), file.etag);
+
+            if (auto ifModifiedSince = headers.tryGetRaw("If-Modified-Since"))
             {
-                throw HttpError(Http::Code::Internal_Server_Error, std::move(str_error));
+                try
+                {
+                    return file.lastModified.date() <= FullDate::fromString(ifModifiedSince->value()).date();
+                }
+                catch (const std::exception&)
+                {
+                    // An invalid date is ignored
+                }
             }
+
+            return false;
         }
 
-        int res = ::fstat(fd, &sb);
+        // Ranges are only sent when the client has parts of the same file
+        // (RFC 9110 13.1.5), the whole file is sent otherwise
+        bool ifRangeHolds(const Request& request, const CachedFile& file)
+        {
+            auto ifRange = request.headers().tryGetRaw("If-Range");
+            if (!ifRange)
+                return true;
+
+            const auto value = trim(ifRange->value());
+            if (value.compare(0, 2, "W/") == 0)
+                return false;
+            if (value.compare(0, 1, "\"") == 0)
+                return value == file.etag;
+
+            try
+            {
+                return FullDate::fromString(std::string(value)).date() == file.lastModified.date();
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }
+
+        const char* precompressedExtension(Header::Encoding encoding)
+        {
+            switch (encoding)
+            {
+            case Header::Encoding::Br:
+                return ".br";
+            case Header::Encoding::Zstd:
+                return ".zst";
+            case Header::Encoding::Gzip:
+                return ".gz";
+            default:
+                return nullptr;
+            }
+        }
+
+        // The precompressed version of the file in the encoding the client
+        // prefers, among those it accepts, nullptr when there is none
+        std::shared_ptr<const CachedFile>
+        findPrecompressed(const Request& request, const std::string& fileName,
+                          const CachedFile& file, FileCache& cache,
+                          Header::Encoding& encoding)
+        {
+            auto acceptEncoding = request.headers().tryGet<Header::AcceptEncoding>();
+            if (!acceptEncoding)
+                return nullptr;
+
+            for (const auto& accepted : acceptEncoding->encodings())
+            {
+                // If the qvalue is 0, the encoding is not supported by the client
+                const char* extension = precompressedExtension(accepted.first);
+                if (extension == nullptr || accepted.second == 0)
+                    continue;
+
+                // Left behind by a change to the file
+                auto precompressed = cache.tryGetSidecar(fileName, extension);
+                if (!precompressed || precompressed->lastModified.date() < file.lastModified.date())
+                    continue;
+
+                encoding = accepted.first;
+                return precompressed;
+            }
+
+            return nullptr;
+        }
 
-        PST_FILE_CLOSE(fd); // Done with fd, close before error can be thrown
-        if (res == -1)
+        std::string makeBoundary()
         {
-            throw HttpError(Code::Internal_Server_Error, "");
+            static std::atomic<uint64_t> counter { 0 };
+            thread_local std::mt19937_64 generator { std::random_device {}() };
+
+            char boundary[48];
+            std::snprintf(boundary, sizeof boundary, "pistache%016" PRIx64 "%08" PRIx64,
+                          static_cast<uint64_t>(generator()),
+                          static_cast<uint64_t>(counter.fetch_add(1) & 0xffffffff));
+            return boundary;
         }
+    } // namespace
+
+    namespace Private
+    {
+        struct FileResponse
+        {
+            using Part = std::variant<RawBuffer, FileBuffer>;
 
-        auto* buf = writer.rdbuf();
+            static Async::Promise<PST_SSIZE_T> send(const Request* request,
+                                                    ResponseWriter& writer,
+                                                    const std::string& fileName,
+                                                    const Mime::MediaType& contentType,
+                                                    FileCache& cache);
+        };
 
-        std::ostream os(buf);
+        Async::Promise<PST_SSIZE_T> FileResponse::send(const Request* request,
+                                                       ResponseWriter& writer,
+                                                       const std::string& fileName,
+                                                       const Mime::MediaType& contentType,
+                                                       FileCache& cache)
+        {
+            // Throws an HttpError when the file can not be served
+            const auto original = cache.get(fileName);
+            auto file           = original;
+
+            const auto method = request ? request->method() : Method::Get;
+
+            // A precompressed version is sent in place of the file, with
+            // its own validators and ranges, but the file's media type
+            Header::Encoding encoding = Header::Encoding::Identity;
+            const bool negotiated     = request && cache.isPrecompressed() && (method == Method::Get || method == Method::Head);
+            if (negotiated)
+            {
+                if (auto precompressed = findPrecompressed(*request, fileName, *original, cache, encoding))
+                    file = std::move(precompressed);
+            }
+
+            Code code = Code::Ok;
+            std::vector<ByteRange> ranges;
+            if (request && (method == Method::Get || method == Method::Head))
+            {
+                if (isNotModified(*request, *file))
+                {
+                    code = Code::Not_Modified;
+                }
+                else if (auto range = request->headers().tryGetRaw("Range");
+                         range && method == Method::Get && ifRangeHolds(*request, *file))
+                {
+                    switch (parseRanges(range->value(), file->size, ranges))
+                    {
+                    case RangeStatus::Satisfiable:
+                        code = Code::Partial_Content;
+                        break;
+                    case RangeStatus::Unsatisfiable:
+                        code = Code::Requested_Range_Not_Satisfiable;
+                        break;
+                    case RangeStatus::Ignored:
+                        ranges.clear();
+                        break;
+                    }
+                }
+            }
+
+            auto& headers = writer.headers();
+            headers.add<Header::ETag>(file->etag);
+            headers.add<Header::LastModified>(file->lastModified);
+            if (encoding != Header::Encoding::Identity)
+                headers.add<Header::ContentEncoding>(encoding);
+
+            const auto& mime = contentType.isValid() ? contentType : original->mime;
+            const bool multipart = ranges.size() > 1;
+            if (multipart)
+            {
+                headers.remove<Header::ContentType>();
+            }
+            else if (mime.isValid() && code != Code::Not_Modified)
+            {
+                auto ct = headers.tryGet<Header::ContentType>();
+                if (ct)
+                    ct->setMime(mime);
+                else
+                    headers.add<Header::ContentType>(mime);
+            }
+
+            auto slice = [&file](size_t offset, size_t length) -> Part {
+                if (file->content)
+                {
+                    if (offset == 0 && length == file->size)
+                        return RawBuffer(file->content);
+                    return RawBuffer(file->content->substr(offset, length), length);
+                }
+                return FileBuffer(file->file, static_cast<off_t>(offset), length);
+            };
+
+            auto contentRange = [&file](const ByteRange& range) {
+                return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(file->size);
+            };
+
+            std::vector<Part> parts;
+            std::string extraHeaders;
+            size_t length = 0;
+            switch (code)
+            {
+            case Code::Ok:
+                length = file->size;
+                if (length > 0)
+                    parts.push_back(slice(0, length));
+                break;
+
+            case Code::Partial_Content:
+                if (!multipart)
+                {
+                    extraHeaders = "Content-Range: " + contentRange(ranges.front()) + "\r\n";
+                    length       = ranges.front().length();
+                    parts.push_back(slice(ranges.front().first, length));
+                    break;
+                }
+                else
+                {
+                    const auto boundary = makeBoundary();
+                    extraHeaders        = "Content-Type: multipart/byteranges; boundary=" + boundary + "\r\n";
+
+                    const std::string partType = mime.isValid() ? "Content-Type: " + mime.toString() + "\r\n" : std::string();
+                    for (size_t i = 0; i < ranges.size(); ++i)
+                    {
+                        std::string preamble = (i == 0 ? "--" : "\r\n--") + boundary + "\r\n" + partType + "Content-Range: " + contentRange(ranges[i]) + "\r\n\r\n";
+                        length += preamble.size() + ranges[i].length();
+
+                        const size_t size = preamble.size();
+                        parts.emplace_back(RawBuffer(std::move(preamble), size));
+                        parts.push_back(slice(ranges[i].first, ranges[i].length()));
+                    }
+
+                    std::string epilogue = "\r\n--" + boundary + "--\r\n";
+                    length += epilogue.size();
+
+                    const size_t size = epilogue.size();
+                    parts.emplace_back(RawBuffer(std::move(epilogue), size));
+                }
+                break;
+
+            case Code::Requested_Range_Not_Satisfiable:
+                extraHeaders = "Content-Range: bytes */" + std::to_string(file->size) + "\r\n";
+                break;
+
+            default:
+                break;
+            }
+
+            // Only the headers, as if the body had been sent, for HEAD
+            if (method == Method::Head)
+                parts.clear();
+
+            auto* buf = writer.rdbuf();
+
+            std::ostream os(buf);
 
 #define PST_OUT(...)                                      \
     do                                                    \
@@ -1200,57 +1817,94 @@ namespace Pistache::Http
         }                                                 \
     } while (0);
 
-        auto setContentType = [&](const Mime::MediaType& contentType) {
-            auto& headers = writer.headers();
-            auto ct       = headers.tryGet<Header::ContentType>();
-            if (ct)
-                ct->setMime(contentType);
-            else
-                headers.add<Header::ContentType>(contentType);
-        };
+            PST_OUT(writeStatusLine(writer.response_.version(), code, *buf));
+            PST_OUT(writeHeaders(headers, *buf));
+            PST_OUT(writeCookies(writer.response_.cookies(), *buf));
+            PST_OUT(os << "Accept-Ranges: bytes\r\n");
+            if (negotiated)
+                PST_OUT(os << "Vary: Accept-Encoding\r\n");
+            PST_OUT(os << extraHeaders);
 
-        PST_OUT(writeStatusLine(writer.response_.version(), Http::Code::Ok, *buf));
-        if (contentType.isValid())
-        {
-            setContentType(contentType);
-        }
-        else
-        {
-            auto mime = Mime::MediaType::fromFile(fileName.c_str());
-            if (mime.isValid())
-                setContentType(mime);
-        }
+            // A 304 describes the file that would have been sent, and has no
+            // body to give the length of
+            if (code != Code::Not_Modified)
+                PST_OUT(writeHeader<Header::ContentLength>(os, length));
 
-        PST_OUT(writeHeaders(writer.headers(), *buf));
-
-        const size_t len = static_cast<size_t>(sb.st_size);
+            PST_OUT(os << crlf);
 
-        PST_OUT(writeHeader<Header::ContentLength>(os, len));
+#undef PST_OUT
 
-        PST_OUT(os << crlf);
+            writer.timeout_.disarm();
 
-        auto* transport = writer.transport_;
-        auto peer       = writer.peer();
-        auto sockFd     = peer->fd(); // may be PS_FD_EMPTY
+            auto* transport = writer.transport_;
+            auto peer       = writer.peer();
+            recordResponse(transport, writer.pipelineSlot_, code);
 
-        auto buffer = buf->buffer();
-        return transport->asyncWrite(sockFd, buffer,
+            // Everything is queued at once and goes out in order, parts of a
+            // held in memory file along with the headers
+            auto queue = [&](const auto& buffer, bool more) {
+                return transport->asyncWrite(peer, buffer,
 #ifdef _USE_LIBEVENT_LIKE_APPLE
-                                     0, // MSG_MORE unsupported in macos sendmsg
-                                        // Instead, we set TCP_NOPUSH via
-                                        // setsockopt (see "man tcp").
-                                     true // use msg_more_style
+                                             0, // MSG_MORE unsupported in macos sendmsg
+                                                // Instead, we set TCP_NOPUSH via
+                                                // setsockopt (see "man tcp").
+                                             more // use msg_more_style
 #else
-                                     MSG_MORE
+                                             more ? MSG_MORE : 0
 #endif
-                                     )
-            .then(
-                [=](PST_SSIZE_T) {
-                    return transport->asyncWrite(sockFd, FileBuffer(fileName));
+                );
+            };
+
+            auto written = queue(buf->release(), !parts.empty());
+            for (size_t i = 0; i < parts.size(); ++i)
+            {
+                const bool more = i + 1 < parts.size();
+                written         = std::visit([&](const auto& part) { return queue(part, more); },
+                                             parts[i]);
+            }
+
+            // The next response may follow once this one is written, or
+            // failed to be. Both continuations share the slot, so that it
+            // is let go of by whichever runs, not when the promise is
+            auto slot = std::make_shared<std::shared_ptr<PipelineSlot>>(
+                std::move(writer.pipelineSlot_));
+
+            return written.then(
+                [slot](PST_SSIZE_T bytes) {
+                    slot->reset();
+                    return bytes;
                 },
-                Async::Throw);
+                [slot](std::exception_ptr& eptr) {
+                    slot->reset();
+                    Async::Throw(eptr);
+                });
+        }
+    } // namespace Private
 
-#undef PST_OUT
+    Async::Promise<PST_SSIZE_T> serveFile(ResponseWriter& writer,
+                                          const std::string& fileName,
+                                          const Mime::MediaType& contentType)
+    {
+        return Private::FileResponse::send(nullptr, writer, fileName, contentType,
+                                           FileCache::global());
+    }
+
+    Async::Promise<PST_SSIZE_T> serveFile(const Request& request,
+                                          ResponseWriter& writer,
+                                          const std::string& fileName,
+                                          const Mime::MediaType& contentType)
+    {
+        return Private::FileResponse::send(&request, writer, fileName, contentType,
+                                           FileCache::global());
+    }
+
+    Async::Promise<PST_SSIZE_T> serveFile(const Request& request,
+                                          ResponseWriter& writer,
+                                          const std::string& fileName,
+                                          const Mime::MediaType& contentType,
+                                          FileCache& cache)
+    {
+        return Private::FileResponse::send(&request, writer, fileName, contentType, cache);
     }
 
     Private::ParserImpl<Http::Request>::ParserImpl(size_t maxDataSize)
@@ -1263,12 +1917,78 @@ namespace Pistache::Http
         allSteps[2] = std::make_unique<BodyStep>(&request);
     }
 
+    Private::ParserImpl<Http::Request>::ParserImpl(ArrayStreamBuf<char>& input)
+        : ParserBase(input)
+        , request()
+        , time_(std::chrono::steady_clock::now())
+    {
+        allSteps[0] = std::make_unique<RequestLineStep>(&request);
+        allSteps[1] = std::make_unique<HeadersStep>(&request);
+        allSteps[2] = std::make_unique<BodyStep>(&request);
+    }
+
     void Private::ParserImpl<Http::Request>::reset()
     {
         ParserBase::reset();
 
         request = Request();
         time_   = std::chrono::steady_clock::now();
+
+        // The steps may have been left half-way through a message
+        allSteps[0]  = std::make_unique<RequestLineStep>(&request);
+        allSteps[1]  = std::make_unique<HeadersStep>(&request);
+        allSteps[2]  = std::make_unique<BodyStep>(&request);
+        bytesToSkip_ = 0;
+
+        headersHandled_ = false;
+        bodyReader_     = nullptr;
+    }
+
+    void Private::ParserImpl<Http::Request>::resetForNextRequest()
+    {
+        resetKeepingUnread();
+
+        request = Request();
+        time_   = std::chrono::steady_clock::now();
+
+        headersHandled_ = false;
+        bodyReader_     = nullptr;
+        bodyStep()->setReader(nullptr);
+    }
+
+    void Private::ParserImpl<Http::Request>::setBodyReader(std::shared_ptr<BodyReader> reader)
+    {
+        headersHandled_ = true;
+        bodyReader_     = std::move(reader);
+        bodyStep()->setReader(bodyReader_.get());
+    }
+
+    Private::BodyStep* Private::ParserImpl<Http::Request>::bodyStep() const
+    {
+        return static_cast<BodyStep*>(allSteps[2].get());
+    }
+
+    void Private::ParserImpl<Http::Request>::discardRequest()
+    {
+        size_t bytesToSkip = 0;
+        if (step()->id() == BodyStep::Id)
+        {
+            // Everything received of the body so far has been consumed
+            auto cl = request.headers().tryGet<Header::ContentLength>();
+            if (cl && !request.headers().has<Header::TransferEncoding>() && cl->value() > request.body().size())
+                bytesToSkip = static_cast<size_t>(cl->value()) - request.body().size();
+        }
+
+        reset();
+        bytesToSkip_ = bytesToSkip;
+    }
+
+    bool Private::ParserImpl<Http::Request>::skipDiscarded()
+    {
+        if (bytesToSkip_ > 0)
+            bytesToSkip_ -= discardInput(bytesToSkip_);
+
+        return bytesToSkip_ == 0;
     }
 
     Private::ParserImpl<Http::Response>::ParserImpl(size_t maxDataSize)
@@ -1280,6 +2000,44 @@ namespace Pistache::Http
         allSteps[2] = std::make_unique<BodyStep>(&response);
     }
 
+    void Private::ParserImpl<Http::Response>::reset()
+    {
+        ParserBase::reset();
+
+        response = Response();
+
+        // The steps may have been left half-way through a message
+        allSteps[0] = std::make_unique<ResponseLineStep>(&response);
+        allSteps[1] = std::make_unique<HeadersStep>(&response);
+        allSteps[2] = std::make_unique<BodyStep>(&response);
+
+        headersHandled_ = false;
+        bodyReader_     = nullptr;
+    }
+
+    void Private::ParserImpl<Http::Response>::resetForNextResponse()
+    {
+        resetKeepingUnread();
+
+        response = Response();
+
+        headersHandled_ = false;
+        bodyReader_     = nullptr;
+        bodyStep()->setReader(nullptr);
+    }
+
+    void Private::ParserImpl<Http::Response>::setBodyReader(std::shared_ptr<BodyReader> reader)
+    {
+        headersHandled_ = true;
+        bodyReader_     = std::move(reader);
+        bodyStep()->setReader(bodyReader_.get());
+    }
+
+    Private::BodyStep* Private::ParserImpl<Http::Response>::bodyStep() const
+    {
+        return static_cast<BodyStep*>(allSteps[2].get());
+    }
+
     void Handler::onInput(const char* buffer, size_t len,
                           const std::shared_ptr<Tcp::Peer>& peer)
     {
@@ -1289,7 +2047,9 @@ namespace Pistache::Http
         auto& request = parser->request;
         try
         {
-            if (!parser->feed(buffer, len))
+            // Input read into the peer's retained buffer is already where
+            // the parser reads from
+            if (!peer->isInputRetained() && !parser->feed(buffer, len))
             {
                 PS_LOG_DEBUG("parser returned false");
 
@@ -1298,19 +2058,61 @@ namespace Pistache::Http
                                 "Request exceeded maximum buffer size");
             }
 
-            auto state = parser->parse();
+            // Still in the body of a request that was refused as too large
+            if (!parser->skipDiscarded())
+                return;
 
-            if (state == Private::State::Done)
+            // A read may carry several pipelined requests. They are handled
+            // one at a time: the next one is only parsed once the response
+            // to the previous one is queued, which keeps responses in order
+            // even when handlers reply asynchronously.
+            while (!parser->awaitingResponse())
             {
-                PS_LOG_DEBUG("Creating response");
-
-                ResponseWriter response(request.version(), transport(), this, peer);
+                if (!parser->headersHandled())
+                {
+                    if (parser->parseHeaders() != Private::State::Next)
+                        break;
 
 #ifdef LIBSTDCPP_SMARTPTR_LOCK_FIXME
-                request.associatePeer(peer);
+                    request.associatePeer(peer);
 #endif
 
-                request.copyAddress(peer->address());
+                    request.copyAddress(peer->address());
+
+                    auto reader = onRequestHeaders(request);
+                    if (reader)
+                    {
+                        reader->resumeInput_ = [transport = transport(),
+                                                weakPeer  = std::weak_ptr<Tcp::Peer>(peer)]() {
+                            if (auto peer = weakPeer.lock())
+                                transport->resumeInput(peer);
+                        };
+                    }
+                    parser->setBodyReader(std::move(reader));
+                }
+
+                // The input is left buffered until the reader is resumed
+                const auto& reader = parser->bodyReader();
+                if (reader && reader->isPaused())
+                    break;
+
+                auto state = parser->parse();
+                if (reader)
+                {
+                    // What was handed to the reader is not needed anymore,
+                    // making room for the rest of the body
+                    parser->compactInput();
+                    parser->touch();
+                }
+
+                if (state != Private::State::Done)
+                    break;
+
+                PS_LOG_DEBUG("Creating response");
+
+                transport()->metrics().requestReceived();
+
+                ResponseWriter response(request.version(), transport(), this, peer);
 
                 auto connection = request.headers().tryGet<Header::Connection>();
 
@@ -1327,14 +2129,41 @@ namespace Pistache::Http
                     response.headers().add<Header::Connection>(ConnectionControl::Close);
                 }
 
+                auto slot = std::make_shared<Private::PipelineSlot>(transport(), peer);
+                response.pipelineSlot_ = slot;
+                parser->setInFlight(slot);
+
                 PS_LOG_DEBUG("Calling peer->setIdle");
                 peer->setIdle(false); // change peer state to not idle
 
-                PS_LOG_DEBUG("Calling onRequest");
-                onRequest(request, std::move(response));
+                PS_LOG_DEBUG("Calling onMutableRequest");
+                onMutableRequest(request, std::move(response));
 
-                PS_LOG_DEBUG("Calling parser->reset");
-                parser->reset();
+                PS_LOG_DEBUG("Calling parser->resetForNextRequest");
+                parser->resetForNextRequest();
+
+                // Still held by a handler that will respond later: it will
+                // resume the input once it has
+                if (slot.use_count() > 1)
+                {
+                    slot->arm();
+                    break;
+                }
+            }
+
+            // Nothing more can come in, and what is there is not a complete
+            // request. A paused reader only has the input wait for it.
+            const auto& reader = parser->bodyReader();
+            if (!parser->awaitingResponse() && parser->inputFull() && !(reader && reader->isPaused()))
+            {
+                PS_LOG_DEBUG("input buffer full");
+
+                const auto version = request.version();
+                parser->discardRequest();
+
+                ResponseWriter response(version, transport(), this, peer);
+                response.send(Code::Request_Entity_Too_Large,
+                              "Request exceeded maximum buffer size");
             }
         }
         catch (const HttpError& err)
@@ -1356,9 +2185,22 @@ namespace Pistache::Http
         }
     }
 
+    std::shared_ptr<BodyReader> Handler::onRequestHeaders(const Request& /*request*/)
+    {
+        return nullptr;
+    }
+
+    void Handler::onMutableRequest(Request& request, ResponseWriter response)
+    {
+        onRequest(request, std::move(response));
+    }
+
     void Handler::onConnection(const std::shared_ptr<Tcp::Peer>& peer)
     {
-        peer->putData(ParserData, std::make_shared<RequestParser>(maxRequestSize_));
+        // The request is parsed in place, out of the buffer the transport
+        // reads into
+        peer->retainInput(receiveBufferSize_, maxRequestSize_);
+        peer->putData(ParserData, std::make_shared<RequestParser>(peer->inputBuffer()));
     }
 
     void Handler::onTimeout(const Request& /*request*/,
@@ -1367,25 +2209,63 @@ namespace Pistache::Http
         response.send(Code::Request_Timeout);
     }
 
+    void BodyReader::pause() { paused_ = true; }
+
+    void BodyReader::resume()
+    {
+        if (!paused_.exchange(false))
+            return;
+
+        if (resumeInput_)
+            resumeInput_();
+    }
+
+    bool BodyReader::isPaused() const { return paused_; }
+
     Timeout::~Timeout() { disarm(); }
 
+    void Timeout::armMs(std::chrono::milliseconds value)
+    {
+        if (!transport)
+            throw std::runtime_error("Timeout has no transport");
+
+        disarm();
+
+        // The callback works on a copy, as this Timeout moves along with its
+        // ResponseWriter
+        timer = transport->timers().schedule(value, [expired = Timeout(*this)]() mutable {
+            expired.onTimeout(1);
+        });
+    }
+
     void Timeout::disarm()
     {
-        if (transport && armed)
+        if (transport && timer != TimerWheel::NoTimer)
         {
-            transport->disarmTimer(timerFd);
+            transport->timers().cancel(timer);
+            timer = TimerWheel::NoTimer;
         }
     }
 
-    bool Timeout::isArmed() const { return armed; }
+    bool Timeout::isArmed() const
+    {
+        return transport && transport->timers().isScheduled(timer);
+    }
+
+    Timeout::Timeout(const Timeout& other)
+        : handler(other.handler)
+        , version(other.version)
+        , transport(other.transport)
+        , timer(TimerWheel::NoTimer)
+        , peer(other.peer)
+    { }
 
     Timeout::Timeout(Tcp::Transport* transport_, Http::Version version, Handler* handler_,
                      std::weak_ptr<Tcp::Peer> peer_)
         : handler(handler_)
         , version(version)
         , transport(transport_)
-        , armed(false)
-        , timerFd(PS_FD_EMPTY)
+        , timer(TimerWheel::NoTimer)
         , peer(peer_)
     { }
 
@@ -1395,6 +2275,9 @@ namespace Pistache::Http
         if (!sp)
             return;
 
+        if (transport)
+            transport->metrics().requestTimedOut();
+
         ResponseWriter response(version, transport, handler, peer);
         auto parser         = Handler::getParser(sp);
         const auto& request = parser->request;
@@ -1409,6 +2292,20 @@ namespace Pistache::Http
 
     size_t Handler::getMaxResponseSize() const { return maxResponseSize_; }
 
+    void Handler::setReceiveBufferSize(size_t value) { receiveBufferSize_ = value; }
+
+    size_t Handler::getReceiveBufferSize() const { return receiveBufferSize_; }
+
+    void Handler::setCompressor(std::shared_ptr<Compressor> compressor)
+    {
+        compressor_ = std::move(compressor);
+    }
+
+    const std::shared_ptr<Compressor>& Handler::getCompressor() const
+    {
+        return compressor_;
+    }
+
     std::shared_ptr<RequestParser>
     Handler::getParser(const std::shared_ptr<Tcp::Peer>& peer)
     {
@@ -20,6 +20,7 @@
 #include <pistache/stream.h>
 
 #include <algorithm>
+#include <cctype>
 #include <charconv>
 #include <cstring>
 #include <iostream>
@@ -399,18 +400,23 @@ namespace Pistache::Http::Header
 
     void ContentLength::parse(const std::string& data)
     {
-        try
+        // Nothing but digits, up to trailing spaces: a length read any other
+        // way would have the body taken for the start of the next request
+        const auto end = data.find_last_not_of(" \t");
+        if (end == std::string::npos
+            || !std::all_of(data.begin(), data.begin() + end + 1,
+                            [](unsigned char c) { return std::isdigit(c) != 0; }))
         {
-            size_t pos;
-            uint64_t val = std::stoull(data, &pos);
-            if (pos != 0)
-            {
-            }
+            throw std::invalid_argument("Invalid Content-Length");
+        }
 
-            value_ = val;
+        try
+        {
+            value_ = std::stoull(data);
         }
-        catch (const std::invalid_argument& /*e*/)
+        catch (const std::out_of_range& /*e*/)
         {
+            throw std::invalid_argument("Content-Length out of range");
         }
     }
 
@@ -625,6 +631,10 @@ namespace Pistache::Http::Header
         }
     }
 
+    void ETag::parse(const std::string& data) { tag_ = data; }
+
+    void ETag::write(std::ostream& os) const { os << tag_; }
+
     void LastModified::parse(const std::string& data)
     {
         fullDate_ = FullDate::fromString(data);
@@ -12,6 +12,8 @@
 
 #include <pistache/http_headers.h>
 
+#include <array>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <unordered_map>
@@ -34,6 +36,7 @@ namespace Pistache::Http::Header
     RegisterHeader(ContentType);
     RegisterHeader(Authorization);
     RegisterHeader(Date);
+    RegisterHeader(ETag);
     RegisterHeader(Expect);
     RegisterHeader(Host);
     RegisterHeader(LastModified);
@@ -41,6 +44,102 @@ namespace Pistache::Http::Header
     RegisterHeader(Server);
     RegisterHeader(UserAgent);
 
+    namespace
+    {
+        template <typename H>
+        std::shared_ptr<Header> makeKnown()
+        {
+            return std::make_shared<H>();
+        }
+
+        struct KnownHeader
+        {
+            std::string_view name;
+            // nullptr for the headers that have no typed form
+            std::shared_ptr<Header> (*make)();
+        };
+
+        // The header names parsed messages are matched against without
+        // hashing the whole name. All of the registered headers above are
+        // here.
+        constexpr KnownHeader KnownHeaders[] = {
+            { Accept::Name, &makeKnown<Accept> },
+            { AccessControlAllowOrigin::Name, &makeKnown<AccessControlAllowOrigin> },
+            { AccessControlAllowHeaders::Name, &makeKnown<AccessControlAllowHeaders> },
+            { AccessControlExposeHeaders::Name, &makeKnown<AccessControlExposeHeaders> },
+            { AccessControlAllowMethods::Name, &makeKnown<AccessControlAllowMethods> },
+            { Allow::Name, &makeKnown<Allow> },
+            { CacheControl::Name, &makeKnown<CacheControl> },
+            { Connection::Name, &makeKnown<Connection> },
+            { AcceptEncoding::Name, &makeKnown<AcceptEncoding> },
+            { ContentEncoding::Name, &makeKnown<ContentEncoding> },
+            { TransferEncoding::Name, &makeKnown<TransferEncoding> },
+            { ContentLength::Name, &makeKnown<ContentLength> },
+            { ContentType::Name, &makeKnown<ContentType> },
+            { Authorization::Name, &makeKnown<Authorization> },
+            { Date::Name, &makeKnown<Date> },
+            { Expect::Name, &makeKnown<Expect> },
+            { Host::Name, &makeKnown<Host> },
+            { LastModified::Name, &makeKnown<LastModified> },
+            { Location::Name, &makeKnown<Location> },
+            { Server::Name, &makeKnown<Server> },
+            { UserAgent::Name, &makeKnown<UserAgent> },
+            { "Cookie", nullptr },
+            { "Set-Cookie", nullptr },
+        };
+
+        constexpr size_t KnownSlotCount = 64;
+
+        constexpr size_t lowercaseByte(char c)
+        {
+            const auto uc = static_cast<unsigned char>(c);
+            return (uc >= 'A' && uc <= 'Z') ? uc + ('a' - 'A') : uc;
+        }
+
+        // A perfect hash of the known names, which are at least two bytes
+        // long: no two of them share a slot, as checked when the table is
+        // built
+        constexpr size_t knownSlot(std::string_view name)
+        {
+            return (name.size() + 3 * lowercaseByte(name[0])
+                    + 22 * lowercaseByte(name[name.size() - 2]))
+                % KnownSlotCount;
+        }
+
+        constexpr std::array<int8_t, KnownSlotCount> makeKnownSlots()
+        {
+            std::array<int8_t, KnownSlotCount> slots {};
+            for (auto& slot : slots)
+                slot = -1;
+
+            for (size_t i = 0; i < std::size(KnownHeaders); ++i)
+            {
+                auto& slot = slots[knownSlot(KnownHeaders[i].name)];
+                if (slot != -1)
+                    throw std::logic_error("Known header names share a slot");
+
+                slot = static_cast<int8_t>(i);
+            }
+
+            return slots;
+        }
+
+        constexpr auto KnownSlots = makeKnownSlots();
+
+        // Index of name in KnownHeaders, whatever its case, or -1
+        int knownIndex(std::string_view name)
+        {
+            if (name.size() < 2)
+                return -1;
+
+            const int index = KnownSlots[knownSlot(name)];
+            if (index < 0 || !LowercaseEqualStatic(name, KnownHeaders[index].name))
+                return -1;
+
+            return index;
+        }
+    } // namespace
+
     bool strToQvalue(const char* str, float* qvalue, std::size_t* qvalueLen)
     {
         constexpr char offset = '0';
@@ -147,6 +246,13 @@ namespace Pistache::Http::Header
             [](const char& a, const char& b) { return std::tolower(a) == b; });
     }
 
+    bool LowercaseEqualStatic(std::string_view dynamic, std::string_view statik)
+    {
+        return std::equal(
+            dynamic.begin(), dynamic.end(), statik.begin(), statik.end(),
+            [](const char& a, const char& b) { return std::tolower(a) == std::tolower(b); });
+    }
+
     Registry& Registry::instance()
     {
         static Registry instance;
@@ -202,6 +308,11 @@ namespace Pistache::Http::Header
 
     Collection& Collection::add(const std::shared_ptr<Header>& header)
     {
+        // A parsed header of the same name takes precedence, as it would
+        // have been added first
+        if (!lazyHeaders_.empty() && getImpl(header->name()).first)
+            return *this;
+
         headers.insert(std::make_pair(header->name(), header));
 
         return *this;
@@ -209,7 +320,15 @@ namespace Pistache::Http::Header
 
     Collection& Collection::addRaw(const Raw& raw)
     {
-        rawHeaders.insert(std::make_pair(raw.name(), raw));
+        const std::string name = raw.name();
+        if (!lazyHeaders_.empty())
+        {
+            auto* lazy = findLazy(name);
+            if (lazy != nullptr && !lazy->rawRemoved)
+                return *this;
+        }
+
+        rawHeaders.insert(std::make_pair(name, raw));
         return *this;
     }
 
@@ -237,13 +356,13 @@ namespace Pistache::Http::Header
 
     Raw Collection::getRaw(const std::string& name) const
     {
-        auto it = rawHeaders.find(name);
-        if (it == std::end(rawHeaders))
+        auto raw = tryGetRaw(name);
+        if (!raw)
         {
             throw std::runtime_error("Could not find header");
         }
 
-        return it->second;
+        return *raw;
     }
 
     std::shared_ptr<const Header>
@@ -267,6 +386,20 @@ namespace Pistache::Http::Header
 
     std::optional<Raw> Collection::tryGetRaw(const std::string& name) const
     {
+        // rawList() may be moving the lazy headers to rawHeaders
+        std::unique_lock<std::mutex> lock(rawMutex_.mutex, std::defer_lock);
+        if (!lazyHeaders_.empty())
+        {
+            lock.lock();
+            auto* lazy = findLazy(name);
+            if (lazy != nullptr && !lazy->rawRemoved)
+            {
+                return std::optional<Raw>(std::in_place,
+                                          std::string(lazyName(*lazy)),
+                                          std::string(lazyValue(*lazy)));
+            }
+        }
+
         auto it = rawHeaders.find(name);
         if (it == std::end(rawHeaders))
         {
@@ -284,7 +417,16 @@ namespace Pistache::Http::Header
     std::vector<std::shared_ptr<Header>> Collection::list() const
     {
         std::vector<std::shared_ptr<Header>> ret;
-        ret.reserve(headers.size());
+        ret.reserve(lazyHeaders_.size() + headers.size());
+        for (auto& lazy : lazyHeaders_)
+        {
+            // Only the first header of a given name is taken
+            if (lazy.typedRemoved || findLazy(lazyName(lazy)) != &lazy)
+                continue;
+
+            if (auto header = makeTyped(lazy))
+                ret.push_back(std::move(header));
+        }
         for (const auto& h : headers)
         {
             ret.push_back(h.second);
@@ -293,11 +435,45 @@ namespace Pistache::Http::Header
         return ret;
     }
 
+    const std::unordered_map<std::string, Raw, LowercaseHash, LowercaseEqual>&
+    Collection::rawList() const
+    {
+        if (lazyHeaders_.empty())
+            return rawHeaders;
+
+        std::lock_guard<std::mutex> guard(rawMutex_.mutex);
+        for (auto& lazy : lazyHeaders_)
+        {
+            if (lazy.rawRemoved)
+                continue;
+
+            std::string name(lazyName(lazy));
+            rawHeaders.emplace(name, Raw(name, std::string(lazyValue(lazy))));
+            lazy.rawRemoved = true;
+        }
+
+        return rawHeaders;
+    }
+
     bool Collection::remove(const std::string& name)
     {
+        auto* lazy = lazyHeaders_.empty() ? nullptr : findLazy(name);
+        if (lazy != nullptr && !lazy->typedRemoved && makeTyped(*lazy))
+        {
+            lazy->typedRemoved = true;
+            std::atomic_store(&lazy->typed, std::shared_ptr<Header>());
+            return true;
+        }
+
         auto tit = headers.find(name);
         if (tit == std::end(headers))
         {
+            if (lazy != nullptr && !lazy->rawRemoved)
+            {
+                lazy->rawRemoved = true;
+                return true;
+            }
+
             auto rit = rawHeaders.find(name);
             if (rit == std::end(rawHeaders))
                 return false;
@@ -313,12 +489,55 @@ namespace Pistache::Http::Header
     {
         headers.clear();
         rawHeaders.clear();
+        rawSection_.clear();
+        lazyHeaders_.clear();
+    }
+
+    std::string_view Collection::keepRawSection(const char* data, size_t len)
+    {
+        const size_t offset = rawSection_.size();
+        rawSection_.append(data, len);
+
+        return std::string_view(rawSection_).substr(offset);
+    }
+
+    void Collection::addLazy(std::string_view name, std::string_view value)
+    {
+        // Enough for the headers of most requests in one allocation
+        if (lazyHeaders_.capacity() == 0)
+            lazyHeaders_.reserve(16);
+
+        LazyHeader lazy;
+        lazy.name         = static_cast<uint32_t>(name.data() - rawSection_.data());
+        lazy.nameLen      = static_cast<uint32_t>(name.size());
+        lazy.value        = static_cast<uint32_t>(value.data() - rawSection_.data());
+        lazy.valueLen     = static_cast<uint32_t>(value.size());
+        lazy.known        = static_cast<int8_t>(knownIndex(name));
+        lazy.typedRemoved = false;
+        lazy.rawRemoved   = false;
+
+        lazyHeaders_.push_back(std::move(lazy));
     }
 
     std::pair<bool, std::shared_ptr<Header>>
-    Collection::getImpl(const std::string& name) const
+    Collection::getImpl(std::string_view name) const
     {
-        auto it = headers.find(name);
+        if (!lazyHeaders_.empty())
+        {
+            auto* lazy = findLazy(name);
+            if (lazy != nullptr && !lazy->typedRemoved)
+            {
+                if (auto header = makeTyped(*lazy))
+                    return std::make_pair(true, std::move(header));
+            }
+        }
+
+        if (headers.empty())
+        {
+            return std::make_pair(false, nullptr);
+        }
+
+        auto it = headers.find(std::string(name));
         if (it == std::end(headers))
         {
             return std::make_pair(false, nullptr);
@@ -327,4 +546,75 @@ namespace Pistache::Http::Header
         return std::make_pair(true, it->second);
     }
 
+    Collection::LazyHeader* Collection::findLazy(std::string_view name) const
+    {
+        const int known = knownIndex(name);
+        for (auto& lazy : lazyHeaders_)
+        {
+            const bool match = (known >= 0)
+                ? lazy.known == known
+                : (lazy.known < 0 && LowercaseEqualStatic(lazyName(lazy), name));
+            if (match)
+                return &lazy;
+        }
+
+        return nullptr;
+    }
+
+    // A header whose value does not parse is taken as absent, as it can no
+    // longer be refused when the request is received. Those the parser relies
+    // on, Content-Type, Content-Length and Transfer-Encoding, are refused then.
+    std::shared_ptr<Header> Collection::makeTyped(LazyHeader& lazy) const
+    {
+        auto cached = std::atomic_load(&lazy.typed);
+        if (cached)
+            return cached;
+
+        std::shared_ptr<Header> header;
+        if (lazy.known >= 0)
+        {
+            const auto make = KnownHeaders[lazy.known].make;
+            if (make == nullptr)
+                return nullptr;
+
+            header = make();
+        }
+        else
+        {
+            // Only the headers registered with the Registry have a typed form
+            const std::string name(lazyName(lazy));
+            auto& registry = Registry::instance();
+            if (!registry.isRegistered(name))
+                return nullptr;
+
+            header = registry.makeHeader(name);
+        }
+
+        const auto value = lazyValue(lazy);
+        try
+        {
+            header->parseRaw(value.data(), value.size());
+        }
+        catch (const std::exception&)
+        {
+            return nullptr;
+        }
+
+        // Another thread may have built it meanwhile: the first one is kept,
+        // so that every caller gets the same object
+        if (!std::atomic_compare_exchange_strong(&lazy.typed, &cached, header))
+            return cached;
+        return header;
+    }
+
+    std::string_view Collection::lazyName(const LazyHeader& lazy) const
+    {
+        return std::string_view(rawSection_).substr(lazy.name, lazy.nameLen);
+    }
+
+    std::string_view Collection::lazyValue(const LazyHeader& lazy) const
+    {
+        return std::string_view(rawSection_).substr(lazy.value, lazy.valueLen);
+    }
+
 } // namespace Pistache::Http::Header
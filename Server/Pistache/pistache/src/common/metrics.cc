@@ -0,0 +1,306 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* metrics.cc
+
+   Implementation of the runtime metrics of a server
+*/
+
+#include <pistache/metrics.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace Pistache::Metrics
+{
+
+    namespace
+    {
+        // Roughly where the buckets of the latency histogram exposed to
+        // Prometheus end, in microseconds. Each is moved up to the end of
+        // the histogram bucket it falls in, so that the counts are exact
+        // (e.g. 100 becomes 103); the scrapes still see bounds that never
+        // change.
+        constexpr uint64_t PrometheusBuckets[] = {
+            100, 250, 500,
+            1000, 2500, 5000,
+            10000, 25000, 50000,
+            100000, 250000, 500000,
+            1000000, 2500000, 5000000, 10000000
+        };
+
+        int highestBit(uint64_t value)
+        {
+            int bit = 0;
+            while (value >>= 1)
+                ++bit;
+            return bit;
+        }
+
+        size_t codeClass(int code)
+        {
+            if (code < 100 || code >= 600)
+                return 4;
+            return static_cast<size_t>(code / 100 - 1);
+        }
+
+        std::string seconds(uint64_t micros)
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(micros) / 1e6);
+            return buffer;
+        }
+
+        class Exposition
+        {
+        public:
+            explicit Exposition(const std::string& prefix)
+                : prefix_(prefix)
+            { }
+
+            void header(const char* name, const char* type, const char* help)
+            {
+                out_ << "# HELP " << prefix_ << '_' << name << ' ' << help << '\n';
+                out_ << "# TYPE " << prefix_ << '_' << name << ' ' << type << '\n';
+            }
+
+            template <typename Value>
+            void workers(const Snapshot& snapshot, const char* name, const char* type,
+                         const char* help, Value value)
+            {
+                header(name, type, help);
+                for (size_t i = 0; i < snapshot.workers.size(); ++i)
+                    sample(name, "worker=\"" + std::to_string(i) + '"', value(snapshot.workers[i]));
+            }
+
+            void sample(const std::string& name, const std::string& labels, const std::string& value)
+            {
+                out_ << prefix_ << '_' << name;
+                if (!labels.empty())
+                    out_ << '{' << labels << '}';
+                out_ << ' ' << value << '\n';
+            }
+
+            void sample(const std::string& name, const std::string& labels, uint64_t value)
+            {
+                sample(name, labels, std::to_string(value));
+            }
+
+            std::string str() const { return out_.str(); }
+
+        private:
+            std::string prefix_;
+            std::ostringstream out_;
+        };
+    }
+
+    size_t Histogram::bucketOf(uint64_t value)
+    {
+        if (value < SubBuckets)
+            return static_cast<size_t>(value);
+
+        // Values in [2^m, 2^(m+1)) are spread over SubBuckets buckets
+        const int magnitude = highestBit(value);
+        const int shift     = magnitude - static_cast<int>(SubBucketBits);
+        return static_cast<size_t>(shift + 1) * SubBuckets
+            + static_cast<size_t>((value >> shift) - SubBuckets);
+    }
+
+    uint64_t Histogram::lowerBound(size_t bucket)
+    {
+        if (bucket < SubBuckets)
+            return bucket;
+
+        const size_t shift = bucket / SubBuckets - 1;
+        return static_cast<uint64_t>(SubBuckets + bucket % SubBuckets) << shift;
+    }
+
+    uint64_t Histogram::upperBound(size_t bucket)
+    {
+        if (bucket + 1 >= BucketCount)
+            return UINT64_MAX;
+        return lowerBound(bucket + 1) - 1;
+    }
+
+    void Histogram::record(uint64_t value, uint64_t count)
+    {
+        counts_[bucketOf(value)] += count;
+        count_ += count;
+        sum_ += value * count;
+        max_ = std::max(max_, value);
+    }
+
+    Histogram& Histogram::operator+=(const Histogram& other)
+    {
+        for (size_t i = 0; i < BucketCount; ++i)
+            counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+        return *this;
+    }
+
+    uint64_t Histogram::quantile(double q) const
+    {
+        if (count_ == 0)
+            return 0;
+
+        q = std::clamp(q, 0.0, 1.0);
+        const auto rank = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_))));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+                return std::min(upperBound(i), max_);
+        }
+        return max_;
+    }
+
+    uint64_t Histogram::countAtMost(uint64_t value) const
+    {
+        const size_t last = bucketOf(value);
+
+        uint64_t count = 0;
+        for (size_t i = 0; i <= last; ++i)
+            count += counts_[i];
+
+        // A bucket only part of which is below value is left out
+        if (upperBound(last) > value)
+            count -= counts_[last];
+        return count;
+    }
+
+    Worker& Worker::operator+=(const Worker& other)
+    {
+        requests += other.requests;
+        for (size_t i = 0; i < responses.size(); ++i)
+            responses[i] += other.responses[i];
+        bytesRead += other.bytesRead;
+        bytesWritten += other.bytesWritten;
+        connections += other.connections;
+        activeConnections += other.activeConnections;
+        writeQueueDepth += other.writeQueueDepth;
+        requestTimeouts += other.requestTimeouts;
+        idleTimeouts += other.idleTimeouts;
+        latency += other.latency;
+        return *this;
+    }
+
+    Worker Snapshot::total() const
+    {
+        Worker total;
+        for (const auto& worker : workers)
+            total += worker;
+        return total;
+    }
+
+    void Recorder::responseSent(int code)
+    {
+        add(responses_[codeClass(code)], 1);
+    }
+
+    void Recorder::responseSent(int code, std::chrono::steady_clock::duration latency)
+    {
+        responseSent(code);
+
+        const auto micros = static_cast<uint64_t>(std::max<int64_t>(
+            0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+        add(latency_[Histogram::bucketOf(micros)], 1);
+        add(latencySum_, micros);
+
+        uint64_t max = latencyMax_.load(std::memory_order_relaxed);
+        while (micros > max && !latencyMax_.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    Worker Recorder::snapshot() const
+    {
+        auto load = [](const Counter& counter) {
+            return counter.load(std::memory_order_relaxed);
+        };
+
+        Worker worker;
+        worker.requests = load(requests_);
+        for (size_t i = 0; i < responses_.size(); ++i)
+            worker.responses[i] = load(responses_[i]);
+        worker.bytesRead       = load(bytesRead_);
+        worker.bytesWritten    = load(bytesWritten_);
+        worker.connections     = load(connections_);
+        worker.requestTimeouts = load(requestTimeouts_);
+        worker.idleTimeouts    = load(idleTimeouts_);
+
+        // The buckets are read one at a time while others may be recording,
+        // so the count is taken from them, to match
+        auto& latency = worker.latency;
+        for (size_t i = 0; i < Histogram::BucketCount; ++i)
+        {
+            latency.counts_[i] = load(latency_[i]);
+            latency.count_ += latency.counts_[i];
+        }
+        latency.sum_ = load(latencySum_);
+        latency.max_ = load(latencyMax_);
+
+        return worker;
+    }
+
+    const char* const PrometheusContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+    std::string toPrometheus(const Snapshot& snapshot, const std::string& prefix)
+    {
+        Exposition out(prefix);
+
+        out.workers(snapshot, "requests_total", "counter", "Requests received in full.",
+                    [](const Worker& w) { return w.requests; });
+
+        out.header("responses_total", "counter", "Responses sent, by status class.");
+        for (size_t i = 0; i < snapshot.workers.size(); ++i)
+        {
+            for (size_t c = 0; c < 5; ++c)
+            {
+                out.sample("responses_total",
+                           "worker=\"" + std::to_string(i) + "\",code=\"" + std::to_string(c + 1) + "xx\"",
+                           snapshot.workers[i].responses[c]);
+            }
+        }
+
+        out.workers(snapshot, "received_bytes_total", "counter", "Bytes read from connections.",
+                    [](const Worker& w) { return w.bytesRead; });
+        out.workers(snapshot, "sent_bytes_total", "counter", "Bytes written to connections.",
+                    [](const Worker& w) { return w.bytesWritten; });
+        out.workers(snapshot, "connections_total", "counter", "Connections accepted.",
+                    [](const Worker& w) { return w.connections; });
+        out.workers(snapshot, "open_connections", "gauge", "Connections currently open.",
+                    [](const Worker& w) { return w.activeConnections; });
+        out.workers(snapshot, "write_queue_depth", "gauge", "Buffers waiting to be written.",
+                    [](const Worker& w) { return w.writeQueueDepth; });
+        out.workers(snapshot, "request_timeouts_total", "counter", "Requests timed out.",
+                    [](const Worker& w) { return w.requestTimeouts; });
+        out.workers(snapshot, "idle_timeouts_total", "counter", "Idle connections closed.",
+                    [](const Worker& w) { return w.idleTimeouts; });
+
+        const auto latency = snapshot.total().latency;
+        out.header("request_duration_seconds", "histogram",
+                   "Time from a request being received to its response being queued.");
+        for (auto nominal : PrometheusBuckets)
+        {
+            const auto bound = Histogram::upperBound(Histogram::bucketOf(nominal));
+            out.sample("request_duration_seconds_bucket", "le=\"" + seconds(bound) + '"',
+                       latency.countAtMost(bound));
+        }
+        out.sample("request_duration_seconds_bucket", "le=\"+Inf\"", latency.count());
+        out.sample("request_duration_seconds_sum", "", std::to_string(static_cast<double>(latency.sum()) / 1e6));
+        out.sample("request_duration_seconds_count", "", latency.count());
+
+        return out.str();
+    }
+
+} // namespace Pistache::Metrics
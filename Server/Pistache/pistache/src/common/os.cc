@@ -27,12 +27,33 @@
 #include <sys/epoll.h>
 #endif
 
+#if defined(PISTACHE_USE_IO_URING) && defined(__linux__) && !defined(_USE_LIBEVENT)
+#define PS_HAS_IO_URING 1
+#include <linux/io_uring.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+// Receiving into provided buffers needs the headers of Linux 6.0 or later,
+// multishot accepts those of 5.19
+#ifdef IORING_RECV_MULTISHOT
+#define PS_HAS_IO_URING_RECV 1
+#endif
+#ifdef IORING_ACCEPT_MULTISHOT
+#define PS_HAS_IO_URING_ACCEPT 1
+#endif
+#endif
+
 #include PST_MISC_IO_HDR // unistd.h e.g. close
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iterator>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Pistache
 {
@@ -172,16 +193,952 @@ namespace Pistache
             , tag(_tag)
         { }
 
-        Epoll::Epoll()
-            : epoll_fd([&]()
+        class Epoll::IoUring
+        {
+#ifdef PS_HAS_IO_URING
+        public:
+            // Throws if the kernel does not provide what is needed
+            explicit IoUring(unsigned entries);
+            ~IoUring();
+
+            IoUring(const IoUring&)            = delete;
+            IoUring& operator=(const IoUring&) = delete;
+
+            void add(int fd, Flags<NotifyOn> interest, Tag tag, Mode mode,
+                     bool oneShot);
+            bool addReceiving(int fd, Flags<NotifyOn> interest, Tag tag);
+            bool addAccepting(int fd, Flags<NotifyOn> interest, Tag tag);
+            void rearm(int fd, Flags<NotifyOn> interest, Tag tag, Mode mode);
+            void remove(int fd);
+
+            bool send(int fd, const std::vector<SendBuffer>& buffers, int flags,
+                      std::shared_ptr<const void> hold);
+
+            int poll(std::vector<Event>& events, std::chrono::milliseconds timeout);
+
+        private:
+            // Buffers lent to the kernel to receive into, 2 MiB of them per
+            // ring. Those reported in the events of a poll() are given back
+            // to the kernel with the next one, by when they have been handled.
+            static constexpr unsigned RecvBuffers     = 256;
+            static constexpr size_t RecvBufferSize    = 8192;
+            static constexpr uint16_t RecvBufferGroup = 0;
+
+            // Set in the user_data of sends in place of a generation, which
+            // stays below it
+            static constexpr uint32_t SendMarker = 1U << 31;
+
+            // What is known of an fd. Each time a poll or receive request is
+            // armed for it, the registration gets a new generation, which is
+            // part of the request's user_data: completions of requests armed
+            // before the fd was rearmed or removed are then told apart and
+            // dropped.
+            struct Registration
+            {
+                uint32_t generation = 0; // 0: not registered
+                uint32_t pollEvents = 0;
+                TagValue tag        = 0;
+                bool multiShot      = false;
+                bool oneShot        = false;
+                bool armed          = false;
+                // The request armed is a multishot recv, or accept, rather
+                // than a poll
+                bool receiving = false;
+                bool accepting = false;
+                // A recv cancelled by a rearm, what it received in the
+                // meantime still being reported
+                uint32_t recvGeneration = 0;
+
+                // Where it was reported in the events of the current poll(),
+                // so that several completions make a single event
+                uint64_t reportedIn  = 0;
+                size_t reportedIndex = 0;
+            };
+
+            static uint64_t userData(int fd, uint32_t generation)
+            {
+                return (static_cast<uint64_t>(fd) << 32) | generation;
+            }
+
+            // A sendmsg on its way, whose header and buffers are kept until
+            // it completes
+            struct Send
+            {
+                bool pending = false;
+                TagValue tag = 0;
+                msghdr msg {};
+                std::vector<iovec> iov;
+                std::shared_ptr<const void> hold;
+            };
+
+            Registration& registration(int fd);
+            uint32_t nextGeneration();
+
+            void setupRecvBuffers();
+            void provideRecvBuffer(uint16_t bid);
+            void recycleRecvBuffers();
+
+            io_uring_sqe* getSqe();
+            void publish();
+            void armPoll(int fd, Registration& reg);
+            void armRecv(int fd, Registration& reg);
+            void armAccept(int fd, Registration& reg);
+            void cancelArmed(int fd, const Registration& reg);
+            void submitIfWaiting();
+            int enter(unsigned toSubmit, unsigned minComplete, unsigned flags,
+                      const void* arg, size_t argSize);
+            void complete(const io_uring_cqe& cqe, std::vector<Event>& events,
+                          size_t first);
+            void completeRecv(int fd, Registration& reg, bool current,
+                              const io_uring_cqe& cqe, std::vector<Event>& events);
+            void completeSend(int fd, const io_uring_cqe& cqe,
+                              std::vector<Event>& events);
+            void completeAccept(int fd, Registration& reg, const io_uring_cqe& cqe,
+                                std::vector<Event>& events);
+
+            int ringFd_ = -1;
+
+            void* sqRing_          = nullptr;
+            size_t sqRingSize_     = 0;
+            void* cqRing_          = nullptr;
+            size_t cqRingSize_     = 0;
+            io_uring_sqe* sqes_    = nullptr;
+            size_t sqesSize_       = 0;
+            unsigned* sqHead_      = nullptr;
+            unsigned* sqTail_      = nullptr;
+            unsigned sqMask_       = 0;
+            unsigned sqEntries_    = 0;
+            unsigned* cqHead_      = nullptr;
+            unsigned* cqTail_      = nullptr;
+            unsigned cqMask_       = 0;
+            io_uring_cqe* cqes_    = nullptr;
+
+            // Local tail of the submission queue, published to the kernel
+            // with publish()
+            unsigned sqeTail_ = 0;
+
+            // The ring fd registered by the polling thread, which then enters
+            // the ring without the fd being looked up every time
+            int registeredIndex_ = -1;
+            std::thread::id registeredBy_;
+
+            // Guards the submission queue and the registrations, which are
+            // changed from any thread; completions are only reaped by the
+            // polling thread
+            std::mutex mutex_;
+            // Whether the polling thread is (about to be) waiting in the
+            // kernel, in which case requests are submitted right away instead
+            // of with the next wait
+            bool waiting_ = false;
+
+            std::vector<Registration> registrations_;
+            uint32_t generation_ = 0;
+            uint64_t pollCount_  = 0;
+
+            // Null when there are no buffers to receive into
+            void* recvRing_    = nullptr;
+            char* recvBuffers_ = nullptr;
+            uint16_t recvTail_ = 0;
+            bool canReceive_   = false;
+            std::vector<uint16_t> lentBuffers_;
+
+            // Nodes, for the headers not to move while sends are pending
+            std::unordered_map<int, Send> sends_;
+
+#ifdef PS_HAS_IO_URING_ACCEPT
+            bool canAccept_ = true;
+#else
+            bool canAccept_ = false;
+#endif
+            // The user_data of accepts cancelled, which may still complete
+            // with connections nobody will take: those are closed
+            std::unordered_set<uint64_t> cancelledAccepts_;
+#endif
+        };
+
+#ifdef PS_HAS_IO_URING
+        namespace
+        {
+            int ioUringSetup(unsigned entries, io_uring_params* params)
+            {
+                return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+            }
+
+            template <typename T>
+            T loadAcquire(const T* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+
+            template <typename T>
+            void storeRelease(T* ptr, T value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+        }
+
+        Epoll::IoUring::IoUring(unsigned entries)
+        {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            // Completions are only reaped when polling, so there is no point
+            // in the kernel interrupting the polling thread to post them
+            params.flags = IORING_SETUP_CLAMP | IORING_SETUP_COOP_TASKRUN;
+
+            ringFd_ = ioUringSetup(entries, &params);
+            if (ringFd_ < 0 && errno == EINVAL)
+            {
+                std::memset(&params, 0, sizeof(params));
+                params.flags = IORING_SETUP_CLAMP;
+                ringFd_      = ioUringSetup(entries, &params);
+            }
+            if (ringFd_ < 0)
+                throw std::runtime_error(std::string("io_uring_setup: ") + strerror(errno));
+
+            // Timed waits need EXT_ARG (5.11), multishot polls 5.13, which is
+            // also when RSRC_TAGS came in
+            const unsigned required = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_RSRC_TAGS;
+            if ((params.features & required) != required)
+            {
+                ::close(ringFd_);
+                throw std::runtime_error("io_uring: kernel too old");
+            }
+
+            sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+                sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+
+            sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+            if (sqRing_ == MAP_FAILED)
+            {
+                sqRing_ = nullptr;
+                ::close(ringFd_);
+                throw std::runtime_error(std::string("io_uring mmap: ") + strerror(errno));
+            }
+
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                cqRing_ = sqRing_;
+            }
+            else
+            {
+                cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+                if (cqRing_ == MAP_FAILED)
+                {
+                    cqRing_ = nullptr;
+                    ::munmap(sqRing_, sqRingSize_);
+                    ::close(ringFd_);
+                    throw std::runtime_error(std::string("io_uring mmap: ") + strerror(errno));
+                }
+            }
+
+            sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+            {
+                if (cqRing_ != sqRing_)
+                    ::munmap(cqRing_, cqRingSize_);
+                ::munmap(sqRing_, sqRingSize_);
+                ::close(ringFd_);
+                throw std::runtime_error(std::string("io_uring mmap: ") + strerror(errno));
+            }
+            sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+            auto* sq   = static_cast<char*>(sqRing_);
+            sqHead_    = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            sqTail_    = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sqMask_    = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sqEntries_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+            sqeTail_   = *sqTail_;
+
+            // Submission queue entries are used in order
+            auto* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            for (unsigned i = 0; i < sqEntries_; ++i)
+                array[i] = i;
+
+            auto* cq = static_cast<char*>(cqRing_);
+            cqHead_  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cqTail_  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cqMask_  = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes_    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            setupRecvBuffers();
+        }
+
+        Epoll::IoUring::~IoUring()
+        {
+            // Closing the ring cancels the requests still armed
+            ::munmap(sqes_, sqesSize_);
+            if (cqRing_ != sqRing_)
+                ::munmap(cqRing_, cqRingSize_);
+            ::munmap(sqRing_, sqRingSize_);
+            ::close(ringFd_);
+
+#ifdef PS_HAS_IO_URING_RECV
+            if (recvRing_)
+            {
+                ::munmap(recvBuffers_, RecvBuffers * RecvBufferSize);
+                ::munmap(recvRing_, RecvBuffers * sizeof(io_uring_buf));
+            }
+#endif
+        }
+
+#ifdef PS_HAS_IO_URING_RECV
+        // The ring is an array of io_uring_buf whose first entry has the
+        // tail in place of resv. io_uring_buf_ring is not used for it: in
+        // C++, the empty struct of its flexible array shifts bufs by 8 bytes.
+        static uint16_t* recvRingTail(void* ring)
+        {
+            return &static_cast<io_uring_buf*>(ring)[0].resv;
+        }
+#endif
+
+        void Epoll::IoUring::setupRecvBuffers()
+        {
+#ifdef PS_HAS_IO_URING_RECV
+            const size_t ringSize    = RecvBuffers * sizeof(io_uring_buf);
+            const size_t buffersSize = RecvBuffers * RecvBufferSize;
+
+            void* ring = ::mmap(nullptr, ringSize, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ring == MAP_FAILED)
+                return;
+            void* buffers = ::mmap(nullptr, buffersSize, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buffers == MAP_FAILED)
+            {
+                ::munmap(ring, ringSize);
+                return;
+            }
+
+            io_uring_buf_reg reg;
+            std::memset(&reg, 0, sizeof(reg));
+            reg.ring_addr    = reinterpret_cast<uint64_t>(ring);
+            reg.ring_entries = RecvBuffers;
+            reg.bgid         = RecvBufferGroup;
+            if (::syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+            {
+                // Before 5.19: fds are then only polled
+                PS_LOG_DEBUG_ARGS("io_uring: no provided buffer ring (%s)", strerror(errno));
+                ::munmap(buffers, buffersSize);
+                ::munmap(ring, ringSize);
+                return;
+            }
+
+            recvRing_    = ring;
+            recvBuffers_ = static_cast<char*>(buffers);
+            canReceive_  = true;
+            for (unsigned bid = 0; bid < RecvBuffers; ++bid)
+                provideRecvBuffer(static_cast<uint16_t>(bid));
+            storeRelease(recvRingTail(recvRing_), recvTail_);
+#endif
+        }
+
+        void Epoll::IoUring::provideRecvBuffer([[maybe_unused]] uint16_t bid)
+        {
+#ifdef PS_HAS_IO_URING_RECV
+            auto& buf = static_cast<io_uring_buf*>(recvRing_)[recvTail_ & (RecvBuffers - 1)];
+            buf.addr  = reinterpret_cast<uint64_t>(recvBuffers_ + bid * RecvBufferSize);
+            buf.len   = RecvBufferSize;
+            buf.bid   = bid;
+            ++recvTail_;
+#endif
+        }
+
+        void Epoll::IoUring::recycleRecvBuffers()
+        {
+#ifdef PS_HAS_IO_URING_RECV
+            if (lentBuffers_.empty())
+                return;
+
+            for (auto bid : lentBuffers_)
+                provideRecvBuffer(bid);
+            storeRelease(recvRingTail(recvRing_), recvTail_);
+            lentBuffers_.clear();
+#endif
+        }
+
+        Epoll::IoUring::Registration& Epoll::IoUring::registration(int fd)
+        {
+            if (fd < 0)
+                throw std::runtime_error("io_uring: invalid fd");
+
+            const auto index = static_cast<size_t>(fd);
+            if (index >= registrations_.size())
+                registrations_.resize(std::max(index + 1, registrations_.size() * 2));
+            return registrations_[index];
+        }
+
+        uint32_t Epoll::IoUring::nextGeneration()
+        {
+            if (++generation_ >= SendMarker)
+                generation_ = 1;
+            return generation_;
+        }
+
+        io_uring_sqe* Epoll::IoUring::getSqe()
+        {
+            if (sqeTail_ - loadAcquire(sqHead_) >= sqEntries_)
+            {
+                // Full: hand what is queued over to the kernel
+                publish();
+                if (enter(sqEntries_, 0, 0, nullptr, 0) < 0)
+                    throw std::runtime_error(std::string("io_uring_enter: ") + strerror(errno));
+            }
+
+            auto* sqe = &sqes_[sqeTail_ & sqMask_];
+            ++sqeTail_;
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        void Epoll::IoUring::publish() { storeRelease(sqTail_, sqeTail_); }
+
+        void Epoll::IoUring::armPoll(int fd, Registration& reg)
+        {
+            auto* sqe   = getSqe();
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd     = fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+            sqe->poll32_events = (reg.pollEvents << 16) | (reg.pollEvents >> 16);
+#else
+            sqe->poll32_events = reg.pollEvents;
+#endif
+            sqe->len       = reg.multiShot ? IORING_POLL_ADD_MULTI : 0;
+            sqe->user_data = userData(fd, reg.generation);
+            reg.armed      = true;
+        }
+
+        void Epoll::IoUring::armRecv([[maybe_unused]] int fd, Registration& reg)
+        {
+#ifdef PS_HAS_IO_URING_RECV
+            auto* sqe      = getSqe();
+            sqe->opcode    = IORING_OP_RECV;
+            sqe->fd        = fd;
+            sqe->ioprio    = IORING_RECV_MULTISHOT;
+            sqe->flags     = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = RecvBufferGroup;
+            sqe->user_data = userData(fd, reg.generation);
+            reg.armed      = true;
+#else
+            reg.armed = false;
+#endif
+        }
+
+        void Epoll::IoUring::armAccept([[maybe_unused]] int fd, Registration& reg)
+        {
+#ifdef PS_HAS_IO_URING_ACCEPT
+            auto* sqe         = getSqe();
+            sqe->opcode       = IORING_OP_ACCEPT;
+            sqe->fd           = fd;
+            sqe->ioprio       = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+            sqe->user_data    = userData(fd, reg.generation);
+            reg.armed         = true;
+#else
+            reg.armed = false;
+#endif
+        }
+
+        void Epoll::IoUring::cancelArmed(int fd, const Registration& reg)
+        {
+            if (reg.accepting)
+                cancelledAccepts_.insert(userData(fd, reg.generation));
+
+            auto* sqe   = getSqe();
+            sqe->opcode = (reg.receiving || reg.accepting) ? IORING_OP_ASYNC_CANCEL
+                                                           : IORING_OP_POLL_REMOVE;
+            sqe->fd     = -1;
+            sqe->addr   = userData(fd, reg.generation);
+            // The outcome of the removal itself is of no interest
+            sqe->user_data = 0;
+        }
+
+        void Epoll::IoUring::submitIfWaiting()
+        {
+            publish();
+            if (waiting_)
+                enter(sqEntries_, 0, 0, nullptr, 0);
+        }
+
+        int Epoll::IoUring::enter(unsigned toSubmit, unsigned minComplete,
+                                  unsigned flags, const void* arg, size_t argSize)
+        {
+            int fd = ringFd_;
+            if (registeredIndex_ >= 0 && registeredBy_ == std::this_thread::get_id())
+            {
+                fd = registeredIndex_;
+                flags |= IORING_ENTER_REGISTERED_RING;
+            }
+
+            int res;
+            do
+            {
+                res = static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                                 minComplete, flags, arg, argSize));
+            } while (res < 0 && errno == EINTR && minComplete == 0);
+
+            return res;
+        }
+
+        void Epoll::IoUring::add(int fd, Flags<NotifyOn> interest, Tag tag,
+                                 Mode mode, bool oneShot)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            auto& reg = registration(fd);
+            // Only left over from an fd closed without having been removed,
+            // whose number has been reused since
+            if (reg.armed)
+                cancelArmed(fd, reg);
+
+            reg            = Registration();
+            reg.generation = nextGeneration();
+            reg.pollEvents = static_cast<uint32_t>(toEpollEvents(interest));
+            reg.tag        = tag.value();
+            reg.oneShot    = oneShot;
+            // Level-triggered polls are armed again after each event instead
+            reg.multiShot = (mode == Mode::Edge) && !oneShot;
+
+            armPoll(fd, reg);
+            submitIfWaiting();
+        }
+
+        bool Epoll::IoUring::addReceiving(int fd, Flags<NotifyOn> interest, Tag tag)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            if (!canReceive_)
+                return false;
+
+            auto& reg = registration(fd);
+            if (reg.armed)
+                cancelArmed(fd, reg);
+
+            reg            = Registration();
+            reg.generation = nextGeneration();
+            reg.pollEvents = static_cast<uint32_t>(toEpollEvents(interest));
+            reg.tag        = tag.value();
+            // Polled for, should it be rearmed, as with an edge-triggered
+            // epoll
+            reg.multiShot = true;
+            reg.receiving = true;
+
+            armRecv(fd, reg);
+            submitIfWaiting();
+            return true;
+        }
+
+        bool Epoll::IoUring::addAccepting(int fd, Flags<NotifyOn> interest, Tag tag)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            if (!canAccept_)
+                return false;
+
+            auto& reg = registration(fd);
+            if (reg.armed)
+                cancelArmed(fd, reg);
+
+            reg            = Registration();
+            reg.generation = nextGeneration();
+            reg.pollEvents = static_cast<uint32_t>(toEpollEvents(interest));
+            reg.tag        = tag.value();
+            reg.accepting  = true;
+
+            armAccept(fd, reg);
+            submitIfWaiting();
+            return true;
+        }
+
+        void Epoll::IoUring::rearm(int fd, Flags<NotifyOn> interest, Tag tag,
+                                   Mode mode)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            auto& reg = registration(fd);
+            if (reg.generation == 0)
+                throw std::runtime_error("io_uring: rearming an fd not registered");
+
+            if (reg.armed)
+                cancelArmed(fd, reg);
+            if (reg.receiving)
+            {
+                // From now on polled; what was received before the recv is
+                // cancelled is not lost, coming ahead of what is polled for
+                reg.recvGeneration = reg.generation;
+                reg.receiving      = false;
+            }
+
+            reg.accepting = false;
+
+            // Like EPOLL_CTL_MOD, rearming makes the registration persistent
+            reg.generation = nextGeneration();
+            reg.pollEvents = static_cast<uint32_t>(toEpollEvents(interest));
+            reg.tag        = tag.value();
+            reg.oneShot    = false;
+            reg.multiShot  = (mode == Mode::Edge);
+
+            armPoll(fd, reg);
+            submitIfWaiting();
+        }
+
+        void Epoll::IoUring::remove(int fd)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            auto& reg = registration(fd);
+            if (reg.armed)
+                cancelArmed(fd, reg);
+            reg = Registration();
+
+            // A send still waiting for room would keep the socket open
+            auto it = sends_.find(fd);
+            if (it != std::end(sends_) && it->second.pending)
+            {
+                auto* sqe      = getSqe();
+                sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+                sqe->fd        = -1;
+                sqe->addr      = userData(fd, SendMarker);
+                sqe->user_data = 0;
+            }
+
+            submitIfWaiting();
+        }
+
+        bool Epoll::IoUring::send(int fd, const std::vector<SendBuffer>& buffers,
+                                  int flags, std::shared_ptr<const void> hold)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+
+            // The completion is reported with the fd's tag
+            if (fd < 0 || static_cast<size_t>(fd) >= registrations_.size()
+                || registrations_[static_cast<size_t>(fd)].generation == 0)
+                return false;
+
+            auto& send = sends_[fd];
+            if (send.pending)
+                return false;
+
+            send.iov.resize(buffers.size());
+            for (size_t i = 0; i < buffers.size(); ++i)
+            {
+                send.iov[i].iov_base = const_cast<char*>(buffers[i].data);
+                send.iov[i].iov_len  = buffers[i].size;
+            }
+            send.msg            = msghdr {};
+            send.msg.msg_iov    = send.iov.data();
+            send.msg.msg_iovlen = send.iov.size();
+            send.tag            = registrations_[static_cast<size_t>(fd)].tag;
+            send.hold           = std::move(hold);
+            send.pending        = true;
+
+            auto* sqe      = getSqe();
+            sqe->opcode    = IORING_OP_SENDMSG;
+            sqe->fd        = fd;
+            sqe->addr      = reinterpret_cast<uint64_t>(&send.msg);
+            sqe->len       = 1;
+            sqe->msg_flags = static_cast<uint32_t>(flags);
+            sqe->user_data = userData(fd, SendMarker);
+
+            submitIfWaiting();
+            return true;
+        }
+
+        void Epoll::IoUring::complete(const io_uring_cqe& cqe,
+                                      std::vector<Event>& events, size_t first)
+        {
+            if (cqe.user_data == 0)
+                return;
+
+            // Given back with the next poll() whatever becomes of what it holds
+            if (cqe.flags & IORING_CQE_F_BUFFER)
+                lentBuffers_.push_back(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+
+            const auto fd         = static_cast<size_t>(cqe.user_data >> 32);
+            const auto generation = static_cast<uint32_t>(cqe.user_data);
+            if (generation == SendMarker)
+            {
+                completeSend(static_cast<int>(fd), cqe, events);
+                return;
+            }
+
+            if (!cancelledAccepts_.empty())
+            {
+                auto it = cancelledAccepts_.find(cqe.user_data);
+                if (it != std::end(cancelledAccepts_))
+                {
+                    if (cqe.res >= 0)
+                        ::close(cqe.res);
+                    if (!(cqe.flags & IORING_CQE_F_MORE))
+                        cancelledAccepts_.erase(it);
+                    return;
+                }
+            }
+
+            if (fd >= registrations_.size())
+                return;
+
+            auto& reg = registrations_[fd];
+            if (reg.generation == generation && reg.accepting)
+            {
+                completeAccept(static_cast<int>(fd), reg, cqe, events);
+                return;
+            }
+            if (reg.generation == generation && reg.receiving)
+            {
+                completeRecv(static_cast<int>(fd), reg, true /* current */, cqe, events);
+                return;
+            }
+            if (reg.recvGeneration != 0 && reg.recvGeneration == generation)
+            {
+                completeRecv(static_cast<int>(fd), reg, false /* current */, cqe, events);
+                return;
+            }
+            if (reg.generation != generation)
+                return; // Rearmed or removed since
+
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                reg.armed = false;
+
+            if (cqe.res < 0)
+            {
+                // A multishot poll may be ended by the kernel, and is then
+                // simply armed again
+                if (cqe.res != -ECANCELED)
+                {
+                    PS_LOG_WARNING_ARGS("io_uring poll on fd %d failed: %s",
+                                        static_cast<int>(fd), strerror(-cqe.res));
+                    reg = Registration();
+                    return;
+                }
+            }
+            else
+            {
+                const auto flags = toNotifyOn(cqe.res);
+                if (reg.reportedIn == pollCount_ && reg.reportedIndex >= first)
+                {
+                    events[reg.reportedIndex].flags |= flags;
+                }
+                else
+                {
+                    Event event(Tag(reg.tag));
+                    event.flags       = flags;
+                    reg.reportedIn    = pollCount_;
+                    reg.reportedIndex = events.size();
+                    events.push_back(event);
+                }
+            }
+
+            // Armed again with the next wait, by when the handler has dealt
+            // with the event: still being ready then makes another event, as
+            // with a level-triggered epoll
+            if (!reg.armed && !reg.oneShot)
+                armPoll(static_cast<int>(fd), reg);
+        }
+
+        void Epoll::IoUring::completeRecv(int fd, Registration& reg, bool current,
+                                          const io_uring_cqe& cqe,
+                                          std::vector<Event>& events)
+        {
+            if (current && !(cqe.flags & IORING_CQE_F_MORE))
+                reg.armed = false;
+
+            if (cqe.res == -EINVAL && current)
+            {
+                // A kernel without multishot recv (before 6.0): the fd, and
+                // those to come, are polled instead
+                PS_LOG_WARNING("io_uring cannot receive, polling instead");
+                canReceive_ = false;
+
+                reg.receiving = false;
+                if (!reg.armed)
+                    armPoll(fd, reg);
+                return;
+            }
+
+            // Out of buffers, until they are recycled, or cancelled
+            if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED)
+            {
+                if (current && !reg.armed)
+                    armRecv(fd, reg);
+                return;
+            }
+
+            if (cqe.res > 0 && !(cqe.flags & IORING_CQE_F_BUFFER))
+                return;
+
+            Event event(Tag(reg.tag));
+            event.completion = Event::Completion::Received;
+            event.result     = cqe.res;
+            if (cqe.res > 0)
+            {
+                const auto bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                event.received = recvBuffers_ + bid * RecvBufferSize;
+            }
+            events.push_back(event);
+
+            // Nothing more comes after the end of the stream, or an error
+            if (current && !reg.armed && cqe.res > 0)
+                armRecv(fd, reg);
+        }
+
+        void Epoll::IoUring::completeSend(int fd, const io_uring_cqe& cqe,
+                                          std::vector<Event>& events)
+        {
+            auto it = sends_.find(fd);
+            if (it == std::end(sends_) || !it->second.pending)
+                return;
+
+            auto& send = it->second;
+            Event event(Tag(send.tag));
+            event.completion = Event::Completion::Sent;
+            event.result     = cqe.res;
+            events.push_back(event);
+
+            send.pending = false;
+            send.hold.reset();
+        }
+
+        void Epoll::IoUring::completeAccept(int fd, Registration& reg,
+                                            const io_uring_cqe& cqe,
+                                            std::vector<Event>& events)
+        {
+            if (!(cqe.flags & IORING_CQE_F_MORE))
+                reg.armed = false;
+
+            if (cqe.res == -EINVAL)
+            {
+                // A kernel without multishot accept (before 5.19): the fd,
+                // and those to come, are polled instead, level-triggered as
+                // a listening socket is
+                PS_LOG_WARNING("io_uring cannot accept, polling instead");
+                canAccept_ = false;
+
+                reg.accepting = false;
+                if (!reg.armed)
+                    armPoll(fd, reg);
+                return;
+            }
+
+            if (cqe.res >= 0)
+            {
+                Event event(Tag(reg.tag));
+                event.completion = Event::Completion::Accepted;
+                event.result     = cqe.res;
+                events.push_back(event);
+            }
+            else if (cqe.res != -ECANCELED)
+            {
+                // Such as EMFILE: the listening socket is still good
+                PS_LOG_WARNING_ARGS("io_uring accept on fd %d failed: %s", fd,
+                                    strerror(-cqe.res));
+            }
+
+            // Ended by the kernel, or by an error
+            if (!reg.armed)
+                armAccept(fd, reg);
+        }
+
+        int Epoll::IoUring::poll(std::vector<Event>& events,
+                                 std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            if (registeredIndex_ < 0 && registeredBy_ == std::thread::id())
+            {
+                // Only usable by this thread from now on
+                io_uring_rsrc_update update;
+                std::memset(&update, 0, sizeof(update));
+                update.offset = static_cast<uint32_t>(-1);
+                update.data   = static_cast<uint64_t>(ringFd_);
+                registeredBy_ = std::this_thread::get_id();
+                if (::syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_RING_FDS,
+                              &update, 1)
+                    == 1)
+                    registeredIndex_ = static_cast<int>(update.offset);
+            }
+
+            // The events they were reported in have all been handled
+            recycleRecvBuffers();
+
+            publish();
+            const unsigned toSubmit = sqeTail_ - loadAcquire(sqHead_);
+            const bool ready        = loadAcquire(cqTail_) != *cqHead_;
+
+            unsigned minComplete = (ready || timeout.count() == 0) ? 0 : 1;
+            waiting_             = minComplete > 0;
+            lock.unlock();
+
+            int res;
+            if (timeout.count() >= 0)
+            {
+                __kernel_timespec ts;
+                ts.tv_sec  = timeout.count() / 1000;
+                ts.tv_nsec = (timeout.count() % 1000) * 1000000;
+
+                io_uring_getevents_arg arg;
+                std::memset(&arg, 0, sizeof(arg));
+                arg.sigmask_sz = _NSIG / 8;
+                arg.ts         = reinterpret_cast<uint64_t>(&ts);
+
+                res = enter(toSubmit, minComplete, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                            &arg, sizeof(arg));
+            }
+            else
+            {
+                res = enter(toSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, _NSIG / 8);
+            }
+            const int error = errno;
+
+            lock.lock();
+            waiting_ = false;
+
+            if (res < 0 && error != ETIME && error != EINTR && error != EBUSY && error != EAGAIN)
+            {
+                errno = error;
+                return -1;
+            }
+
+            ++pollCount_;
+            const size_t first = events.size();
+
+            unsigned head       = *cqHead_;
+            const unsigned tail = loadAcquire(cqTail_);
+            for (; head != tail; ++head)
+                complete(cqes_[head & cqMask_], events, first);
+            storeRelease(cqHead_, head);
+
+            return static_cast<int>(events.size() - first);
+        }
+#endif // PS_HAS_IO_URING
+
+        Epoll::Epoll(Backend backend)
 #ifdef _USE_LIBEVENT
-                       { return TRY_NULL_RET(EventMethFns::create(
-                             Const::MaxEvents)); }
+            : epoll_fd(TRY_NULL_RET(EventMethFns::create(Const::MaxEvents)))
 #else
-                       { return TRY_RET(epoll_create(Const::MaxEvents)); }
+            : epoll_fd(-1)
 #endif
-                       ())
-        { }
+        {
+            if (backend == Backend::IoUring)
+            {
+#ifdef PS_HAS_IO_URING
+                try
+                {
+                    uring_ = std::make_unique<IoUring>(static_cast<unsigned>(Const::MaxEvents * 4));
+                    return;
+                }
+                catch (const std::exception& e)
+                {
+                    PS_LOG_WARNING_ARGS("io_uring unavailable (%s), using epoll", e.what());
+                }
+#else
+                PS_LOG_WARNING("Built without io_uring support, using epoll");
+#endif
+            }
+
+#ifndef _USE_LIBEVENT
+            epoll_fd = TRY_RET(epoll_create(Const::MaxEvents));
+#endif
+        }
 
         Epoll::~Epoll()
         {
@@ -194,6 +1151,11 @@ namespace Pistache
 #endif
         }
 
+        Backend Epoll::backend() const
+        {
+            return uring_ ? Backend::IoUring : Backend::Epoll;
+        }
+
         void Epoll::addFd(Fd fd, Flags<NotifyOn> interest, Tag tag,
                           [[maybe_unused]] Mode mode)
         {
@@ -211,6 +1173,14 @@ namespace Pistache
                               fd, events, nullptr /* time */));
 
 #else
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+            {
+                uring_->add(fd, interest, tag, mode, false /* oneShot */);
+                return;
+            }
+#endif
+
             struct epoll_event ev;
             ev.events = toEpollEvents(interest);
             if (mode == Mode::Edge)
@@ -244,6 +1214,14 @@ namespace Pistache
             TRY(epoll_fd->ctl(EvCtlAction::Add,
                               fd, events, nullptr /* time */));
 #else
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+            {
+                uring_->add(fd, interest, tag, mode, true /* oneShot */);
+                return;
+            }
+#endif
+
             struct epoll_event ev;
             ev.events = toEpollEvents(interest);
             ev.events |= EPOLLONESHOT;
@@ -255,6 +1233,32 @@ namespace Pistache
 #endif
         }
 
+        bool Epoll::addFdReceiving([[maybe_unused]] Fd fd,
+                                   [[maybe_unused]] Flags<NotifyOn> interest,
+                                   [[maybe_unused]] Tag tag)
+        {
+            PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+                return uring_->addReceiving(fd, interest, tag);
+#endif
+            return false;
+        }
+
+        bool Epoll::addFdAccepting([[maybe_unused]] Fd fd,
+                                   [[maybe_unused]] Flags<NotifyOn> interest,
+                                   [[maybe_unused]] Tag tag)
+        {
+            PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+                return uring_->addAccepting(fd, interest, tag);
+#endif
+            return false;
+        }
+
         void Epoll::removeFd(Fd fd)
         {
             PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
@@ -263,6 +1267,14 @@ namespace Pistache
             TRY(epoll_fd->ctl(EvCtlAction::Del,
                               fd, 0 /* events */, nullptr /* time */));
 #else
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+            {
+                uring_->remove(fd);
+                return;
+            }
+#endif
+
             struct epoll_event ev;
             TRY(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev));
 #endif
@@ -298,6 +1310,14 @@ namespace Pistache
                               fd, events, nullptr /* time */));
 
 #else
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+            {
+                uring_->rearm(fd, interest, tag, mode);
+                return;
+            }
+#endif
+
             struct epoll_event ev;
             ev.events = toEpollEvents(interest);
             if (mode == Mode::Edge)
@@ -308,6 +1328,18 @@ namespace Pistache
 #endif
         }
 
+        bool Epoll::send([[maybe_unused]] Fd fd,
+                         [[maybe_unused]] const std::vector<SendBuffer>& buffers,
+                         [[maybe_unused]] int flags,
+                         [[maybe_unused]] std::shared_ptr<const void> hold)
+        {
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+                return uring_->send(fd, buffers, flags, std::move(hold));
+#endif
+            return false;
+        }
+
 #ifdef DEBUG
         static void logFdAndNotifyOn(int i,
 #ifdef _USE_LIBEVENT
@@ -446,6 +1478,11 @@ namespace Pistache
 
 #else // not ifdef _USE_LIBEVENT
 
+#ifdef PS_HAS_IO_URING
+            if (uring_)
+                return uring_->poll(events, timeout);
+#endif
+
             struct epoll_event evs[Const::MaxEvents];
 
             int ready_fds = -1;
@@ -647,7 +1684,9 @@ namespace Pistache
             throw std::runtime_error("Can not try to read if unbound");
 
         uint64_t val = 0;
-        int res      = TRY_RET(READ_EFD(event_fd, &val));
+        // Not TRY_RET: running out of events (EAGAIN) is the expected way
+        // out of a tryRead loop, not an error
+        int res      = READ_EFD(event_fd, &val);
 #ifdef DEBUG
         if (res != 0) // 0 is success
             PS_LOG_DEBUG_ARGS("FdEventFd %p read fail", event_fd);
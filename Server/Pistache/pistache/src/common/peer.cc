@@ -75,6 +75,13 @@ namespace Pistache::Tcp
     void Peer::setIdle(bool bIdle) { isIdle_ = bIdle; }
     bool Peer::isIdle() const { return isIdle_; }
 
+    std::chrono::steady_clock::time_point Peer::lastActivity() const
+    {
+        return lastActivity_;
+    }
+
+    void Peer::touch() { lastActivity_ = std::chrono::steady_clock::now(); }
+
     const std::string& Peer::hostname()
     {
         if (hostname_.empty())
@@ -116,6 +123,16 @@ namespace Pistache::Tcp
     void* Peer::ssl() const { return ssl_; }
     size_t Peer::getID() const { return id_; }
 
+    ArrayStreamBuf<char>& Peer::inputBuffer() { return input_; }
+
+    void Peer::retainInput(size_t initialSize, size_t maxSize)
+    {
+        input_         = ArrayStreamBuf<char>(maxSize, initialSize);
+        inputRetained_ = true;
+    }
+
+    bool Peer::isInputRetained() const { return inputRetained_; }
+
     Fd Peer::fd() const
     {
         Fd res_fd(fd_);
@@ -203,6 +220,44 @@ namespace Pistache::Tcp
         return transport()->asyncWrite(fd_, buffer, flags);
     }
 
+    size_t Peer::queuedBytes() const { return queuedBytes_; }
+
+    void Peer::onWritable(size_t lowWaterMark, std::function<void()> callback)
+    {
+        {
+            std::lock_guard<std::mutex> guard(writableMutex_);
+            if (queuedBytes_ > lowWaterMark)
+            {
+                onWritable_   = std::move(callback);
+                lowWaterMark_ = lowWaterMark;
+                return;
+            }
+
+            onWritable_ = nullptr;
+        }
+
+        callback();
+    }
+
+    void Peer::addQueued(size_t bytes) { queuedBytes_ += bytes; }
+
+    void Peer::removeQueued(size_t bytes)
+    {
+        queuedBytes_ -= bytes;
+
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> guard(writableMutex_);
+            if (!onWritable_ || queuedBytes_ > lowWaterMark_)
+                return;
+
+            callback    = std::move(onWritable_);
+            onWritable_ = nullptr;
+        }
+
+        callback();
+    }
+
     std::ostream& operator<<(std::ostream& os, Peer& peer)
     {
         const auto& addr = peer.address();
@@ -0,0 +1,628 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/******************************************************************************
+ * pist_asynclog.cc
+ *
+ * Asynchronous backend for the PS_LOG_... macros
+ *
+ * Each thread that logs gets a ring of records of its own, that only it
+ * writes to and only the background thread reads from, so that neither ever
+ * waits on the other. The rings are kept in a list which the mutex of the
+ * backend guards; a thread only takes that mutex the first time it logs.
+ *
+ */
+
+#include <pistache/winornix.h>
+
+#include <pistache/pist_syslog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+/*****************************************************************************/
+
+namespace Pistache::AsyncLog
+{
+    std::atomic<bool> gRunning { false };
+
+    namespace
+    {
+        // How long the background thread sleeps when there is nothing to
+        // write. A producer only wakes it early when its ring fills up.
+        constexpr auto IdleWait = std::chrono::milliseconds(5);
+
+        struct Ring
+        {
+            Ring(size_t _capacity, unsigned _id)
+                : records(_capacity)
+                , id(_id)
+            { }
+
+            std::vector<Record> records; // a power of two of them
+            const unsigned id;
+
+            // Records [tail, head) are waiting. head is only written by the
+            // thread the ring belongs to, tail only by the background thread.
+            alignas(64) std::atomic<size_t> head { 0 };
+            alignas(64) std::atomic<size_t> tail { 0 };
+
+            // Set when the thread exits; the ring is let go once drained
+            std::atomic<bool> closed { false };
+        };
+
+        struct Backend
+        {
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable drained;
+
+            std::vector<std::shared_ptr<Ring>> rings;
+            unsigned nextRingId = 0;
+            size_t ringRecords  = 0;
+
+            // Bumped by each start, so that threads drop the rings of a
+            // previous run
+            std::atomic<uint64_t> generation { 0 };
+            std::atomic<uint64_t> dropped { 0 };
+
+            std::thread thread;
+            bool stopping = false;
+
+            PSLogSink sink = PSLogSink::Syslog;
+            FILE * file    = nullptr;
+        };
+
+        // Never destroyed: threads may still log while statics are torn down
+        Backend & backend()
+        {
+            static Backend * instance = new Backend;
+            return(*instance);
+        }
+
+        struct LocalRing
+        {
+            ~LocalRing()
+            {
+                if (ring)
+                    ring->closed.store(true, std::memory_order_release);
+            }
+
+            std::shared_ptr<Ring> ring;
+            uint64_t generation = 0;
+        };
+
+        thread_local LocalRing tLocalRing;
+
+        Ring * attach(LocalRing & _local, uint64_t _generation)
+        {
+            auto & b = backend();
+            std::lock_guard<std::mutex> guard(b.mutex);
+
+            if (_local.ring)
+                _local.ring->closed.store(true, std::memory_order_release);
+            _local.ring.reset();
+
+            // Stopped, or stopping, in the meantime
+            if ((b.ringRecords == 0) ||
+                (_generation != b.generation.load(std::memory_order_relaxed)))
+                return(nullptr);
+
+            _local.ring = std::make_shared<Ring>(b.ringRecords, b.nextRingId++);
+            _local.generation = _generation;
+            b.rings.push_back(_local.ring);
+            return(_local.ring.get());
+        }
+
+        const char * levelStr(int _pri)
+        {
+            switch(_pri)
+            {
+            case LOG_ALERT:   return("ALERT");
+            case LOG_ERR:     return("ERR");
+            case LOG_WARNING: return("WRN");
+            case LOG_INFO:    return("INF");
+            case LOG_DEBUG:   return("DBG");
+            default:          return("UNKNOWN");
+            }
+        }
+
+        const char * baseName(const char * _path)
+        {
+            if (!_path)
+                return("");
+
+            const char * base = _path;
+            for (const char * p = _path; *p; ++p)
+            {
+                if ((*p == '/') || (*p == '\\'))
+                    base = p + 1;
+            }
+            return(base);
+        }
+
+        size_t advance(size_t _size, size_t _pos, int _res)
+        {
+            if (_res < 0)
+                return(_pos);
+            return(std::min(_pos + static_cast<size_t>(_res), _size - 1));
+        }
+
+        #if defined(__clang__) || defined(__GNUC__)
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+        #endif
+
+        // Formats the conversion _spec (e.g. "%-8.3") of a record argument,
+        // the length modifiers being chosen by the argument's type rather
+        // than by the format
+        int formatArg(char * _out, size_t _size, std::string & _spec,
+                      const char * _modifiers, char _conversion,
+                      const Record & _rec, size_t _arg)
+        {
+            const ArgType type   = _rec.types[_arg];
+            const uint64_t value = _rec.values[_arg];
+
+            const bool isInt =
+                (std::strchr("diouxXc", _conversion) != nullptr);
+            const bool isFloat =
+                (std::strchr("fFeEgGaA", _conversion) != nullptr);
+
+            if ((_conversion == 's') && (type == ArgType::String))
+            {
+                _spec += 's';
+                return(snprintf(_out, _size, _spec.c_str(), &_rec.text[value]));
+            }
+            if (_conversion == 'p')
+            {
+                _spec += 'p';
+                return(snprintf(_out, _size, _spec.c_str(),
+                                reinterpret_cast<void *>(
+                                    static_cast<uintptr_t>(value))));
+            }
+            if (isFloat && (type == ArgType::Double))
+            {
+                double d;
+                std::memcpy(&d, &value, sizeof(d));
+                _spec += _conversion;
+                return(snprintf(_out, _size, _spec.c_str(), d));
+            }
+            if (isInt)
+            {
+                switch(type)
+                {
+                case ArgType::Int:
+                case ArgType::UInt:
+                    // h and hh narrow what was promoted to int, and still
+                    // apply; longer ones are as wide as int here
+                    if ((_modifiers[0] == 'h') && (_conversion != 'c'))
+                        _spec += _modifiers;
+                    _spec += _conversion;
+                    if (type == ArgType::Int)
+                        return(snprintf(_out, _size, _spec.c_str(),
+                                        static_cast<int>(value)));
+                    return(snprintf(_out, _size, _spec.c_str(),
+                                    static_cast<unsigned>(value)));
+
+                case ArgType::LongLong:
+                case ArgType::ULongLong:
+                    _spec += "ll";
+                    _spec += _conversion;
+                    if (type == ArgType::LongLong)
+                        return(snprintf(_out, _size, _spec.c_str(),
+                                        static_cast<long long>(value)));
+                    return(snprintf(_out, _size, _spec.c_str(),
+                                    static_cast<unsigned long long>(value)));
+
+                default:
+                    break;
+                }
+            }
+
+            // The argument does not go with the conversion: printf itself
+            // would not have been able to print it either
+            return(snprintf(_out, _size, "(?)"));
+        }
+
+        #if defined(__clang__) || defined(__GNUC__)
+        #pragma GCC diagnostic pop
+        #endif
+
+        // printf, with the arguments taken from the record
+        void formatMessage(const Record & _rec, char * _out, size_t _size)
+        {
+            const char * f = _rec.format;
+            size_t pos     = 0;
+            size_t arg     = 0;
+
+            auto nextInt = [&](int & _value) {
+                if ((arg >= _rec.argCount) ||
+                    ((_rec.types[arg] != ArgType::Int) &&
+                     (_rec.types[arg] != ArgType::UInt)))
+                    return(false);
+                _value = static_cast<int>(_rec.values[arg++]);
+                return(true);
+            };
+
+            std::string spec;
+            while (*f && (pos + 1 < _size))
+            {
+                if (*f != '%')
+                {
+                    _out[pos++] = *f++;
+                    continue;
+                }
+
+                if (f[1] == '%')
+                {
+                    _out[pos++] = '%';
+                    f += 2;
+                    continue;
+                }
+
+                spec = "%";
+                ++f;
+                while (*f && std::strchr("-+ #0'", *f))
+                    spec += *f++;
+
+                bool ok = true;
+                if (*f == '*')
+                {
+                    int width = 0;
+                    ok = nextInt(width);
+                    spec += std::to_string(width);
+                    ++f;
+                }
+                else
+                {
+                    while ((*f >= '0') && (*f <= '9'))
+                        spec += *f++;
+                }
+
+                if (*f == '.')
+                {
+                    ++f;
+                    if (*f == '*')
+                    {
+                        int precision = 0;
+                        ok = nextInt(precision) && ok;
+                        // A negative precision is taken as if there was none
+                        if (precision >= 0)
+                            spec += '.' + std::to_string(precision);
+                        ++f;
+                    }
+                    else
+                    {
+                        spec += '.';
+                        while ((*f >= '0') && (*f <= '9'))
+                            spec += *f++;
+                    }
+                }
+
+                char modifiers[4] = { 0 };
+                for (size_t m = 0; *f && std::strchr("hlLqjzt", *f); ++f)
+                {
+                    if (m + 1 < sizeof(modifiers))
+                        modifiers[m++] = *f;
+                }
+
+                const char conversion = *f;
+                if (conversion)
+                    ++f;
+
+                int res = -1;
+                if (ok && (conversion != 'n') && (arg < _rec.argCount))
+                    res = formatArg(&_out[pos], _size - pos, spec, modifiers,
+                                    conversion, _rec, arg++);
+                else
+                    res = snprintf(&_out[pos], _size - pos, "(?)");
+                pos = advance(_size, pos, res);
+            }
+
+            _out[pos] = 0;
+        }
+
+        void write(const Backend & _b, const Record & _rec, const Ring & _ring)
+        {
+            char message[2048];
+            formatMessage(_rec, message, sizeof(message));
+
+            if (_b.sink == PSLogSink::Syslog)
+            {
+                PSLogFn(_rec.pri, _rec.andPrintf, _rec.file, _rec.line,
+                        _rec.function, "%s", message);
+                return;
+            }
+
+            const time_t secs = static_cast<time_t>(_rec.time / 1000000);
+            const long micros = static_cast<long>(_rec.time % 1000000);
+
+            char when[64] = "<No Timestamp>";
+            struct tm this_tm;
+            memset(&this_tm, 0, sizeof(this_tm));
+            if (PST_LOCALTIME_R(&secs, &this_tm))
+                strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &this_tm);
+
+            fprintf(_b.file, "%s.%06ld %s [%u] %s:%d in %s(): %s\n",
+                    when, micros, levelStr(_rec.pri), _ring.id,
+                    baseName(_rec.file), _rec.line,
+                    _rec.function ? _rec.function : "", message);
+        }
+
+        // Writes what the ring holds, returning how many records it did
+        size_t drain(Backend & _b, Ring & _ring)
+        {
+            const size_t head = _ring.head.load(std::memory_order_acquire);
+            size_t tail       = _ring.tail.load(std::memory_order_relaxed);
+            if (tail == head)
+                return(0);
+
+            const size_t mask = _ring.records.size() - 1;
+            const size_t count = head - tail;
+            for (; tail != head; ++tail)
+                write(_b, _ring.records[tail & mask], _ring);
+
+            if (_b.file)
+                fflush(_b.file);
+
+            // Only now are the records written, as far as PSLogFlushAsync is
+            // concerned, and may the thread reuse them
+            _ring.tail.store(tail, std::memory_order_release);
+            return(count);
+        }
+
+        void run()
+        {
+            auto & b = backend();
+            std::vector<std::shared_ptr<Ring>> rings;
+
+            for (;;)
+            {
+                bool stopping = false;
+                {
+                    std::lock_guard<std::mutex> guard(b.mutex);
+                    stopping = b.stopping;
+
+                    // Rings of threads gone, that have been drained
+                    b.rings.erase(
+                        std::remove_if(b.rings.begin(), b.rings.end(),
+                                       [](const std::shared_ptr<Ring> & r) {
+                                           return(r->closed.load(std::memory_order_acquire) &&
+                                                  (r->tail.load(std::memory_order_relaxed) ==
+                                                   r->head.load(std::memory_order_acquire)));
+                                       }),
+                        b.rings.end());
+                    rings = b.rings;
+                }
+
+                size_t written = 0;
+                for (auto & ring : rings)
+                    written += drain(b, *ring);
+
+                std::unique_lock<std::mutex> lock(b.mutex);
+                if (written)
+                    b.drained.notify_all();
+                if (stopping && !written)
+                    break;
+                if (!written)
+                    b.wake.wait_for(lock, IdleWait);
+            }
+        }
+    }
+
+    // Follows the parsing of formatMessage, stopping at each argument
+    FormatCursor::Use FormatCursor::next()
+    {
+        if (!pos_)
+            return(Use::Unknown);
+
+        if (stage_ == Stage::Start)
+        {
+            for (;;)
+            {
+                pos_ = std::strchr(pos_, '%');
+                if (!pos_)
+                    return(Use::Unknown);
+                if (pos_[1] != '%')
+                    break;
+                pos_ += 2;
+            }
+
+            ++pos_;
+            precision_ = -1;
+            while (*pos_ && std::strchr("-+ #0'", *pos_))
+                ++pos_;
+
+            stage_ = Stage::AfterWidth;
+            if (*pos_ == '*')
+            {
+                ++pos_;
+                return(Use::Width);
+            }
+            while ((*pos_ >= '0') && (*pos_ <= '9'))
+                ++pos_;
+        }
+
+        if (stage_ == Stage::AfterWidth)
+        {
+            stage_ = Stage::AfterPrecision;
+            if (*pos_ == '.')
+            {
+                ++pos_;
+                if (*pos_ == '*')
+                {
+                    ++pos_;
+                    return(Use::Precision);
+                }
+                precision_ = 0;
+                for (; (*pos_ >= '0') && (*pos_ <= '9'); ++pos_)
+                {
+                    if (precision_ < static_cast<int>(TextSize))
+                        precision_ = precision_ * 10 + (*pos_ - '0');
+                }
+            }
+        }
+
+        while (*pos_ && std::strchr("hlLqjzt", *pos_))
+            ++pos_;
+        conversion_ = *pos_;
+        if (*pos_)
+            ++pos_;
+        stage_ = Stage::Start;
+        return(Use::Conversion);
+    }
+
+    Record * claim()
+    {
+        auto & b = backend();
+        const uint64_t generation = b.generation.load(std::memory_order_acquire);
+
+        LocalRing & local = tLocalRing;
+        Ring * ring = local.ring.get();
+        if (!ring || (local.generation != generation))
+        {
+            ring = attach(local, generation);
+            if (!ring)
+                return(nullptr);
+        }
+
+        const size_t head = ring->head.load(std::memory_order_relaxed);
+        if (head - ring->tail.load(std::memory_order_acquire) >= ring->records.size())
+        {
+            b.dropped.fetch_add(1, std::memory_order_relaxed);
+            return(nullptr);
+        }
+
+        Record * rec = &ring->records[head & (ring->records.size() - 1)];
+        rec->time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return(rec);
+    }
+
+    void publish()
+    {
+        Ring & ring = *tLocalRing.ring;
+
+        const size_t head = ring.head.load(std::memory_order_relaxed) + 1;
+        ring.head.store(head, std::memory_order_release);
+
+        if ((head - ring.tail.load(std::memory_order_relaxed)) * 4 > ring.records.size() * 3)
+            backend().wake.notify_one();
+    }
+
+} // namespace Pistache::AsyncLog
+
+/*****************************************************************************/
+
+using namespace Pistache::AsyncLog;
+
+bool PSLogStartAsync(PSLogSink _sink, const char * _path, size_t _ringRecords)
+{
+    auto & b = backend();
+    std::lock_guard<std::mutex> guard(b.mutex);
+
+    if (b.thread.joinable())
+        return(false);
+
+    FILE * file = nullptr;
+    if (_sink == PSLogSink::File)
+    {
+        if ((!_path) || (!_path[0]))
+            return(false);
+        file = fopen(_path, "a");
+        if (!file)
+            return(false);
+    }
+    else if (_sink == PSLogSink::Stdout)
+    {
+        file = stdout;
+    }
+
+    size_t capacity = 2;
+    while (capacity < _ringRecords)
+        capacity <<= 1;
+
+    b.sink        = _sink;
+    b.file        = file;
+    b.ringRecords = capacity;
+    b.stopping    = false;
+    b.generation.fetch_add(1, std::memory_order_release);
+    b.thread = std::thread(run);
+
+    gRunning.store(true, std::memory_order_release);
+    return(true);
+}
+
+void PSLogStopAsync()
+{
+    auto & b = backend();
+
+    std::thread thread;
+    {
+        std::lock_guard<std::mutex> guard(b.mutex);
+        if (!b.thread.joinable())
+            return;
+
+        gRunning.store(false, std::memory_order_release);
+        b.stopping    = true;
+        b.ringRecords = 0;
+        thread        = std::move(b.thread);
+    }
+    b.wake.notify_all();
+    thread.join();
+
+    std::lock_guard<std::mutex> guard(b.mutex);
+    b.rings.clear();
+    if (b.file && (b.file != stdout))
+        fclose(b.file);
+    b.file = nullptr;
+    b.drained.notify_all();
+}
+
+void PSLogFlushAsync()
+{
+    auto & b = backend();
+
+    std::unique_lock<std::mutex> lock(b.mutex);
+    if (!b.thread.joinable())
+        return;
+
+    std::vector<std::pair<std::shared_ptr<Ring>, size_t>> targets;
+    for (const auto & ring : b.rings)
+        targets.emplace_back(ring, ring->head.load(std::memory_order_acquire));
+
+    auto done = [&] {
+        if (!b.thread.joinable())
+            return(true);
+        for (const auto & [ring, head] : targets)
+        {
+            if (ring->tail.load(std::memory_order_acquire) < head)
+                return(false);
+        }
+        return(true);
+    };
+
+    b.wake.notify_one();
+    while (!done())
+        b.drained.wait_for(lock, IdleWait);
+}
+
+uint64_t PSLogAsyncDropped()
+{
+    return(backend().dropped.load(std::memory_order_relaxed));
+}
+
+/*****************************************************************************/
@@ -1092,6 +1092,20 @@ static void PSLogStrPrv(int _priority, bool _andPrintf, const char * _str)
 
 // ---------------------------------------------------------------------------
 
+std::atomic<int> gPSLogLevel(LOG_DEBUG);
+
+extern "C" void PSLogSetLevel(int _pri)
+{
+    gPSLogLevel.store(_pri, std::memory_order_relaxed);
+}
+
+extern "C" int PSLogGetLevel()
+{
+    return(gPSLogLevel.load(std::memory_order_relaxed));
+}
+
+// ---------------------------------------------------------------------------
+
 extern "C" void PSLogNoLocFn(int _pri, bool _andPrintf,
                              const char * _format, ...)
 {
@@ -130,8 +130,21 @@ namespace Pistache::Aio
                               Polling::Mode mode = Polling::Mode::Level)
             = 0;
 
+        virtual bool registerFdReceiving(const Reactor::Key& key, Fd fd,
+                                         Polling::NotifyOn interest, Polling::Tag tag)
+            = 0;
+
+        virtual bool registerFdAccepting(const Reactor::Key& key, Fd fd,
+                                         Polling::Tag tag)
+            = 0;
+
         virtual void removeFd(const Reactor::Key& key, Fd fd) = 0;
 
+        virtual bool send(const Reactor::Key& key, Fd fd,
+                          const std::vector<Polling::SendBuffer>& buffers, int flags,
+                          std::shared_ptr<const void> hold)
+            = 0;
+
         virtual void runOnce() = 0;
         virtual void run()     = 0;
 
@@ -146,12 +159,13 @@ namespace Pistache::Aio
     class SyncImpl : public Reactor::Impl
     {
     public:
-        explicit SyncImpl(Reactor* reactor)
+        explicit SyncImpl(Reactor* reactor,
+                          Polling::Backend backend = Polling::Backend::Epoll)
             : Reactor::Impl(reactor)
             , handlers_()
             , shutdown_()
             , shutdownFd()
-            , poller()
+            , poller(backend)
         {
             shutdownFd.bind(poller);
         }
@@ -265,6 +279,26 @@ namespace Pistache::Aio
             poller.rearmFd(fd, Flags<Polling::NotifyOn>(interest), pollTag, mode);
         }
 
+        bool registerFdReceiving(const Reactor::Key& key, Fd fd,
+                                 Polling::NotifyOn interest, Polling::Tag tag) override
+        {
+            PS_TIMEDBG_START_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+
+            auto pollTag = encodeTag(key, tag);
+            PS_LOG_DBG_NOTIFY_ON;
+            return poller.addFdReceiving(fd, Flags<Polling::NotifyOn>(interest), pollTag);
+        }
+
+        bool registerFdAccepting(const Reactor::Key& key, Fd fd,
+                                 Polling::Tag tag) override
+        {
+            PS_TIMEDBG_START_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+
+            auto pollTag = encodeTag(key, tag);
+            return poller.addFdAccepting(fd, Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
+                                         pollTag);
+        }
+
         void removeFd(const Reactor::Key& /*key*/, Fd fd) override
         {
             PS_TIMEDBG_START_ARGS("Reactor %p, Fd %" PIST_QUOTE(PS_FD_PRNTFCD),
@@ -273,6 +307,13 @@ namespace Pistache::Aio
             poller.removeFd(fd);
         }
 
+        bool send(const Reactor::Key& /*key*/, Fd fd,
+                  const std::vector<Polling::SendBuffer>& buffers, int flags,
+                  std::shared_ptr<const void> hold) override
+        {
+            return poller.send(fd, buffers, flags, std::move(hold));
+        }
+
         void runOnce() override
         {
             PS_TIMEDBG_START;
@@ -528,7 +569,8 @@ namespace Pistache::Aio
         static constexpr uint32_t KeyMarker = 0xBADB0B;
 
         AsyncImpl(Reactor* reactor,
-                  size_t threads, const std::string& threadsName)
+                  size_t threads, const std::string& threadsName,
+                  Polling::Backend backend = Polling::Backend::Epoll)
             : Reactor::Impl(reactor)
         {
             PS_TIMEDBG_START_THIS;
@@ -537,7 +579,7 @@ namespace Pistache::Aio
                 throw std::runtime_error("Too many worker threads requested (max "s + std::to_string(SyncImpl::MaxHandlers()) + ")."s);
 
             for (size_t i = 0; i < threads; ++i)
-                workers_.emplace_back(std::make_unique<Worker>(reactor, threadsName));
+                workers_.emplace_back(std::make_unique<Worker>(reactor, threadsName, backend));
             PS_LOG_DEBUG_ARGS("threads %d, workers_.size() %d",
                               threads, workers_.size());
         }
@@ -634,6 +676,22 @@ namespace Pistache::Aio
             dispatchCall(key, &SyncImpl::modifyFd, fd, interest, tag, mode);
         }
 
+        bool registerFdReceiving(const Reactor::Key& key, Fd fd,
+                                 Polling::NotifyOn interest, Polling::Tag tag) override
+        {
+            PS_TIMEDBG_START_THIS;
+
+            return dispatchCall(key, &SyncImpl::registerFdReceiving, fd, interest, tag);
+        }
+
+        bool registerFdAccepting(const Reactor::Key& key, Fd fd,
+                                 Polling::Tag tag) override
+        {
+            PS_TIMEDBG_START_THIS;
+
+            return dispatchCall(key, &SyncImpl::registerFdAccepting, fd, tag);
+        }
+
         void removeFd(const Reactor::Key& key, Fd fd) override
         {
             PS_TIMEDBG_START_ARGS("this %p, Fd %" PIST_QUOTE(PS_FD_PRNTFCD),
@@ -641,6 +699,13 @@ namespace Pistache::Aio
             dispatchCall(key, &SyncImpl::removeFd, fd);
         }
 
+        bool send(const Reactor::Key& key, Fd fd,
+                  const std::vector<Polling::SendBuffer>& buffers, int flags,
+                  std::shared_ptr<const void> hold) override
+        {
+            return dispatchCall(key, &SyncImpl::send, fd, buffers, flags, std::move(hold));
+        }
+
         void runOnce() override { }
 
         void run() override
@@ -675,8 +740,10 @@ namespace Pistache::Aio
 
 #define CALL_MEMBER_FN(obj, pmf) (obj->*(pmf))
 
-        template <typename Func, typename... Args>
-        void dispatchCall(const Reactor::Key& key, Func func, Args&&... args) const
+        template <typename Ret, typename... Params, typename... Args>
+        Ret dispatchCall(const Reactor::Key& key,
+                         Ret (SyncImpl::*func)(const Reactor::Key&, Params...),
+                         Args&&... args) const
         {
             PS_TIMEDBG_START_THIS;
             PS_LOG_DEBUG_ARGS("workers_.size() %d", workers_.size());
@@ -686,8 +753,7 @@ namespace Pistache::Aio
 
             Reactor::Key originalKey(decoded.first);
 
-            CALL_MEMBER_FN(wrk->sync.get(), func)
-            (originalKey, std::forward<Args>(args)...);
+            return CALL_MEMBER_FN(wrk->sync.get(), func)(originalKey, std::forward<Args>(args)...);
         }
 
 #undef CALL_MEMBER_FN
@@ -695,9 +761,10 @@ namespace Pistache::Aio
         struct Worker
         {
 
-            explicit Worker(Reactor* reactor, const std::string& threadsName)
+            Worker(Reactor* reactor, const std::string& threadsName,
+                   Polling::Backend backend)
                 : thread()
-                , sync(new SyncImpl(reactor))
+                , sync(new SyncImpl(reactor, backend))
                 , threadsName_(threadsName)
             { }
 
@@ -896,6 +963,19 @@ namespace Pistache::Aio
         impl()->modifyFd(key, fd, interest, Polling::Tag(fd), mode);
     }
 
+    bool Reactor::registerFdReceiving(const Reactor::Key& key, Fd fd,
+                                      Polling::NotifyOn interest)
+    {
+        PS_TIMEDBG_START_THIS;
+        return impl()->registerFdReceiving(key, fd, interest, Polling::Tag(fd));
+    }
+
+    bool Reactor::registerFdAccepting(const Reactor::Key& key, Fd fd)
+    {
+        PS_TIMEDBG_START_THIS;
+        return impl()->registerFdAccepting(key, fd, Polling::Tag(fd));
+    }
+
     void Reactor::removeFd(const Reactor::Key& key, Fd fd)
     {
         PS_TIMEDBG_START_ARGS("Reactor %p, Fd %" PIST_QUOTE(PS_FD_PRNTFCD),
@@ -904,6 +984,13 @@ namespace Pistache::Aio
         impl()->removeFd(key, fd);
     }
 
+    bool Reactor::send(const Reactor::Key& key, Fd fd,
+                       const std::vector<Polling::SendBuffer>& buffers, int flags,
+                       std::shared_ptr<const void> hold)
+    {
+        return impl()->send(key, fd, buffers, flags, std::move(hold));
+    }
+
     void Reactor::run() { impl()->run(); }
 
     void Reactor::shutdown()
@@ -934,7 +1021,7 @@ namespace Pistache::Aio
     Reactor::Impl* AsyncContext::makeImpl(Reactor* reactor) const
     {
         PS_TIMEDBG_START_THIS;
-        return new AsyncImpl(reactor, threads_, threadsName_);
+        return new AsyncImpl(reactor, threads_, threadsName_, backend_);
     }
 
     AsyncContext AsyncContext::singleThreaded() { return AsyncContext(1); }
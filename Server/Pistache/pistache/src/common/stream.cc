@@ -11,6 +11,7 @@
 
 #include <pistache/winornix.h>
 
+#include <pistache/pist_syslog.h>
 #include <pistache/stream.h>
 
 #include <algorithm>
@@ -31,7 +32,7 @@ namespace Pistache
 {
 
     RawBuffer::RawBuffer(std::string data, size_t length)
-        : data_(std::move(data))
+        : data_(data.empty() ? nullptr : std::make_shared<const std::string>(std::move(data)))
         , length_(length)
     { }
 
@@ -40,12 +41,18 @@ namespace Pistache
         , length_(length)
     {
         // input may come not from a ZTS - copy only length_ characters.
-        data_.assign(data, length_);
+        if (length_ > 0)
+            data_ = std::make_shared<const std::string>(data, length_);
     }
 
+    RawBuffer::RawBuffer(std::shared_ptr<const std::string> data)
+        : data_(std::move(data))
+        , length_(data_ ? data_->size() : 0)
+    { }
+
     RawBuffer RawBuffer::copy(size_t fromIndex) const
     {
-        if (data_.empty())
+        if (!data_ || data_->empty())
             return RawBuffer();
 
         if (length_ < fromIndex)
@@ -53,18 +60,28 @@ namespace Pistache
                 "Trying to detach buffer from an index bigger than lengthght.");
 
         auto newDatalength  = length_ - fromIndex;
-        std::string newData = data_.substr(fromIndex, newDatalength);
+        std::string newData = data_->substr(fromIndex, newDatalength);
 
         return RawBuffer(std::move(newData), newDatalength);
     }
 
-    const std::string& RawBuffer::data() const { return data_; }
+    const std::string& RawBuffer::data() const
+    {
+        static const std::string Empty;
+        return data_ ? *data_ : Empty;
+    }
 
     size_t RawBuffer::size() const { return length_; }
 
+    OpenFile::~OpenFile()
+    {
+        PS_LOG_DEBUG_ARGS("file ::close actual_fd %d", fd_);
+        PST_FILE_CLOSE(fd_);
+    }
+
     FileBuffer::FileBuffer(const std::string& fileName)
-        : fileName_(fileName)
-        , fd_(-1)
+        : file_()
+        , offset_(0)
         , size_(0)
     {
         if (fileName.empty())
@@ -86,17 +103,33 @@ namespace Pistache
             throw std::runtime_error("Could not get file stats");
         }
 
-        fd_   = fd;
+        file_ = std::make_shared<const OpenFile>(fd);
         size_ = sb.st_size;
     }
 
-    int FileBuffer::fd() const { return fd_; }
+    FileBuffer::FileBuffer(std::shared_ptr<const OpenFile> file, off_t offset, size_t size)
+        : file_(std::move(file))
+        , offset_(offset)
+        , size_(size)
+    {
+        if (!file_)
+        {
+            throw std::runtime_error("No file");
+        }
+    }
+
+    int FileBuffer::fd() const { return file_->fd(); }
+
+    off_t FileBuffer::offset() const { return offset_; }
+
+    const std::shared_ptr<const OpenFile>& FileBuffer::file() const { return file_; }
 
     size_t FileBuffer::size() const { return size_; }
 
     DynamicStreamBuf::DynamicStreamBuf(size_t size, size_t maxSize)
         : data_()
         , maxSize_(maxSize)
+        , initialSize_(size)
     {
         assert(size <= maxSize);
 
@@ -104,20 +137,27 @@ namespace Pistache
     }
 
     DynamicStreamBuf::DynamicStreamBuf(DynamicStreamBuf&& other)
-        : data_(std::move(other.data_))
+        : data_()
         , maxSize_(other.maxSize_)
+        , initialSize_(other.initialSize_)
     {
-        setp(other.pptr(), other.epptr());
-        other.setp(nullptr, nullptr);
+        *this = std::move(other);
     }
 
     DynamicStreamBuf& DynamicStreamBuf::operator=(DynamicStreamBuf&& other)
     {
         if (&other != this)
         {
-            data_    = std::move(other.data_);
-            maxSize_ = other.maxSize_;
-            setp(other.pptr(), other.epptr());
+            // A short string may not keep its storage when moved
+            const size_t written = other.written();
+
+            data_        = std::move(other.data_);
+            maxSize_     = other.maxSize_;
+            initialSize_ = other.initialSize_;
+            setp(data_.data(), data_.data() + data_.size());
+            pbump(static_cast<int>(written));
+
+            other.data_.clear();
             other.setp(nullptr, nullptr);
         }
 
@@ -126,7 +166,27 @@ namespace Pistache
 
     RawBuffer DynamicStreamBuf::buffer() const
     {
-        return RawBuffer(data_.data(), pptr() - data_.data());
+        return RawBuffer(data_.data(), written());
+    }
+
+    RawBuffer DynamicStreamBuf::release()
+    {
+        const size_t written = this->written();
+        data_.resize(written);
+
+        RawBuffer buffer(std::move(data_), written);
+
+        data_.clear();
+        setp(nullptr, nullptr);
+
+        return buffer;
+    }
+
+    size_t DynamicStreamBuf::written() const
+    {
+        if (pptr() == nullptr)
+            return 0;
+        return static_cast<size_t>(pptr() - data_.data());
     }
 
     size_t DynamicStreamBuf::maxSize() const { return maxSize_; }
@@ -145,7 +205,11 @@ namespace Pistache
             const auto size = data_.size();
             if (size < maxSize_)
             {
-                reserve((size ? size : 1u) * 2);
+                // Released buffers start over from their initial size
+                if (size == 0 && initialSize_ > 0)
+                    reserve(initialSize_);
+                else
+                    reserve((size ? size : 1u) * 2);
                 *pptr() = static_cast<char>(ch);
                 pbump(1);
                 return traits_type::not_eof(ch);
@@ -10,130 +10,42 @@
    Implementation of the timer pool
 */
 
-#include <pistache/os.h>
 #include <pistache/timer_pool.h>
 
-#include <cassert>
-
-#include <pistache/eventmeth.h>
-#include <pistache/pist_quote.h>
-
-#ifndef _USE_LIBEVENT_LIKE_APPLE
-// Note: sys/timerfd.h is linux-only (and certainly POSIX only)
-#include <sys/timerfd.h>
-#endif
-
 namespace Pistache
 {
 
     TimerPool::Entry::Entry()
-        : fd_(PS_FD_EMPTY)
-        , registered(false)
+        : wheel_(nullptr)
+        , timer_(TimerWheel::NoTimer)
     {
         state.store(static_cast<uint32_t>(State::Idle));
     }
 
-    TimerPool::Entry::~Entry()
-    {
-        if (fd_ != PS_FD_EMPTY)
-        {
-            CLOSE_FD(fd_);
-            fd_ = PS_FD_EMPTY;
-        }
-    }
+    // A timer still armed is not cancelled, as the wheel may well be gone
+    // by then. It is left to fire, its callback having to cope with that.
+    TimerPool::Entry::~Entry() = default;
 
-    Fd TimerPool::Entry::fd() const
+    void TimerPool::Entry::armMs(TimerWheel& wheel, std::chrono::milliseconds value,
+                                 TimerWheel::Callback callback)
     {
-        assert(fd_ != PS_FD_EMPTY);
-
-        return fd_;
-    }
+        disarm();
 
-    void TimerPool::Entry::initialize()
-    {
-        if (fd_ == PS_FD_EMPTY)
-        {
-#ifdef _USE_LIBEVENT
-            fd_ = TRY_NULL_RET(EventMethFns::em_timer_new(
-                PST_CLOCK_MONOTONIC,
-                F_SETFDL_NOTHING, PST_O_NONBLOCK,
-                nullptr /* EventMethEpollEquiv ptr */));
-            // The EventMethEpollEquiv ptr gets set
-            // later, when
-            // TimerPool::Entry::registerReactor is
-            // called (the reactor owns the
-            // EventMethEpollEquiv)
-#else
-            fd_ = TRY_RET(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK));
-#endif
-        }
+        wheel_ = &wheel;
+        timer_ = wheel.schedule(value, std::move(callback));
     }
 
     void TimerPool::Entry::disarm()
     {
-        if (fd_ == PS_FD_EMPTY)
-        {
-            assert(fd_ != PS_FD_EMPTY);
-            PS_LOG_DEBUG("fd_ empty");
-            throw std::runtime_error("fd_ empty");
-        }
-
-#ifdef _USE_LIBEVENT
-        TRY(EventMethFns::setEmEventTime(fd_, nullptr));
-#else
-        itimerspec spec;
-        spec.it_interval.tv_sec  = 0;
-        spec.it_interval.tv_nsec = 0;
-
-        spec.it_value.tv_sec  = 0;
-        spec.it_value.tv_nsec = 0;
+        if (wheel_ && timer_ != TimerWheel::NoTimer)
+            wheel_->cancel(timer_);
 
-        TRY(timerfd_settime(fd_, 0, &spec, nullptr));
-#endif
+        timer_ = TimerWheel::NoTimer;
     }
 
-    void TimerPool::Entry::registerReactor(const Aio::Reactor::Key& key,
-                                           Aio::Reactor* reactor)
+    bool TimerPool::Entry::isArmed() const
     {
-        if (!registered)
-        {
-            PS_LOG_DEBUG_ARGS("Register fd %" PIST_QUOTE(PS_FD_PRNTFCD) " with reactor %p",
-                              fd_, reactor);
-
-            reactor->registerFd(key, fd_, Polling::NotifyOn::Read);
-            registered = true;
-        }
-    }
-
-    void TimerPool::Entry::armMs(std::chrono::milliseconds value)
-    {
-        if (fd_ == PS_FD_EMPTY)
-        {
-            PS_LOG_DEBUG("fd_ NULL");
-            assert(fd_ != PS_FD_EMPTY);
-            throw std::runtime_error("fd_ NULL");
-        }
-
-#ifdef _USE_LIBEVENT
-        TRY(EventMethFns::setEmEventTime(fd_, &value));
-#else
-
-        itimerspec spec;
-        spec.it_interval.tv_sec  = 0;
-        spec.it_interval.tv_nsec = 0;
-
-        if (value.count() < 1000)
-        {
-            spec.it_value.tv_sec  = 0;
-            spec.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
-        }
-        else
-        {
-            spec.it_value.tv_sec  = std::chrono::duration_cast<std::chrono::seconds>(value).count();
-            spec.it_value.tv_nsec = 0;
-        }
-        TRY(timerfd_settime(fd_, 0, &spec, nullptr));
-#endif
+        return wheel_ && wheel_->isScheduled(timer_);
     }
 
     TimerPool::TimerPool(size_t initialSize)
@@ -151,10 +63,7 @@ namespace Pistache
             auto curState = static_cast<uint32_t>(TimerPool::Entry::State::Idle);
             auto newState = static_cast<uint32_t>(TimerPool::Entry::State::Used);
             if (entry->state.compare_exchange_strong(curState, newState))
-            {
-                entry->initialize();
                 return entry;
-            }
         }
 
         return nullptr;
@@ -0,0 +1,492 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* timer_wheel.cc
+
+   Implementation of the hierarchical timing wheel
+*/
+
+#include <pistache/common.h>
+#include <pistache/eventmeth.h>
+#include <pistache/pist_quote.h>
+#include <pistache/timer_wheel.h>
+
+#include PST_MISC_IO_HDR // e.g. unistd.h
+
+#ifndef _USE_LIBEVENT_LIKE_APPLE
+// Note: sys/timerfd.h is linux-only (and certainly POSIX only)
+#include <sys/timerfd.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <stdexcept>
+
+namespace Pistache
+{
+
+    namespace
+    {
+        // Index of the lowest set bit, value must not be zero
+        size_t lowestBit(uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return index;
+#else
+            return static_cast<size_t>(__builtin_ctzll(value));
+#endif
+        }
+
+        // Index of the highest set bit, value must not be zero
+        size_t highestBit(uint64_t value)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return index;
+#else
+            return 63 - static_cast<size_t>(__builtin_clzll(value));
+#endif
+        }
+    } // namespace
+
+    TimerWheel::TimerWheel()
+        : origin_(Clock::now())
+    {
+        for (auto& level : slots_)
+            level.fill(Nil);
+        occupied_.fill(0);
+    }
+
+    TimerWheel::~TimerWheel()
+    {
+        if (timerFd_ != PS_FD_EMPTY)
+        {
+            CLOSE_FD(timerFd_);
+            timerFd_ = PS_FD_EMPTY;
+        }
+    }
+
+    TimerWheel::TimerId TimerWheel::scheduleAt(Clock::time_point deadline, Callback callback)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        // Overdue timers fire on the next tick. Not on the current one, which
+        // a callback scheduling its own timer again would never get out of.
+        uint64_t tick = toTick(deadline, true);
+        if (tick <= now_)
+            tick = now_ + 1;
+
+        uint32_t index;
+        if (free_ != Nil)
+        {
+            index = free_;
+            free_ = nodes_[index].next;
+        }
+        else
+        {
+            if (nodes_.size() >= Nil)
+                throw std::runtime_error("Too many timers");
+
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+
+        auto& node    = nodes_[index];
+        node.callback = std::move(callback);
+        node.expiry   = tick;
+        node.active   = true;
+        link(index);
+        ++size_;
+
+        if (timerFd_ != PS_FD_EMPTY && tick < armedTick_)
+            rearm();
+
+        return (static_cast<TimerId>(node.gen) << 32) | index;
+    }
+
+    bool TimerWheel::cancel(TimerId id)
+    {
+        // Destroyed once the lock is released, as whatever the callback holds
+        // on to may well cancel timers of its own
+        Callback callback;
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        const uint32_t index = find(id);
+        if (index == Nil)
+            return false;
+
+        callback = std::move(nodes_[index].callback);
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    bool TimerWheel::isScheduled(TimerId id) const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return find(id) != Nil;
+    }
+
+    size_t TimerWheel::size() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return size_;
+    }
+
+    size_t TimerWheel::advance(Clock::time_point now)
+    {
+        const uint64_t tick = toTick(now, false);
+
+        // Callbacks are run one by one, each taken off the list of due timers
+        // right before it runs, so that the others can still be cancelled
+        size_t count = 0;
+        for (;;)
+        {
+            Callback callback;
+            {
+                std::lock_guard<std::mutex> guard(mutex_);
+
+                if (dueHead_ == Nil)
+                    advanceTo(tick);
+                if (dueHead_ == Nil)
+                    break;
+
+                const uint32_t index = dueHead_;
+                callback             = std::move(nodes_[index].callback);
+                unlink(index);
+                release(index);
+            }
+
+            callback();
+            ++count;
+        }
+
+        return count;
+    }
+
+    std::optional<TimerWheel::Clock::time_point> TimerWheel::nextDeadline() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        size_t level;
+        auto tick = nextEvent(&level);
+        if (!tick)
+            return std::nullopt;
+
+        return fromTick(*tick);
+    }
+
+    Polling::Tag TimerWheel::bind(Polling::Epoll& poller)
+    {
+        if (isBound())
+            throw std::runtime_error("The timer wheel has already been bound");
+
+        Fd fd =
+#ifdef _USE_LIBEVENT
+            TRY_NULL_RET(poller.em_timer_new(PST_CLOCK_MONOTONIC,
+                                             F_SETFDL_NOTHING,
+                                             PST_O_NONBLOCK));
+#else
+            TRY_RET(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+#endif
+
+        Polling::Tag tag(fd);
+        PS_LOG_DEBUG_ARGS("Add timer wheel fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
+        poller.addFd(fd, Flags<Polling::NotifyOn>(Polling::NotifyOn::Read), tag);
+
+        std::lock_guard<std::mutex> guard(mutex_);
+        timerFd_   = fd;
+        armedTick_ = UINT64_MAX;
+        rearm();
+
+        return tag;
+    }
+
+    void TimerWheel::unbind(Polling::Epoll& poller)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (timerFd_ == PS_FD_EMPTY)
+            return;
+
+        PS_LOG_DEBUG_ARGS("Remove and close timer wheel fd %" PIST_QUOTE(PS_FD_PRNTFCD),
+                          timerFd_);
+
+        poller.removeFd(timerFd_);
+        CLOSE_FD(timerFd_);
+        timerFd_ = PS_FD_EMPTY;
+    }
+
+    // timerFd_ is only changed from the polling thread, so reading it from
+    // there needs no locking
+    bool TimerWheel::isBound() const { return timerFd_ != PS_FD_EMPTY; }
+
+    Polling::Tag TimerWheel::tag() const
+    {
+        if (timerFd_ == PS_FD_EMPTY)
+            throw std::runtime_error("Can not retrieve tag of an unbound timer wheel");
+
+        return Polling::Tag(timerFd_);
+    }
+
+    void TimerWheel::handleReady()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (timerFd_ == PS_FD_EMPTY)
+                return;
+
+            uint64_t expirations;
+            [[maybe_unused]] auto rv = READ_FD(timerFd_, &expirations, sizeof expirations);
+
+            // The fd is no longer armed, timers scheduled by the callbacks
+            // arm it again as needed
+            armedTick_ = UINT64_MAX;
+        }
+
+        advance(Clock::now());
+
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (timerFd_ != PS_FD_EMPTY)
+            rearm();
+    }
+
+    uint64_t TimerWheel::toTick(Clock::time_point time, bool roundUp) const
+    {
+        if (time <= origin_)
+            return 0;
+
+        // time_point::max() and the like must not overflow
+        const auto elapsed = time - origin_;
+        if (elapsed >= std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(MaxTick)))
+            return MaxTick;
+
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+        uint64_t tick = static_cast<uint64_t>(ms.count());
+        if (roundUp && ms < elapsed)
+            ++tick;
+
+        return tick;
+    }
+
+    TimerWheel::Clock::time_point TimerWheel::fromTick(uint64_t tick) const
+    {
+        return origin_ + std::chrono::milliseconds(tick);
+    }
+
+    void TimerWheel::link(uint32_t index)
+    {
+        auto& node = nodes_[index];
+
+        // A timer goes in the level of the highest digit in which its expiry
+        // differs from the current tick. Every timer in a slot thus lies
+        // ahead of the current tick, and the lower levels only hold timers
+        // that expire before those of the slots above them.
+        const uint64_t diff = node.expiry ^ now_;
+        const size_t level  = diff < SlotCount ? 0 : highestBit(diff) / SlotBits;
+        const size_t slot   = (node.expiry >> (level * SlotBits)) & (SlotCount - 1);
+
+        node.level = static_cast<uint8_t>(level);
+        node.slot  = static_cast<uint8_t>(slot);
+        node.prev  = Nil;
+        node.next  = slots_[level][slot];
+
+        if (node.next != Nil)
+            nodes_[node.next].prev = index;
+
+        slots_[level][slot] = index;
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void TimerWheel::unlink(uint32_t index)
+    {
+        auto& node     = nodes_[index];
+        const bool due = node.level == DueLevel;
+        uint32_t& head = due ? dueHead_ : slots_[node.level][node.slot];
+
+        if (node.prev != Nil)
+            nodes_[node.prev].next = node.next;
+        else
+            head = node.next;
+
+        if (node.next != Nil)
+            nodes_[node.next].prev = node.prev;
+        else if (due)
+            dueTail_ = node.prev;
+
+        if (!due && head == Nil)
+            occupied_[node.level] &= ~(uint64_t(1) << node.slot);
+    }
+
+    void TimerWheel::appendDue(uint32_t index)
+    {
+        auto& node = nodes_[index];
+        node.level = DueLevel;
+        node.prev  = dueTail_;
+        node.next  = Nil;
+
+        if (dueTail_ != Nil)
+            nodes_[dueTail_].next = index;
+        else
+            dueHead_ = index;
+
+        dueTail_ = index;
+    }
+
+    void TimerWheel::release(uint32_t index)
+    {
+        auto& node    = nodes_[index];
+        node.callback = nullptr;
+        node.active   = false;
+
+        // Ids stay unique until the generation wraps around
+        if (++node.gen == 0)
+            node.gen = 1;
+
+        node.prev = Nil;
+        node.next = free_;
+        free_     = index;
+        --size_;
+    }
+
+    uint32_t TimerWheel::find(TimerId id) const
+    {
+        const auto index = static_cast<uint32_t>(id & 0xffffffff);
+        const auto gen   = static_cast<uint32_t>(id >> 32);
+
+        if (index >= nodes_.size())
+            return Nil;
+
+        const auto& node = nodes_[index];
+        if (!node.active || node.gen != gen)
+            return Nil;
+
+        return index;
+    }
+
+    std::optional<uint64_t> TimerWheel::nextEvent(size_t* level) const
+    {
+        for (size_t l = 0; l < Levels; ++l)
+        {
+            if (occupied_[l] == 0)
+                continue;
+
+            const size_t shift = l * SlotBits;
+            const size_t digit = (now_ >> shift) & (SlotCount - 1);
+
+            // The current slot of a level above the first was emptied when
+            // the wheel got to it
+            const size_t first = l == 0 ? digit : digit + 1;
+            if (first >= SlotCount)
+                continue;
+
+            const uint64_t pending = occupied_[l] & (~uint64_t(0) << first);
+            if (pending == 0)
+                continue;
+
+            // Start of the slot, in the span of the current slot of the
+            // level above
+            const size_t upper = shift + SlotBits;
+            const uint64_t base = upper >= 64 ? 0 : (now_ >> upper) << upper;
+
+            *level = l;
+            return base | (static_cast<uint64_t>(lowestBit(pending)) << shift);
+        }
+
+        return std::nullopt;
+    }
+
+    // Stops at the first slot found due, for its callbacks to run before the
+    // wheel moves on, so that they may still schedule timers due before tick
+    void TimerWheel::advanceTo(uint64_t tick)
+    {
+        for (;;)
+        {
+            size_t level;
+            auto event = nextEvent(&level);
+            if (!event || *event > tick)
+                break;
+
+            now_ = *event;
+
+            const size_t slot = (now_ >> (level * SlotBits)) & (SlotCount - 1);
+            uint32_t index    = slots_[level][slot];
+            slots_[level][slot] = Nil;
+            occupied_[level] &= ~(uint64_t(1) << slot);
+
+            while (index != Nil)
+            {
+                const uint32_t next = nodes_[index].next;
+
+                if (level == 0)
+                    appendDue(index);
+                else // Closer now, so down to a lower level
+                    link(index);
+
+                index = next;
+            }
+
+            if (level == 0)
+                return;
+        }
+
+        if (tick > now_)
+            now_ = tick;
+    }
+
+    void TimerWheel::rearm()
+    {
+        size_t level;
+        auto event        = nextEvent(&level);
+        const uint64_t tick = event ? *event : UINT64_MAX;
+        if (tick == armedTick_)
+            return;
+
+        armedTick_ = tick;
+
+        if (!event)
+        {
+#ifdef _USE_LIBEVENT
+            TRY(EventMethFns::setEmEventTime(timerFd_, nullptr));
+#else
+            itimerspec spec = {};
+            TRY(timerfd_settime(timerFd_, 0, &spec, nullptr));
+#endif
+            return;
+        }
+
+        auto delay = fromTick(tick) - Clock::now();
+
+#ifdef _USE_LIBEVENT
+        auto delayMs = std::chrono::ceil<std::chrono::milliseconds>(delay);
+        if (delayMs < std::chrono::milliseconds(1))
+            delayMs = std::chrono::milliseconds(1);
+
+        TRY(EventMethFns::setEmEventTime(timerFd_, &delayMs));
+#else
+        // A zero value would disarm the timer
+        auto delayNs = std::chrono::duration_cast<std::chrono::nanoseconds>(delay);
+        if (delayNs < std::chrono::nanoseconds(1))
+            delayNs = std::chrono::nanoseconds(1);
+
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(delayNs);
+
+        itimerspec spec;
+        spec.it_interval.tv_sec  = 0;
+        spec.it_interval.tv_nsec = 0;
+        spec.it_value.tv_sec     = static_cast<time_t>(secs.count());
+        spec.it_value.tv_nsec    = static_cast<long>((delayNs - secs).count());
+
+        TRY(timerfd_settime(timerFd_, 0, &spec, nullptr));
+#endif
+    }
+
+} // namespace Pistache
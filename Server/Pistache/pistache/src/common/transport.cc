@@ -42,12 +42,32 @@
 #include <sys/timerfd.h>
 #endif
 
+#ifndef _IS_WINDOWS
+#include <sys/socket.h>
+#include <sys/uio.h> // for iovec, IOV_MAX
+#ifndef IOV_MAX
+#define IOV_MAX 16 // the least POSIX allows
+#endif
+#endif
+
 #include <pistache/os.h>
 #include <pistache/peer.h>
 #include <pistache/tcp.h>
 #include <pistache/transport.h>
 #include <pistache/utils.h>
 
+#ifdef PISTACHE_USE_SSL
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#endif /* PISTACHE_USE_SSL */
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 using std::to_string;
 
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -60,6 +80,27 @@ namespace Pistache::Tcp
 {
     using namespace Polling;
 
+#ifdef PISTACHE_USE_SSL
+    namespace
+    {
+        std::string sslErrorsToString()
+        {
+            std::string res;
+            char buffer[256];
+
+            while (unsigned long err = ERR_get_error())
+            {
+                ERR_error_string_n(err, buffer, sizeof(buffer));
+                if (!res.empty())
+                    res += "; ";
+                res += buffer;
+            }
+
+            return res;
+        }
+    } // namespace
+#endif /* PISTACHE_USE_SSL */
+
     Transport::Transport(const std::shared_ptr<Tcp::Handler>& handler)
 #ifdef _USE_LIBEVENT_LIKE_APPLE
         : tcp_prot_num_(-1)
@@ -92,7 +133,19 @@ namespace Pistache::Tcp
 
     std::shared_ptr<Aio::Handler> Transport::clone() const
     {
-        return std::make_shared<Transport>(handler_->clone());
+        auto transport = std::make_shared<Transport>(handler_->clone());
+        transport->setSslHandshakeTimeout(sslHandshakeTimeout_);
+        return transport;
+    }
+
+    void Transport::setSslHandshakeTimeout(std::chrono::milliseconds timeout)
+    {
+        sslHandshakeTimeout_ = timeout;
+    }
+
+    std::chrono::milliseconds Transport::sslHandshakeTimeout() const
+    {
+        return sslHandshakeTimeout_;
     }
 
     void Transport::flush()
@@ -105,8 +158,9 @@ namespace Pistache::Tcp
         PS_TIMEDBG_START_THIS;
 
         writesQueue.bind(poller);
-        timersQueue.bind(poller);
+        timers_.bind(poller);
         peersQueue.bind(poller);
+        resumeQueue.bind(poller);
         notifier.bind(poller);
 
 #ifdef _USE_LIBEVENT
@@ -123,13 +177,19 @@ namespace Pistache::Tcp
 #endif
 
         notifier.unbind(poller);
+        resumeQueue.unbind(poller);
         peersQueue.unbind(poller);
-        timersQueue.unbind(poller);
+        timers_.unbind(poller);
         writesQueue.unbind(poller);
     }
 
     void Transport::handleNewPeer(const std::shared_ptr<Tcp::Peer>& peer)
     {
+        // Counted right away, rather than once the peer reaches the
+        // transport thread, so that a burst of dispatches sees it
+        activePeers_.fetch_add(1, std::memory_order_relaxed);
+        metrics_.connectionAccepted();
+
         auto ctx                   = context();
         const bool isInRightThread = std::this_thread::get_id() == ctx.thread();
 
@@ -194,6 +254,8 @@ namespace Pistache::Tcp
     {
         PS_LOG_DEBUG_ARGS("%d fds", fds.size());
 
+        const auto busyStart = std::chrono::steady_clock::now();
+
         for (const auto& entry : fds)
         {
             PS_LOG_DBG_FD_AND_NOTIFY;
@@ -203,21 +265,56 @@ namespace Pistache::Tcp
                 PS_LOG_DEBUG("Write queue");
                 handleWriteQueue();
             }
-            else if (entry.getTag() == timersQueue.tag())
+            else if (entry.getTag() == timers_.tag())
             {
-                PS_LOG_DEBUG("Timers queue");
-                handleTimerQueue();
+                PS_LOG_DEBUG("Timers");
+                timers_.handleReady();
             }
             else if (entry.getTag() == peersQueue.tag())
             {
                 PS_LOG_DEBUG("Peers queue");
                 handlePeerQueue();
             }
+            else if (entry.getTag() == resumeQueue.tag())
+            {
+                PS_LOG_DEBUG("Resume queue");
+                handleResumeQueue();
+            }
             else if (entry.getTag() == notifier.tag())
             {
                 PS_LOG_DEBUG("notifier");
                 handleNotify();
             }
+            else if (acceptFd_ != PS_FD_EMPTY && entry.getTag() == Polling::Tag(acceptFd_))
+            {
+                PS_LOG_DEBUG("Acceptor");
+                if (entry.isAccepted())
+                    handleAccepted(entry.transferred());
+                else
+                    handleAcceptor();
+            }
+            else if (isHandshakeFd(entry.getTag()))
+            {
+                auto tag        = entry.getTag();
+                FdConst fdconst = static_cast<FdConst>(tag.value());
+                auto peer       = handshakes_.at(PS_CAST_AWAY_CONST_FD(fdconst)).peer;
+
+                PS_LOG_DEBUG("driveHandshake");
+                driveHandshake(peer);
+            }
+            else if (entry.isReceived())
+            {
+                auto tag = entry.getTag();
+                if (isPeerFd(tag))
+                    handleReceived(getPeer(tag), entry.receivedData(), entry.transferred());
+                else
+                    PS_LOG_DEBUG("received, not a peer");
+            }
+            else if (entry.isSent())
+            {
+                FdConst fdconst = static_cast<FdConst>(entry.getTag().value());
+                handleSent(PS_CAST_AWAY_CONST_FD(fdconst), entry.transferred());
+            }
 
             else if (entry.isReadable())
             {
@@ -231,22 +328,9 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG("handleIncoming");
                     handleIncoming(peer);
                 }
-                else if (isTimerFd(tag))
-                {
-                    auto it      = timers.find(static_cast<decltype(timers)::key_type>(tag.value()));
-                    auto& entry_ = it->second;
-                    PS_LOG_DEBUG("handleTimer");
-                    handleTimer(std::move(entry_));
-                    PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erased from timers",
-                                      it->first);
-
-                    PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " erasing from timers",
-                                      it->first);
-                    timers.erase(it->first);
-                }
                 else
                 {
-                    PS_LOG_DEBUG("neither peer nor timer");
+                    PS_LOG_DEBUG("not a peer");
                 }
             }
             else if (entry.isWritable())
@@ -277,18 +361,64 @@ namespace Pistache::Tcp
                 asyncWriteImpl(fd);
             }
         }
+
+        recordBusy(std::chrono::steady_clock::now() - busyStart);
+    }
+
+    void Transport::recordBusy(std::chrono::nanoseconds elapsed)
+    {
+        // Only the transport thread writes these, so plain load/store is
+        // enough; the atomics are for the readers on other threads
+        const int64_t ns = elapsed.count();
+        busyNs_.store(busyNs_.load(std::memory_order_relaxed) + ns,
+                      std::memory_order_relaxed);
+
+        // Exponential moving average, alpha = 1/8
+        const int64_t recent = recentBusyNs_.load(std::memory_order_relaxed);
+        recentBusyNs_.store(recent + (ns - recent) / 8, std::memory_order_relaxed);
+    }
+
+    size_t Transport::activePeers() const
+    {
+        return activePeers_.load(std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds Transport::busyTime() const
+    {
+        return std::chrono::nanoseconds(busyNs_.load(std::memory_order_relaxed));
+    }
+
+    std::chrono::nanoseconds Transport::recentBusyTime() const
+    {
+        return std::chrono::nanoseconds(recentBusyNs_.load(std::memory_order_relaxed));
+    }
+
+    Metrics::Worker Transport::metricsSnapshot()
+    {
+        auto worker              = metrics_.snapshot();
+        worker.activeConnections = activePeers();
+
+        Guard guard(toWriteLock);
+        for (const auto& [fd, wq] : toWrite)
+            worker.writeQueueDepth += wq.size();
+        for (const auto& [fd, wq] : sending_)
+            worker.writeQueueDepth += wq.size();
+
+        return worker;
     }
 
     void Transport::disarmTimer(Fd fd)
     {
         PS_TIMEDBG_START_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
-        auto it = timers.find(fd);
-        if (it == std::end(timers))
+        Guard guard(fdTimersLock);
+
+        auto it = fdTimers.find(fd);
+        if (it == std::end(fdTimers))
             throw std::runtime_error("Timer has not been armed");
 
-        auto& entry = it->second;
-        entry.disable();
+        timers_.cancel(it->second);
+        fdTimers.erase(it);
     }
 
     void Transport::handleIncoming(const std::shared_ptr<Peer>& peer)
@@ -299,19 +429,49 @@ namespace Pistache::Tcp
             return;
         }
 
-        char buffer[Const::MaxBuffer] = { 0 };
-
-        PST_SSIZE_T totalBytes = 0;
-        em_socket_t fdactual   = peer->actualFd();
+        em_socket_t fdactual = peer->actualFd();
         if (fdactual < 0)
         {
             PS_LOG_DEBUG_ARGS("Peer %p has no actual Fd", peer.get());
             return;
         }
 
+        if (!peer->heldInput_.empty())
+        {
+            // Received before the peer stalled, so ahead of what is read
+            std::string held;
+            held.swap(peer->heldInput_);
+            feedInput(peer, held.data(), held.size());
+            if (!peer->heldInput_.empty())
+                return;
+        }
+
+        // Read straight into the peer's own buffer, which is kept from one
+        // read to the next, rather than into a fresh stack buffer the
+        // handler would then have to copy from
+        auto& input = peer->inputBuffer();
+
         for (;;)
         {
+            size_t room = input.prepare(1);
+            if (room == 0)
+            {
+                // Only a handler retaining its input lets the buffer fill
+                // up. Give it a chance to make room, e.g. by refusing an
+                // oversized request; if it does not, stop reading until it
+                // resumes its input.
+                handler_->onInput(nullptr, 0, peer);
+
+                room = input.prepare(1);
+                if (room == 0)
+                {
+                    PS_LOG_DEBUG_ARGS("Input of peer %p stalled", peer.get());
+                    peer->inputStalled_ = true;
+                    break;
+                }
+            }
 
+            char* buffer = input.writePtr();
             PST_SSIZE_T bytes;
 
 #ifdef PISTACHE_USE_SSL
@@ -319,38 +479,29 @@ namespace Pistache::Tcp
             {
                 PS_LOG_DEBUG("SSL_read");
 
-                bytes = SSL_read(reinterpret_cast<SSL*>(peer->ssl()),
-                                 buffer + totalBytes,
-                                 static_cast<int>(Const::MaxBuffer - totalBytes));
+                bytes = SSL_read(reinterpret_cast<SSL*>(peer->ssl()), buffer,
+                                 static_cast<int>(std::min<size_t>(room, INT_MAX)));
             }
             else
             {
 #endif /* PISTACHE_USE_SSL */
                 PS_LOG_DEBUG("recv (read)");
-                bytes = PST_SOCK_READ(fdactual, buffer + totalBytes,
-                                      Const::MaxBuffer - totalBytes);
+                bytes = PST_SOCK_READ(fdactual, buffer, room);
 #ifdef PISTACHE_USE_SSL
             }
 #endif /* PISTACHE_USE_SSL */
 
             PST_DBG_DECL_SE_ERR_P_EXTRA;
             PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
-                                                               "bytes read %d, totalBytes %d, "
+                                                               "bytes read %d, "
                                                                "err %d %s",
-                              peer->fd(), bytes, totalBytes,
+                              peer->fd(), bytes,
                               (bytes < 0) ? errno : 0,
                               (bytes < 0) ? (PST_STRERROR_R_ERRNO) : "");
 
             if (bytes == -1)
             {
-                if (errno == EAGAIN || errno == EWOULDBLOCK)
-                {
-                    if (totalBytes > 0)
-                    {
-                        handler_->onInput(buffer, totalBytes, peer);
-                    }
-                }
-                else
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
                 {
                     handlePeerDisconnection(peer);
                 }
@@ -364,8 +515,88 @@ namespace Pistache::Tcp
 
             else
             {
-                handler_->onInput(buffer, bytes, peer);
+                input.commit(static_cast<size_t>(bytes));
+                metrics_.bytesRead(static_cast<size_t>(bytes));
+                peer->touch();
+                handler_->onInput(buffer, static_cast<size_t>(bytes), peer);
+
+                if (!peer->isInputRetained())
+                    input.reset();
+            }
+        }
+    }
+
+    void Transport::handleReceived(const std::shared_ptr<Peer>& peer,
+                                   const char* data, int64_t result)
+    {
+        if (result <= 0)
+        {
+            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", end of input (%d)",
+                              peer->fd(), static_cast<int>(result));
+
+            // A stalled peer is read from once resumed, when the end of the
+            // stream, or the error, is come across again
+            if (!peer->inputStalled_)
+                handlePeerDisconnection(peer);
+            return;
+        }
+
+        const auto size = static_cast<size_t>(result);
+        metrics_.bytesRead(size);
+        peer->touch();
+
+        // Still received for a while after the peer stalled
+        if (peer->inputStalled_ || !peer->heldInput_.empty())
+        {
+            peer->heldInput_.append(data, size);
+            return;
+        }
+
+        feedInput(peer, data, size);
+    }
+
+    void Transport::feedInput(const std::shared_ptr<Peer>& peer, const char* data,
+                              size_t size)
+    {
+        auto& input = peer->inputBuffer();
+
+        while (size > 0 && peer->fd() != PS_FD_EMPTY)
+        {
+            size_t room = input.prepare(size);
+            if (room == 0)
+            {
+                // As when reading, see handleIncoming
+                handler_->onInput(nullptr, 0, peer);
+
+                room = input.prepare(size);
+                if (room == 0)
+                {
+                    PS_LOG_DEBUG_ARGS("Input of peer %p stalled", peer.get());
+                    peer->inputStalled_ = true;
+                    peer->heldInput_.append(data, size);
+
+                    // Nothing more is to be received until the input
+                    // resumes: the peer is then read from instead
+                    if (peer->inputReceived_)
+                    {
+                        peer->inputReceived_ = false;
+                        reactor()->modifyFd(key(), peer->fd(), NotifyOn::Read, Polling::Mode::Edge);
+                    }
+                    return;
+                }
             }
+
+            const size_t len = std::min(room, size);
+            char* buffer     = input.writePtr();
+            std::memcpy(buffer, data, len);
+            input.commit(len);
+            handler_->onInput(buffer, len, peer);
+
+            if (!peer->isInputRetained())
+                input.reset();
+
+            data += len;
+            size -= len;
         }
     }
 
@@ -396,6 +627,7 @@ namespace Pistache::Tcp
             else
             {
                 peers_.erase(it);
+                activePeers_.fetch_sub(1, std::memory_order_relaxed);
             }
         }
 
@@ -420,16 +652,39 @@ namespace Pistache::Tcp
             return;
         }
 
-        Guard guard(toWriteLock);
-        toWrite.erase(fd); // Clean up write buffers
+        std::vector<Async::Deferred<PST_SSIZE_T>> dropped;
+        {
+            Guard guard(toWriteLock);
+
+            // Clean up write buffers. The poller holds on to what it is
+            // still sending, if anything.
+            for (auto* queues : { &toWrite, &sending_ })
+            {
+                auto it = queues->find(fd);
+                if (it == std::end(*queues))
+                    continue;
 
-        CLOSE_FD(fd);
+                takeWrites(it->second, dropped);
+                queues->erase(it);
+            }
+
+            CLOSE_FD(fd);
+        }
+
+        rejectWrites(dropped, ECONNABORTED);
     }
 
     void Transport::removeAllPeers()
     {
         PS_TIMEDBG_START_THIS;
 
+        while (!handshakes_.empty())
+        {
+            // abortHandshake erases the entry, hence the copy
+            auto peer = handshakes_.begin()->second.peer;
+            abortHandshake(peer);
+        }
+
         for (;;)
         {
             std::shared_ptr<Peer> peer;
@@ -444,6 +699,7 @@ namespace Pistache::Tcp
                 if (!peer)
                 {
                     peers_.erase(it);
+                    activePeers_.fetch_sub(1, std::memory_order_relaxed);
                     PS_LOG_DEBUG("peer NULL");
                     continue;
                 }
@@ -451,6 +707,90 @@ namespace Pistache::Tcp
 
             removePeer(peer); // removePeer locks mutex, erases peer from peers_
         }
+
+        // Counted when handed over, but never reached the transport thread
+        for (;;)
+        {
+            auto entry = peersQueue.popSafe();
+            if (!entry)
+                break;
+
+            activePeers_.fetch_sub(1, std::memory_order_relaxed);
+            if (entry->peer)
+            {
+                // Has its write queue dropped along with the fd
+                entry->peer->associateTransport(this);
+                entry->peer->closeFd();
+            }
+        }
+    }
+
+    template <typename Buf>
+    Async::Promise<PST_SSIZE_T> Transport::asyncWriteQueued(const std::shared_ptr<Peer>& peer,
+                                                            const Buf& buffer, int flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                                            ,
+                                                            bool msg_more_style
+#endif
+    )
+    {
+        // Counted before the write is queued, as it may complete right away
+        const size_t size = buffer.size();
+        peer->addQueued(size);
+
+        std::weak_ptr<Peer> weak(peer);
+        auto release = [weak, size]() {
+            if (auto queuedFor = weak.lock())
+                queuedFor->removeQueued(size);
+        };
+
+        return asyncWrite(peer->fd(), buffer, flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                          ,
+                          msg_more_style
+#endif
+                          )
+            .then(
+                [release](PST_SSIZE_T written) {
+                    release();
+                    return written;
+                },
+                [release](std::exception_ptr exc) {
+                    release();
+                    Async::Throw(exc);
+                });
+    }
+
+    Async::Promise<PST_SSIZE_T> Transport::asyncWrite(const std::shared_ptr<Peer>& peer,
+                                                      const RawBuffer& buffer, int flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                                      ,
+                                                      bool msg_more_style
+#endif
+    )
+    {
+        return asyncWriteQueued(peer, buffer, flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                ,
+                                msg_more_style
+#endif
+        );
+    }
+
+    Async::Promise<PST_SSIZE_T> Transport::asyncWrite(const std::shared_ptr<Peer>& peer,
+                                                      const FileBuffer& buffer, int flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                                      ,
+                                                      bool msg_more_style
+#endif
+    )
+    {
+        return asyncWriteQueued(peer, buffer, flags
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+                                ,
+                                msg_more_style
+#endif
+        );
     }
 
     void Transport::asyncWriteImpl(Fd fd)
@@ -458,10 +798,18 @@ namespace Pistache::Tcp
         PS_TIMEDBG_START_THIS;
 
         bool stop = false;
+
         while (!stop)
         {
             std::unique_lock<std::mutex> lock(toWriteLock);
 
+            // Carried on with once the poller reports what it sent
+            if (sending_.find(fd) != std::end(sending_))
+            {
+                PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " being sent to", fd);
+                return;
+            }
+
             auto it = toWrite.find(fd);
 
             // cleanup will have been handled by handlePeerDisconnection
@@ -482,21 +830,85 @@ namespace Pistache::Tcp
 #ifdef _USE_LIBEVENT_LIKE_APPLE
             bool msg_more_style = entry.msg_more_style;
 #endif
-            BufferHolder& buffer                  = entry.buffer;
-            Async::Deferred<PST_SSIZE_T> deferred = std::move(entry.deferred);
+            BufferHolder& buffer = entry.buffer;
 
             auto cleanUp = [&]() {
                 wq.pop_front();
                 if (wq.empty())
                 {
+                    // The fd is only polled for writability after a write
+                    // would have blocked, and stops being as soon as it is
+                    // reported writable
                     PS_LOG_DEBUG_ARGS("Erasing fd %" PIST_QUOTE(PS_FD_PRNTFCD) " from toWrite", fd);
                     toWrite.erase(fd);
-                    reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
                     stop = true;
                 }
                 lock.unlock();
             };
 
+#ifndef _IS_WINDOWS
+            if (submitSend(fd, wq))
+            {
+                if (wq.empty())
+                    toWrite.erase(it);
+                break;
+            }
+
+            if (wq.size() > 1)
+            {
+                // Several responses, or parts of one, are waiting: have
+                // them go out with a single call
+                const PST_SSIZE_T bytesWritten = sendGathered(fd, wq);
+                if (bytesWritten > 0)
+                {
+                    metrics_.bytesWritten(static_cast<size_t>(bytesWritten));
+                    touchPeer(fd);
+
+                    // The entries covered are all accounted for before any
+                    // promise is resolved, as a continuation may well queue
+                    // and write more to this fd from within
+                    std::vector<std::pair<Async::Deferred<PST_SSIZE_T>, size_t>> written;
+                    auto left = static_cast<size_t>(bytesWritten);
+                    while (left > 0)
+                    {
+                        auto& front         = wq.front();
+                        const size_t size   = front.buffer.size();
+                        const size_t unsent = size - front.buffer.offset();
+                        if (left < unsent)
+                        {
+                            front.buffer.setOffset(front.buffer.offset() + left);
+                            break;
+                        }
+
+                        left -= unsent;
+                        written.emplace_back(std::move(front.deferred), size);
+                        wq.pop_front();
+                    }
+
+                    if (wq.empty())
+                    {
+                        toWrite.erase(fd);
+                        stop = true;
+                    }
+                    lock.unlock();
+
+                    for (auto& [deferred, size] : written)
+                        deferred.resolve(static_cast<PST_SSIZE_T>(size));
+                    continue;
+                }
+                if (bytesWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
+                                        Polling::Mode::Edge);
+                    break;
+                }
+                // Otherwise, the buffers are written one at a time below,
+                // which also deals with any error
+            }
+#endif
+
+            Async::Deferred<PST_SSIZE_T> deferred = std::move(entry.deferred);
+
             size_t totalWritten = buffer.offset();
             for (;;)
             {
@@ -508,7 +920,7 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG_ARGS("sendRawBuffer fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", len %d",
                                       fd, len);
 
-                    auto raw        = buffer.raw();
+                    const auto& raw = buffer.raw();
                     const auto* ptr = raw.data().c_str() + totalWritten;
                     bytesWritten    = sendRawBuffer(fd, ptr, len, flags
 #ifdef _USE_LIBEVENT_LIKE_APPLE
@@ -522,9 +934,9 @@ namespace Pistache::Tcp
                     PS_LOG_DEBUG_ARGS("sendFile fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", len %d",
                                       fd, len);
 
-                    auto file    = buffer.fd();
-                    off_t offset = static_cast<off_t>(totalWritten);
-                    bytesWritten = sendFile(fd, file, offset, len);
+                    const auto& file = buffer.file();
+                    off_t offset     = file.offset() + static_cast<off_t>(totalWritten);
+                    bytesWritten     = sendFile(fd, file.fd(), offset, len);
                 }
                 if (bytesWritten < 0)
                 {
@@ -534,18 +946,10 @@ namespace Pistache::Tcp
 
                     if (errno == EAGAIN || errno == EWOULDBLOCK)
                     {
-                        auto bufferHolder = buffer.detach(static_cast<off_t>(totalWritten));
-
-                        // pop_front kills buffer - so we cannot continue loop or use buffer
-                        // after this point
-                        wq.pop_front();
-                        wq.push_front(WriteEntry(std::move(deferred),
-                                                 bufferHolder, fd, flags
-#ifdef _USE_LIBEVENT_LIKE_APPLE
-                                                 ,
-                                                 msg_more_style
-#endif
-                                                 ));
+                        // Picked up from where it stopped once the fd is
+                        // writable again
+                        buffer.setOffset(totalWritten);
+                        entry.deferred = std::move(deferred);
                         reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
                                             Polling::Mode::Edge);
                         stop = true;
@@ -557,9 +961,18 @@ namespace Pistache::Tcp
                     {
                         PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) " EBADF/EPIPE/ECONNRESET so erasing",
                                           fd);
+                        const int error = errno;
+
+                        // Nor will anything queued after it be written
+                        std::vector<Async::Deferred<PST_SSIZE_T>> dropped;
+                        dropped.push_back(std::move(deferred));
                         wq.pop_front();
+                        takeWrites(wq, dropped);
                         toWrite.erase(fd);
+                        lock.unlock();
                         stop = true;
+
+                        rejectWrites(dropped, error);
                     }
                     else
                     {
@@ -571,20 +984,11 @@ namespace Pistache::Tcp
                 }
                 else
                 {
+                    metrics_.bytesWritten(static_cast<size_t>(bytesWritten));
+                    touchPeer(fd);
                     totalWritten += bytesWritten;
                     if (totalWritten >= buffer.size())
                     {
-                        if (buffer.isFile())
-                        {
-                            PS_LOG_DEBUG_ARGS("file ::close actual_fd %d",
-                                              buffer.fd());
-
-                            // done with the file buffer, nothing else knows
-                            // whether to close it with the way the code is
-                            // written.
-                            PST_FILE_CLOSE(buffer.fd());
-                        }
-
                         cleanUp();
 
                         // Cast to match the type of defered template
@@ -597,47 +1001,267 @@ namespace Pistache::Tcp
         }
     }
 
-#ifdef _USE_LIBEVENT_LIKE_APPLE
-    void Transport::configureMsgMoreStyle(Fd fd, bool msg_more_style)
+#ifndef _IS_WINDOWS
+    PST_SSIZE_T Transport::sendGathered(Fd fd, const std::deque<WriteEntry>& wq)
     {
-        // PS_USE_TCP_NODELAY defined (or not) at top of file
-
-        int tcp_no_push  = 0;
-        socklen_t len    = sizeof(tcp_no_push);
-        int sock_opt_res = -1;
+#ifdef PISTACHE_USE_SSL
+        {
+            // See comment in transport.h on why peers_ must be mutex-protected
+            std::lock_guard<std::mutex> l_guard(peers_mutex_);
 
-#ifdef PS_USE_TCP_NODELAY
-        { // encapsulate
-            PST_SOCK_OPT_VAL_T tcp_nodelay = 0;
-            sock_opt_res                   = getsockopt(GET_ACTUAL_FD(fd), tcp_prot_num_,
-                                                        TCP_NODELAY, &tcp_nodelay, &len);
-            if (sock_opt_res == 0)
-                tcp_no_push = !tcp_nodelay;
+            // TLS records are written one buffer at a time
+            auto it = peers_.find(fd);
+            if (it == std::end(peers_) || it->second->ssl() != nullptr)
+                return 0;
         }
-#else
-        sock_opt_res = getsockopt(GET_ACTUAL_FD(fd), tcp_prot_num_,
-#if defined __APPLE__ || defined _IS_BSD
-                                  TCP_NOPUSH,
-#else
-                                  TCP_CORK,
-#endif
-                                  &tcp_no_push, &len);
-#endif // of if defined(__NetBSD__) || defined(_IS_WINDOWS) ... else
+#endif /* PISTACHE_USE_SSL */
 
-        if (sock_opt_res == 0)
+        struct iovec iov[IOV_MAX];
+        int iovcnt = 0;
+
+        const int flags = wq.front().flags;
+        for (const auto& entry : wq)
         {
-            if (((tcp_no_push == 0) && (msg_more_style)) || ((tcp_no_push != 0) && (!msg_more_style)))
-            {
-                PS_LOG_DEBUG_ARGS("Setting MSG_MORE style to %s",
-                                  (msg_more_style) ? "on" : "off");
+            if (iovcnt == IOV_MAX || !entry.buffer.isRaw() || entry.flags != flags)
+                break;
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+            // Those toggle the socket options around their own send
+            if (entry.msg_more_style)
+                break;
+#endif
 
-                PST_SOCK_OPT_VAL_T optval =
-#ifdef PS_USE_TCP_NODELAY
-                    // In NetBSD case we're getting/setting (or resetting) the
-                    // TCP_NODELAY socket option, which _stops_ data being held
-                    // prior to send, whereas in Linux, macOS, FreeBSD or
-                    // OpenBSD we're using TCP_CORK/TCP_NOPUSH which may
-                    // _cause_ data to be held prior to send. I.e. they're
+            const auto& data      = entry.buffer.raw().data();
+            const size_t offset   = entry.buffer.offset();
+            iov[iovcnt].iov_base  = const_cast<char*>(data.data()) + offset;
+            iov[iovcnt].iov_len   = entry.buffer.size() - offset;
+            ++iovcnt;
+        }
+
+        if (iovcnt < 2)
+            return 0;
+
+        struct msghdr msg = {};
+        msg.msg_iov       = iov;
+        msg.msg_iovlen    = iovcnt;
+
+        PS_LOG_DEBUG_ARGS("::sendmsg, fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", %d buffers",
+                          fd, iovcnt);
+
+        // MSG_NOSIGNAL is used to prevent SIGPIPE on client connection
+        // termination
+        const auto bytesWritten = ::sendmsg(GET_ACTUAL_FD(fd), &msg, flags | MSG_NOSIGNAL);
+
+        PS_LOG_DEBUG_ARGS("bytesWritten = %d", bytesWritten);
+
+        return static_cast<PST_SSIZE_T>(bytesWritten);
+    }
+#endif
+
+#ifndef _IS_WINDOWS
+    bool Transport::submitSend(Fd fd, std::deque<WriteEntry>& wq)
+    {
+        // Only the transport thread tells the sends of a fd apart from
+        // those to a peer it had before, as it handles what was sent in order
+        Aio::Reactor* r = reactor();
+        if (!r || std::this_thread::get_id() != context().thread())
+            return false;
+
+        {
+            // See comment in transport.h on why peers_ must be mutex-protected
+            std::lock_guard<std::mutex> l_guard(peers_mutex_);
+
+            // TLS records are written by OpenSSL
+            auto it = peers_.find(fd);
+            if (it == std::end(peers_) || it->second->ssl() != nullptr)
+                return false;
+        }
+
+        std::vector<Polling::SendBuffer> buffers;
+        auto hold = std::make_shared<std::vector<RawBuffer>>();
+
+        // As sendGathered does
+        const int flags = wq.front().flags;
+        for (const auto& entry : wq)
+        {
+            if (buffers.size() == IOV_MAX || !entry.buffer.isRaw() || entry.flags != flags)
+                break;
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+            if (entry.msg_more_style)
+                break;
+#endif
+
+            const auto& raw     = entry.buffer.raw();
+            const size_t offset = entry.buffer.offset();
+            buffers.push_back({ raw.data().data() + offset, entry.buffer.size() - offset });
+            hold->push_back(raw);
+        }
+
+        if (buffers.empty())
+            return false;
+
+        PS_LOG_DEBUG_ARGS("Sending %d buffers to fd %" PIST_QUOTE(PS_FD_PRNTFCD),
+                          static_cast<int>(buffers.size()), fd);
+
+        // MSG_NOSIGNAL is used to prevent SIGPIPE on client connection
+        // termination
+        if (!r->send(key(), fd, buffers, flags | MSG_NOSIGNAL, std::move(hold)))
+            return false;
+
+        auto& sending = sending_[fd];
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            sending.push_back(std::move(wq.front()));
+            wq.pop_front();
+        }
+        return true;
+    }
+#endif
+
+    void Transport::handleSent(Fd fd, int64_t result)
+    {
+        PS_LOG_DEBUG_ARGS("fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", sent %d",
+                          fd, static_cast<int>(result));
+
+        std::vector<std::pair<Async::Deferred<PST_SSIZE_T>, size_t>> written;
+        std::vector<Async::Deferred<PST_SSIZE_T>> failed;
+        {
+            Guard guard(toWriteLock);
+
+            // Unless the peer went away meanwhile
+            auto it = sending_.find(fd);
+            if (it == std::end(sending_))
+                return;
+
+            auto sent = std::move(it->second);
+            sending_.erase(it);
+
+            if (result < 0)
+            {
+                takeWrites(sent, failed);
+
+                // As when writing, see asyncWriteImpl: nothing more is to be
+                // written to the fd
+                const int error = static_cast<int>(-result);
+                if (error == EBADF || error == EPIPE || error == ECONNRESET || error == ECANCELED)
+                {
+                    auto it = toWrite.find(fd);
+                    if (it != std::end(toWrite))
+                    {
+                        takeWrites(it->second, failed);
+                        toWrite.erase(it);
+                    }
+                }
+            }
+            else
+            {
+                metrics_.bytesWritten(static_cast<size_t>(result));
+                touchPeer(fd);
+
+                auto left = static_cast<size_t>(result);
+                while (!sent.empty())
+                {
+                    auto& front         = sent.front();
+                    const size_t size   = front.buffer.size();
+                    const size_t unsent = size - front.buffer.offset();
+                    if (left < unsent)
+                    {
+                        front.buffer.setOffset(front.buffer.offset() + left);
+                        break;
+                    }
+
+                    left -= unsent;
+                    written.emplace_back(std::move(front.deferred), size);
+                    sent.pop_front();
+                }
+
+                // What is left goes out ahead of what was queued since
+                if (!sent.empty())
+                {
+                    auto& wq = toWrite[fd];
+                    wq.insert(wq.begin(), std::make_move_iterator(sent.begin()),
+                              std::make_move_iterator(sent.end()));
+                }
+            }
+        }
+
+        for (auto& [deferred, size] : written)
+            deferred.resolve(static_cast<PST_SSIZE_T>(size));
+
+        rejectWrites(failed, static_cast<int>(-result));
+
+        asyncWriteImpl(fd);
+    }
+
+    void Transport::touchPeer(Fd fd)
+    {
+        // See comment in transport.h on why peers_ must be mutex-protected
+        std::lock_guard<std::mutex> l_guard(peers_mutex_);
+
+        auto it = peers_.find(fd);
+        if (it != std::end(peers_))
+            it->second->touch();
+    }
+
+    void Transport::takeWrites(std::deque<WriteEntry>& wq,
+                               std::vector<Async::Deferred<PST_SSIZE_T>>& deferreds)
+    {
+        for (auto& entry : wq)
+            deferreds.push_back(std::move(entry.deferred));
+        wq.clear();
+    }
+
+    void Transport::rejectWrites(std::vector<Async::Deferred<PST_SSIZE_T>>& deferreds,
+                                 int error)
+    {
+        for (auto& deferred : deferreds)
+        {
+            errno = error;
+            deferred.reject(Pistache::Error::system("Could not write data"));
+        }
+        deferreds.clear();
+    }
+
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+    void Transport::configureMsgMoreStyle(Fd fd, bool msg_more_style)
+    {
+        // PS_USE_TCP_NODELAY defined (or not) at top of file
+
+        int tcp_no_push  = 0;
+        socklen_t len    = sizeof(tcp_no_push);
+        int sock_opt_res = -1;
+
+#ifdef PS_USE_TCP_NODELAY
+        { // encapsulate
+            PST_SOCK_OPT_VAL_T tcp_nodelay = 0;
+            sock_opt_res                   = getsockopt(GET_ACTUAL_FD(fd), tcp_prot_num_,
+                                                        TCP_NODELAY, &tcp_nodelay, &len);
+            if (sock_opt_res == 0)
+                tcp_no_push = !tcp_nodelay;
+        }
+#else
+        sock_opt_res = getsockopt(GET_ACTUAL_FD(fd), tcp_prot_num_,
+#if defined __APPLE__ || defined _IS_BSD
+                                  TCP_NOPUSH,
+#else
+                                  TCP_CORK,
+#endif
+                                  &tcp_no_push, &len);
+#endif // of if defined(__NetBSD__) || defined(_IS_WINDOWS) ... else
+
+        if (sock_opt_res == 0)
+        {
+            if (((tcp_no_push == 0) && (msg_more_style)) || ((tcp_no_push != 0) && (!msg_more_style)))
+            {
+                PS_LOG_DEBUG_ARGS("Setting MSG_MORE style to %s",
+                                  (msg_more_style) ? "on" : "off");
+
+                PST_SOCK_OPT_VAL_T optval =
+#ifdef PS_USE_TCP_NODELAY
+                    // In NetBSD case we're getting/setting (or resetting) the
+                    // TCP_NODELAY socket option, which _stops_ data being held
+                    // prior to send, whereas in Linux, macOS, FreeBSD or
+                    // OpenBSD we're using TCP_CORK/TCP_NOPUSH which may
+                    // _cause_ data to be held prior to send. I.e. they're
                     // opposites.
                     msg_more_style ? 0 : 1;
 #else
@@ -877,94 +1501,48 @@ namespace Pistache::Tcp
     {
         PS_TIMEDBG_START_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD), fd);
 
-        auto ctx                   = context();
-        const bool isInRightThread = std::this_thread::get_id() == ctx.thread();
-        TimerEntry entry(fd, value, std::move(deferred));
+        Guard guard(fdTimersLock);
 
-        if (!isInRightThread)
+        auto it = fdTimers.find(fd);
+        if (it != std::end(fdTimers) && timers_.isScheduled(it->second))
         {
-            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", timersQueue.push",
-                              fd);
-            timersQueue.push(std::move(entry));
-        }
-        else
-        {
-            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", armTimerMsImpl",
-                              fd);
-            armTimerMsImpl(std::move(entry));
-        }
-    }
-
-    void Transport::armTimerMsImpl(TimerEntry entry)
-    {
-#ifdef DEBUG
-        Fd entry_fd = entry.fd;
-
-#ifdef _USE_LIBEVENT
-        PS_LOG_DEBUG_ARGS("entry.fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
-                                                                 "fd->type %d",
-                          entry_fd,
-                          EventMethFns::getEmEventType(entry_fd));
-#else
-        PS_LOG_DEBUG_ARGS("entry.fd %" PIST_QUOTE(PS_FD_PRNTFCD),
-                          entry_fd);
-#endif
+            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) " timer already armed", fd);
 
-#endif
-
-        auto it = timers.find(entry.fd);
-        if (it != std::end(timers))
-        {
-            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD),
-                              "timer already armed",
-                              entry.fd);
-
-            entry.deferred.reject(std::runtime_error("Timer is already armed"));
+            deferred.reject(std::runtime_error("Timer is already armed"));
             return;
         }
 
-        int res = -1;
-#ifdef _USE_LIBEVENT
-        assert(entry.fd != PS_FD_EMPTY);
-        res = EventMethFns::setEmEventTime(entry.fd, &(entry.value));
-#else
-        itimerspec spec;
-        spec.it_interval.tv_sec  = 0;
-        spec.it_interval.tv_nsec = 0;
-
-        if (entry.value.count() < 1000)
-        {
-            spec.it_value.tv_sec  = 0;
-            spec.it_value.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(entry.value)
-                                        .count();
-        }
-        else
-        {
-            spec.it_value.tv_sec  = std::chrono::duration_cast<std::chrono::seconds>(entry.value).count();
-            spec.it_value.tv_nsec = 0;
-        }
+        // A Deferred can only be moved, which std::function does not allow
+        auto shared = std::make_shared<Async::Deferred<uint64_t>>(std::move(deferred));
 
-        res = timerfd_settime(entry.fd, 0, &spec, nullptr);
-#endif
-        if (res == -1)
-        {
-            PST_DBG_DECL_SE_ERR_P_EXTRA;
-            PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", ernno %d %s",
-                              entry.fd, errno, PST_STRERROR_R_ERRNO);
-
-            entry.deferred.reject(Pistache::Error::system("Could not set timer time"));
-            return;
-        }
+        fdTimers[fd] = timers_.schedule(value, [this, fd, shared]() {
+            {
+                Guard guard(fdTimersLock);
 
-        reactor()->registerFdOneShot(key(), entry.fd, NotifyOn::Read,
-                                     Polling::Mode::Edge);
+                // The fd may have been disarmed, then armed again, in the
+                // meantime
+                auto it = fdTimers.find(fd);
+                if (it != std::end(fdTimers) && !timers_.isScheduled(it->second))
+                    fdTimers.erase(it);
+            }
 
-        PS_LOG_DEBUG_ARGS("Timer %" PIST_QUOTE(PS_FD_PRNTFCD) " inserting into timers", entry.fd);
-        timers.insert(std::make_pair(entry.fd, std::move(entry)));
+            shared->resolve(static_cast<uint64_t>(1));
+        });
     }
 
     void Transport::handleWriteQueue(bool flush)
     {
+        // The fds written to are only written once the queue is drained, so
+        // that what was queued for each of them goes out together
+        std::array<Fd, 16> fds;
+        size_t fdCount = 0;
+
+        auto writeFds = [&]() {
+            for (size_t i = 0; i < fdCount; ++i)
+                asyncWriteImpl(fds[i]);
+            fdCount = 0;
+        };
+
         // Let's drain the queue
         for (;;)
         {
@@ -972,52 +1550,97 @@ namespace Pistache::Tcp
             if (!write)
                 break;
 
+            // The peer may have gone away since
             auto fd = write->peerFd;
-            if (fd == PS_FD_EMPTY)
-                continue;
-            if (!isPeerFd(fd))
+            if (fd == PS_FD_EMPTY || !isPeerFd(fd))
+            {
+                errno = ECONNABORTED;
+                write->deferred.reject(Pistache::Error::system("Could not write data"));
                 continue;
+            }
 
+            bool pending;
             {
                 Guard guard(toWriteLock);
-                toWrite[fd].push_back(std::move(*write));
+                auto& wq = toWrite[fd];
+
+                // Writes already pending for a fd are waiting for it to be
+                // writable again, which the reactor tells
+                pending = !wq.empty();
+                wq.push_back(std::move(*write));
             }
 
+            if (pending && !flush)
+                continue;
 
-            if (flush)
-                asyncWriteImpl(fd);
-            else
-                reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
-                                    Polling::Mode::Edge);
+            if (std::find(fds.begin(), fds.begin() + fdCount, fd) != fds.begin() + fdCount)
+                continue;
+
+            if (fdCount == fds.size())
+                writeFds();
+            fds[fdCount++] = fd;
         }
+
+        writeFds();
     }
 
-    void Transport::handleTimerQueue()
+    void Transport::handlePeerQueue()
     {
         PS_TIMEDBG_START_THIS;
 
         for (;;)
         {
-            auto timer = timersQueue.popSafe();
-            if (!timer)
+            auto data = peersQueue.popSafe();
+            PS_LOG_DEBUG_ARGS("data %p", data.get());
+            if (!data)
                 break;
 
-            armTimerMsImpl(std::move(*timer));
+            handlePeer(data->peer);
         }
     }
 
-    void Transport::handlePeerQueue()
+    void Transport::resumeInput(const std::shared_ptr<Peer>& peer)
+    {
+        // Always queued, even from the transport thread, as the handler is
+        // typically still in onInput for this peer at that point
+        PeerEntry entry(peer);
+        resumeQueue.push(std::move(entry));
+    }
+
+    void Transport::handleResumeQueue()
     {
         PS_TIMEDBG_START_THIS;
 
         for (;;)
         {
-            auto data = peersQueue.popSafe();
-            PS_LOG_DEBUG_ARGS("data %p", data.get());
+            auto data = resumeQueue.popSafe();
             if (!data)
                 break;
 
-            handlePeer(data->peer);
+            const auto& peer = data->peer;
+            Fd fd            = peer->fd();
+            if (fd == PS_FD_EMPTY)
+            {
+                PS_LOG_DEBUG("Peer closed before its input was resumed");
+                continue;
+            }
+
+            { // The peer may have been removed, and its fd reused, meanwhile
+                std::lock_guard<std::mutex> l_guard(peers_mutex_);
+                auto it = peers_.find(fd);
+                if (it == std::end(peers_) || it->second != peer)
+                    continue;
+            }
+
+            handler_->onInput(nullptr, 0, peer);
+
+            // Reading stopped for lack of room: with edge-triggered polling,
+            // no new event would come for what is left in the socket
+            if (peer->inputStalled_)
+            {
+                peer->inputStalled_ = false;
+                handleIncoming(peer);
+            }
         }
     }
 
@@ -1029,23 +1652,247 @@ namespace Pistache::Tcp
         if (fd == PS_FD_EMPTY)
         {
             PS_LOG_DEBUG("Empty Fd");
+            activePeers_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+
+        peer->associateTransport(this);
+
+#ifdef PISTACHE_USE_SSL
+        if (peer->ssl() != nullptr && !SSL_is_init_finished(static_cast<SSL*>(peer->ssl())))
+        {
+            startHandshake(peer);
             return;
         }
+#endif /* PISTACHE_USE_SSL */
 
+        addPeer(peer);
+
+        // Over TLS, OpenSSL reads from the socket itself
+        if (peer->ssl() == nullptr
+            && reactor()->registerFdReceiving(key(), fd, NotifyOn::Read | NotifyOn::Shutdown))
+        {
+            peer->inputReceived_ = true;
+            return;
+        }
+
+        reactor()->registerFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
+                              Polling::Mode::Edge);
+    }
+
+    void Transport::setAcceptor(Fd listenFd, Acceptor acceptor, Adopter adopter)
+    {
+        PS_TIMEDBG_START_ARGS("listenFd %" PIST_QUOTE(PS_FD_PRNTFCD), listenFd);
+
+        acceptFd_ = listenFd;
+        acceptor_ = std::move(acceptor);
+        adopter_  = std::move(adopter);
+
+        if (adopter_ && reactor()->registerFdAccepting(key(), acceptFd_))
+            return;
+
+        reactor()->registerFd(key(), acceptFd_, NotifyOn::Read, Polling::Mode::Level);
+    }
+
+    void Transport::handleAccepted(int64_t fd)
+    {
+        PS_TIMEDBG_START_ARGS("fd %d", static_cast<int>(fd));
+
+        std::shared_ptr<Peer> peer;
+        try
+        {
+            peer = adopter_(static_cast<em_socket_t>(fd));
+        }
+        catch (const std::exception& e)
+        {
+            PS_LOG_WARNING_ARGS("Accept failed: %s", e.what());
+            return;
+        }
+
+        if (peer)
+            handleAcceptedPeer(peer);
+    }
+
+    void Transport::handleAcceptor()
+    {
+        PS_TIMEDBG_START_THIS;
+
+        // Bound the work done per wakeup so that a burst of connections
+        // cannot starve the peers this transport is already serving. The
+        // socket is level-triggered, so any backlog is reported again.
+        static constexpr int MaxAcceptsPerWakeup = 64;
+
+        for (int i = 0; i < MaxAcceptsPerWakeup; ++i)
+        {
+            std::shared_ptr<Peer> peer;
+            try
+            {
+                peer = acceptor_(acceptFd_);
+            }
+            catch (const std::exception& e)
+            {
+                PS_LOG_WARNING_ARGS("Accept failed: %s", e.what());
+                break;
+            }
+
+            if (!peer)
+                break;
+
+            handleAcceptedPeer(peer);
+        }
+    }
+
+    void Transport::handleAcceptedPeer(const std::shared_ptr<Peer>& peer)
+    {
+        // Accepted from onReady, on this transport's own thread: the fd is
+        // registered with its reactor right away, without the round trip
+        // through peersQueue that peers handed over by the Listener take
+        activePeers_.fetch_add(1, std::memory_order_relaxed);
+        metrics_.connectionAccepted();
+
+        handlePeer(peer);
+    }
+
+    void Transport::addPeer(const std::shared_ptr<Peer>& peer)
+    {
         {
             // See comment in transport.h on why peers_ must be mutex-protected
             std::lock_guard<std::mutex> l_guard(peers_mutex_);
 
-            auto auto_insert_res_pr = peers_.insert(std::make_pair(fd, peer));
+            auto auto_insert_res_pr = peers_.insert(std::make_pair(peer->fd(), peer));
             if (!auto_insert_res_pr.second)
                 PS_LOG_WARNING_ARGS("Failed to insert peer %p", peer.get());
         }
 
-        peer->associateTransport(this);
-
+        onPeerAdded(peer);
         handler_->onConnection(peer);
+    }
+
+    void Transport::onPeerAdded(const std::shared_ptr<Peer>& /*peer*/) { }
+
+    bool Transport::isHandshakeFd(Polling::Tag tag) const
+    {
+        if (handshakes_.empty())
+            return false;
+
+        FdConst fdconst = static_cast<FdConst>(tag.value());
+        return handshakes_.find(PS_CAST_AWAY_CONST_FD(fdconst)) != std::end(handshakes_);
+    }
+
+    void Transport::startHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        auto timer = TimerWheel::NoTimer;
+        if (sslHandshakeTimeout_ > std::chrono::milliseconds(0))
+        {
+            std::weak_ptr<Peer> weakPeer = peer;
+            timer = timers_.schedule(sslHandshakeTimeout_, [this, weakPeer]() {
+                auto expired = weakPeer.lock();
+                if (!expired)
+                    return;
+
+                auto it = handshakes_.find(expired->fd());
+                if (it == std::end(handshakes_) || it->second.peer != expired)
+                    return;
+
+                PS_LOG_INFO_ARGS("SSL handshake timed out for peer %p", expired.get());
+                abortHandshake(expired);
+            });
+        }
+
+        Fd fd = peer->fd();
+        handshakes_.insert_or_assign(fd, HandshakeEntry(peer, timer));
+
         reactor()->registerFd(key(), fd, NotifyOn::Read | NotifyOn::Shutdown,
                               Polling::Mode::Edge);
+
+        // The ClientHello is often already waiting on the socket
+        driveHandshake(peer);
+    }
+
+    void Transport::driveHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+#ifdef PISTACHE_USE_SSL
+        Fd fd = peer->fd();
+        if (fd == PS_FD_EMPTY)
+        {
+            PS_LOG_DEBUG("Empty Fd");
+            return;
+        }
+
+        auto* ssl = static_cast<SSL*>(peer->ssl());
+
+        ERR_clear_error();
+        const int res = SSL_accept(ssl);
+        if (res == 1)
+        {
+            PS_LOG_DEBUG("SSL_accept success");
+
+            auto it = handshakes_.find(fd);
+            if (it != std::end(handshakes_))
+            {
+                timers_.cancel(it->second.timer);
+                handshakes_.erase(it);
+            }
+            addPeer(peer);
+            reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
+
+            // The client may already have sent application data behind its
+            // Finished message. Being edge-triggered, we would not be told
+            // about it again, so read it now.
+            handleIncoming(peer);
+            return;
+        }
+
+        switch (SSL_get_error(ssl, res))
+        {
+        case SSL_ERROR_WANT_READ:
+            reactor()->modifyFd(key(), fd, NotifyOn::Read, Polling::Mode::Edge);
+            return;
+
+        case SSL_ERROR_WANT_WRITE:
+            reactor()->modifyFd(key(), fd, NotifyOn::Read | NotifyOn::Write,
+                                Polling::Mode::Edge);
+            return;
+
+        default:
+            break;
+        }
+
+        PS_LOG_INFO_ARGS("SSL connection error, fd %" PIST_QUOTE(PS_FD_PRNTFCD) ": %s",
+                         fd, sslErrorsToString().c_str());
+#endif /* PISTACHE_USE_SSL */
+
+        abortHandshake(peer);
+    }
+
+    void Transport::abortHandshake(const std::shared_ptr<Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        Fd fd = peer->fd();
+        if (fd == PS_FD_EMPTY)
+        {
+            PS_LOG_DEBUG("Empty Fd");
+            return;
+        }
+
+        auto it = handshakes_.find(fd);
+        if (it != std::end(handshakes_))
+        {
+            timers_.cancel(it->second.timer);
+            handshakes_.erase(it);
+            activePeers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        Aio::Reactor* r = reactor();
+        if (r) // or if r is NULL then reactor has been detached already
+            r->removeFd(key(), fd);
+
+        peer->closeFd();
     }
 
     void Transport::handleNotify()
@@ -1073,38 +1920,6 @@ namespace Pistache::Tcp
         loadRequest_.clear();
     }
 
-    void Transport::handleTimer(TimerEntry entry)
-    {
-        PS_TIMEDBG_START_THIS;
-
-        if (entry.isActive())
-        {
-            uint64_t numWakeups;
-
-            auto res = READ_FD(entry.fd, &numWakeups, sizeof numWakeups);
-            if (res == -1)
-            {
-                if (errno == EAGAIN || errno == EWOULDBLOCK)
-                    return;
-                else
-                    entry.deferred.reject(
-                        Pistache::Error::system("Could not read timerfd"));
-            }
-            else
-            {
-                if (res != sizeof(numWakeups))
-                {
-                    entry.deferred.reject(
-                        Pistache::Error("Read invalid number of bytes for timer fd: " + std::to_string(GET_ACTUAL_FD(entry.fd))));
-                }
-                else
-                {
-                    entry.deferred.resolve(numWakeups);
-                }
-            }
-        }
-    }
-
     bool Transport::isPeerFd(FdConst fdconst) const
     {
         PS_TIMEDBG_START_THIS;
@@ -1124,29 +1939,12 @@ namespace Pistache::Tcp
         return peers_.find(fd) != std::end(peers_);
     }
 
-    bool Transport::isTimerFd(FdConst fdconst) const
-    {
-        PS_TIMEDBG_START_THIS;
-
-        // Can cast away const since we're not actually going to change fd
-        Fd fd    = PS_CAST_AWAY_CONST_FD(fdconst);
-        bool res = (timers.find(fd) != std::end(timers));
-
-        PS_LOG_DEBUG_ARGS("Fd %" PIST_QUOTE(PS_FD_PRNTFCD) " %s in timers",
-                          fdconst, (res ? "is" : "is not"));
-        return res;
-    }
-
     bool Transport::isPeerFd(Polling::Tag tag) const
     {
         PS_TIMEDBG_START_THIS;
 
         return isPeerFd(static_cast<FdConst>(tag.value()));
     }
-    bool Transport::isTimerFd(Polling::Tag tag) const
-    {
-        return isTimerFd(static_cast<FdConst>(tag.value()));
-    }
 
     std::shared_ptr<Peer> Transport::getPeer(FdConst fdconst)
     {
@@ -16,8 +16,10 @@
 #include <pistache/pist_quote.h>
 #include <pistache/tcp.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <optional>
 
 namespace Pistache::Http
 {
@@ -28,202 +30,168 @@ namespace Pistache::Http
         using Base = Tcp::Transport;
 
         explicit TransportImpl(const std::shared_ptr<Tcp::Handler>& handler);
-        ~TransportImpl() override;
-
-        void registerPoller(Polling::Epoll& poller) override;
-        void unregisterPoller(Polling::Epoll& poller) override;
-
-        void onReady(const Aio::FdSet& fds) override;
 
         void setHeaderTimeout(std::chrono::milliseconds timeout);
         void setBodyTimeout(std::chrono::milliseconds timeout);
         void setKeepaliveTimeout(std::chrono::milliseconds timeout);
+        void setIdleTimeout(std::chrono::milliseconds timeout);
 
         std::shared_ptr<Aio::Handler> clone() const override;
 
+    protected:
+        void onPeerAdded(const std::shared_ptr<Tcp::Peer>& peer) override;
+
     private:
         std::shared_ptr<Tcp::Handler> handler_;
         std::chrono::milliseconds headerTimeout_;
         std::chrono::milliseconds bodyTimeout_;
         std::chrono::milliseconds keepaliveTimeout_;
+        std::chrono::milliseconds idleTimeout_;
 
-        Fd timerFd;
-
-        void checkIdlePeers();
-        bool checkTimeout(bool idle, Private::StepId id, std::chrono::milliseconds elapsed);
+        void scheduleIdleCheck(const std::shared_ptr<Tcp::Peer>& peer,
+                               std::chrono::milliseconds delay);
+        void checkIdlePeer(const std::weak_ptr<Tcp::Peer>& weakPeer);
+        std::optional<std::chrono::milliseconds> timeoutFor(bool idle, Private::StepId id) const;
+        std::chrono::milliseconds shortestTimeout() const;
         void closePeer(std::shared_ptr<Tcp::Peer>& peer);
+        void dropPeer(std::shared_ptr<Tcp::Peer>& peer);
     };
 
     TransportImpl::TransportImpl(const std::shared_ptr<Tcp::Handler>& handler)
         : Tcp::Transport(handler)
         , handler_(handler)
-        , timerFd(PS_FD_EMPTY)
     { }
 
-    TransportImpl::~TransportImpl()
+    void TransportImpl::setHeaderTimeout(std::chrono::milliseconds timeout)
     {
-        if (timerFd != PS_FD_EMPTY)
-        {
-            CLOSE_FD(timerFd);
-            timerFd = PS_FD_EMPTY;
-        }
+        headerTimeout_ = timeout;
     }
-
-    void TransportImpl::registerPoller(Polling::Epoll& poller)
+    void TransportImpl::setBodyTimeout(std::chrono::milliseconds timeout)
     {
-        PS_TIMEDBG_START_THIS;
+        bodyTimeout_ = timeout;
+    }
+    void TransportImpl::setKeepaliveTimeout(std::chrono::milliseconds timeout)
+    {
+        keepaliveTimeout_ = timeout;
+    }
+    void TransportImpl::setIdleTimeout(std::chrono::milliseconds timeout)
+    {
+        idleTimeout_ = timeout;
+    }
 
-        Base::registerPoller(poller);
+    void TransportImpl::onPeerAdded(const std::shared_ptr<Tcp::Peer>& peer)
+    {
+        // Each peer has a single timer, due when it could first time out.
+        // Once it fires, the peer is checked and the timer set again for
+        // whatever time is left, so that activity never touches the timer.
+        scheduleIdleCheck(peer, shortestTimeout());
+    }
 
-        timerFd =
-#ifdef _USE_LIBEVENT
-            TRY_NULL_RET(poller.em_timer_new(PST_CLOCK_MONOTONIC,
-                                             F_SETFDL_NOTHING,
-                                             PST_O_NONBLOCK));
-#else
-            TRY_RET(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK));
-#endif
+    void TransportImpl::scheduleIdleCheck(const std::shared_ptr<Tcp::Peer>& peer,
+                                          std::chrono::milliseconds delay)
+    {
+        std::weak_ptr<Tcp::Peer> weakPeer = peer;
+        timers().schedule(std::max(delay, std::chrono::milliseconds(1)),
+                          [this, weakPeer]() { checkIdlePeer(weakPeer); });
+    }
 
-        static constexpr auto TimerInterval   = std::chrono::milliseconds(500);
-        static constexpr auto TimerIntervalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(TimerInterval);
+    void TransportImpl::checkIdlePeer(const std::weak_ptr<Tcp::Peer>& weakPeer)
+    {
+        auto peer = weakPeer.lock();
+        if (!peer)
+            return;
 
-        static_assert(
-            TimerInterval < std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::seconds(1)),
-            "Timer frequency should be less than 1 second");
+        Fd fd = peer->fd();
+        if (fd == PS_FD_EMPTY)
+            return;
 
-#ifdef _USE_LIBEVENT
-        if (timerFd == PS_FD_EMPTY)
         {
-            assert(timerFd != PS_FD_EMPTY);
-            PS_LOG_DEBUG("timerFd NULL");
-            throw std::runtime_error("timerFd NULL");
+            // See comment in transport.h on why peers_ must be mutex-protected
+            std::lock_guard<std::mutex> l_guard(peers_mutex_);
+            auto it = peers_.find(fd);
+            if (it == std::end(peers_) || it->second != peer)
+                return;
         }
 
-        std::chrono::milliseconds interval_ms = std::chrono::
-            duration_cast<std::chrono::milliseconds>(TimerIntervalNs);
-        TRY(EventMethFns::setEmEventTime(timerFd, &interval_ms));
-
-#else
-        itimerspec spec;
-        spec.it_value.tv_sec  = 0;
-        spec.it_value.tv_nsec = TimerIntervalNs.count();
+        auto parser = Http::Handler::getParser(peer);
+        auto now    = std::chrono::steady_clock::now();
+        auto quiet  = std::chrono::duration_cast<std::chrono::milliseconds>(now - peer->lastActivity());
 
-        spec.it_interval.tv_sec  = 0;
-        spec.it_interval.tv_nsec = TimerIntervalNs.count();
-
-        TRY(timerfd_settime(timerFd, 0, &spec, nullptr));
-#endif
-
-        Polling::Tag tag(timerFd);
-        PS_LOG_DEBUG_ARGS("Add timer read fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", interval %dms",
-                          timerFd, TimerInterval.count());
-        poller.addFd(timerFd, Flags<Polling::NotifyOn>(Polling::NotifyOn::Read), Polling::Tag(timerFd));
-    }
+        // A response is waiting for the client to take it. Part of it may
+        // be out already, so there is no answering with a 408.
+        if (peer->queuedBytes() > 0)
+        {
+            if (quiet > idleTimeout_)
+            {
+                dropPeer(peer);
+                return;
+            }
 
-    void TransportImpl::unregisterPoller(Polling::Epoll& poller)
-    {
-        PS_TIMEDBG_START_THIS;
+            scheduleIdleCheck(peer, idleTimeout_ - quiet + std::chrono::milliseconds(1));
+            return;
+        }
 
-        if (timerFd != PS_FD_EMPTY)
+        // The handler has yet to respond, which it is not timed out for
+        if (parser->awaitingResponse())
         {
-            PS_LOG_DEBUG_ARGS("Remove and close timer fd %" PIST_QUOTE(PS_FD_PRNTFCD), timerFd);
+            scheduleIdleCheck(peer, shortestTimeout());
+            return;
+        }
 
-            Aio::Reactor* r = reactor();
-            if (r) // or if r is NULL then reactor has been detached already
-                r->removeFd(key(), timerFd);
+        // Idle connections, and request bodies, are timed out from the last
+        // time anything went through, the request line and headers from
+        // when they started to come in
+        const auto id = parser->step()->id();
+        auto elapsed  = std::chrono::duration_cast<std::chrono::milliseconds>(now - parser->time());
+        if (peer->isIdle())
+            elapsed = quiet;
 
-            CLOSE_FD(timerFd);
+        auto timeout = timeoutFor(peer->isIdle(), id);
+        if (timeout && elapsed > *timeout)
+        {
+            closePeer(peer);
+            return;
         }
 
-        Base::unregisterPoller(poller); // Transport unregisterPoller
-    }
-
-    void TransportImpl::onReady(const Aio::FdSet& fds)
-    {
-        PS_TIMEDBG_START_THIS;
+        // Without a timeout for the current state, look again once any
+        // could apply
+        auto delay = timeout ? *timeout - elapsed + std::chrono::milliseconds(1)
+                             : shortestTimeout();
 
-        for (const auto& entry : fds)
+        if (!peer->isIdle() && id == Private::BodyStep::Id)
         {
-            if (entry.getTag() == Polling::Tag(timerFd))
+            // A body that stopped coming in
+            if (quiet > idleTimeout_)
             {
-                uint64_t wakeups;
-                [[maybe_unused]] auto rv = READ_FD(timerFd,
-                                                   &wakeups, sizeof wakeups);
-                PS_LOG_DEBUG_ARGS("timerFd %p had %u wakeup%s",
-                                  timerFd, wakeups, (wakeups == 1) ? "" : "s");
-
-                checkIdlePeers();
-                break;
+                closePeer(peer);
+                return;
             }
+            delay = std::min(delay, idleTimeout_ - quiet + std::chrono::milliseconds(1));
         }
 
-        Base::onReady(fds);
+        scheduleIdleCheck(peer, delay);
     }
 
-    void TransportImpl::setHeaderTimeout(std::chrono::milliseconds timeout)
-    {
-        headerTimeout_ = timeout;
-    }
-    void TransportImpl::setBodyTimeout(std::chrono::milliseconds timeout)
+    std::chrono::milliseconds TransportImpl::shortestTimeout() const
     {
-        bodyTimeout_ = timeout;
-    }
-    void TransportImpl::setKeepaliveTimeout(std::chrono::milliseconds timeout)
-    {
-        keepaliveTimeout_ = timeout;
+        return std::min({ headerTimeout_, bodyTimeout_, keepaliveTimeout_, idleTimeout_ });
     }
 
-    void TransportImpl::checkIdlePeers()
+    std::optional<std::chrono::milliseconds>
+    TransportImpl::timeoutFor(bool idle, Private::StepId id) const
     {
-        std::vector<std::shared_ptr<Tcp::Peer>> idlePeers;
+        if (idle)
+            return keepaliveTimeout_;
 
-        {
-            // See comment in transport.h on why peers_ must be mutex-protected
-            std::lock_guard<std::mutex> l_guard(peers_mutex_);
-            for (const auto& peerPair : peers_)
-            {
-                const auto& peer = peerPair.second;
-                auto parser      = Http::Handler::getParser(peer);
-                auto time        = parser->time();
-
-                auto now     = std::chrono::steady_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - time);
-
-                auto* step = parser->step();
-                if (checkTimeout(peer->isIdle(), step->id(), elapsed))
-                {
-                    idlePeers.push_back(peer);
-                }
-            }
-        }
+        if (id == Private::RequestLineStep::Id || id == Private::HeadersStep::Id)
+            return std::min(headerTimeout_, bodyTimeout_);
 
-        for (auto& idlePeer : idlePeers)
-        {
-            closePeer(idlePeer);
-        }
-    }
-    bool TransportImpl::checkTimeout(bool idle, Private::StepId id, std::chrono::milliseconds elapsed)
-    {
-        if (idle)
-        {
-            return elapsed > keepaliveTimeout_;
-        }
-        else
-        {
-            if (id == Private::RequestLineStep::Id || id == Private::HeadersStep::Id)
-            {
-                return elapsed > headerTimeout_ || elapsed > bodyTimeout_;
-            }
-            else if (id == Private::BodyStep::Id)
-            {
-                return elapsed > bodyTimeout_;
-            }
-            else
-            {
-                return false;
-            }
-        }
+        if (id == Private::BodyStep::Id)
+            return bodyTimeout_;
+
+        return std::nullopt;
     }
+
     void TransportImpl::closePeer(std::shared_ptr<Tcp::Peer>& peer)
     {
         PS_TIMEDBG_START_THIS;
@@ -232,21 +200,32 @@ namespace Pistache::Http
         // false: there is at least one http request on the peer(keepalive or not) -> send 408 message first, then call removePeer
         if (peer->isIdle())
         {
+            metrics().idleTimedOut();
             removePeer(peer);
         }
         else
         {
+            metrics().requestTimedOut();
             ResponseWriter response(Http::Version::Http11, this, static_cast<Http::Handler*>(handler_.get()), peer);
             response.send(Http::Code::Request_Timeout).then([peer, this](PST_SSIZE_T) { removePeer(peer); }, [peer, this](std::exception_ptr) { removePeer(peer); });
         }
     }
 
+    void TransportImpl::dropPeer(std::shared_ptr<Tcp::Peer>& peer)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        metrics().requestTimedOut();
+        removePeer(peer);
+    }
+
     std::shared_ptr<Aio::Handler> TransportImpl::clone() const
     {
         auto transport = std::make_shared<TransportImpl>(handler_->clone());
         transport->setHeaderTimeout(headerTimeout_);
         transport->setBodyTimeout(bodyTimeout_);
         transport->setKeepaliveTimeout(keepaliveTimeout_);
+        transport->setIdleTimeout(idleTimeout_);
         return transport;
     }
 
@@ -262,6 +241,12 @@ namespace Pistache::Http
         , logger_(PISTACHE_NULL_STRING_LOGGER)
         // This should be moved after "keepaliveTimeout_" in the next ABI change
         , sslHandshakeTimeout_(Const::DefaultSSLHandshakeTimeout)
+        , perWorkerAccept_(false)
+        , acceptCpuSteering_(false)
+        , dispatchPolicy_(Tcp::DispatchPolicy::RoundRobin)
+        , receiveBufferSize_(Const::MaxBuffer)
+        , pollingBackend_(Polling::Backend::Epoll)
+        , idleTimeout_(Const::DefaultIdleTimeout)
     { }
 
     Endpoint::Options& Endpoint::Options::threads(int val)
@@ -305,12 +290,48 @@ namespace Pistache::Http
         return *this;
     }
 
+    Endpoint::Options& Endpoint::Options::receiveBufferSize(size_t val)
+    {
+        receiveBufferSize_ = val;
+        return *this;
+    }
+
     Endpoint::Options& Endpoint::Options::logger(PISTACHE_STRING_LOGGER_T logger)
     {
         logger_ = logger;
         return *this;
     }
 
+    Endpoint::Options& Endpoint::Options::perWorkerAccept(bool val)
+    {
+        perWorkerAccept_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::acceptCpuSteering(bool val)
+    {
+        acceptCpuSteering_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::dispatchPolicy(Tcp::DispatchPolicy val)
+    {
+        dispatchPolicy_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::pollingBackend(Polling::Backend val)
+    {
+        pollingBackend_ = val;
+        return *this;
+    }
+
+    Endpoint::Options& Endpoint::Options::compressor(std::shared_ptr<Compressor> val)
+    {
+        compressor_ = std::move(val);
+        return *this;
+    }
+
     Endpoint::Endpoint() = default;
 
     Endpoint::Endpoint(const Address& addr)
@@ -320,6 +341,9 @@ namespace Pistache::Http
     void Endpoint::init(const Endpoint::Options& options)
     {
         listener.init(options.threads_, options.flags_, options.threadsName_, options.backlog_);
+        listener.setPerWorkerAccept(options.perWorkerAccept_, options.acceptCpuSteering_);
+        listener.setDispatchPolicy(options.dispatchPolicy_);
+        listener.setPollingBackend(options.pollingBackend_);
         listener.setTransportFactory([this, options] {
             if (!handler_)
                 throw std::runtime_error("Must call setHandler()");
@@ -328,6 +352,7 @@ namespace Pistache::Http
             transport->setHeaderTimeout(options.headerTimeout_);
             transport->setBodyTimeout(options.bodyTimeout_);
             transport->setKeepaliveTimeout(options.keepaliveTimeout_);
+            transport->setIdleTimeout(options.idleTimeout_);
 
             return transport;
         });
@@ -336,6 +361,9 @@ namespace Pistache::Http
         {
             handler_->setMaxRequestSize(options.maxRequestSize_);
             handler_->setMaxResponseSize(options.maxResponseSize_);
+            handler_->setReceiveBufferSize(options.receiveBufferSize_);
+            if (options.compressor_)
+                handler_->setCompressor(options.compressor_);
         }
 
         options_ = options;
@@ -347,6 +375,9 @@ namespace Pistache::Http
         handler_ = handler;
         handler_->setMaxRequestSize(options_.maxRequestSize_);
         handler_->setMaxResponseSize(options_.maxResponseSize_);
+        handler_->setReceiveBufferSize(options_.receiveBufferSize_);
+        if (options_.compressor_)
+            handler_->setCompressor(options_.compressor_);
     }
 
     void Endpoint::bind() { listener.bind(); }
@@ -357,7 +388,15 @@ namespace Pistache::Http
 
     void Endpoint::serveThreaded() { serveImpl(&Tcp::Listener::runThreaded); }
 
-    void Endpoint::shutdown() { listener.shutdown(); }
+    void Endpoint::shutdown()
+    {
+        listener.shutdown();
+
+        // Bodies still being compressed are queued on transports that are
+        // about to go away with the endpoint
+        if (handler_ && handler_->getCompressor())
+            handler_->getCompressor()->wait();
+    }
 
     Endpoint::~Endpoint() { shutdown(); }
 
@@ -386,6 +425,8 @@ namespace Pistache::Http
         return listener.requestLoad(old);
     }
 
+    Metrics::Snapshot Endpoint::metrics() { return Metrics::Snapshot { listener.metrics() }; }
+
     Endpoint::Options Endpoint::options() { return Options(); }
 
     std::vector<std::shared_ptr<Tcp::Peer>> Endpoint::getAllPeer()
@@ -35,6 +35,10 @@
 #include <sys/epoll.h>
 #endif
 
+#ifdef __linux__
+#include <linux/filter.h> // for SO_ATTACH_REUSEPORT_CBPF
+#endif
+
 #include PST_SOCKET_HDR
 
 #ifndef _USE_LIBEVENT_LIKE_APPLE
@@ -287,11 +291,19 @@ namespace Pistache::Tcp
         if (acceptThread.joinable())
             acceptThread.join();
 
+        // The workers' pollers go with the reactor: a multishot accept they
+        // still have armed on a listening socket keeps it open otherwise
+        reactor_.reset();
+
         if (listen_fd != PS_FD_EMPTY)
         {
             CLOSE_FD(listen_fd);
             listen_fd = PS_FD_EMPTY;
         }
+
+        for (Fd fd : workerListenFds_)
+            CLOSE_FD(fd);
+        workerListenFds_.clear();
     }
 
     void Listener::init(size_t workers, Flags<Options> options,
@@ -321,6 +333,22 @@ namespace Pistache::Tcp
         handler_ = handler;
     }
 
+    void Listener::setPerWorkerAccept(bool enable, bool cpuSteering)
+    {
+        perWorkerAccept_   = enable;
+        acceptCpuSteering_ = cpuSteering;
+    }
+
+    void Listener::setDispatchPolicy(DispatchPolicy policy)
+    {
+        dispatchPolicy_ = policy;
+    }
+
+    void Listener::setPollingBackend(Polling::Backend backend)
+    {
+        pollingBackend_ = backend;
+    }
+
     void Listener::pinWorker([[maybe_unused]] size_t worker, [[maybe_unused]] const CpuSet& set)
     {
 #if 0
@@ -370,7 +398,15 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        setSocketOptions(actual_fd, options_);
+        const bool perWorkerAccept = usePerWorkerAccept(addr->ai_family);
+
+        // Every socket of a SO_REUSEPORT group, including the first, needs
+        // the option set before bind
+        Flags<Options> options = options_;
+        if (perWorkerAccept)
+            options.setFlag(Options::ReusePort);
+
+        setSocketOptions(actual_fd, options);
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
@@ -416,26 +452,119 @@ namespace Pistache::Tcp
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
-        PS_LOG_DEBUG_ARGS("Add read fd %" PIST_QUOTE(PS_FD_PRNTFCD), event_fd);
-        poller.addFd(event_fd,
-                     Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
-                     Polling::Tag(event_fd));
+        // In per-worker accept mode, listen_fd is accepted on by the first
+        // worker, not by the accept thread
+        if (!perWorkerAccept)
+        {
+            PS_LOG_DEBUG_ARGS("Add read fd %" PIST_QUOTE(PS_FD_PRNTFCD), event_fd);
+            poller.addFd(event_fd,
+                         Flags<Polling::NotifyOn>(Polling::NotifyOn::Read),
+                         Polling::Tag(event_fd));
+        }
         listen_fd = event_fd;
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
         auto transport = transportFactory_();
+        if (useSSL_)
+            transport->setSslHandshakeTimeout(sslHandshakeTimeout_);
 
         reactor_ = std::make_shared<Aio::Reactor>();
-        reactor_->init(Aio::AsyncContext(workers_, workersName_));
+        reactor_->init(Aio::AsyncContext(workers_, workersName_, pollingBackend_));
 
         transportKey = reactor_->addHandler(transport);
 
+        if (perWorkerAccept)
+            setupWorkerAcceptors(addr, socktype, options);
+
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(actual_fd);
 
         return true;
     }
 
+    bool Listener::usePerWorkerAccept([[maybe_unused]] int family) const
+    {
+        if (!perWorkerAccept_)
+            return false;
+
+#if defined(_USE_LIBEVENT) || !defined(SO_REUSEPORT)
+        PS_LOG_WARNING("Per-worker accept not supported, using a single acceptor");
+        return false;
+#else
+        if (family == AF_UNIX)
+        {
+            PS_LOG_WARNING("Per-worker accept not supported for unix domain "
+                           "sockets, using a single acceptor");
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    void Listener::setupWorkerAcceptors([[maybe_unused]] const struct addrinfo* addr,
+                                        [[maybe_unused]] int socktype,
+                                        [[maybe_unused]] Flags<Options> options)
+    {
+        PS_TIMEDBG_START_THIS;
+
+#if !defined(_USE_LIBEVENT) && defined(SO_REUSEPORT)
+        // Bind the other sockets of the group to the address the first one
+        // actually got, so that an ephemeral port is shared by all of them
+        struct sockaddr_storage bound_addr = {};
+        socklen_t bound_addr_len           = sizeof(bound_addr);
+        auto* bound_addr_alias             = reinterpret_cast<struct sockaddr*>(&bound_addr);
+        TRY(PST_SOCK_GETSOCKNAME(listen_fd, bound_addr_alias, &bound_addr_len));
+
+        auto handlers = reactor_->handlers(transportKey);
+        for (size_t i = 0; i < handlers.size(); ++i)
+        {
+            Fd fd = listen_fd;
+            if (i > 0)
+            {
+                fd = TRY_RET(PST_SOCK_SOCKET(addr->ai_family, socktype,
+                                             addr->ai_protocol));
+                workerListenFds_.push_back(fd);
+
+                setSocketOptions(fd, options);
+                TRY(PST_SOCK_BIND(fd, bound_addr_alias, bound_addr_len));
+                TRY(PST_SOCK_LISTEN(fd, backlog_));
+                make_non_blocking(fd);
+            }
+
+            PS_LOG_DEBUG_ARGS("Worker %u accepts on fd %d", i, fd);
+
+            auto transport = std::static_pointer_cast<Transport>(handlers[i]);
+            transport->setAcceptor(
+                fd,
+                [this](Fd listenFd) { return acceptPeer(listenFd); },
+                [this](em_socket_t cli_fd) { return adoptPeer(cli_fd); });
+        }
+
+        if (acceptCpuSteering_)
+        {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+            // Return the index, within the SO_REUSEPORT group, of the socket
+            // to use: the CPU the packet was received on, modulo the group
+            // size. Sockets join the group in worker order.
+            struct sock_filter code[] = {
+                { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+                { BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(handlers.size()) },
+                { BPF_RET | BPF_A, 0, 0, 0 },
+            };
+            struct sock_fprog prog = {};
+            prog.len               = static_cast<unsigned short>(sizeof(code) / sizeof(code[0]));
+            prog.filter            = code;
+
+            TRY(::setsockopt(listen_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                             &prog, sizeof(prog)));
+#else
+            PS_LOG_WARNING("SO_ATTACH_REUSEPORT_CBPF not supported, "
+                           "accept CPU steering disabled");
+#endif
+        }
+#endif
+    }
+
     void Listener::bind(const Address& address)
     {
         PS_TIMEDBG_START_THIS;
@@ -616,6 +745,20 @@ namespace Pistache::Tcp
             reactor_->shutdown();
     }
 
+    std::vector<Metrics::Worker> Listener::metrics()
+    {
+        std::vector<Metrics::Worker> workers;
+        if (!reactor_)
+            return workers;
+
+        for (const auto& handler : reactor_->handlers(transportKey))
+        {
+            auto transport = std::static_pointer_cast<Transport>(handler);
+            workers.push_back(transport->metricsSnapshot());
+        }
+        return workers;
+    }
+
     Async::Promise<Listener::Load>
     Listener::requestLoad(const Listener::Load& old)
     {
@@ -637,6 +780,13 @@ namespace Pistache::Tcp
                     Load res;
                     res.raw = usages;
 
+                    for (const auto& handler : handlers)
+                    {
+                        auto transport = std::static_pointer_cast<Transport>(handler);
+                        res.connections.push_back(transport->activePeers());
+                        res.busy.push_back(transport->busyTime());
+                    }
+
                     if (old.raw.empty())
                     {
                         res.global = 0.0;
@@ -684,9 +834,50 @@ namespace Pistache::Tcp
     {
         PS_TIMEDBG_START_THIS;
 
+        auto peer = acceptPeer(listen_fd);
+        if (!peer)
+            return;
+
+        PS_LOG_DEBUG_ARGS("Calling dispatchPeer %p", peer.get());
+        dispatchPeer(peer);
+    }
+
+    std::shared_ptr<Peer> Listener::acceptPeer(Fd listenFd)
+    {
+        PS_TIMEDBG_START_THIS;
+
         struct sockaddr_storage peer_addr;
-        em_socket_t actual_cli_fd = acceptConnection(peer_addr);
+        em_socket_t actual_cli_fd = acceptConnection(listenFd, peer_addr);
+        if (actual_cli_fd < 0)
+            return nullptr;
+
+        return makePeer(actual_cli_fd, peer_addr);
+    }
+
+    std::shared_ptr<Peer> Listener::adoptPeer(em_socket_t actual_cli_fd)
+    {
+        PS_TIMEDBG_START_THIS;
+
+        // Accepted by the poller, which does not ask for the address
+        struct sockaddr_storage peer_addr;
+        socklen_t peer_addr_len = sizeof(peer_addr);
+        if (::getpeername(actual_cli_fd,
+                          reinterpret_cast<struct sockaddr*>(&peer_addr),
+                          &peer_addr_len)
+            < 0)
+        {
+            // Reset by the client already
+            PS_LOG_DEBUG_ARGS("getpeername failed for fd %d", actual_cli_fd);
+            PST_SOCK_CLOSE(actual_cli_fd);
+            return nullptr;
+        }
 
+        return makePeer(actual_cli_fd, peer_addr);
+    }
+
+    std::shared_ptr<Peer> Listener::makePeer(em_socket_t actual_cli_fd,
+                                             struct sockaddr_storage& peer_addr)
+    {
         void* ssl = nullptr;
 
 #ifdef PISTACHE_USE_SSL
@@ -705,30 +896,6 @@ namespace Pistache::Tcp
                 throw ServerError(err.c_str());
             }
 
-            // If user requested SSL handshake timeout, enable it on the
-            //  socket.  This is sometimes necessary if a client connects,
-            //  sends nothing, or possibly refuses to accept any bytes, and
-            //  never completes a handshake. This would have left SSL_accept
-            //  hanging indefinitely and is effectively a DoS...
-            if (sslHandshakeTimeout_ > 0ms)
-            {
-                PS_LOG_DEBUG("SSL timeout to be set");
-
-                struct timeval timeout;
-
-                timeout.tv_sec = static_cast<PST_TIMEVAL_S_T>(std::chrono::duration_cast<std::chrono::seconds>(sslHandshakeTimeout_).count());
-
-                const auto residual_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(sslHandshakeTimeout_) - std::chrono::duration_cast<std::chrono::seconds>(sslHandshakeTimeout_);
-                timeout.tv_usec                  = static_cast<PST_SUSECONDS_T>(residual_microseconds.count());
-
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_RCVTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_T*>(&timeout),
-                                 sizeof(timeout)));
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_T*>(&timeout),
-                                 sizeof(timeout)));
-            }
-
             SSL_set_fd(ssl_data,
 #ifdef _IS_WINDOWS
                        // SSL_set_fd takes type int for the FD parm, resulting
@@ -746,54 +913,10 @@ namespace Pistache::Tcp
             );
             SSL_set_accept_state(ssl_data);
 
-            int ssl_accept_res = SSL_accept(ssl_data);
-
-            if (ssl_accept_res <= 0)
-            {
-                PS_LOG_DEBUG_ARGS("SSL_accept failed, ssl_accept_res %d, "
-                                  "actual_cli_fd %d",
-                                  ssl_accept_res, actual_cli_fd);
-
-#ifdef DEBUG
-                const char* ssl_ver = OPENSSL_VERSION_TEXT;
-                PS_LOG_DEBUG_ARGS("openssl: %s", ssl_ver);
-#endif
-
-#ifdef DEBUG
-                int ssl_err_code = SSL_get_error(ssl_data, ssl_accept_res);
-                PS_LOG_DEBUG_ARGS("ssl_err_code %d", ssl_err_code);
-#endif
-
-                std::string err = "SSL connection error: "
-                    + ssl_print_errors_to_string();
-
-                PS_LOG_DEBUG_ARGS("%s", err.c_str());
-
-                PISTACHE_LOG_STRING_INFO(logger_, err);
-                SSL_free(ssl_data);
-                PST_SOCK_CLOSE(actual_cli_fd);
-                return;
-            }
-
-            PS_LOG_DEBUG("SSL_accept succcess");
-
-            // Remove socket timeouts if they were enabled now that we have
-            //  handshaked...
-            if (sslHandshakeTimeout_ > 0ms)
-            {
-                PS_LOG_DEBUG("SSL timeout to be removed");
-
-                struct timeval timeout;
-                timeout.tv_sec  = 0;
-                timeout.tv_usec = 0;
-
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_RCVTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_T*>(&timeout),
-                                 sizeof(timeout)));
-                TRY(::setsockopt(actual_cli_fd, SOL_SOCKET, SO_SNDTIMEO,
-                                 reinterpret_cast<PST_SOCK_OPT_VAL_T*>(&timeout),
-                                 sizeof(timeout)));
-            }
+            // The handshake itself is not performed here: it is driven
+            // without blocking by the Transport worker the peer is
+            // dispatched to, so that a slow or silent client cannot stall
+            // the accept loop. See Transport::driveHandshake.
 
             ssl = static_cast<void*>(ssl_data);
         }
@@ -837,21 +960,21 @@ namespace Pistache::Tcp
             peer = Peer::Create(client_fd, Address::fromUnix(peer_alias));
         }
 
-        PS_LOG_DEBUG_ARGS("Calling dispatchPeer %p", peer.get());
-        dispatchPeer(peer);
+        return peer;
     }
 
-    em_socket_t Listener::acceptConnection(struct sockaddr_storage& peer_addr) const
+    em_socket_t Listener::acceptConnection(Fd listenFd,
+                                           struct sockaddr_storage& peer_addr) const
     {
         PS_TIMEDBG_START_THIS;
 
         socklen_t peer_addr_len = sizeof(peer_addr);
 
-        em_socket_t listen_fd_actual = GET_ACTUAL_FD(listen_fd);
+        em_socket_t listen_fd_actual = GET_ACTUAL_FD(listenFd);
 
         PS_LOG_DEBUG_ARGS("listen_fd %" PIST_QUOTE(PS_FD_PRNTFCD) ", "
                                                                   "listen_fd_actual %d",
-                          listen_fd, listen_fd_actual);
+                          listenFd, listen_fd_actual);
 
         LOG_DEBUG_ACT_FD_AND_FDL_FLAGS(listen_fd_actual);
 
@@ -892,6 +1015,11 @@ namespace Pistache::Tcp
 
         if (client_actual_fd < 0)
         {
+            // Nothing (left) to accept; can happen with several acceptors
+            // draining their own queue
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return client_actual_fd;
+
             PST_DECL_SE_ERR_P_EXTRA;
 
             if (errno == EBADF || errno == ENOTSOCK)
@@ -975,6 +1103,64 @@ namespace Pistache::Tcp
             return;
         }
 
+        auto handlers  = reactor_->handlers(transportKey);
+        auto idx       = pickWorker(handlers, actual_fd);
+        auto transport = std::static_pointer_cast<Transport>(handlers[idx]);
+
+        transport->handleNewPeer(peer);
+    }
+
+    size_t Listener::pickWorker(
+        const std::vector<std::shared_ptr<Aio::Handler>>& handlers,
+        [[maybe_unused]] em_socket_t actual_fd)
+    {
+        const size_t count = handlers.size();
+        if (count == 1)
+            return 0;
+
+        // Without copying the shared_ptr, and its atomic reference count
+        auto transportAt = [&](size_t i) -> const Transport& {
+            return static_cast<const Transport&>(*handlers[i]);
+        };
+
+        // Fewer live peers first, then less recent busy time
+        auto lessLoaded = [&](size_t a, size_t b) {
+            const auto& ta = transportAt(a);
+            const auto& tb = transportAt(b);
+
+            const size_t peersA = ta.activePeers();
+            const size_t peersB = tb.activePeers();
+            if (peersA != peersB)
+                return peersA < peersB;
+            return ta.recentBusyTime() < tb.recentBusyTime();
+        };
+
+        switch (dispatchPolicy_)
+        {
+        case DispatchPolicy::LeastConnections:
+        {
+            size_t best = 0;
+            for (size_t i = 1; i < count; ++i)
+            {
+                if (lessLoaded(i, best))
+                    best = i;
+            }
+            return best;
+        }
+        case DispatchPolicy::PowerOfTwoChoices:
+        {
+            std::uniform_int_distribution<size_t> dist(0, count - 1);
+            const size_t first = dist(dispatchRng_);
+            // Draw the second among the count - 1 others
+            size_t second = std::uniform_int_distribution<size_t>(0, count - 2)(dispatchRng_);
+            if (second >= first)
+                ++second;
+            return lessLoaded(second, first) ? second : first;
+        }
+        case DispatchPolicy::RoundRobin:
+            break;
+        }
+
         em_socket_t input_for_idx = 0;
 #ifdef _IS_WINDOWS
         // actual_fd in Windows seems to be a multiple of 4, so we'll fail to
@@ -999,11 +1185,7 @@ namespace Pistache::Tcp
         input_for_idx = actual_fd;
 #endif
 
-        auto handlers  = reactor_->handlers(transportKey);
-        auto idx       = input_for_idx % handlers.size();
-        auto transport = std::static_pointer_cast<Transport>(handlers[idx]);
-
-        transport->handleNewPeer(peer);
+        return static_cast<size_t>(input_for_idx) % count;
     }
 
     Listener::TransportFactory Listener::defaultTransportFactory() const
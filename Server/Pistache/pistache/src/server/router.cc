@@ -11,20 +11,101 @@
 */
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 #include <pistache/description.h>
+#include <pistache/endpoint.h>
 #include <pistache/router.h>
 
 namespace Pistache::Rest
 {
 
-    Request::Request(Http::Request request, std::vector<TypedParam>&& params,
-                     std::vector<TypedParam>&& splats)
+    Request::Request(Http::Request&& request)
         : Http::Request(std::move(request))
-        , params_(std::move(params))
-        , splats_(std::move(splats))
     { }
 
+    Request::Request(const Request& other)
+        : Http::Request(other)
+        , params_(other.params_)
+        , splats_(other.splats_)
+        , path_(other.path_)
+        , routes_(other.routes_)
+    {
+        rebase(other.resource(), other.path_);
+    }
+
+    Request::Request(Request&& other)
+        : Request(std::move(other), other.resource(), other.path_)
+    { }
+
+    // The views are taken before other is moved from, as the bytes of short
+    // strings are copied rather than moved
+    Request::Request(Request&& other, std::string_view resource, std::string_view path)
+        : Http::Request(std::move(other))
+        , params_(std::move(other.params_))
+        , splats_(std::move(other.splats_))
+        , path_(std::move(other.path_))
+        , routes_(std::move(other.routes_))
+    {
+        rebase(resource, path);
+    }
+
+    Request& Request::operator=(const Request& other)
+    {
+        if (this != &other)
+        {
+            Http::Request::operator=(other);
+            params_ = other.params_;
+            splats_ = other.splats_;
+            path_   = other.path_;
+            routes_ = other.routes_;
+            rebase(other.resource(), other.path_);
+        }
+        return *this;
+    }
+
+    Request& Request::operator=(Request&& other)
+    {
+        if (this != &other)
+        {
+            const std::string_view resource = other.resource();
+            const std::string_view path     = other.path_;
+
+            Http::Request::operator=(std::move(other));
+            params_ = std::move(other.params_);
+            splats_ = std::move(other.splats_);
+            path_   = std::move(other.path_);
+            routes_ = std::move(other.routes_);
+            rebase(resource, path);
+        }
+        return *this;
+    }
+
+    void Request::rebase(std::string_view resource, std::string_view path)
+    {
+        // Only the addresses of the former storage are compared, it is never
+        // read from
+        auto rebaseOne = [&](TypedParam& param) {
+            const auto value = reinterpret_cast<std::uintptr_t>(param.value_.data());
+            for (const auto& [from, to] : { std::make_pair(resource, std::string_view(this->resource())),
+                                            std::make_pair(path, std::string_view(path_)) })
+            {
+                const auto begin = reinterpret_cast<std::uintptr_t>(from.data());
+                if (value >= begin && value <= begin + from.size())
+                {
+                    param.value_ = to.substr(value - begin, param.value_.size());
+                    return;
+                }
+            }
+        };
+
+        for (auto& param : params_)
+            rebaseOne(param);
+        for (auto& splat : splats_)
+            rebaseOne(splat);
+    }
+
     bool Request::hasParam(const std::string& name) const
     {
         auto it = std::find_if(
@@ -59,8 +140,6 @@ namespace Pistache::Rest
 
     std::vector<TypedParam> Request::splat() const { return splats_; }
 
-    std::regex SegmentTreeNode::multiple_slash = std::regex("//+", std::regex_constants::optimize);
-
     SegmentTreeNode::SegmentTreeNode()
         : resource_ref_()
         , fixed_()
@@ -121,13 +200,31 @@ namespace Pistache::Rest
 
     std::string SegmentTreeNode::sanitizeResource(const std::string& path)
     {
-        const auto& dup = std::regex_replace(path, SegmentTreeNode::multiple_slash,
-                                             std::string("/"));
-        if (dup[dup.length() - 1] == '/')
+        std::string buffer;
+        return std::string(sanitizeResource(std::string_view(path), buffer));
+    }
+
+    std::string_view SegmentTreeNode::sanitizeResource(std::string_view path,
+                                                       std::string& buffer)
+    {
+        if (path.find("//") != std::string_view::npos)
         {
-            return dup.substr(1, dup.length() - 2);
+            buffer.clear();
+            buffer.reserve(path.size());
+            for (char c : path)
+            {
+                if (c != '/' || buffer.empty() || buffer.back() != '/')
+                    buffer.push_back(c);
+            }
+            path = buffer;
         }
-        return dup.substr(1);
+
+        if (path.empty())
+            return path;
+
+        if (path.back() == '/')
+            return path.substr(1, path.size() > 1 ? path.size() - 2 : 0);
+        return path.substr(1);
     }
 
     void SegmentTreeNode::addRoute(
@@ -275,9 +372,7 @@ namespace Pistache::Rest
             // Check if it is a path param
             for (const auto& param : param_)
             {
-                std::string para_name { param.first.data(), param.first.length() };
-                std::string para_val { current_segment.data(), current_segment.length() };
-                params.emplace_back(para_name, para_val);
+                params.emplace_back(param.first, current_segment);
                 auto result = param.second->findRoute(lower_path, params, splats);
                 auto route  = std::get<0>(result);
                 if (route != nullptr)
@@ -288,9 +383,7 @@ namespace Pistache::Rest
             // Check if it is an optional path param
             for (const auto& optional : optional_)
             {
-                std::string opt_name { optional.first.data(), optional.first.length() };
-                std::string opt_val { current_segment.data(), current_segment.length() };
-                params.emplace_back(opt_name, opt_val);
+                params.emplace_back(optional.first, current_segment);
                 auto result = optional.second->findRoute(lower_path, params, splats);
 
                 auto route = std::get<0>(result);
@@ -309,8 +402,7 @@ namespace Pistache::Rest
             // Check if it is a splat
             if (splat_ != nullptr)
             {
-                std::string splat { current_segment.data(), current_segment.length() };
-                splats.emplace_back(splat, splat);
+                splats.emplace_back(current_segment, current_segment);
                 auto result = splat_->findRoute(lower_path, params, splats);
 
                 auto route = std::get<0>(result);
@@ -355,16 +447,320 @@ namespace Pistache::Rest
         return findRoute(path, params, splats);
     }
 
+    RouteMatcher::RouteMatcher(const SegmentTreeNode& root)
+    {
+        compile(root);
+    }
+
+    RouteMatcher::Label RouteMatcher::store(std::string_view label, size_t headSize)
+    {
+        Label stored;
+        stored.offset   = static_cast<uint32_t>(labels_.size());
+        stored.size     = static_cast<uint32_t>(label.size());
+        stored.headSize = static_cast<uint32_t>(headSize);
+        labels_.append(label);
+        return stored;
+    }
+
+    std::string_view RouteMatcher::view(const Label& label) const
+    {
+        return std::string_view(labels_).substr(label.offset, label.size);
+    }
+
+    std::string_view RouteMatcher::head(const Label& label) const
+    {
+        return std::string_view(labels_).substr(label.offset, label.headSize);
+    }
+
+    uint32_t RouteMatcher::compile(const SegmentTreeNode& node)
+    {
+        const auto index = static_cast<uint32_t>(nodes_.size());
+        nodes_.emplace_back();
+
+        if (node.route_)
+        {
+            nodes_[index].route = static_cast<uint32_t>(routes_.size());
+            routes_.push_back(node.route_);
+        }
+
+        // Fixed segments are merged with the ones below them for as long as
+        // there is nothing else to match on the way
+        std::vector<std::pair<std::string, const SegmentTreeNode*>> fixed;
+        for (const auto& [segment, child] : node.fixed_)
+        {
+            std::string label(segment);
+            const SegmentTreeNode* target = child.get();
+            while (!target->route_ && target->fixed_.size() == 1 && target->param_.empty() && target->optional_.empty() && !target->splat_)
+            {
+                const auto& next = *target->fixed_.begin();
+                label += '/';
+                label += next.first;
+                target = next.second.get();
+            }
+            fixed.emplace_back(std::move(label), target);
+        }
+
+        // By first segment, for them to be binary searched
+        auto firstSegment = [](const std::string& label) {
+            return std::string_view(label).substr(0, label.find('/'));
+        };
+        std::sort(fixed.begin(), fixed.end(), [&](const auto& lhs, const auto& rhs) {
+            return firstSegment(lhs.first) < firstSegment(rhs.first);
+        });
+
+        auto sorted = [](const auto& collection) {
+            std::vector<std::pair<std::string_view, const SegmentTreeNode*>> result;
+            for (const auto& [name, child] : collection)
+                result.emplace_back(name, child.get());
+            std::sort(result.begin(), result.end());
+            return result;
+        };
+        const auto params    = sorted(node.param_);
+        const auto optionals = sorted(node.optional_);
+
+        // The edges of a node are contiguous, their children being compiled
+        // once they all are laid out
+        auto layout = [&](const auto& children, Range& range, bool isFixed) {
+            range.begin = static_cast<uint32_t>(edges_.size());
+            for (const auto& [label, child] : children)
+            {
+                Edge edge;
+                edge.label = store(label, isFixed ? std::string_view(label).find('/') : label.size());
+                if (edge.label.headSize > edge.label.size)
+                    edge.label.headSize = edge.label.size;
+                edges_.push_back(edge);
+            }
+            range.end = static_cast<uint32_t>(edges_.size());
+        };
+
+        Range fixedRange, paramsRange, optionalsRange;
+        layout(fixed, fixedRange, true);
+        layout(params, paramsRange, false);
+        layout(optionals, optionalsRange, false);
+
+        nodes_[index].fixed     = fixedRange;
+        nodes_[index].params    = paramsRange;
+        nodes_[index].optionals = optionalsRange;
+
+        if (!fixed.empty())
+            nodes_[index].jumps = jumpTable(fixedRange, 0);
+
+        for (size_t i = 0; i < fixed.size(); ++i)
+            edges_[fixedRange.begin + i].child = compile(*fixed[i].second);
+        for (size_t i = 0; i < params.size(); ++i)
+            edges_[paramsRange.begin + i].child = compile(*params[i].second);
+        for (size_t i = 0; i < optionals.size(); ++i)
+            edges_[optionalsRange.begin + i].child = compile(*optionals[i].second);
+
+        if (node.splat_)
+        {
+            const auto splat    = compile(*node.splat_);
+            nodes_[index].splat = splat;
+        }
+
+        return index;
+    }
+
+    const Route* RouteMatcher::match(std::string_view path, std::vector<TypedParam>& params,
+                                     std::vector<TypedParam>& splats) const
+    {
+        const Route* route = nullptr;
+        if (nodes_.empty() || !match(0, path, params, splats, route))
+        {
+            params.clear();
+            splats.clear();
+            return nullptr;
+        }
+        return route;
+    }
+
+    uint32_t RouteMatcher::jumpTable(Range edges, uint32_t offset)
+    {
+        // As sorted, the first segments share no longer a prefix than the
+        // first and the last of them do
+        const auto front = head(edges_[edges.begin].label);
+        const auto back  = head(edges_[edges.end - 1].label);
+        while (offset < front.size() && offset < back.size() && front[offset] == back[offset])
+            ++offset;
+
+        auto byteAt = [&](uint32_t edge) {
+            const auto segment = head(edges_[edge].label);
+            return static_cast<uint8_t>(segment.size() == offset ? '/' : segment[offset]);
+        };
+
+        uint8_t first = UINT8_MAX, last = 0;
+        for (auto edge = edges.begin; edge < edges.end; ++edge)
+        {
+            first = std::min(first, byteAt(edge));
+            last  = std::max(last, byteAt(edge));
+        }
+
+        const auto index = static_cast<uint32_t>(tables_.size());
+        JumpTable table;
+        table.offset = offset;
+        table.begin  = static_cast<uint32_t>(jumps_.size());
+        table.size   = static_cast<uint16_t>(last - first + 1);
+        table.first  = first;
+        tables_.push_back(table);
+        jumps_.resize(jumps_.size() + table.size);
+
+        // The edges sharing a byte there are contiguous, also being sorted.
+        // Only one first segment can end there, others go on to a table of
+        // their own.
+        for (auto edge = edges.begin; edge < edges.end;)
+        {
+            const auto byte = byteAt(edge);
+            auto end        = edge + 1;
+            while (end < edges.end && byteAt(end) == byte)
+                ++end;
+
+            const auto jump = table.begin + (byte - first);
+            if (end - edge == 1)
+                jumps_[jump].edge = edge;
+            else
+                jumps_[jump].table = jumpTable(Range { edge, end }, offset + 1);
+
+            edge = end;
+        }
+
+        return index;
+    }
+
+    uint32_t RouteMatcher::findFixed(const Node& node, std::string_view segment) const
+    {
+        auto index = node.jumps;
+        while (index != Nil)
+        {
+            const auto& table = tables_[index];
+            if (segment.size() < table.offset)
+                return Nil;
+
+            const auto byte = static_cast<uint8_t>(segment.size() == table.offset ? '/' : segment[table.offset]);
+            if (byte < table.first || byte - table.first >= table.size)
+                return Nil;
+
+            const auto& jump = jumps_[table.begin + (byte - table.first)];
+            if (jump.edge != Nil)
+                return jump.edge;
+            index = jump.table;
+        }
+        return Nil;
+    }
+
+    bool RouteMatcher::match(uint32_t index, std::string_view path,
+                             std::vector<TypedParam>& params,
+                             std::vector<TypedParam>& splats, const Route*& route) const
+    {
+        for (;;)
+        {
+            const auto& node = nodes_[index];
+
+            if (path.empty())
+            {
+                // An empty final optional, taken to be the first one when
+                // there are several
+                if (node.optionals.begin != node.optionals.end)
+                {
+                    index = edges_[node.optionals.begin].child;
+                    continue;
+                }
+
+                if (node.route == Nil)
+                    return false;
+
+                route = routes_[node.route].get();
+                return true;
+            }
+
+            const auto delimiter = path.find('/');
+            const auto segment   = path.substr(0, delimiter);
+            const auto rest      = delimiter == std::string_view::npos
+                     ? std::string_view()
+                     : path.substr(delimiter + 1);
+
+            const bool hasAlternatives = node.params.begin != node.params.end
+                || node.optionals.begin != node.optionals.end
+                || node.splat != Nil;
+
+            uint32_t next = Nil;
+            std::string_view nextPath;
+
+            const auto fixed = findFixed(node, segment);
+            if (fixed != Nil)
+            {
+                const auto& edge = edges_[fixed];
+                const auto label = view(edge.label);
+
+                // Along with the segments merged into the edge
+                if (edge.label.headSize == segment.size() && path.size() >= label.size()
+                    && std::memcmp(path.data(), label.data(), label.size()) == 0
+                    && (path.size() == label.size() || path[label.size()] == '/'))
+                {
+                    next     = edge.child;
+                    nextPath = path.size() == label.size()
+                        ? std::string_view()
+                        : path.substr(label.size() + 1);
+                }
+            }
+
+            if (next != Nil)
+            {
+                if (!hasAlternatives)
+                {
+                    index = next;
+                    path  = nextPath;
+                    continue;
+                }
+
+                if (match(next, nextPath, params, splats, route))
+                    return true;
+            }
+
+            for (auto i = node.params.begin; i < node.params.end; ++i)
+            {
+                params.emplace_back(view(edges_[i].label), segment);
+                if (match(edges_[i].child, rest, params, splats, route))
+                    return true;
+                params.pop_back();
+            }
+
+            for (auto i = node.optionals.begin; i < node.optionals.end; ++i)
+            {
+                params.emplace_back(view(edges_[i].label), segment);
+                if (match(edges_[i].child, rest, params, splats, route))
+                    return true;
+                params.pop_back();
+
+                if (match(edges_[i].child, rest, params, splats, route))
+                    return true;
+            }
+
+            if (node.splat != Nil)
+            {
+                splats.emplace_back(segment, segment);
+                if (match(node.splat, rest, params, splats, route))
+                    return true;
+                splats.pop_back();
+            }
+
+            return false;
+        }
+    }
+
     namespace Private
     {
 
         RouterHandler::RouterHandler(const Rest::Router& router)
             : router(std::make_shared<Rest::Router>(router))
-        { }
+        {
+            this->router->compile();
+        }
 
         RouterHandler::RouterHandler(std::shared_ptr<Rest::Router> router)
             : router(std::move(router))
-        { }
+        {
+            this->router->compile();
+        }
 
         void RouterHandler::onRequest(const Http::Request& req,
                                       Http::ResponseWriter response)
@@ -373,6 +769,13 @@ namespace Pistache::Rest
             router->route(req, std::move(response));
         }
 
+        void RouterHandler::onMutableRequest(Http::Request& req,
+                                             Http::ResponseWriter response)
+        {
+            PS_TIMEDBG_START_THIS;
+            router->route(std::move(req), std::move(response));
+        }
+
         void RouterHandler::onDisconnection(const std::shared_ptr<Tcp::Peer>& peer)
         {
             PS_TIMEDBG_START_THIS;
@@ -462,6 +865,7 @@ namespace Pistache::Rest
         auto& r              = routes[method];
         const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
         const std::string_view path { sanitized.data(), sanitized.size() };
+        invalidate();
         r.removeRoute(path);
     }
 
@@ -493,60 +897,57 @@ namespace Pistache::Rest
     void Router::invokeNotFoundHandler(const Http::Request& req,
                                        Http::ResponseWriter resp) const
     {
-        notFoundHandler(Rest::Request(req, std::vector<TypedParam>(),
-                                      std::vector<TypedParam>()),
-                        std::move(resp));
+        notFoundHandler(Rest::Request(Http::Request(req)), std::move(resp));
     }
 
     Route::Status Router::route(const Http::Request& request,
                                 Http::ResponseWriter response) const
+    {
+        return route(Http::Request(request), std::move(response));
+    }
+
+    Route::Status Router::route(Http::Request&& request,
+                                Http::ResponseWriter response) const
     {
         PS_TIMEDBG_START_THIS;
 
-        const auto& resource = request.resource();
-        if (resource.empty())
+        if (request.resource().empty())
             throw std::runtime_error("Invalid zero-length URL.");
 
-        auto req  = request;
-        auto resp = response.clone();
+        // Where the request stays until the handler is done with it, so that
+        // params and splats can view into it
+        Request req(std::move(request));
 
         for (const auto& middleware : middlewares)
         {
-            auto result = middleware(req, resp);
+            auto result = middleware(req, response);
 
             // Handler returns true, go to the next piped handler, otherwise break and return
             if (!result)
                 return Route::Status::Match;
         }
 
-        std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>,
-                   std::vector<TypedParam>>
-            result;
-
-        const auto sanitized = SegmentTreeNode::sanitizeResource(resource);
-        const std::string_view path { sanitized.data(), sanitized.size() };
+        const auto path = SegmentTreeNode::sanitizeResource(req.resource(), req.path_);
 
-        const auto routesIt = routes.find(req.method());
-        if (routesIt != routes.end())
-            result = routesIt->second.findRoute(path);
+        const auto compiled = this->compiled();
 
-        auto route = std::get<0>(result);
-        if (route != nullptr)
+        const auto matcherIt = compiled->find(req.method());
+        if (matcherIt != compiled->end())
         {
-            auto params = std::get<1>(result);
-            auto splats = std::get<2>(result);
-            route->invokeHandler(Request(std::move(req), std::move(params), std::move(splats)),
-                                 std::move(resp));
-            return Route::Status::Match;
+            const auto* route = matcherIt->second.match(path, req.params_, req.splats_);
+            if (route != nullptr)
+            {
+                // The names of the params view into the compiled routes
+                req.routes_ = compiled;
+                route->invokeHandler(req, std::move(response));
+                return Route::Status::Match;
+            }
         }
 
         for (const auto& handler : customHandlers)
         {
-            auto cloned_resp     = response.clone();
-            auto handler1 = handler(
-                Request(req, std::vector<TypedParam>(), std::vector<TypedParam>()),
-                std::move(cloned_resp));
-            if (handler1 == Route::Result::Ok)
+            // Each may decline the request, leaving the response to the next
+            if (handler(req, response.clone()) == Route::Result::Ok)
                 return Route::Status::Match;
         }
 
@@ -558,17 +959,16 @@ namespace Pistache::Rest
         // RFC 7231 requires HTTP 405 responses to include a list of
         // supported methods for the requested resource.
         std::vector<Http::Method> supportedMethods;
-        for (auto& methods : routes)
+        std::vector<TypedParam> params, splats;
+        for (const auto& [method, matcher] : *compiled)
         {
-            if (methods.first == req.method())
+            if (method == req.method())
                 continue;
 
-            auto res = methods.second.findRoute(path);
-            auto rte = std::get<0>(res);
-            if (rte != nullptr)
-            {
-                supportedMethods.push_back(methods.first);
-            }
+            if (matcher.match(path, params, splats) != nullptr)
+                supportedMethods.push_back(method);
+            params.clear();
+            splats.clear();
         }
 
         if (!supportedMethods.empty())
@@ -579,7 +979,7 @@ namespace Pistache::Rest
 
         if (hasNotFoundHandler())
         {
-            invokeNotFoundHandler(req, std::move(response));
+            notFoundHandler(req, std::move(response));
         }
         else
         {
@@ -601,9 +1001,34 @@ namespace Pistache::Rest
                                   std::default_delete<char[]>());
         std::memcpy(ptr.get(), sanitized.data(), sanitized.length());
         const std::string_view path { ptr.get(), sanitized.length() };
+        invalidate();
         r.addRoute(path, handler, ptr);
     }
 
+    void Router::compile() const { compiled(); }
+
+    std::shared_ptr<const Router::CompiledRoutes> Router::compiled() const
+    {
+        auto compiled = std::atomic_load(&compiled_);
+        if (compiled)
+            return compiled;
+
+        // Should routes be compiled by several threads at once, they all
+        // compile the same
+        auto fresh = std::make_shared<CompiledRoutes>();
+        for (const auto& [method, root] : routes)
+            fresh->emplace(method, RouteMatcher(root));
+
+        compiled = std::move(fresh);
+        std::atomic_store(&compiled_, compiled);
+        return compiled;
+    }
+
+    void Router::invalidate()
+    {
+        std::atomic_store(&compiled_, std::shared_ptr<const CompiledRoutes>());
+    }
+
     void Router::disconnectPeer(const std::shared_ptr<Tcp::Peer>& peer)
     {
         PS_TIMEDBG_START_THIS;
@@ -665,5 +1090,87 @@ namespace Pistache::Rest
             router.head(resource, std::move(handler));
         }
 
+        void Prometheus(Router& router, const std::string& resource,
+                        std::function<Pistache::Metrics::Snapshot()> source)
+        {
+            router.get(resource, [source = std::move(source)](const Request&, Http::ResponseWriter response) {
+                response.send(Http::Code::Ok, Pistache::Metrics::toPrometheus(source()),
+                              Http::Mime::MediaType::fromString(Pistache::Metrics::PrometheusContentType));
+                return Route::Result::Ok;
+            });
+        }
+
+        void Prometheus(Router& router, const std::string& resource,
+                        Http::Endpoint& endpoint)
+        {
+            Prometheus(router, resource, [&endpoint] { return endpoint.metrics(); });
+        }
+
+        void Get(Router& router, TypedRoute route)
+        {
+            router.get(route.resource, std::move(route.handler));
+        }
+
+        void Post(Router& router, TypedRoute route)
+        {
+            router.post(route.resource, std::move(route.handler));
+        }
+
+        void Put(Router& router, TypedRoute route)
+        {
+            router.put(route.resource, std::move(route.handler));
+        }
+
+        void Patch(Router& router, TypedRoute route)
+        {
+            router.patch(route.resource, std::move(route.handler));
+        }
+
+        void Delete(Router& router, TypedRoute route)
+        {
+            router.del(route.resource, std::move(route.handler));
+        }
+
+        void Options(Router& router, TypedRoute route)
+        {
+            router.options(route.resource, std::move(route.handler));
+        }
+
+        void Head(Router& router, TypedRoute route)
+        {
+            router.head(route.resource, std::move(route.handler));
+        }
+
+        namespace details
+        {
+            std::string untypedResource(std::string_view path)
+            {
+                std::string resource;
+                resource.reserve(path.size());
+
+                bool inParam = false;
+                for (size_t i = 0; i < path.size(); ++i)
+                {
+                    const char c = path[i];
+                    if (c == '/')
+                        inParam = false;
+                    else if (c == ':' && (i == 0 || path[i - 1] == '/'))
+                        inParam = true;
+
+                    if (inParam && c == '<')
+                    {
+                        const auto close = path.find('>', i);
+                        if (close == std::string_view::npos)
+                            break;
+                        i = close;
+                        continue;
+                    }
+
+                    resource.push_back(c);
+                }
+                return resource;
+            }
+        } // namespace details
+
     } // namespace Routes
 } // namespace Pistache::Rest
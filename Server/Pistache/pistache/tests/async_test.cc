@@ -10,6 +10,8 @@
 #include <pistache/common.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -519,3 +521,84 @@ TEST(async_test, chain_rejects)
     (*rejecter)(std::runtime_error("foo"));
     ASSERT_TRUE(ok);
 }
+
+TEST(async_test, settles_once_while_attaching)
+{
+    // The first continuation meets the settlement without a lock, the
+    // others through the core's list
+    for (int i = 0; i < 1000; ++i)
+    {
+        std::atomic<int> resolved { 0 };
+        std::unique_ptr<Async::Resolver> resolver;
+        Async::Promise<int> promise(
+            [&](Async::Resolver& resolve, Async::Rejection& /*reject*/) {
+                resolver = std::make_unique<Async::Resolver>(std::move(resolve));
+            });
+
+        std::thread producer([&] { (*resolver)(i); });
+        for (int j = 0; j < 3; ++j)
+        {
+            promise.then([&](int v) { resolved += v == i; }, Async::NoExcept);
+        }
+        producer.join();
+
+        ASSERT_EQ(resolved, 3);
+    }
+}
+
+// Not so much a test as a measure of what a then chain costs, as built for
+// every write. In the steady state, no core or continuation comes from the
+// heap.
+TEST(async_test, then_chain_cost)
+{
+    constexpr int Chains = 100000;
+
+    auto chain = [](bool settleFirst) {
+        std::unique_ptr<Async::Resolver> resolver;
+        Async::Promise<ssize_t> promise(
+            [&](Async::Resolver& resolve, Async::Rejection& /*reject*/) {
+                resolver = std::make_unique<Async::Resolver>(std::move(resolve));
+            });
+
+        ssize_t result = 0;
+        if (settleFirst)
+            (*resolver)(ssize_t(42));
+
+        promise
+            .then([](ssize_t bytes) { return bytes * 2; }, Async::Throw)
+            .then([&](ssize_t bytes) { result = bytes; }, Async::NoExcept);
+
+        if (!settleFirst)
+            (*resolver)(ssize_t(42));
+
+        return result;
+    };
+
+    for (bool settleFirst : { true, false })
+    {
+        // Fills the pool
+        for (int i = 0; i < 100; ++i)
+            chain(settleFirst);
+
+        const auto before = Async::Private::poolStats();
+        const auto start  = std::chrono::steady_clock::now();
+        ssize_t total     = 0;
+        for (int i = 0; i < Chains; ++i)
+            total += chain(settleFirst);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto after   = Async::Private::poolStats();
+
+        ASSERT_EQ(total, ssize_t(84) * Chains);
+
+        const auto allocated = after.allocated - before.allocated;
+        const auto reused    = after.reused - before.reused;
+        std::cout << (settleFirst ? "Settled, then attached: " : "Attached, then settled: ")
+                  << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / Chains
+                  << " ns, " << static_cast<double>(allocated) / Chains << " heap and "
+                  << static_cast<double>(reused) / Chains << " pooled allocations per chain"
+                  << std::endl;
+
+        ASSERT_EQ(allocated, 0u);
+        ASSERT_GT(reused, 0u);
+    }
+}
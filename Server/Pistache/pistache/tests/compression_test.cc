@@ -0,0 +1,306 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/compression.h>
+#include <pistache/endpoint.h>
+#include <pistache/file_cache.h>
+#include <pistache/http.h>
+
+#include <httplib.h>
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+#include <zlib.h>
+#endif
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace Pistache;
+
+namespace
+{
+    class TempDir
+    {
+    public:
+        TempDir()
+        {
+            static int counter = 0;
+            path_ = std::filesystem::temp_directory_path() / ("pistache_compression_" + std::to_string(::getpid()) + "_" + std::to_string(counter++));
+            std::filesystem::create_directories(path_);
+        }
+
+        ~TempDir() { std::filesystem::remove_all(path_); }
+
+        std::string write(const std::string& name, const std::string& content) const
+        {
+            const auto file = (path_ / name).string();
+            std::ofstream(file, std::ios::binary | std::ios::trunc) << content;
+            return file;
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    struct FileHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(FileHandler)
+
+        FileHandler(std::string fileName, std::shared_ptr<Http::FileCache> cache)
+            : fileName_(std::move(fileName))
+            , cache_(std::move(cache))
+        { }
+
+        void onRequest(const Http::Request& request, Http::ResponseWriter writer) override
+        {
+            Http::serveFile(request, writer, fileName_, Http::Mime::MediaType(), *cache_);
+        }
+
+    private:
+        std::string fileName_;
+        std::shared_ptr<Http::FileCache> cache_;
+    };
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+    std::string makeBody(size_t size)
+    {
+        std::string body;
+        body.reserve(size);
+        for (size_t i = 0; body.size() < size; ++i)
+            body += "line " + std::to_string(i) + " of a compressible body\n";
+        body.resize(size);
+        return body;
+    }
+
+    std::string uncompress(const std::string& compressed, size_t size)
+    {
+        std::string data(size, '\0');
+        uLongf length = static_cast<uLongf>(size);
+        if (::uncompress(reinterpret_cast<unsigned char*>(data.data()), &length,
+                         reinterpret_cast<const unsigned char*>(compressed.data()),
+                         static_cast<uLong>(compressed.size()))
+            != Z_OK)
+            return std::string();
+
+        data.resize(length);
+        return data;
+    }
+
+    // Sends a body of the size given in the path, compressed when asked to
+    struct SizedHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(SizedHandler)
+
+        void onRequest(const Http::Request& request, Http::ResponseWriter writer) override
+        {
+            const auto size = std::stoul(request.resource().substr(1));
+            writer.setCompression(request.getBestAcceptEncoding());
+            writer.send(Http::Code::Ok, makeBody(size));
+        }
+    };
+#endif
+}
+
+TEST(compression_test, unsupported_encoding)
+{
+    const std::string body(4096, 'x');
+    ASSERT_THROW(Http::compress(Http::Header::Encoding::Gzip, 0, body.data(), body.size()),
+                 std::runtime_error);
+}
+
+TEST(compression_test, runs_posted_tasks)
+{
+    const auto caller = std::this_thread::get_id();
+
+    Http::Compressor compressor(Http::Compressor::options().threads(2));
+    std::atomic<int> ran { 0 };
+    std::atomic<int> elsewhere { 0 };
+    for (int i = 0; i < 16; ++i)
+    {
+        compressor.post([&] {
+            if (std::this_thread::get_id() != caller)
+                ++elsewhere;
+            ++ran;
+        });
+    }
+
+    compressor.wait();
+    ASSERT_EQ(ran, 16);
+    ASSERT_EQ(elsewhere, 16);
+
+    // Without threads, tasks run right away
+    Http::Compressor inline_(Http::Compressor::options().threads(0));
+    bool done = false;
+    inline_.post([&] { done = true; });
+    ASSERT_TRUE(done);
+    ASSERT_FALSE(inline_.compressesAsync(100 * 1024 * 1024));
+}
+
+TEST(compression_test, thresholds)
+{
+    Http::Compressor compressor(Http::Compressor::options().minSize(100).asyncMinSize(1000));
+
+    ASSERT_FALSE(compressor.shouldCompress(99));
+    ASSERT_TRUE(compressor.shouldCompress(100));
+    ASSERT_FALSE(compressor.compressesAsync(999));
+    ASSERT_TRUE(compressor.compressesAsync(1000));
+}
+
+#ifdef PISTACHE_USE_CONTENT_ENCODING_DEFLATE
+TEST(compression_test, caches_compressed_bodies)
+{
+    Http::Compressor compressor(Http::Compressor::options().maxCachedBodies(2).maxCachedSize(8192));
+    const auto deflate = Http::Header::Encoding::Deflate;
+
+    const auto body = makeBody(4096);
+    auto first      = compressor.compress(deflate, Z_DEFAULT_COMPRESSION, body.data(), body.size());
+    ASSERT_EQ(uncompress(*first, body.size()), body);
+    ASSERT_EQ(compressor.cacheSize(), 1u);
+    ASSERT_EQ(compressor.cacheMemoryUsage(), body.size() + first->size());
+
+    // The same content, from another buffer
+    const std::string copy = body;
+    ASSERT_EQ(compressor.find(deflate, Z_DEFAULT_COMPRESSION, copy.data(), copy.size()), first);
+    ASSERT_EQ(compressor.compress(deflate, Z_DEFAULT_COMPRESSION, copy.data(), copy.size()), first);
+    ASSERT_EQ(compressor.cacheHits(), 2u);
+
+    // Another level is another entry
+    ASSERT_FALSE(compressor.find(deflate, Z_BEST_COMPRESSION, body.data(), body.size()));
+    compressor.compress(deflate, Z_BEST_COMPRESSION, body.data(), body.size());
+    ASSERT_EQ(compressor.cacheSize(), 2u);
+
+    // Too large to be cached
+    const auto large = makeBody(16384);
+    auto compressed  = compressor.compress(deflate, Z_DEFAULT_COMPRESSION, large.data(), large.size());
+    ASSERT_EQ(uncompress(*compressed, large.size()), large);
+    ASSERT_EQ(compressor.cacheSize(), 2u);
+
+    // The least recently used goes first
+    const auto other = makeBody(2048);
+    compressor.compress(deflate, Z_DEFAULT_COMPRESSION, other.data(), other.size());
+    ASSERT_EQ(compressor.cacheSize(), 2u);
+    ASSERT_TRUE(compressor.find(deflate, Z_BEST_COMPRESSION, body.data(), body.size()));
+    ASSERT_FALSE(compressor.find(deflate, Z_DEFAULT_COMPRESSION, body.data(), body.size()));
+
+    compressor.clearCache();
+    ASSERT_EQ(compressor.cacheSize(), 0u);
+    ASSERT_EQ(compressor.cacheMemoryUsage(), 0u);
+}
+
+TEST(compression_test, server_compresses_through_compressor)
+{
+    auto compressor = std::make_shared<Http::Compressor>(
+        Http::Compressor::options().minSize(256).asyncMinSize(64 * 1024));
+
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(1).compressor(compressor));
+    server.setHandler(Http::make_handler<SizedHandler>());
+    server.serveThreaded();
+
+    httplib::Client client("localhost", server.getPort());
+    client.set_decompress(false);
+    const httplib::Headers deflate = { { "Accept-Encoding", "deflate" } };
+
+    // Below the threshold
+    auto res = client.Get("/100", deflate);
+    ASSERT_TRUE(res);
+    ASSERT_FALSE(res->has_header("Content-Encoding"));
+    ASSERT_EQ(res->body, makeBody(100));
+
+    res = client.Get("/4096", deflate);
+    ASSERT_EQ(res->get_header_value("Content-Encoding"), "deflate");
+    ASSERT_EQ(uncompress(res->body, 4096), makeBody(4096));
+
+    res = client.Get("/4096", deflate);
+    ASSERT_EQ(uncompress(res->body, 4096), makeBody(4096));
+    ASSERT_EQ(compressor->cacheHits(), 1u);
+
+    // Compressed on the compressor's thread, then written by the transport.
+    // The connection goes on with the next request once it has been.
+    for (int i = 0; i < 2; ++i)
+    {
+        res = client.Get("/200000", deflate);
+        ASSERT_TRUE(res);
+        ASSERT_EQ(res->get_header_value("Content-Encoding"), "deflate");
+        ASSERT_EQ(uncompress(res->body, 200000), makeBody(200000));
+    }
+    ASSERT_EQ(compressor->cacheHits(), 2u);
+
+    res = client.Get("/4096");
+    ASSERT_FALSE(res->has_header("Content-Encoding"));
+
+    server.shutdown();
+}
+#endif
+
+TEST(compression_test, serves_precompressed_files)
+{
+    TempDir dir;
+    const auto file = dir.write("page.txt", "the uncompressed page");
+    dir.write("page.txt.gz", "gzipped page");
+    dir.write("page.txt.br", "brotli page");
+
+    auto cache = std::make_shared<Http::FileCache>();
+    cache->setPrecompressed(true);
+
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<FileHandler>(file, cache));
+    server.serveThreaded();
+
+    httplib::Client client("localhost", server.getPort());
+    client.set_decompress(false);
+
+    auto res = client.Get("/", { { "Accept-Encoding", "gzip" } });
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->status, 200);
+    ASSERT_EQ(res->body, "gzipped page");
+    ASSERT_EQ(res->get_header_value("Content-Encoding"), "gzip");
+    ASSERT_EQ(res->get_header_value("Content-Type"), "text/plain");
+    ASSERT_EQ(res->get_header_value("Vary"), "Accept-Encoding");
+    const auto etag = res->get_header_value("ETag");
+
+    // The client's preference, then whatever exists
+    res = client.Get("/", { { "Accept-Encoding", "gzip;q=0.5, br" } });
+    ASSERT_EQ(res->body, "brotli page");
+    ASSERT_EQ(res->get_header_value("Content-Encoding"), "br");
+
+    res = client.Get("/", { { "Accept-Encoding", "zstd, gzip;q=0.1" } });
+    ASSERT_EQ(res->body, "gzipped page");
+
+    res = client.Get("/", { { "Accept-Encoding", "gzip;q=0" } });
+    ASSERT_EQ(res->body, "the uncompressed page");
+    ASSERT_FALSE(res->has_header("Content-Encoding"));
+    ASSERT_EQ(res->get_header_value("Vary"), "Accept-Encoding");
+
+    // Validators and ranges are those of the precompressed file
+    ASSERT_NE(res->get_header_value("ETag"), etag);
+    res = client.Get("/", { { "Accept-Encoding", "gzip" }, { "Range", "bytes=0-6" } });
+    ASSERT_EQ(res->status, 206);
+    ASSERT_EQ(res->body, "gzipped");
+
+    // Left behind by a change to the file
+    const auto gz = dir.write("page.txt.gz", "stale gzipped page");
+    std::filesystem::last_write_time(gz, std::filesystem::last_write_time(file) - std::chrono::hours(1));
+    res = client.Get("/", { { "Accept-Encoding", "gzip" } });
+    ASSERT_EQ(res->body, "the uncompressed page");
+
+    cache->setPrecompressed(false);
+    res = client.Get("/", { { "Accept-Encoding", "br" } });
+    ASSERT_EQ(res->body, "the uncompressed page");
+    ASSERT_FALSE(res->has_header("Vary"));
+
+    server.shutdown();
+}
@@ -0,0 +1,265 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/endpoint.h>
+#include <pistache/file_cache.h>
+#include <pistache/http.h>
+
+#include <httplib.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace Pistache;
+
+namespace
+{
+    class TempFile
+    {
+    public:
+        explicit TempFile(const std::string& content)
+        {
+            static int counter = 0;
+            path_ = (std::filesystem::temp_directory_path() / ("pistache_file_cache_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + ".txt")).string();
+            write(content);
+        }
+
+        ~TempFile() { std::filesystem::remove(path_); }
+
+        void write(const std::string& content) const
+        {
+            std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+            file << content;
+        }
+
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+    // Only reads up to the end of the response headers
+    std::string requestHead(Port port, const std::string& header)
+    {
+        std::string head;
+
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr     = {};
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            return head;
+
+        const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n" + header + "\r\n\r\n";
+        ::send(fd, request.data(), request.size(), 0);
+
+        char c;
+        while (head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0)
+        {
+            if (::recv(fd, &c, 1, 0) != 1)
+                break;
+            head.push_back(c);
+        }
+
+        ::close(fd);
+        return head;
+    }
+
+    struct FileHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(FileHandler)
+
+        explicit FileHandler(std::string fileName)
+            : fileName_(std::move(fileName))
+        { }
+
+        void onRequest(const Http::Request& request, Http::ResponseWriter writer) override
+        {
+            Http::serveFile(request, writer, fileName_);
+        }
+
+    private:
+        std::string fileName_;
+    };
+}
+
+TEST(file_cache_test, keeps_files_open)
+{
+    TempFile tmp("Hello, World!");
+    Http::FileCache cache;
+
+    auto first  = cache.get(tmp.path());
+    auto second = cache.get(tmp.path());
+
+    ASSERT_EQ(first->file, second->file);
+    ASSERT_EQ(first->etag, second->etag);
+    ASSERT_EQ(second->size, 13u);
+    ASSERT_EQ(second->mime, MIME(Text, Plain));
+    ASSERT_EQ(cache.size(), 1u);
+}
+
+TEST(file_cache_test, drops_modified_files)
+{
+    TempFile tmp("Hello, World!");
+    Http::FileCache cache;
+
+    auto before = cache.get(tmp.path());
+    tmp.write("Hello again, World!");
+    auto after = cache.get(tmp.path());
+
+    ASSERT_NE(before->file, after->file);
+    ASSERT_NE(before->etag, after->etag);
+    ASSERT_EQ(after->size, 19u);
+}
+
+TEST(file_cache_test, holds_small_hot_files_in_memory)
+{
+    TempFile small("small");
+    TempFile large(std::string(1024, 'x'));
+    Http::FileCache cache(16, 4096, 512);
+
+    ASSERT_FALSE(cache.get(small.path())->content);
+    auto hot = cache.get(small.path());
+    ASSERT_TRUE(hot->content);
+    ASSERT_EQ(*hot->content, "small");
+    ASSERT_EQ(cache.memoryUsage(), 5u);
+
+    cache.get(large.path());
+    ASSERT_FALSE(cache.get(large.path())->content);
+    ASSERT_EQ(cache.memoryUsage(), 5u);
+
+    cache.invalidate(small.path());
+    ASSERT_EQ(cache.memoryUsage(), 0u);
+}
+
+TEST(file_cache_test, evicts_least_recently_used)
+{
+    TempFile a("a"), b("b"), c("c");
+    Http::FileCache cache(2);
+
+    auto first = cache.get(a.path());
+    cache.get(b.path());
+    cache.get(c.path());
+    ASSERT_EQ(cache.size(), 2u);
+
+    ASSERT_NE(cache.get(a.path())->file, first->file);
+}
+
+TEST(file_cache_test, finds_sidecars_created_after_a_miss)
+{
+    TempFile tmp("Hello, World!");
+    Http::FileCache cache;
+
+    cache.get(tmp.path());
+    ASSERT_FALSE(cache.tryGetSidecar(tmp.path(), ".gz"));
+    ASSERT_FALSE(cache.tryGetSidecar(tmp.path(), ".gz"));
+
+    {
+        std::ofstream sidecar(tmp.path() + ".gz", std::ios::binary);
+        sidecar << "compressed";
+    }
+
+    auto sidecar = cache.tryGetSidecar(tmp.path(), ".gz");
+    std::filesystem::remove(tmp.path() + ".gz");
+    ASSERT_TRUE(sidecar);
+    ASSERT_EQ(sidecar->size, 10u);
+}
+
+TEST(file_cache_test, missing_file)
+{
+    Http::FileCache cache;
+
+    try
+    {
+        cache.get("/this/file/does/not/exist");
+        FAIL() << "Expected an HttpError";
+    }
+    catch (const Http::HttpError& error)
+    {
+        ASSERT_EQ(error.code(), static_cast<int>(Http::Code::Not_Found));
+    }
+    ASSERT_EQ(cache.size(), 0u);
+}
+
+TEST(file_cache_test, serve_file_validators_and_ranges)
+{
+    TempFile tmp("0123456789abcdefghij");
+
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<FileHandler>(tmp.path()));
+    server.serveThreaded();
+
+    httplib::Client client("localhost", server.getPort());
+
+    auto res = client.Get("/");
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->status, 200);
+    ASSERT_EQ(res->body, "0123456789abcdefghij");
+    ASSERT_EQ(res->get_header_value("Accept-Ranges"), "bytes");
+    ASSERT_TRUE(res->has_header("Last-Modified"));
+
+    const auto etag         = res->get_header_value("ETag");
+    const auto lastModified = res->get_header_value("Last-Modified");
+    ASSERT_EQ(etag.front(), '"');
+
+    // A 304 has no body, nor a Content-Length, which some clients wait for
+    // the connection to be closed on
+    auto head = requestHead(server.getPort(), "If-None-Match: \"other\", " + etag);
+    ASSERT_EQ(head.rfind("HTTP/1.1 304 Not Modified\r\n", 0), 0u);
+    ASSERT_NE(head.find("ETag: " + etag + "\r\n"), std::string::npos);
+    ASSERT_EQ(head.find("Content-Length"), std::string::npos);
+
+    head = requestHead(server.getPort(), "If-Modified-Since: " + lastModified);
+    ASSERT_EQ(head.rfind("HTTP/1.1 304 Not Modified\r\n", 0), 0u);
+
+    res = client.Get("/", { { "If-None-Match", "\"other\"" } });
+    ASSERT_EQ(res->status, 200);
+
+    res = client.Get("/", { { "Range", "bytes=2-5" } });
+    ASSERT_EQ(res->status, 206);
+    ASSERT_EQ(res->body, "2345");
+    ASSERT_EQ(res->get_header_value("Content-Range"), "bytes 2-5/20");
+
+    res = client.Get("/", { { "Range", "bytes=-3" } });
+    ASSERT_EQ(res->status, 206);
+    ASSERT_EQ(res->body, "hij");
+
+    res = client.Get("/", { { "Range", "bytes=0-1, 10-" } });
+    ASSERT_EQ(res->status, 206);
+    ASSERT_EQ(res->get_header_value("Content-Type").rfind("multipart/byteranges; boundary=", 0), 0u);
+    ASSERT_NE(res->body.find("Content-Range: bytes 0-1/20\r\n\r\n01\r\n"), std::string::npos);
+    ASSERT_NE(res->body.find("Content-Range: bytes 10-19/20\r\n\r\nabcdefghij\r\n"), std::string::npos);
+
+    res = client.Get("/", { { "Range", "bytes=50-60" } });
+    ASSERT_EQ(res->status, 416);
+    ASSERT_EQ(res->get_header_value("Content-Range"), "bytes */20");
+
+    // Ranges of another version of the file are not sent
+    res = client.Get("/", { { "Range", "bytes=2-5" }, { "If-Range", "\"other\"" } });
+    ASSERT_EQ(res->status, 200);
+    ASSERT_EQ(res->body.size(), 20u);
+
+    res = client.Head("/");
+    ASSERT_EQ(res->status, 200);
+    ASSERT_EQ(res->get_header_value("Content-Length"), "20");
+    ASSERT_TRUE(res->body.empty());
+
+    // The connection is still usable after a HEAD
+    res = client.Get("/", { { "Range", "bytes=0-0" } });
+    ASSERT_EQ(res->body, "0");
+
+    server.shutdown();
+}
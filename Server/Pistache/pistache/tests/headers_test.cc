@@ -14,6 +14,8 @@
 #include <chrono>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 using testing::ElementsAre;
 using testing::SizeIs;
@@ -390,6 +392,11 @@ TEST(headers_test, content_length)
 
     ASSERT_EQ("3495", oss.str());
     ASSERT_EQ(cl.value(), 3495U);
+
+    ASSERT_THROW(cl.parse("abc"), std::invalid_argument);
+    ASSERT_THROW(cl.parse("12abc"), std::invalid_argument);
+    ASSERT_THROW(cl.parse(""), std::invalid_argument);
+    ASSERT_THROW(cl.parse("99999999999999999999"), std::invalid_argument);
 }
 
 // Verify authorization header with basic method works correctly...
@@ -791,6 +798,20 @@ TEST(headers_test, last_modified_test)
     ASSERT_EQ(ref, oss.str());
 }
 
+TEST(headers_test, etag_test)
+{
+    Pistache::Http::Header::ETag e0("\"5f-1a\"");
+    std::ostringstream oss;
+    e0.write(oss);
+    ASSERT_EQ("\"5f-1a\"", oss.str());
+    ASSERT_FALSE(e0.isWeak());
+
+    Pistache::Http::Header::ETag e1;
+    e1.parse("W/\"5f-1a\"");
+    ASSERT_EQ("W/\"5f-1a\"", e1.tag());
+    ASSERT_TRUE(e1.isWeak());
+}
+
 TEST(headers_test, location_test)
 {
 
@@ -1016,3 +1037,96 @@ TEST(headers_test, cookie_headers_are_case_insensitive)
         ASSERT_EQ(request.cookies().get("x").value, "y");
     }
 }
+
+TEST(headers_test, parsed_headers_are_typed_on_first_lookup)
+{
+    std::string lines = "content-length: 42\r\n"
+                        "X-Custom: a\r\n"
+                        "Content-Length: 7\r\n"
+                        "\r\n";
+
+    Pistache::RawStreamBuf<> buf(&lines[0], lines.size());
+    Pistache::StreamCursor cursor(&buf);
+    Pistache::Http::Request request;
+    Pistache::Http::Private::HeadersStep step(&request);
+    ASSERT_EQ(step.apply(cursor), Pistache::Http::Private::State::Next);
+
+    auto& headers = request.headers();
+
+    // The first header of a name wins, and is only built once
+    auto cl = headers.tryGet<Pistache::Http::Header::ContentLength>();
+    ASSERT_NE(cl, nullptr);
+    ASSERT_EQ(cl->value(), 42u);
+    ASSERT_EQ(headers.tryGet<Pistache::Http::Header::ContentLength>(), cl);
+    ASSERT_FALSE(headers.has<Pistache::Http::Header::Host>());
+
+    ASSERT_EQ(headers.tryGetRaw("x-custom")->value(), "a");
+    ASSERT_EQ(headers.list().size(), 1u);
+
+    // Removing the typed header leaves the raw one
+    ASSERT_TRUE(headers.remove<Pistache::Http::Header::ContentLength>());
+    ASSERT_FALSE(headers.has<Pistache::Http::Header::ContentLength>());
+    ASSERT_EQ(headers.tryGetRaw("Content-Length")->value(), "42");
+    ASSERT_EQ(headers.list().size(), 0u);
+    ASSERT_EQ(headers.rawList().size(), 2u);
+}
+
+TEST(headers_test, malformed_parsed_header_reads_as_absent)
+{
+    std::string lines = "Date: not a date\r\n"
+                        "Content-Length: 42\r\n"
+                        "\r\n";
+
+    Pistache::RawStreamBuf<> buf(&lines[0], lines.size());
+    Pistache::StreamCursor cursor(&buf);
+    Pistache::Http::Request request;
+    Pistache::Http::Private::HeadersStep step(&request);
+    ASSERT_EQ(step.apply(cursor), Pistache::Http::Private::State::Next);
+
+    const auto& headers = request.headers();
+
+    ASSERT_EQ(headers.tryGet<Pistache::Http::Header::Date>(), nullptr);
+    ASSERT_FALSE(headers.has<Pistache::Http::Header::Date>());
+    ASSERT_THROW(headers.get<Pistache::Http::Header::Date>(), std::runtime_error);
+    ASSERT_EQ(headers.list().size(), 1u);
+
+    // It is still there as it was received
+    ASSERT_EQ(headers.tryGetRaw("Date")->value(), "not a date");
+}
+
+TEST(headers_test, parsed_headers_are_built_once_across_threads)
+{
+    std::string lines = "Content-Length: 42\r\n"
+                        "X-Custom: a\r\n"
+                        "\r\n";
+
+    Pistache::RawStreamBuf<> buf(&lines[0], lines.size());
+    Pistache::StreamCursor cursor(&buf);
+    Pistache::Http::Request request;
+    Pistache::Http::Private::HeadersStep step(&request);
+    ASSERT_EQ(step.apply(cursor), Pistache::Http::Private::State::Next);
+
+    const auto& headers = request.headers();
+
+    constexpr size_t Threads = 4;
+    std::vector<std::shared_ptr<const Pistache::Http::Header::ContentLength>> seen(Threads);
+    std::vector<size_t> rawSizes(Threads);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < Threads; ++i)
+    {
+        threads.emplace_back([&, i] {
+            seen[i]     = headers.tryGet<Pistache::Http::Header::ContentLength>();
+            rawSizes[i] = headers.rawList().size();
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    ASSERT_NE(seen[0], nullptr);
+    for (size_t i = 0; i < Threads; ++i)
+    {
+        ASSERT_EQ(seen[i], seen[0]);
+        ASSERT_EQ(rawSizes[i], 2u);
+    }
+    ASSERT_EQ(seen[0]->value(), 42u);
+}
@@ -10,8 +10,16 @@
 
 #include <gtest/gtest.h>
 
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <atomic>
 #include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace Pistache;
 
@@ -82,8 +90,141 @@ struct QueryBounceHandler : public Http::Handler
 namespace
 {
     std::string largeContent(4097, 'a');
+
+    // Accepts a single connection, and answers its requests only once
+    // count of them came in, all at once, each response holding the path of
+    // its request
+    class PipelineServer
+    {
+    public:
+        explicit PipelineServer(size_t count)
+        {
+            listener_            = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr     = {};
+            addr.sin_family      = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t len        = sizeof(addr);
+            ::bind(listener_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            ::listen(listener_, 4);
+            ::getsockname(listener_, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+
+            thread_ = std::thread([this, count] { serve(count); });
+        }
+
+        ~PipelineServer()
+        {
+            thread_.join();
+            ::close(listener_);
+        }
+
+        uint16_t port() const { return port_; }
+
+    private:
+        void serve(size_t count)
+        {
+            pollfd listening = { listener_, POLLIN, 0 };
+            if (::poll(&listening, 1, 5000) != 1)
+                return;
+
+            const int fd = ::accept(listener_, nullptr, nullptr);
+            std::string received;
+            std::vector<std::string> paths;
+            while (paths.size() < count)
+            {
+                pollfd reading = { fd, POLLIN, 0 };
+                char buffer[1024];
+                if (::poll(&reading, 1, 5000) != 1)
+                    break;
+                const auto bytes = ::recv(fd, buffer, sizeof(buffer), 0);
+                if (bytes <= 0)
+                    break;
+                received.append(buffer, static_cast<size_t>(bytes));
+
+                size_t end;
+                while ((end = received.find("\r\n\r\n")) != std::string::npos)
+                {
+                    const auto start = received.find(' ') + 1;
+                    paths.push_back(received.substr(start, received.find(' ', start) - start));
+                    received.erase(0, end + 4);
+                }
+            }
+
+            std::string responses;
+            for (const auto& path : paths)
+                responses += "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(path.size()) + "\r\n\r\n" + path;
+            ::send(fd, responses.data(), responses.size(), 0);
+
+            // Until the client is done with the connection
+            pollfd closing = { fd, POLLIN, 0 };
+            ::poll(&closing, 1, 5000);
+            ::close(fd);
+        }
+
+        int listener_;
+        uint16_t port_;
+        std::thread thread_;
+    };
+}
+
+namespace
+{
+    std::string makeBigBody()
+    {
+        std::string body;
+        for (size_t i = 0; body.size() < 1024 * 1024; ++i)
+            body += std::to_string(i) + '\n';
+        return body;
+    }
+
+    const std::string bigBody = makeBigBody();
+
+    // Pauses after the first part of the body
+    class PausingReader : public Http::BodyReader
+    {
+    public:
+        void onData(const char* data, size_t len) override
+        {
+            received_.append(data, len);
+            if (!paused_once_)
+            {
+                paused_once_ = true;
+                pause();
+            }
+        }
+
+        size_t size() const { return received_.size(); }
+        const std::string& received() const { return received_; }
+
+    private:
+        std::string received_;
+        bool paused_once_ = false;
+    };
 }
 
+struct BigBodyHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(BigBodyHandler)
+
+    void onRequest(const Http::Request& /*request*/,
+                   Http::ResponseWriter writer) override
+    {
+        writer.send(Http::Code::Ok, bigBody);
+    }
+};
+
+struct SlowHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(SlowHandler)
+
+    void onRequest(const Http::Request& /*request*/,
+                   Http::ResponseWriter writer) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        writer.send(Http::Code::Ok, "Hello, World!");
+    }
+};
+
 struct LargeContentHandler : public Http::Handler
 {
     HTTP_PROTOTYPE(LargeContentHandler)
@@ -629,3 +770,176 @@ TEST(http_client_test, client_do_not_get_large_content)
     ASSERT_FALSE(ok_flag);
     ASSERT_TRUE(exception_flag);
 }
+
+TEST(http_client_test, pipelines_requests_on_one_connection)
+{
+    const size_t RequestsCount = 4;
+    PipelineServer server(RequestsCount);
+
+    Http::Experimental::Client client;
+    client.init(Http::Experimental::Client::options()
+                    .maxConnectionsPerHost(1)
+                    .pipelineDepth(RequestsCount));
+
+    // The server answers none until it has them all
+    std::vector<Async::Promise<Http::Response>> responses;
+    std::vector<std::string> bodies(RequestsCount);
+    for (size_t i = 0; i < RequestsCount; ++i)
+    {
+        const auto page = "127.0.0.1:" + std::to_string(server.port()) + "/" + std::to_string(i);
+        auto response   = client.get(page).send();
+        response.then([&bodies, i](Http::Response rsp) { bodies[i] = rsp.body(); },
+                      Async::IgnoreException);
+        responses.push_back(std::move(response));
+    }
+
+    auto sync = Async::whenAll(responses.begin(), responses.end());
+    Async::Barrier<std::vector<Http::Response>> barrier(sync);
+    barrier.wait_for(std::chrono::seconds(5));
+
+    client.shutdown();
+
+    for (size_t i = 0; i < RequestsCount; ++i)
+        ASSERT_EQ(bodies[i], "/" + std::to_string(i));
+}
+
+TEST(http_client_test, full_queue_blocks_send)
+{
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<SlowHandler>());
+    server.serveThreaded();
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+
+    Http::Experimental::Client client;
+    client.init(Http::Experimental::Client::options()
+                    .maxConnectionsPerHost(1)
+                    .maxQueuedRequests(1));
+
+    std::vector<Async::Promise<Http::Response>> responses;
+    std::atomic<int> response_counter(0);
+    auto send = [&]() {
+        auto response = client.get(server_address).send();
+        response.then(
+            [&](Http::Response rsp) {
+                if (rsp.code() == Http::Code::Ok)
+                    ++response_counter;
+            },
+            Async::IgnoreException);
+        responses.push_back(std::move(response));
+    };
+
+    // One on the connection, and one waiting for it
+    send();
+    send();
+
+    // Then no room until the first is answered
+    const auto start = std::chrono::steady_clock::now();
+    send();
+    const auto waited = std::chrono::steady_clock::now() - start;
+    ASSERT_LE(client.queuedRequests(), 1u);
+
+    auto sync = Async::whenAll(responses.begin(), responses.end());
+    Async::Barrier<std::vector<Http::Response>> barrier(sync);
+    barrier.wait_for(std::chrono::seconds(5));
+
+    server.shutdown();
+    client.shutdown();
+
+    ASSERT_GE(waited, std::chrono::milliseconds(100));
+    ASSERT_EQ(response_counter, 3);
+}
+
+TEST(http_client_test, streams_response_body)
+{
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<BigBodyHandler>());
+    server.serveThreaded();
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+
+    // Far less than the body, which is never held whole
+    Http::Experimental::Client client;
+    client.init(Http::Experimental::Client::options().maxResponseSize(64 * 1024));
+
+    std::atomic<size_t> received(0);
+    std::string body;
+    auto response = client.get(server_address).stream([&](const char* data, size_t len) {
+        body.append(data, len);
+        received += len;
+    });
+
+    Async::Barrier<Http::Response> headersBarrier(response.headers);
+    headersBarrier.wait_for(std::chrono::seconds(5));
+
+    Http::Code code       = Http::Code::Internal_Server_Error;
+    size_t headersBodyLen = 1;
+    response.headers.then(
+        [&](Http::Response rsp) {
+            code           = rsp.code();
+            headersBodyLen = rsp.body().size();
+        },
+        Async::IgnoreException);
+
+    Async::Barrier<Http::Response> doneBarrier(response.done);
+    doneBarrier.wait_for(std::chrono::seconds(5));
+
+    bool done = false;
+    response.done.then([&](Http::Response rsp) { done = rsp.body().empty(); },
+                       Async::IgnoreException);
+
+    server.shutdown();
+    client.shutdown();
+
+    ASSERT_EQ(code, Http::Code::Ok);
+    ASSERT_EQ(headersBodyLen, 0u);
+    ASSERT_TRUE(done);
+    ASSERT_EQ(received.load(), bigBody.size());
+    ASSERT_EQ(body, bigBody);
+}
+
+TEST(http_client_test, paused_reader_stops_reading)
+{
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<BigBodyHandler>());
+    server.serveThreaded();
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+
+    Http::Experimental::Client client;
+    client.init();
+
+    auto reader   = std::make_shared<PausingReader>();
+    auto response = client.get(server_address).stream(reader);
+
+    Async::Barrier<Http::Response> headersBarrier(response.headers);
+    headersBarrier.wait_for(std::chrono::seconds(5));
+
+    // Nothing more comes in until resumed
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const size_t whilePaused = reader->size();
+    ASSERT_TRUE(reader->isPaused());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_EQ(reader->size(), whilePaused);
+    ASSERT_LT(whilePaused, bigBody.size());
+
+    reader->resume();
+
+    Async::Barrier<Http::Response> doneBarrier(response.done);
+    doneBarrier.wait_for(std::chrono::seconds(5));
+
+    server.shutdown();
+    client.shutdown();
+
+    ASSERT_TRUE(response.done.isFulfilled());
+    ASSERT_EQ(reader->received(), bigBody);
+}
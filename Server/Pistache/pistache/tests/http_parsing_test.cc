@@ -76,6 +76,34 @@ TEST(http_parsing_test, parser_reset)
     ASSERT_EQ(parser.request.body(), "");
 }
 
+TEST(http_parsing_test, bad_content_length_is_refused)
+{
+    // Were the length taken as absent, the body would be parsed as a second,
+    // smuggled, request
+    for (const char* length : { "abc", "99999999999999999999", "5x", "-5" })
+    {
+        Http::RequestParser parser(Const::DefaultMaxRequestSize);
+
+        const std::string data = std::string("POST /a HTTP/1.1\r\n"
+                                             "Host: localhost\r\n"
+                                             "Content-Length: ")
+            + length + "\r\n\r\n"
+                       "GET /smuggled HTTP/1.1\r\n"
+                       "Host: localhost\r\n\r\n";
+        parser.feed(data.data(), data.size());
+
+        try
+        {
+            parser.parse();
+            FAIL() << "Content-Length: " << length << " was accepted";
+        }
+        catch (const Http::HttpError& error)
+        {
+            ASSERT_EQ(error.code(), static_cast<int>(Http::Code::Bad_Request)) << length;
+        }
+    }
+}
+
 TEST(http_parsing_test, succ_response_line_step)
 {
     Http::Response response;
@@ -33,6 +33,8 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <future>
 #include <mutex>
@@ -494,6 +496,129 @@ TEST(http_server_test, many_client_with_requests_to_multithreaded_server)
 #endif
 }
 
+TEST(http_server_test, many_client_with_requests_to_per_worker_accept_server)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    auto flags       = Tcp::Options::ReuseAddr;
+    auto server_opts = Http::Endpoint::options()
+                           .flags(flags)
+                           .threads(4)
+                           .perWorkerAccept(true)
+                           .acceptCpuSteering(true);
+    server.init(server_opts);
+    LOGGER("test", "Trying to run server...");
+    server.setHandler(Http::make_handler<HelloHandlerWithDelay>());
+    ASSERT_NO_THROW(server.serveThreaded());
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+    LOGGER("test", "Server address: " << server_address);
+
+    const int NO_TIMEOUT                = 0;
+    const int SECONDS_TIMOUT            = 20;
+    const int FIRST_CLIENT_REQUEST_SIZE = 64;
+    std::future<int> result1(std::async(clientLogicFunc,
+                                        FIRST_CLIENT_REQUEST_SIZE, server_address,
+                                        NO_TIMEOUT, SECONDS_TIMOUT));
+    const int SECOND_CLIENT_REQUEST_SIZE = 96;
+    std::future<int> result2(
+        std::async(clientLogicFunc, SECOND_CLIENT_REQUEST_SIZE, server_address,
+                   NO_TIMEOUT, SECONDS_TIMOUT));
+
+    int res1 = result1.get();
+    int res2 = result2.get();
+
+    server.shutdown();
+
+    ASSERT_EQ(res1, FIRST_CLIENT_REQUEST_SIZE);
+    ASSERT_EQ(res2, SECOND_CLIENT_REQUEST_SIZE);
+}
+
+TEST(http_server_test, many_client_with_requests_to_io_uring_server)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    auto flags       = Tcp::Options::ReuseAddr;
+    auto server_opts = Http::Endpoint::options()
+                           .flags(flags)
+                           .threads(4)
+                           .pollingBackend(Polling::Backend::IoUring);
+    server.init(server_opts);
+    LOGGER("test", "Trying to run server...");
+    server.setHandler(Http::make_handler<HelloHandlerWithDelay>());
+    ASSERT_NO_THROW(server.serveThreaded());
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+    LOGGER("test", "Server address: " << server_address);
+
+    const int NO_TIMEOUT                = 0;
+    const int SECONDS_TIMOUT            = 20;
+    const int FIRST_CLIENT_REQUEST_SIZE = 64;
+    std::future<int> result1(std::async(clientLogicFunc,
+                                        FIRST_CLIENT_REQUEST_SIZE, server_address,
+                                        NO_TIMEOUT, SECONDS_TIMOUT));
+    const int SECOND_CLIENT_REQUEST_SIZE = 96;
+    std::future<int> result2(
+        std::async(clientLogicFunc, SECOND_CLIENT_REQUEST_SIZE, server_address,
+                   NO_TIMEOUT, SECONDS_TIMOUT));
+
+    int res1 = result1.get();
+    int res2 = result2.get();
+
+    server.shutdown();
+
+    ASSERT_EQ(res1, FIRST_CLIENT_REQUEST_SIZE);
+    ASSERT_EQ(res2, SECOND_CLIENT_REQUEST_SIZE);
+}
+
+TEST(http_server_test, many_client_with_requests_to_io_uring_per_worker_accept_server)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    // The workers' pollers accept the connections themselves
+    Http::Endpoint server(address);
+    auto flags       = Tcp::Options::ReuseAddr;
+    auto server_opts = Http::Endpoint::options()
+                           .flags(flags)
+                           .threads(4)
+                           .perWorkerAccept(true)
+                           .pollingBackend(Polling::Backend::IoUring);
+    server.init(server_opts);
+    LOGGER("test", "Trying to run server...");
+    server.setHandler(Http::make_handler<HelloHandlerWithDelay>());
+    ASSERT_NO_THROW(server.serveThreaded());
+
+    const std::string server_address = "localhost:" + server.getPort().toString();
+    LOGGER("test", "Server address: " << server_address);
+
+    const int NO_TIMEOUT                = 0;
+    const int SECONDS_TIMOUT            = 20;
+    const int FIRST_CLIENT_REQUEST_SIZE = 64;
+    std::future<int> result1(std::async(clientLogicFunc,
+                                        FIRST_CLIENT_REQUEST_SIZE, server_address,
+                                        NO_TIMEOUT, SECONDS_TIMOUT));
+    const int SECOND_CLIENT_REQUEST_SIZE = 96;
+    std::future<int> result2(
+        std::async(clientLogicFunc, SECOND_CLIENT_REQUEST_SIZE, server_address,
+                   NO_TIMEOUT, SECONDS_TIMOUT));
+
+    int res1 = result1.get();
+    int res2 = result2.get();
+
+    server.shutdown();
+
+    ASSERT_EQ(res1, FIRST_CLIENT_REQUEST_SIZE);
+    ASSERT_EQ(res2, SECOND_CLIENT_REQUEST_SIZE);
+}
+
 TEST(http_server_test,
      multiple_client_with_different_requests_to_multithreaded_server)
 {
@@ -1159,6 +1284,110 @@ TEST(http_server_test, client_request_timeout_on_delay_in_body_send_raises_http_
 #endif
 }
 
+TEST(http_server_test, client_request_timeout_on_stall_in_body_send_raises_http_408)
+{
+    PS_TIMEDBG_START;
+
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+#ifdef DEBUG
+    const int em_event_count_before = EventMethFns::getEmEventCount();
+#endif
+#endif
+
+    { // encapsulate
+
+    Pistache::Address address("localhost", Pistache::Port(0));
+
+    // Well within the body timeout, but the body stops coming in
+    const auto bodyTimeout = std::chrono::seconds(30);
+    const auto idleTimeout = std::chrono::seconds(1);
+
+    Http::Endpoint server(address);
+    auto flags = Tcp::Options::ReuseAddr;
+    auto opts  = Http::Endpoint::options()
+                    .flags(flags)
+                    .bodyTimeout(bodyTimeout)
+                    .idleTimeout(idleTimeout);
+
+    server.init(opts);
+    server.setHandler(Http::make_handler<PingHandler>());
+    server.serveThreaded();
+
+    auto port = server.getPort();
+    auto addr = "localhost:" + port.toString();
+    LOGGER("test", "Server address: " << addr);
+
+    const std::string reqStr = "POST /ping HTTP/1.1\r\nHost: localhost\r\nContent-Type: text/plain\r\nContent-Length: 32\r\n\r\nabc";
+
+    TcpClient client;
+    EXPECT_TRUE(client.connect(Pistache::Address("localhost", port))) << client.lastError();
+    EXPECT_TRUE(client.send(reqStr)) << client.lastError();
+
+    const auto start   = std::chrono::steady_clock::now();
+    char recvBuf[1024] = {
+        0,
+    };
+    size_t bytes;
+    EXPECT_TRUE(client.receive(recvBuf, sizeof(recvBuf), &bytes, std::chrono::seconds(5))) << client.lastError();
+    EXPECT_EQ(0, strncmp(recvBuf, ExpectedResponseLine, strlen(ExpectedResponseLine)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    server.shutdown();
+
+    } // end encapsulate
+
+#ifdef _USE_LIBEVENT_LIKE_APPLE
+#ifdef DEBUG
+    const int em_event_count_after = EventMethFns::getEmEventCount();
+
+    PS_LOG_DEBUG_ARGS("em_event_count_before %d, em_event_count_after %d",
+                      em_event_count_before, em_event_count_after);
+    ASSERT_EQ(em_event_count_before, em_event_count_after);
+#endif
+#endif
+}
+
+TEST(http_server_test, client_request_no_timeout_on_slow_body_send)
+{
+    PS_TIMEDBG_START;
+
+    Pistache::Address address("localhost", Pistache::Port(0));
+
+    // The body takes longer than the idle timeout, but keeps coming in
+    const auto idleTimeout = std::chrono::milliseconds(1000);
+
+    Http::Endpoint server(address);
+    auto flags = Tcp::Options::ReuseAddr;
+    auto opts  = Http::Endpoint::options()
+                    .flags(flags)
+                    .idleTimeout(idleTimeout);
+
+    server.init(opts);
+    server.setHandler(Http::make_handler<PingHandler>());
+    server.serveThreaded();
+
+    auto port = server.getPort();
+
+    TcpClient client;
+    EXPECT_TRUE(client.connect(Pistache::Address("localhost", port))) << client.lastError();
+    EXPECT_TRUE(client.send("POST /ping HTTP/1.1\r\nHost: localhost\r\nContent-Type: text/plain\r\nContent-Length: 8\r\n\r\n")) << client.lastError();
+    for (const char* part : { "ab", "cd", "ef", "gh" })
+    {
+        std::this_thread::sleep_for(idleTimeout / 2);
+        EXPECT_TRUE(client.send(part)) << client.lastError();
+    }
+
+    char recvBuf[1024] = {
+        0,
+    };
+    size_t bytes;
+    EXPECT_TRUE(client.receive(recvBuf, sizeof(recvBuf), &bytes, std::chrono::seconds(5))) << client.lastError();
+    EXPECT_NE(0, strncmp(recvBuf, ExpectedResponseLine, strlen(ExpectedResponseLine)));
+    EXPECT_NE(nullptr, strstr(recvBuf, "200 OK"));
+
+    server.shutdown();
+}
+
 TEST(http_server_test, client_request_no_timeout)
 {
     PS_TIMEDBG_START;
@@ -1342,6 +1571,368 @@ TEST(http_server_test, client_multiple_requests_disconnects_handled)
 #endif
 }
 
+// Replies to /slow from another thread, after a while, and to anything else
+// right away
+struct PipelineHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(PipelineHandler)
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        PS_TIMEDBG_START_THIS;
+
+        if (request.resource() == "/slow")
+        {
+            std::thread([writer = std::move(writer)]() mutable {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                writer.send(Http::Code::Ok, "slow");
+            }).detach();
+        }
+        else
+        {
+            writer.send(Http::Code::Ok, request.resource().substr(1));
+        }
+    }
+};
+
+TEST(http_server_test, pipelined_requests_are_answered_in_order)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr));
+    server.setHandler(Http::make_handler<PipelineHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    // All in a single write, the first one answered asynchronously
+    const std::string requests = "GET /slow HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n"
+                                 "POST /first HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\nContent-Length: 4\r\n\r\nabcd"
+                                 "GET /second HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+    ASSERT_TRUE(client.send(requests)) << client.lastError();
+
+    std::string received;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received.find("second") == std::string::npos && std::chrono::steady_clock::now() < deadline)
+    {
+        char recvBuf[1024];
+        size_t bytes = 0;
+        if (!client.receive(recvBuf, sizeof(recvBuf), &bytes, std::chrono::seconds(1)))
+            continue;
+        received.append(recvBuf, bytes);
+    }
+
+    server.shutdown();
+
+    const auto slow   = received.find("slow");
+    const auto first  = received.find("first");
+    const auto second = received.find("second");
+    ASSERT_NE(slow, std::string::npos) << received;
+    ASSERT_NE(first, std::string::npos) << received;
+    ASSERT_NE(second, std::string::npos) << received;
+    EXPECT_LT(slow, first);
+    EXPECT_LT(first, second);
+}
+
+// Replies to /big/<letter> with a large body made of that letter
+struct LargeResponseHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(LargeResponseHandler)
+
+    static constexpr size_t BodySize = 1024 * 1024;
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        PS_TIMEDBG_START_THIS;
+
+        writer.send(Http::Code::Ok, std::string(BodySize, request.resource().back()));
+    }
+};
+
+static void checkPipelinedLargeResponses(Polling::Backend backend)
+{
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options()
+                    .flags(Tcp::Options::ReuseAddr)
+                    .pollingBackend(backend));
+    server.setHandler(Http::make_handler<LargeResponseHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    const std::string letters = "abcdefgh";
+    std::string requests;
+    for (char letter : letters)
+        requests += std::string("GET /big/") + letter + " HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+    ASSERT_TRUE(client.send(requests)) << client.lastError();
+
+    // Not reading for a while fills up the socket buffers, so that the
+    // responses queued meanwhile only go out in parts
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    const size_t bodiesSize = letters.size() * LargeResponseHandler::BodySize;
+    std::string received;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        // Past the bodies, only the last headers are left to come
+        const bool mostlyDone = received.size() >= bodiesSize;
+
+        char recvBuf[65536];
+        size_t bytes = 0;
+        if (!client.receive(recvBuf, sizeof(recvBuf), &bytes,
+                            std::chrono::milliseconds(mostlyDone ? 200 : 1000)))
+        {
+            if (mostlyDone)
+                break;
+            continue;
+        }
+        received.append(recvBuf, bytes);
+    }
+
+    // Everything has come in, in order and intact
+    size_t pos = 0;
+    for (char letter : letters)
+    {
+        const auto headersEnd = received.find("\r\n\r\n", pos);
+        ASSERT_NE(headersEnd, std::string::npos) << "response " << letter;
+
+        const size_t bodyStart = headersEnd + 4;
+        ASSERT_LE(bodyStart + LargeResponseHandler::BodySize, received.size()) << "response " << letter;
+        ASSERT_EQ(received.compare(bodyStart, LargeResponseHandler::BodySize,
+                                   std::string(LargeResponseHandler::BodySize, letter)),
+                  0)
+            << "response " << letter;
+
+        pos = bodyStart + LargeResponseHandler::BodySize;
+    }
+
+    server.shutdown();
+}
+
+TEST(http_server_test, pipelined_large_responses_survive_partial_writes)
+{
+    PS_TIMEDBG_START;
+
+    checkPipelinedLargeResponses(Polling::Backend::Epoll);
+}
+
+TEST(http_server_test, pipelined_large_responses_survive_partial_writes_io_uring)
+{
+    PS_TIMEDBG_START;
+
+    // Falls back to epoll where io_uring is not available
+    checkPipelinedLargeResponses(Polling::Backend::IoUring);
+}
+
+// Tallies the body of requests to /stream as it comes in, pausing now and
+// then for another thread to resume it, and replies with the tally
+struct StreamingHandler : public Http::Handler
+{
+    HTTP_PROTOTYPE(StreamingHandler)
+
+    struct Reader : public Http::BodyReader,
+                    public std::enable_shared_from_this<Reader>
+    {
+        void onData(const char* data, size_t len) override
+        {
+            total += len;
+            largest = std::max(largest, len);
+            for (size_t i = 0; i < len; ++i)
+                checksum += static_cast<unsigned char>(data[i]);
+
+            if (++calls % 8 == 0)
+            {
+                pause();
+                std::thread([self = shared_from_this()] {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    self->resume();
+                }).detach();
+            }
+        }
+
+        size_t total     = 0;
+        size_t largest   = 0;
+        size_t calls     = 0;
+        uint64_t checksum = 0;
+    };
+
+    std::shared_ptr<Http::BodyReader> onRequestHeaders(const Http::Request& request) override
+    {
+        if (request.resource() != "/stream")
+            return nullptr;
+
+        reader_ = std::make_shared<Reader>();
+        return reader_;
+    }
+
+    void onRequest(const Http::Request& request,
+                   Http::ResponseWriter writer) override
+    {
+        PS_TIMEDBG_START_THIS;
+
+        if (request.resource() != "/stream")
+        {
+            writer.send(Http::Code::Ok, "body:" + request.body());
+            return;
+        }
+
+        std::ostringstream oss;
+        oss << "total:" << reader_->total << " checksum:" << reader_->checksum
+            << " largest:" << reader_->largest << " body:" << request.body().size();
+        writer.send(Http::Code::Ok, oss.str());
+    }
+
+private:
+    std::shared_ptr<Reader> reader_;
+};
+
+static std::string receiveUntil(TcpClient& client, const std::string& expected)
+{
+    std::string received;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received.find(expected) == std::string::npos && std::chrono::steady_clock::now() < deadline)
+    {
+        char recvBuf[1024];
+        size_t bytes = 0;
+        if (!client.receive(recvBuf, sizeof(recvBuf), &bytes, std::chrono::seconds(1)))
+            continue;
+        received.append(recvBuf, bytes);
+    }
+    return received;
+}
+
+static void checkStreamedRequestBody(Polling::Backend backend)
+{
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options()
+                    .flags(Tcp::Options::ReuseAddr)
+                    .threads(1)
+                    .pollingBackend(backend));
+    server.setHandler(Http::make_handler<StreamingHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    // Much more than the max request size
+    const size_t bodySize = 4 * 1024 * 1024;
+    std::string body(bodySize, '\0');
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < bodySize; ++i)
+    {
+        body[i] = static_cast<char>(i % 251);
+        checksum += static_cast<unsigned char>(body[i]);
+    }
+
+    ASSERT_TRUE(client.send("POST /stream HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n"
+                            "Content-Length: "
+                            + std::to_string(bodySize) + "\r\n\r\n"))
+        << client.lastError();
+    for (size_t pos = 0; pos < bodySize; pos += 65536)
+        ASSERT_TRUE(client.send(body.data() + pos, std::min<size_t>(65536, bodySize - pos)))
+            << client.lastError();
+
+    // Followed by a request whose body is kept as usual
+    ASSERT_TRUE(client.send("POST /echo HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n"
+                            "Content-Length: 5\r\n\r\nhello"))
+        << client.lastError();
+
+    const auto received = receiveUntil(client, "body:hello");
+    server.shutdown();
+
+    const std::string expected = "total:" + std::to_string(bodySize) + " checksum:" + std::to_string(checksum);
+    ASSERT_NE(received.find(expected), std::string::npos) << received.substr(0, 512);
+    ASSERT_NE(received.find(" body:0"), std::string::npos) << received.substr(0, 512);
+    ASSERT_NE(received.find("body:hello"), std::string::npos) << received.substr(0, 512);
+
+    // Never more than the input buffer at once
+    const auto largestPos = received.find("largest:");
+    ASSERT_NE(largestPos, std::string::npos);
+    ASSERT_LE(std::stoul(received.substr(largestPos + 8)), Const::DefaultMaxRequestSize);
+}
+
+TEST(http_server_test, request_body_is_streamed_to_reader)
+{
+    PS_TIMEDBG_START;
+
+    checkStreamedRequestBody(Polling::Backend::Epoll);
+}
+
+TEST(http_server_test, request_body_is_streamed_to_reader_io_uring)
+{
+    PS_TIMEDBG_START;
+
+    // The body comes in many receive buffers, some of them while paused
+    checkStreamedRequestBody(Polling::Backend::IoUring);
+}
+
+TEST(http_server_test, chunked_request_body_is_streamed_decoded)
+{
+    PS_TIMEDBG_START;
+
+    const Pistache::Address address("localhost", Pistache::Port(0));
+
+    Http::Endpoint server(address);
+    server.init(Http::Endpoint::options().flags(Tcp::Options::ReuseAddr).threads(1));
+    server.setHandler(Http::make_handler<StreamingHandler>());
+    server.serveThreaded();
+
+    TcpClient client;
+    ASSERT_TRUE(client.connect(Pistache::Address("localhost", server.getPort())))
+        << client.lastError();
+
+    ASSERT_TRUE(client.send("POST /stream HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n"
+                            "Transfer-Encoding: chunked\r\n\r\n"))
+        << client.lastError();
+
+    // Chunks both smaller and larger than the input buffer, sent in pieces
+    // that split their sizes and delimiters
+    std::string encoded;
+    size_t total      = 0;
+    uint64_t checksum = 0;
+    for (size_t size : { 1, 10, 4000, 4096, 10000, 100000, 3, 65536, 7 })
+    {
+        char sizeLine[32];
+        std::snprintf(sizeLine, sizeof sizeLine, "%zx\r\n", size);
+        encoded += sizeLine;
+        for (size_t i = 0; i < size; ++i)
+        {
+            const char c = static_cast<char>('a' + (total + i) % 26);
+            encoded.push_back(c);
+            checksum += static_cast<unsigned char>(c);
+        }
+        encoded += "\r\n";
+        total += size;
+    }
+    encoded += "0\r\n\r\n";
+
+    for (size_t pos = 0; pos < encoded.size(); pos += 1499)
+        ASSERT_TRUE(client.send(encoded.data() + pos, std::min<size_t>(1499, encoded.size() - pos)))
+            << client.lastError();
+
+    const std::string expected = "total:" + std::to_string(total) + " checksum:" + std::to_string(checksum);
+    const auto received        = receiveUntil(client, expected);
+    server.shutdown();
+
+    ASSERT_NE(received.find(expected), std::string::npos) << received.substr(0, 512);
+    ASSERT_NE(received.find(" body:0"), std::string::npos) << received.substr(0, 512);
+}
+
 struct ContentEncodingHandler : public Http::Handler
 {
     HTTP_PROTOTYPE(ContentEncodingHandler)
@@ -24,6 +24,8 @@
 #include <sstream>
 
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <thread> // provides "sleep_for"
 using namespace std::chrono_literals;
 
@@ -331,6 +333,104 @@ TEST(listener_test, listener_bind_ephemeral_v4_port)
     ASSERT_TRUE(bound_port > static_cast<uint16_t>(0));
 }
 
+namespace
+{
+    // Polls the listener load until the total number of live peers reaches
+    // expected, or gives up after a few seconds
+    Pistache::Tcp::Listener::Load
+    waitForConnections(Pistache::Tcp::Listener& listener, size_t expected)
+    {
+        Pistache::Tcp::Listener::Load load;
+        for (int i = 0; i < 50; ++i)
+        {
+            // The continuation may run after wait_for gives up
+            struct Result
+            {
+                std::mutex mutex;
+                bool done = false;
+                Pistache::Tcp::Listener::Load load;
+            };
+            auto result = std::make_shared<Result>();
+
+            auto promise = listener.requestLoad(Pistache::Tcp::Listener::Load());
+            promise.then(
+                [result](const Pistache::Tcp::Listener::Load& res) {
+                    std::lock_guard<std::mutex> guard(result->mutex);
+                    result->load = res;
+                    result->done = true;
+                },
+                Pistache::Async::IgnoreException);
+
+            Pistache::Async::Barrier<Pistache::Tcp::Listener::Load> barrier(promise);
+            barrier.wait_for(std::chrono::seconds(1));
+
+            bool done;
+            {
+                std::lock_guard<std::mutex> guard(result->mutex);
+                done = result->done;
+                if (done)
+                    load = result->load;
+            }
+
+            if (done)
+            {
+                size_t total = 0;
+                for (auto count : load.connections)
+                    total += count;
+                if (total == expected)
+                    break;
+            }
+            std::this_thread::sleep_for(100ms);
+        }
+        return load;
+    }
+}
+
+TEST(listener_test, listener_least_connections_dispatch)
+{
+    PS_TIMEDBG_START;
+
+    const size_t workers = 4;
+
+    Pistache::Tcp::Listener listener;
+    listener.init(workers);
+    listener.setDispatchPolicy(Pistache::Tcp::DispatchPolicy::LeastConnections);
+    listener.setHandler(Pistache::Http::make_handler<DummyHandler>());
+    listener.bind(Pistache::Address(Pistache::IP::loopback(), Pistache::Port(0)));
+    listener.runThreaded();
+
+    {
+        std::vector<std::unique_ptr<SocketWrapper>> clients;
+        for (size_t i = 0; i < 2 * workers; ++i)
+        {
+            em_socket_t fd = PST_SOCK_SOCKET(AF_INET, SOCK_STREAM, 0);
+            ASSERT_NE(fd, -1);
+            clients.push_back(std::make_unique<SocketWrapper>(fd));
+
+            struct sockaddr_in sin = {};
+            sin.sin_family         = AF_INET;
+            sin.sin_port           = htons(static_cast<uint16_t>(listener.getPort()));
+            sin.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+            ASSERT_EQ(PST_SOCK_CONNECT(fd, reinterpret_cast<struct sockaddr*>(&sin),
+                                       sizeof(sin)),
+                      0);
+        }
+
+        auto load = waitForConnections(listener, clients.size());
+        ASSERT_EQ(load.connections.size(), workers);
+        ASSERT_EQ(load.busy.size(), workers);
+        for (auto count : load.connections)
+            EXPECT_EQ(count, 2u);
+    }
+
+    // Closed connections are no longer counted
+    auto load = waitForConnections(listener, 0);
+    for (auto count : load.connections)
+        EXPECT_EQ(count, 0u);
+
+    listener.shutdown();
+}
+
 TEST(listener_test, listener_bind_ephemeral_v6_port)
 {
     PS_TIMEDBG_START;
@@ -10,7 +10,9 @@
 
 #include <chrono>
 #include <openssl/bio.h>
+#include <openssl/ssl.h>
 #include <pistache/http.h>
+#include <string>
 
 using testing::Eq;
 using testing::Le;
@@ -94,3 +96,61 @@ TEST(listener_tls_test, tls_handshake_timeout_custom)
 
     BIO_free_all(bio);
 }
+
+TEST(listener_tls_test, tls_handshake_does_not_block_accept)
+{
+    Pistache::Tcp::Listener listener;
+    listener.init(1);
+    listener.setupSSL("./certs/server.crt", "./certs/server.key", false, nullptr, std::chrono::seconds(10));
+    listener.setHandler(Pistache::Http::make_handler<HelloHandler>());
+    listener.bind(Pistache::Address(Pistache::IP::loopback(), 0));
+    listener.runThreaded();
+
+    const std::string port = listener.getPort().toString();
+
+    // A client that connects but never starts its handshake
+    BIO* silent = BIO_new_connect("localhost");
+    BIO_set_conn_port(silent, port.c_str());
+    long success = BIO_do_connect(silent);
+    ASSERT_THAT(success, Eq(1));
+
+    // A well-behaved client connecting right after it must not have to wait
+    // for the silent one to time out
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(ctx, nullptr);
+
+    BIO* client = BIO_new_ssl_connect(ctx);
+    BIO_set_conn_hostname(client, ("localhost:" + port).c_str());
+
+    const auto pre_handshake = std::chrono::steady_clock::now();
+
+    success = BIO_do_handshake(client);
+    EXPECT_THAT(success, Eq(1));
+
+    const auto duration = std::chrono::steady_clock::now() - pre_handshake;
+
+    // Well below the 10 seconds the silent client is allowed
+    EXPECT_THAT(duration, Le(std::chrono::seconds(5)));
+
+    // The connection is then served as usual
+    const std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    EXPECT_THAT(BIO_write(client, request.data(), static_cast<int>(request.size())),
+                Eq(static_cast<int>(request.size())));
+
+    std::string response;
+    char buf[256];
+    int bytes;
+    while ((bytes = BIO_read(client, buf, sizeof buf)) > 0)
+    {
+        response.append(buf, static_cast<size_t>(bytes));
+        if (response.find("Hello world\n") != std::string::npos)
+            break;
+    }
+    EXPECT_THAT(response.substr(0, 15), Eq("HTTP/1.1 200 OK"));
+
+    BIO_free_all(client);
+    SSL_CTX_free(ctx);
+    BIO_free_all(silent);
+
+    listener.shutdown();
+}
@@ -7,6 +7,12 @@
 #include <gtest/gtest.h>
 #include <pistache/mailbox.h>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
 struct Data
 {
     static inline int num_instances = 0;
@@ -28,6 +34,8 @@ struct Data
 
     Data(const Data&) = delete;
 
+    Data& operator=(Data&&) = default;
+
     ~Data()
     {
         EXPECT_EQ(val, Data::fingerprint);
@@ -79,3 +87,146 @@ TEST_F(QueueTest, push_pop)
     EXPECT_TRUE(queue->empty());
     EXPECT_EQ(Data::num_instances, 0);
 }
+
+TEST(mpmc_queue_test, cells_are_padded)
+{
+    using Queue = Pistache::MPMCQueue<int, 16>;
+    EXPECT_GE(sizeof(Queue), 16 * Pistache::CachelineSize);
+}
+
+TEST_F(QueueTest, mpmc_moves_values_out)
+{
+    {
+        Pistache::MPMCQueue<Data, 4> queue;
+        const int cells = Data::num_instances;
+
+        // Data can not be copied
+        EXPECT_TRUE(queue.enqueue(Data()));
+        Data data;
+        EXPECT_TRUE(queue.dequeue(data));
+        EXPECT_FALSE(queue.dequeue(data));
+        EXPECT_EQ(Data::num_instances, cells + 1);
+    }
+    EXPECT_EQ(Data::num_instances, 0);
+
+    Pistache::MPMCQueue<std::unique_ptr<int>, 2> queue;
+    EXPECT_TRUE(queue.enqueue(std::make_unique<int>(1)));
+    EXPECT_TRUE(queue.enqueue(std::make_unique<int>(2)));
+    EXPECT_FALSE(queue.enqueue(std::make_unique<int>(3)));
+
+    std::unique_ptr<int> value;
+    EXPECT_TRUE(queue.dequeue(value));
+    EXPECT_EQ(*value, 1);
+    EXPECT_TRUE(queue.dequeue(value));
+    EXPECT_EQ(*value, 2);
+}
+
+TEST(mpmc_queue_test, bulk_operations)
+{
+    Pistache::MPMCQueue<int, 8> queue;
+
+    std::vector<int> values { 0, 1, 2, 3, 4, 5 };
+    EXPECT_EQ(queue.enqueue_bulk(values.begin(), values.size()), 6u);
+
+    // Only the room left is used
+    EXPECT_EQ(queue.enqueue_bulk(values.begin(), values.size()), 2u);
+    EXPECT_EQ(queue.enqueue_bulk(values.begin(), values.size()), 0u);
+
+    std::vector<int> out(5);
+    EXPECT_EQ(queue.dequeue_bulk(out.begin(), out.size()), 5u);
+    EXPECT_EQ(out, (std::vector<int> { 0, 1, 2, 3, 4 }));
+
+    EXPECT_EQ(queue.dequeue_bulk(out.begin(), out.size()), 3u);
+    EXPECT_EQ(out[0], 5);
+    EXPECT_EQ(out[1], 0);
+    EXPECT_EQ(out[2], 1);
+    EXPECT_EQ(queue.dequeue_bulk(out.begin(), out.size()), 0u);
+
+    // Wrapping around the end of the cells
+    EXPECT_EQ(queue.enqueue_bulk(values.begin(), values.size()), 6u);
+    EXPECT_EQ(queue.dequeue_bulk(out.begin(), out.size()), 5u);
+    EXPECT_EQ(out, (std::vector<int> { 0, 1, 2, 3, 4 }));
+}
+
+TEST(mpmc_queue_test, wait_dequeue)
+{
+    Pistache::MPMCQueue<int, 8> queue;
+
+    int value = 0;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.wait_dequeue_for(value, std::chrono::milliseconds(50)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+    std::thread producer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        queue.enqueue(42);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::vector<int> values { 1, 2 };
+        queue.enqueue_bulk(values.begin(), values.size());
+    });
+
+    queue.wait_dequeue(value);
+    EXPECT_EQ(value, 42);
+
+    std::vector<int> out(4);
+    size_t count = queue.wait_dequeue_bulk(out.begin(), out.size());
+    producer.join();
+    count += queue.dequeue_bulk(out.begin() + static_cast<std::ptrdiff_t>(count), out.size() - count);
+    EXPECT_EQ(count, 2u);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], 2);
+}
+
+TEST(mpmc_queue_test, concurrent_producers_and_consumers)
+{
+    constexpr size_t Threads   = 4;
+    constexpr size_t PerThread = 20000;
+
+    Pistache::MPMCQueue<size_t, 64> queue;
+    std::vector<std::thread> threads;
+    std::vector<size_t> sums(Threads, 0);
+
+    for (size_t i = 0; i < Threads; ++i)
+    {
+        threads.emplace_back([&queue, i] {
+            for (size_t n = 1; n <= PerThread; ++n)
+            {
+                // Odd producers go in batches
+                if (i % 2 == 0)
+                {
+                    while (!queue.enqueue(n))
+                        std::this_thread::yield();
+                }
+                else
+                {
+                    size_t batch[] = { n };
+                    while (queue.enqueue_bulk(batch, 1) == 0)
+                        std::this_thread::yield();
+                }
+            }
+        });
+
+        threads.emplace_back([&queue, &sums, i] {
+            size_t received = 0;
+            size_t batch[8];
+            while (received < PerThread)
+            {
+                const size_t count = queue.wait_dequeue_bulk(batch, std::min<size_t>(8, PerThread - received));
+                for (size_t n = 0; n < count; ++n)
+                    sums[i] += batch[n];
+                received += count;
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    size_t total = 0;
+    for (auto sum : sums)
+        total += sum;
+    EXPECT_EQ(total, Threads * PerThread * (PerThread + 1) / 2);
+
+    size_t value;
+    EXPECT_FALSE(queue.dequeue(value));
+}
@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+#include <pistache/metrics.h>
+#include <pistache/router.h>
+
+#include <httplib.h>
+
+#include "tcp_client.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace Pistache;
+
+namespace
+{
+    struct StatusHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(StatusHandler)
+
+        void onRequest(const Http::Request& request, Http::ResponseWriter writer) override
+        {
+            if (request.resource() == "/missing")
+                writer.send(Http::Code::Not_Found);
+            else if (request.resource() == "/stream")
+            {
+                auto stream = writer.stream(Http::Code::Ok);
+                stream << "part";
+                stream.ends();
+            }
+            else
+                writer.send(Http::Code::Ok, "Hello, World!");
+        }
+    };
+
+    bool contains(const std::string& text, const std::string& line)
+    {
+        return text.find(line + "\n") != std::string::npos;
+    }
+}
+
+TEST(metrics_test, histogram_buckets)
+{
+    using Metrics::Histogram;
+
+    // Values below SubBuckets have a bucket each
+    for (uint64_t v = 0; v < Histogram::SubBuckets; ++v)
+        ASSERT_EQ(Histogram::bucketOf(v), v);
+
+    // Buckets cover every value once, in order
+    for (size_t b = 0; b + 1 < 200; ++b)
+    {
+        ASSERT_EQ(Histogram::upperBound(b) + 1, Histogram::lowerBound(b + 1));
+        ASSERT_EQ(Histogram::bucketOf(Histogram::lowerBound(b)), b);
+        ASSERT_EQ(Histogram::bucketOf(Histogram::upperBound(b)), b);
+    }
+    ASSERT_EQ(Histogram::bucketOf(UINT64_MAX), Histogram::BucketCount - 1);
+
+    // Within 1 / SubBuckets of the value
+    const size_t bucket = Histogram::bucketOf(1000000);
+    ASSERT_LE(Histogram::upperBound(bucket) - Histogram::lowerBound(bucket),
+              1000000 / Histogram::SubBuckets);
+}
+
+TEST(metrics_test, histogram_quantiles)
+{
+    Metrics::Histogram histogram;
+    ASSERT_EQ(histogram.quantile(0.5), 0u);
+
+    for (uint64_t v = 1; v <= 1000; ++v)
+        histogram.record(v);
+
+    ASSERT_EQ(histogram.count(), 1000u);
+    ASSERT_EQ(histogram.sum(), 500500u);
+    ASSERT_EQ(histogram.max(), 1000u);
+    ASSERT_EQ(histogram.quantile(1.0), 1000u);
+
+    const auto median = histogram.quantile(0.5);
+    ASSERT_GE(median, 500u);
+    ASSERT_LE(median, 500u + 500u / Metrics::Histogram::SubBuckets);
+
+    // At most the upper bound of a bucket is exact
+    ASSERT_EQ(histogram.countAtMost(7), 7u);
+    ASSERT_EQ(histogram.countAtMost(Metrics::Histogram::upperBound(Metrics::Histogram::bucketOf(300))),
+              Metrics::Histogram::upperBound(Metrics::Histogram::bucketOf(300)));
+
+    Metrics::Histogram other;
+    other.record(5000, 10);
+    histogram += other;
+    ASSERT_EQ(histogram.count(), 1010u);
+    ASSERT_EQ(histogram.max(), 5000u);
+    ASSERT_GE(histogram.quantile(0.999), 4096u);
+}
+
+TEST(metrics_test, endpoint_records_requests)
+{
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(2));
+    server.setHandler(Http::make_handler<StatusHandler>());
+    server.serveThreaded();
+
+    httplib::Client client("localhost", server.getPort());
+    client.set_keep_alive(true);
+    for (int i = 0; i < 3; ++i)
+        ASSERT_EQ(client.Get("/")->status, 200);
+    ASSERT_EQ(client.Get("/missing")->status, 404);
+    ASSERT_EQ(client.Get("/stream")->body, "part");
+
+    const auto snapshot = server.metrics();
+    ASSERT_EQ(snapshot.workers.size(), 2u);
+
+    const auto total = snapshot.total();
+    ASSERT_EQ(total.requests, 5u);
+    ASSERT_EQ(total.responses[1], 4u);
+    ASSERT_EQ(total.responses[3], 1u);
+    ASSERT_EQ(total.connections, 1u);
+    ASSERT_EQ(total.activeConnections, 1u);
+    ASSERT_EQ(total.latency.count(), 5u);
+    ASSERT_GT(total.bytesRead, 5u * 16);
+    ASSERT_GT(total.bytesWritten, 5u * 16);
+    ASSERT_EQ(total.writeQueueDepth, 0u);
+
+    client.stop();
+    server.shutdown();
+}
+
+TEST(metrics_test, counts_timeouts)
+{
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options()
+                    .threads(1)
+                    .headerTimeout(std::chrono::milliseconds(100))
+                    .keepaliveTimeout(std::chrono::milliseconds(100)));
+    server.setHandler(Http::make_handler<StatusHandler>());
+    server.serveThreaded();
+
+    const Address address("localhost", server.getPort());
+
+    // Never finishes its request
+    TcpClient partial;
+    ASSERT_TRUE(partial.connect(address));
+    ASSERT_TRUE(partial.send("GET / HTTP/1.1\r\nHost: localhost\r\n"));
+
+    // Goes idle after one
+    TcpClient idle;
+    ASSERT_TRUE(idle.connect(address));
+    ASSERT_TRUE(idle.send("GET / HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n"));
+
+    Metrics::Worker total;
+    for (int i = 0; i < 50; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        total = server.metrics().total();
+        if (total.requestTimeouts == 1 && total.idleTimeouts == 1)
+            break;
+    }
+
+    ASSERT_EQ(total.requestTimeouts, 1u);
+    ASSERT_EQ(total.idleTimeouts, 1u);
+    ASSERT_EQ(total.responses[3], 1u);
+
+    server.shutdown();
+}
+
+TEST(metrics_test, prometheus_buckets_are_exact)
+{
+    Metrics::Worker worker;
+    worker.latency.record(97);
+    worker.latency.record(100);
+    worker.latency.record(104);
+
+    Metrics::Snapshot snapshot;
+    snapshot.workers.push_back(worker);
+
+    // The 100 us bound is that of the histogram bucket holding 96 to 103 us
+    const auto text = Metrics::toPrometheus(snapshot);
+    ASSERT_TRUE(contains(text, "pistache_request_duration_seconds_bucket{le=\"0.000103\"} 2"));
+    ASSERT_TRUE(contains(text, "pistache_request_duration_seconds_bucket{le=\"0.000255\"} 3"));
+}
+
+TEST(metrics_test, prometheus_route)
+{
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+
+    Rest::Router router;
+    Rest::Routes::Prometheus(router, "/metrics", server);
+    server.setHandler(router.handler());
+    server.serveThreaded();
+
+    httplib::Client client("localhost", server.getPort());
+    client.set_keep_alive(true);
+    ASSERT_EQ(client.Get("/metrics")->status, 200);
+    ASSERT_EQ(client.Get("/nothing")->status, 404);
+
+    auto res = client.Get("/metrics");
+    ASSERT_EQ(res->get_header_value("Content-Type"), Metrics::PrometheusContentType);
+
+    const auto& text = res->body;
+    ASSERT_TRUE(contains(text, "# TYPE pistache_requests_total counter"));
+    ASSERT_TRUE(contains(text, "pistache_requests_total{worker=\"0\"} 3"));
+    ASSERT_TRUE(contains(text, "pistache_responses_total{worker=\"0\",code=\"2xx\"} 1"));
+    ASSERT_TRUE(contains(text, "pistache_responses_total{worker=\"0\",code=\"4xx\"} 1"));
+    ASSERT_TRUE(contains(text, "# TYPE pistache_request_duration_seconds histogram"));
+    ASSERT_TRUE(contains(text, "pistache_request_duration_seconds_bucket{le=\"+Inf\"} 2"));
+    ASSERT_TRUE(contains(text, "pistache_request_duration_seconds_count 2"));
+    ASSERT_TRUE(contains(text, "pistache_open_connections{worker=\"0\"} 1"));
+
+    server.shutdown();
+}
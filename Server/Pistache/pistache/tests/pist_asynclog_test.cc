@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/pist_syslog.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    class LogFile
+    {
+    public:
+        LogFile()
+        {
+            static int counter = 0;
+            path_ = (std::filesystem::temp_directory_path() / ("pistache_asynclog_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + ".log")).string();
+        }
+
+        ~LogFile()
+        {
+            PSLogStopAsync();
+            std::filesystem::remove(path_);
+        }
+
+        std::vector<std::string> lines() const
+        {
+            std::vector<std::string> result;
+            std::ifstream file(path_);
+            for (std::string line; std::getline(file, line);)
+                result.push_back(line);
+            return result;
+        }
+
+        size_t count(const std::string& text) const
+        {
+            size_t n = 0;
+            for (const auto& line : lines())
+                n += (line.find(text) != std::string::npos);
+            return n;
+        }
+
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+    enum class Color { Red,
+                       Green };
+}
+
+TEST(pist_asynclog_test, formats_arguments_on_the_background_thread)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str()));
+    ASSERT_FALSE(PSLogStartAsync(PSLogSink::Stdout));
+
+    const std::string name = "pistache";
+    const char* nothing    = nullptr;
+    const size_t size      = 12345;
+    int value              = 7;
+
+    PS_LOG_WARNING_ARGS("name=%s null=%s n=%d f=%5.2f z=%zu x=%x pct=%% pad=[%-5s] star=[%*d] ll=%lld c=%c e=%d",
+                        name.c_str(), nothing, -42, 3.14159, size, 255u, "ab", 4, 9,
+                        -1234567890123LL, 'Q', Color::Green);
+    PS_LOG_WARNING_ARGS("ptr=%p", static_cast<void*>(&value));
+    PSLogFlushAsync();
+
+    const auto lines = log.lines();
+    ASSERT_EQ(lines.size(), 2u);
+
+    EXPECT_NE(lines[0].find("WRN"), std::string::npos);
+    EXPECT_NE(lines[0].find("pist_asynclog_test.cc:"), std::string::npos);
+    EXPECT_NE(lines[0].find("name=pistache null=(null) n=-42 f= 3.14 z=12345 x=ff pct=% pad=[ab   ] star=[   9] ll=-1234567890123 c=Q e=1"),
+              std::string::npos)
+        << lines[0];
+
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "ptr=%p", static_cast<void*>(&value));
+    EXPECT_NE(lines[1].find(expected), std::string::npos) << lines[1];
+}
+
+TEST(pist_asynclog_test, long_strings_are_truncated)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str()));
+
+    const std::string big(1000, 'a');
+    PS_LOG_WARNING_ARGS("[%s][%s][%d]", big.c_str(), "tail", 5);
+    PSLogFlushAsync();
+
+    const auto lines = log.lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("[" + std::string(Pistache::AsyncLog::TextSize - 1, 'a') + "][][5]"),
+              std::string::npos);
+}
+
+TEST(pist_asynclog_test, strings_are_read_up_to_their_precision)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str()));
+
+    // Not nul-terminated, as a slice of a request buffer would be
+    const char slice[] = { 'G', 'E', 'T', ' ', '/' };
+    const int len      = 3;
+
+    PS_LOG_WARNING_ARGS("[%.*s][%.2s][%*.*s][%s][%.*s]", len, slice, slice, 5, len, slice,
+                        "tail", -1, "all");
+    PSLogFlushAsync();
+
+    const auto lines = log.lines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("[GET][GE][  GET][tail][all]"), std::string::npos) << lines[0];
+}
+
+TEST(pist_asynclog_test, char_pointers_not_given_for_s_are_not_read)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str()));
+
+    // Not nul-terminated either: only its address is logged
+    const char buffer[] = { 'x', 'y' };
+
+    PS_LOG_WARNING_ARGS("buf=%p s=%s", buffer, "tail");
+    PSLogFlushAsync();
+
+    const auto lines = log.lines();
+    ASSERT_EQ(lines.size(), 1u);
+
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "buf=%p s=tail", static_cast<const void*>(buffer));
+    EXPECT_NE(lines[0].find(expected), std::string::npos) << lines[0];
+}
+
+TEST(pist_asynclog_test, gathers_the_rings_of_all_threads)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str(), 1024));
+
+    constexpr int Threads  = 4;
+    constexpr int Messages = 500;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < Threads; ++t)
+    {
+        threads.emplace_back([t] {
+            for (int i = 0; i < Messages; ++i)
+                PS_LOG_WARNING_ARGS("thread %d message %d", t, i);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    PSLogFlushAsync();
+    ASSERT_EQ(PSLogAsyncDropped(), 0u);
+
+    const auto lines = log.lines();
+    ASSERT_EQ(lines.size(), static_cast<size_t>(Threads * Messages));
+    for (int t = 0; t < Threads; ++t)
+    {
+        EXPECT_EQ(log.count("thread " + std::to_string(t) + " message "), static_cast<size_t>(Messages));
+        EXPECT_EQ(log.count("thread " + std::to_string(t) + " message " + std::to_string(Messages - 1)), 1u);
+    }
+}
+
+TEST(pist_asynclog_test, drops_when_a_ring_is_full)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str(), 2));
+
+    const auto droppedBefore = PSLogAsyncDropped();
+    constexpr size_t Messages = 20000;
+    for (size_t i = 0; i < Messages; ++i)
+        PS_LOG_WARNING_ARGS("message %zu", i);
+    PSLogFlushAsync();
+
+    const auto dropped = PSLogAsyncDropped() - droppedBefore;
+    EXPECT_EQ(log.lines().size() + dropped, Messages);
+}
+
+TEST(pist_asynclog_test, filters_by_the_runtime_level)
+{
+    LogFile log;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, log.path().c_str()));
+
+    const int level = PSLogGetLevel();
+    PSLogSetLevel(LOG_ERR);
+    ASSERT_FALSE(PSLogIsEnabled(LOG_WARNING));
+
+    int evaluated = 0;
+    PS_LOG_WARNING_ARGS("filtered %d", ++evaluated);
+    PS_LOG_ERR_ARGS("kept %d", ++evaluated);
+    PSLogSetLevel(level);
+    PSLogFlushAsync();
+
+    // The arguments of a message filtered out are not even evaluated
+    EXPECT_EQ(evaluated, 1);
+    EXPECT_EQ(log.count("filtered"), 0u);
+    EXPECT_EQ(log.count("kept 1"), 1u);
+}
+
+TEST(pist_asynclog_test, restarts_with_another_file)
+{
+    LogFile first;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, first.path().c_str()));
+    PS_LOG_WARNING_ARGS("%s", "one");
+    PSLogStopAsync();
+
+    ASSERT_FALSE(Pistache::AsyncLog::isRunning());
+    EXPECT_EQ(first.count("one"), 1u);
+
+    LogFile second;
+    ASSERT_TRUE(PSLogStartAsync(PSLogSink::File, second.path().c_str()));
+    PS_LOG_WARNING_ARGS("%s", "two");
+    PSLogStopAsync();
+
+    EXPECT_EQ(first.count("two"), 0u);
+    EXPECT_EQ(second.count("two"), 1u);
+}
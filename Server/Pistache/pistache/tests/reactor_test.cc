@@ -9,6 +9,8 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -113,3 +115,86 @@ TEST(reactor_test, reactor_exceed_max_threads)
         reactor->init(Aio::AsyncContext(5 * MAX_SUPPORTED_THREADS + 1)),
         std::runtime_error);
 }
+
+TEST(reactor_test, reactor_creation_io_uring)
+{
+    // Falls back to epoll where io_uring is not available
+    constexpr size_t NUM_THREADS          = 2;
+    std::shared_ptr<Aio::Reactor> reactor = Aio::Reactor::create();
+    reactor->init(Aio::AsyncContext(NUM_THREADS, "", Polling::Backend::IoUring));
+    auto key = reactor->addHandler(std::make_shared<TransportMock>());
+    reactor->run();
+
+    auto handlers = reactor->handlers(key);
+    ASSERT_EQ(handlers.size(), NUM_THREADS);
+
+    for (size_t i = 0; i < handlers.size(); ++i)
+    {
+        auto transport = std::static_pointer_cast<TransportMock>(handlers[i]);
+        for (int j = 0; j < 100; ++j)
+            transport->push(static_cast<int>(i) * 100 + j);
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    reactor->shutdown();
+
+    for (size_t i = 0; i < handlers.size(); ++i)
+    {
+        auto transport = std::static_pointer_cast<TransportMock>(handlers[i]);
+        ASSERT_EQ(transport->values().size(), 100u);
+    }
+}
+
+TEST(reactor_test, poller_backends_report_readiness)
+{
+    using namespace std::chrono_literals;
+
+    for (auto backend : { Polling::Backend::Epoll, Polling::Backend::IoUring })
+    {
+        Polling::Epoll poller(backend);
+
+        int fds[2];
+        ASSERT_EQ(::pipe(fds), 0);
+        const Polling::Tag tag(static_cast<Polling::TagValue>(fds[0]));
+
+        std::vector<Polling::Event> events;
+        char byte = 'a';
+
+        // Level-triggered: reported for as long as there is something to read
+        poller.addFd(fds[0], Flags<Polling::NotifyOn>(Polling::NotifyOn::Read), tag);
+        ASSERT_EQ(poller.poll(events, 0ms), 0);
+        ASSERT_EQ(::write(fds[1], &byte, 1), 1);
+        for (int i = 0; i < 2; ++i)
+        {
+            events.clear();
+            ASSERT_EQ(poller.poll(events, 1000ms), 1);
+            ASSERT_EQ(events[0].tag, tag);
+            ASSERT_TRUE(events[0].flags.hasFlag(Polling::NotifyOn::Read));
+        }
+        ASSERT_EQ(::read(fds[0], &byte, 1), 1);
+        events.clear();
+        ASSERT_EQ(poller.poll(events, 0ms), 0);
+
+        // Edge-triggered: reported once for every write
+        poller.rearmFd(fds[0], Flags<Polling::NotifyOn>(Polling::NotifyOn::Read), tag,
+                       Polling::Mode::Edge);
+        ASSERT_EQ(::write(fds[1], &byte, 1), 1);
+        events.clear();
+        ASSERT_EQ(poller.poll(events, 1000ms), 1);
+        events.clear();
+        ASSERT_EQ(poller.poll(events, 50ms), 0);
+        ASSERT_EQ(::write(fds[1], &byte, 1), 1);
+        events.clear();
+        ASSERT_EQ(poller.poll(events, 1000ms), 1);
+
+        // Not reported anymore once removed
+        poller.removeFd(fds[0]);
+        ASSERT_EQ(::write(fds[1], &byte, 1), 1);
+        events.clear();
+        ASSERT_EQ(poller.poll(events, 50ms), 0);
+
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+}
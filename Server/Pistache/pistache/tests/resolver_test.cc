@@ -0,0 +1,300 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+
+#include <pistache/client.h>
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+#include <pistache/resolver.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Pistache;
+
+namespace
+{
+    struct HelloHandler : public Http::Handler
+    {
+        HTTP_PROTOTYPE(HelloHandler)
+
+        void onRequest(const Http::Request& /*request*/, Http::ResponseWriter writer) override
+        {
+            writer.send(Http::Code::Ok, "Hello, World!");
+        }
+    };
+
+    // Listens on 127.0.0.2, never accepting, its backlog full for the SYN of
+    // whoever connects next to be dropped: their connection goes unanswered
+    class StalledListener
+    {
+    public:
+        // On any free port when port is 0
+        explicit StalledListener(uint16_t port = 0)
+        {
+            sockaddr_in addr     = {};
+            addr.sin_family      = AF_INET;
+            addr.sin_addr.s_addr = htonl(0x7f000002);
+            addr.sin_port        = htons(port);
+
+            listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            ::bind(listener_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+            ::listen(listener_, 0);
+
+            socklen_t len = sizeof(addr);
+            ::getsockname(listener_, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+
+            filler_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            ::connect(filler_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+
+        ~StalledListener()
+        {
+            ::close(filler_);
+            ::close(listener_);
+        }
+
+        uint16_t port() const { return port_; }
+
+    private:
+        int listener_;
+        int filler_;
+        uint16_t port_;
+    };
+
+    // The addresses a promise resolved to, or none when it was rejected
+    std::vector<IP> wait(Async::Promise<std::vector<IP>> promise, bool* rejected = nullptr)
+    {
+        Async::Barrier<std::vector<IP>> barrier(promise);
+        barrier.wait_for(std::chrono::seconds(10));
+
+        std::vector<IP> addresses;
+        promise.then([&](const std::vector<IP>& result) { addresses = result; },
+                     [&](std::exception_ptr) {
+                         if (rejected)
+                             *rejected = true;
+                     });
+        return addresses;
+    }
+}
+
+TEST(resolver_test, numeric_addresses)
+{
+    Dns::Resolver resolver;
+
+    auto addresses = wait(resolver.resolve("127.0.0.1", Port(8080)));
+    ASSERT_EQ(addresses.size(), 1u);
+    ASSERT_EQ(addresses[0].toString(), "127.0.0.1");
+    ASSERT_EQ(addresses[0].getPort(), 8080);
+
+    addresses = wait(resolver.resolve("::1", Port(80)));
+    ASSERT_EQ(addresses.size(), 1u);
+    ASSERT_EQ(addresses[0].getFamily(), AF_INET6);
+
+    ASSERT_EQ(resolver.lookups(), 0u);
+}
+
+TEST(resolver_test, static_hosts)
+{
+    Dns::Resolver resolver;
+    resolver.addHost("Service.Test", { IP(10, 0, 0, 1), IP(10, 0, 0, 2) });
+
+    auto addresses = wait(resolver.resolve("service.test", Port(1234)));
+    ASSERT_EQ(addresses.size(), 2u);
+    ASSERT_EQ(addresses[0].toString(), "10.0.0.1");
+    ASSERT_EQ(addresses[1].getPort(), 1234);
+    ASSERT_EQ(resolver.lookups(), 0u);
+
+    resolver.removeHost("service.test");
+    bool rejected = false;
+    wait(resolver.resolve("service.test", Port(1234)), &rejected);
+    ASSERT_EQ(resolver.lookups(), 1u);
+}
+
+TEST(resolver_test, caches_answers_and_failures)
+{
+    Dns::Resolver resolver(Dns::Resolver::options().negativeTtl(std::chrono::milliseconds(100)));
+
+    auto addresses = wait(resolver.resolve("localhost", Port(80)));
+    ASSERT_FALSE(addresses.empty());
+    ASSERT_EQ(wait(resolver.resolve("LOCALHOST", Port(80))).size(), addresses.size());
+    ASSERT_EQ(resolver.lookups(), 1u);
+    ASSERT_EQ(resolver.cacheHits(), 1u);
+
+    // Another port is another query
+    wait(resolver.resolve("localhost", Port(81)));
+    ASSERT_EQ(resolver.lookups(), 2u);
+
+    bool rejected = false;
+    wait(resolver.resolve("pistache.invalid", Port(80)), &rejected);
+    ASSERT_TRUE(rejected);
+
+    rejected = false;
+    wait(resolver.resolve("pistache.invalid", Port(80)), &rejected);
+    ASSERT_TRUE(rejected);
+    ASSERT_EQ(resolver.lookups(), 3u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    wait(resolver.resolve("pistache.invalid", Port(80)));
+    ASSERT_EQ(resolver.lookups(), 4u);
+
+    resolver.clearCache();
+    ASSERT_EQ(resolver.cacheSize(), 0u);
+}
+
+TEST(resolver_test, interleaves_families)
+{
+    const IP v6a(0, 0, 0, 0, 0, 0, 0, 1);
+    const IP v6b(0, 0, 0, 0, 0, 0, 0, 2);
+    const IP v4a(127, 0, 0, 1);
+    const IP v4b(127, 0, 0, 2);
+
+    const auto ordered = Dns::Resolver::interleave({ v6a, v6b, v4a, v4b });
+    ASSERT_EQ(ordered.size(), 4u);
+    ASSERT_EQ(ordered[0].toString(), v6a.toString());
+    ASSERT_EQ(ordered[1].toString(), v4a.toString());
+    ASSERT_EQ(ordered[2].toString(), v6b.toString());
+    ASSERT_EQ(ordered[3].toString(), v4b.toString());
+
+    ASSERT_EQ(Dns::Resolver::interleave({ v4a, v4b, v6a })[1].toString(), v6a.toString());
+}
+
+TEST(resolver_test, client_falls_back_to_next_address)
+{
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<HelloHandler>());
+    server.serveThreaded();
+
+    // Nothing listens on the first address
+    auto resolver = std::make_shared<Dns::Resolver>();
+    resolver->addHost("pistache.test", { IP(127, 0, 0, 2), IP::loopback() });
+    const std::string page = "http://pistache.test:" + server.getPort().toString() + "/";
+
+    Http::Experimental::Client client;
+    client.init(Http::Experimental::Client::options().resolver(resolver));
+
+    auto response = client.get(page).send();
+    Async::Barrier<Http::Response> barrier(response);
+    barrier.wait_for(std::chrono::seconds(5));
+
+    std::string body;
+    response.then([&](Http::Response rsp) { body = rsp.body(); }, Async::IgnoreException);
+
+    client.shutdown();
+    server.shutdown();
+
+    ASSERT_EQ(body, "Hello, World!");
+}
+
+TEST(resolver_test, client_races_a_stalled_address)
+{
+    Http::Endpoint server(Address(IP::loopback(), Port(0)));
+    server.init(Http::Endpoint::options().threads(1));
+    server.setHandler(Http::make_handler<HelloHandler>());
+    server.serveThreaded();
+
+    // The first address never answers: the second one is tried alongside it
+    // well before the connection would time out
+    StalledListener stalled(server.getPort());
+    auto resolver = std::make_shared<Dns::Resolver>();
+    resolver->addHost("pistache.test", { IP(127, 0, 0, 2), IP::loopback() });
+    const std::string page = "http://pistache.test:" + server.getPort().toString() + "/";
+
+    Http::Experimental::Client client;
+    client.init(Http::Experimental::Client::options().resolver(resolver));
+
+    const auto start = std::chrono::steady_clock::now();
+    auto response    = client.get(page).send();
+    Async::Barrier<Http::Response> barrier(response);
+    barrier.wait_for(std::chrono::seconds(5));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::string body;
+    response.then([&](Http::Response rsp) { body = rsp.body(); }, Async::IgnoreException);
+
+    client.shutdown();
+    server.shutdown();
+
+    ASSERT_EQ(body, "Hello, World!");
+    ASSERT_GE(elapsed, Http::Experimental::Default::ConnectionAttemptDelay);
+    ASSERT_LT(elapsed, std::chrono::seconds(2));
+}
+
+TEST(resolver_test, client_times_out_connecting)
+{
+    StalledListener stalled;
+    auto resolver = std::make_shared<Dns::Resolver>();
+    resolver->addHost("pistache.test", { IP(127, 0, 0, 2) });
+
+    Http::Experimental::Client client;
+    client.init(Http::Experimental::Client::options()
+                    .resolver(resolver)
+                    .connectTimeout(std::chrono::milliseconds(200)));
+
+    const auto start = std::chrono::steady_clock::now();
+    auto response    = client.get("http://pistache.test:" + std::to_string(stalled.port()) + "/").send();
+    Async::Barrier<Http::Response> barrier(response);
+    barrier.wait_for(std::chrono::seconds(5));
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    client.shutdown();
+
+    ASSERT_TRUE(response.isRejected());
+    ASSERT_LT(elapsed, std::chrono::seconds(2));
+}
+
+TEST(resolver_test, client_rejects_unresolved_hosts)
+{
+    Http::Experimental::Client client;
+    client.init();
+
+    auto response = client.get("http://pistache.invalid/").send();
+    Async::Barrier<Http::Response> barrier(response);
+    barrier.wait_for(std::chrono::seconds(10));
+
+    client.shutdown();
+
+    ASSERT_TRUE(response.isRejected());
+}
+
+TEST(resolver_test, destroyed_from_its_own_continuation)
+{
+    auto resolver = std::make_shared<Dns::Resolver>();
+    auto holder   = std::make_shared<std::shared_ptr<Dns::Resolver>>(resolver);
+
+    std::promise<void> released;
+    std::promise<void> done;
+    auto releasedFuture = released.get_future();
+    const auto caller   = std::this_thread::get_id();
+
+    // The continuation drops the last reference to the resolver, on one of
+    // its workers unless the lookup was over before it was attached
+    auto finish = [&, holder]() {
+        if (std::this_thread::get_id() != caller)
+            releasedFuture.wait();
+        holder->reset();
+        done.set_value();
+    };
+    resolver->resolve("localhost", Port(80))
+        .then([finish](const std::vector<IP>&) { finish(); },
+              [finish](std::exception_ptr) { finish(); });
+
+    resolver.reset();
+    released.set_value();
+
+    ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+}
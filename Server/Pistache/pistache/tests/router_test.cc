@@ -31,11 +31,35 @@
 using namespace Pistache;
 using namespace Pistache::Rest;
 
+// Matches with the routes compiled as well, expecting the same route and
+// the same params and splats
+std::tuple<std::shared_ptr<Route>, std::vector<TypedParam>, std::vector<TypedParam>>
+findRoute(const SegmentTreeNode& routes, std::string_view path)
+{
+    auto result = routes.findRoute(path);
+
+    RouteMatcher matcher(routes);
+    std::vector<TypedParam> params, splats;
+    const auto* route = matcher.match(path, params, splats);
+
+    EXPECT_EQ(route, std::get<0>(result).get()) << path;
+    auto sameAs = [](const std::vector<TypedParam>& lhs, const std::vector<TypedParam>& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                          [](const TypedParam& l, const TypedParam& r) {
+                              return l.name() == r.name() && l.value() == r.value();
+                          });
+    };
+    EXPECT_TRUE(sameAs(params, std::get<1>(result))) << path;
+    EXPECT_TRUE(sameAs(splats, std::get<2>(result))) << path;
+
+    return result;
+}
+
 bool match(const SegmentTreeNode& routes, const std::string& req)
 {
     const auto& s = SegmentTreeNode::sanitizeResource(req);
     std::shared_ptr<Route> route;
-    std::tie(route, std::ignore, std::ignore) = routes.findRoute({ s.data(), s.size() });
+    std::tie(route, std::ignore, std::ignore) = findRoute(routes, { s.data(), s.size() });
     return route != nullptr;
 }
 
@@ -48,7 +72,7 @@ bool matchParams(
     std::shared_ptr<Route> route;
     std::vector<TypedParam> params;
     std::string_view sv { s.data(), s.length() };
-    std::tie(route, params, std::ignore) = routes.findRoute(sv);
+    std::tie(route, params, std::ignore) = findRoute(routes, sv);
 
     if (route == nullptr)
         return false;
@@ -74,7 +98,7 @@ bool matchSplat(const SegmentTreeNode& routes, const std::string& req,
     std::shared_ptr<Route> route;
     std::vector<TypedParam> splats;
     std::string_view sv { s.data(), s.length() };
-    std::tie(route, std::ignore, splats) = routes.findRoute(sv);
+    std::tie(route, std::ignore, splats) = findRoute(routes, sv);
 
     if (route == nullptr)
         return false;
@@ -104,8 +128,9 @@ TEST(router_test, test_fixed_routes)
     ASSERT_FALSE(match(routes, "/v2/hello"));
     ASSERT_FALSE(match(routes, "/v1/hell0"));
 
-    s = SegmentTreeNode::sanitizeResource("/a/b/c");
-    routes.addRoute(std::string_view { s.data(), s.length() }, nullptr, nullptr);
+    // The tree views into the resources it was given
+    const auto t = SegmentTreeNode::sanitizeResource("/a/b/c");
+    routes.addRoute(std::string_view { t.data(), t.length() }, nullptr, nullptr);
     ASSERT_TRUE(match(routes, "/a/b/c"));
 }
 
@@ -171,6 +196,68 @@ TEST(router_test, test_mixed)
     ASSERT_TRUE(matchSplat(routes, "/hi", { "hi" }));
 }
 
+TEST(router_test, test_compiled_routes)
+{
+    const std::vector<std::string> resources = {
+        "/api/v1/users",
+        "/api/v1/users/:id",
+        "/api/v1/users/:id/avatar",
+        "/api/v1/uploads/*",
+        "/api/v2/users/:id",
+        "/api/v2/:resource/count/all",
+        "/apis",
+        "/assets/css/main.css",
+        "/about",
+        "/b/:x?",
+        "/s/a",
+        "/s/ab",
+        "/s/abc/x",
+        "/s/a-b",
+        "/s/b",
+        "/",
+    };
+
+    // The tree views into the resources
+    std::vector<std::string> sanitized;
+    for (const auto& resource : resources)
+        sanitized.push_back(SegmentTreeNode::sanitizeResource(resource));
+
+    SegmentTreeNode routes;
+    for (const auto& path : sanitized)
+        routes.addRoute(path, nullptr, nullptr);
+
+    // Chains of fixed segments are merged, as "assets/css/main.css" is
+    RouteMatcher matcher(routes);
+    ASSERT_LT(matcher.nodeCount(), 25u);
+
+    ASSERT_TRUE(match(routes, "/"));
+    ASSERT_TRUE(match(routes, "/api/v1/users"));
+    ASSERT_TRUE(match(routes, "/apis"));
+    ASSERT_TRUE(match(routes, "/about"));
+    ASSERT_TRUE(match(routes, "/assets/css/main.css"));
+    ASSERT_FALSE(match(routes, "/assets/css"));
+    ASSERT_FALSE(match(routes, "/assets/css/main.css/more"));
+    ASSERT_FALSE(match(routes, "/assets/cs/main.css"));
+    ASSERT_FALSE(match(routes, "/api"));
+    ASSERT_FALSE(match(routes, "/ap"));
+
+    ASSERT_TRUE(matchParams(routes, "/api/v1/users/42/avatar", { { ":id", "42" } }));
+    ASSERT_TRUE(matchSplat(routes, "/api/v1/uploads/file", { "file" }));
+
+    // Backtracks from a fixed segment to a param
+    ASSERT_TRUE(matchParams(routes, "/api/v2/users/count/all", { { ":resource", "users" } }));
+    ASSERT_TRUE(matchParams(routes, "/api/v2/users/7", { { ":id", "7" } }));
+
+    // Told apart by the jump tables
+    for (const auto* path : { "/s/a", "/s/ab", "/s/abc/x", "/s/a-b", "/s/b" })
+        ASSERT_TRUE(match(routes, path)) << path;
+    for (const auto* path : { "/s", "/s/abc", "/s/aa", "/s/abd/x", "/s/a-", "/s/c", "/s/a/b" })
+        ASSERT_FALSE(match(routes, path)) << path;
+
+    ASSERT_TRUE(matchParams(routes, "/b/1", { { ":x", "1" } }));
+    ASSERT_TRUE(match(routes, "/b"));
+}
+
 TEST(router_test, test_notfound_exactly_once)
 {
     Address addr(Ipv4::any(), 0);
@@ -440,6 +527,156 @@ TEST(router_test, test_auth_middleware)
     ASSERT_EQ(response->status, int(Pistache::Http::Code::Ok));
 }
 
+TEST(router_test, test_params_view_into_request)
+{
+    Address addr(Ipv4::any(), 0);
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+
+    auto opts = Http::Endpoint::options().threads(1);
+    endpoint->init(opts);
+
+    Rest::Router router;
+    router.addMiddleware([](Http::Request& request, Http::ResponseWriter&) {
+        request.headers().addRaw(Http::Header::Raw("X-Seen", "yes"));
+        return true;
+    });
+
+    Routes::Get(router, "/users/:id/*", [](const Rest::Request& request, Http::ResponseWriter response) {
+        // Copies and moves of the request have params of their own
+        std::vector<Rest::Request> copies { request };
+        copies.push_back(std::move(copies.front()));
+        const auto& copy = copies.back();
+
+        std::string body = copy.param(":id").as<std::string>() + " " + copy.splatAt(0).as<std::string>();
+        body += " " + request.headers().getRaw("X-Seen").value();
+        response.send(Http::Code::Ok, body);
+        return Route::Result::Ok;
+    });
+
+    endpoint->setHandler(router.handler());
+    endpoint->serveThreaded();
+
+    httplib::Client client("localhost", endpoint->getPort());
+
+    auto response = client.Get("/users/42/avatar");
+    ASSERT_EQ(response->status, int(Http::Code::Ok));
+    ASSERT_EQ(response->body, "42 avatar yes");
+
+    // Collapsed into storage of the request's own
+    response = client.Get("//users///1234567890123456789012345//avatar/");
+    ASSERT_EQ(response->status, int(Http::Code::Ok));
+    ASSERT_EQ(response->body, "1234567890123456789012345 avatar yes");
+
+    endpoint->shutdown();
+}
+
+namespace
+{
+    constexpr char UserPost[]  = "/users/:id<uint64>/posts/:slug";
+    constexpr char Pages[]     = "/pages/:page<int16>?";
+    constexpr char Ratio[]     = "/ratio/:value<double>/:flag<bool>";
+    constexpr char Tags[]      = "/tags/:tag/:extra?";
+
+    static_assert(Routes::details::paramCount(UserPost) == 2);
+    static_assert(Routes::details::paramSpec(UserPost, 0).name == ":id");
+    static_assert(Routes::details::paramSpec(UserPost, 0).type == Routes::details::ParamType::Uint64);
+    static_assert(Routes::details::paramSpec(UserPost, 1).type == Routes::details::ParamType::String);
+    static_assert(Routes::details::paramSpec(Pages, 0).optional);
+    static_assert(Routes::details::paramSpec("/a/:b<uint128>", 0).type == Routes::details::ParamType::Unknown);
+
+    class TypedApi
+    {
+    public:
+        void getPost(const Rest::Request&, Http::ResponseWriter response, uint64_t id,
+                     std::string_view slug)
+        {
+            response.send(Http::Code::Ok, std::to_string(id + 1) + " " + std::string(slug));
+        }
+
+        void getPage(const Rest::Request&, Http::ResponseWriter response,
+                     std::optional<int16_t> page) const
+        {
+            response.send(Http::Code::Ok, page ? std::to_string(*page) : "none");
+        }
+    };
+
+    void getRatio(const Rest::Request&, Http::ResponseWriter response, double value, bool flag)
+    {
+        response.send(Http::Code::Ok, std::to_string(static_cast<int>(value * 4)) + (flag ? " yes" : " no"));
+    }
+
+    void getTags(const Rest::Request&, Http::ResponseWriter response, const std::string& tag,
+                 std::optional<std::string> extra)
+    {
+        response.send(Http::Code::Ok, tag + " " + extra.value_or("none"));
+    }
+}
+
+TEST(router_test, test_typed_routes)
+{
+    ASSERT_EQ(Routes::details::untypedResource(UserPost), "/users/:id/posts/:slug");
+    ASSERT_EQ(Routes::details::untypedResource(Pages), "/pages/:page?");
+
+    Address addr(Ipv4::any(), 0);
+    auto endpoint = std::make_shared<Http::Endpoint>(addr);
+    endpoint->init(Http::Endpoint::options().threads(1));
+
+    TypedApi api;
+    Rest::Router router;
+    Routes::Get(router, Routes::bind<UserPost>(&TypedApi::getPost, &api));
+    Routes::Get(router, Routes::bind<Pages>(&TypedApi::getPage, &api));
+    Routes::Get(router, Routes::bind<Ratio>(&getRatio));
+    Routes::Get(router, Routes::bind<Tags>(&getTags));
+
+    endpoint->setHandler(router.handler());
+    endpoint->serveThreaded();
+
+    httplib::Client client("localhost", endpoint->getPort());
+
+    auto response = client.Get("/users/18446744073709551614/posts/hello");
+    ASSERT_EQ(response->status, int(Http::Code::Ok));
+    ASSERT_EQ(response->body, "18446744073709551615 hello");
+
+    response = client.Get("/pages/-12");
+    ASSERT_EQ(response->body, "-12");
+    response = client.Get("/pages");
+    ASSERT_EQ(response->body, "none");
+
+    response = client.Get("/ratio/0.75/true");
+    ASSERT_EQ(response->body, "3 yes");
+
+    // Strings, for handlers that take them
+    response = client.Get("/tags/red/blue");
+    ASSERT_EQ(response->body, "red blue");
+    response = client.Get("/tags/red");
+    ASSERT_EQ(response->body, "red none");
+
+    // Not of the type of the param, as a whole
+    for (const auto* path : { "/users/-1/posts/hello", "/users/12abc/posts/hello",
+                              "/users/18446744073709551616/posts/hello", "/pages/40000",
+                              "/ratio/1.5/maybe" })
+    {
+        response = client.Get(path);
+        ASSERT_EQ(response->status, int(Http::Code::Bad_Request)) << path;
+    }
+
+    endpoint->shutdown();
+}
+
+TEST(router_test, test_lexical_cast)
+{
+    TypedParam param(":id", "42");
+    ASSERT_EQ(param.as<int>(), 42);
+    ASSERT_EQ(param.as<uint64_t>(), 42u);
+    ASSERT_EQ(param.as<double>(), 42.0);
+    ASSERT_EQ(param.as<std::string_view>(), "42");
+    ASSERT_EQ(param.as<char>(), '4');
+
+    ASSERT_THROW(TypedParam(":id", "42x").as<int>(), std::runtime_error);
+    ASSERT_THROW(TypedParam(":id", "-1").as<unsigned>(), std::runtime_error);
+    ASSERT_THROW(TypedParam(":id", "70000").as<int16_t>(), std::runtime_error);
+}
+
 TEST(segment_tree_node_test, test_resource_sanitize)
 {
     ASSERT_EQ(SegmentTreeNode::sanitizeResource("/path"), "path");
@@ -447,6 +684,17 @@ TEST(segment_tree_node_test, test_resource_sanitize)
     ASSERT_EQ(SegmentTreeNode::sanitizeResource("/path//to/bar"), "path/to/bar");
     ASSERT_EQ(SegmentTreeNode::sanitizeResource("/path//to/bar"), "path/to/bar");
     ASSERT_EQ(SegmentTreeNode::sanitizeResource("/path/to///////:place"), "path/to/:place");
+    ASSERT_EQ(SegmentTreeNode::sanitizeResource("/path/"), "path");
+    ASSERT_EQ(SegmentTreeNode::sanitizeResource("/"), "");
+
+    // Only collapsed into the buffer when there is something to collapse
+    std::string buffer;
+    const std::string resource = "/path/to/bar";
+    ASSERT_EQ(SegmentTreeNode::sanitizeResource(std::string_view(resource), buffer).data(),
+              resource.data() + 1);
+    ASSERT_TRUE(buffer.empty());
+    ASSERT_EQ(SegmentTreeNode::sanitizeResource(std::string_view("//path//to/"), buffer), "path/to");
+    ASSERT_EQ(buffer, "/path/to/");
 }
 
 namespace
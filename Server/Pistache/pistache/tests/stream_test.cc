@@ -134,6 +134,33 @@ TEST(stream, test_array_buffer)
     ASSERT_FALSE(buffer.feed(part2, strlen(part2)));
 }
 
+TEST(stream, test_array_buffer_in_place_writes)
+{
+    ArrayStreamBuf<char> buffer(8, 4);
+    StreamCursor cursor { &buffer };
+
+    // Room is made as needed, up to the maximum size
+    ASSERT_EQ(buffer.prepare(1), 4u);
+    std::memcpy(buffer.writePtr(), "abcd", 4);
+    buffer.commit(4);
+    ASSERT_EQ(cursor.remaining(), 4u);
+
+    ASSERT_EQ(buffer.prepare(1), 4u);
+    std::memcpy(buffer.writePtr(), "efgh", 4);
+    buffer.commit(4);
+    ASSERT_TRUE(buffer.full());
+    ASSERT_EQ(buffer.prepare(1), 0u);
+
+    // What has been read is dropped, the rest is kept for the next parse
+    cursor.advance(6);
+    buffer.compact();
+    ASSERT_FALSE(buffer.full());
+    ASSERT_EQ(cursor.remaining(), 2u);
+    ASSERT_EQ(cursor.current(), 'g');
+
+    ASSERT_EQ(buffer.prepare(8), 6u);
+}
+
 TEST(stream, test_cursor_advance_for_array)
 {
     ArrayStreamBuf<char> buffer(Const::MaxBuffer);
@@ -237,3 +264,49 @@ TEST(stream, test_cursor_diff_for_array)
     second_cursor.advance(4);
     ASSERT_EQ(second_cursor.diff(first_cursor), 0u);
 }
+
+TEST(stream, test_raw_buffer_copies_share_storage)
+{
+    RawBuffer buffer1(std::string("test_string"), 11);
+    RawBuffer buffer2 = buffer1;
+
+    ASSERT_EQ(buffer2.size(), 11u);
+    ASSERT_EQ(buffer1.data().data(), buffer2.data().data());
+
+    // copy() still makes a deep copy
+    RawBuffer buffer3 = buffer1.copy();
+    ASSERT_EQ(buffer3.data(), "test_string");
+    ASSERT_NE(buffer1.data().data(), buffer3.data().data());
+}
+
+TEST(stream, test_dyn_buffer_release)
+{
+    DynamicStreamBuf buf(4, Const::MaxBuffer);
+
+    {
+        std::ostream os(&buf);
+        os << "Hello World!";
+    }
+
+    auto rawbuf = buf.release();
+    ASSERT_EQ(rawbuf.size(), 12u);
+    ASSERT_EQ(rawbuf.data(), "Hello World!");
+    ASSERT_EQ(buf.buffer().size(), 0u);
+
+    // The buffer can be written to again without touching what was released
+    {
+        std::ostream os(&buf);
+        os << "Bye";
+    }
+
+    ASSERT_EQ(buf.buffer().data(), "Bye");
+    ASSERT_EQ(rawbuf.data(), "Hello World!");
+
+    // Moving keeps what was written so far
+    DynamicStreamBuf moved(std::move(buf));
+    {
+        std::ostream os(&moved);
+        os << "!";
+    }
+    ASSERT_EQ(moved.release().data(), "Bye!");
+}
@@ -14,6 +14,7 @@
 #include <curl/curl.h>
 #include <curl/easy.h>
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -288,6 +289,190 @@ TEST_F(StreamingTests, ChunkedStream)
 
 }
 
+namespace
+{
+    struct PacingStats
+    {
+        std::atomic<size_t> maxQueued { 0 };
+        std::atomic<size_t> pauses { 0 };
+        std::atomic<size_t> flushed { 0 };
+    };
+
+    // Streams as fast as the stream lets it, waiting for it to drain
+    // whenever it stops being writable
+    struct PacedProducer : public std::enable_shared_from_this<PacedProducer>
+    {
+        static constexpr size_t ChunkSize     = 16 * 1024;
+        static constexpr size_t Chunks        = 1024;
+        static constexpr size_t HighWaterMark = 256 * 1024;
+        static constexpr size_t LowWaterMark  = 64 * 1024;
+
+        PacedProducer(Http::ResponseStream stream_, std::shared_ptr<PacingStats> stats_)
+            : stream(std::move(stream_))
+            , stats(std::move(stats_))
+            , payload(ChunkSize, 'p')
+        {
+            stream.setWaterMarks(HighWaterMark, LowWaterMark);
+        }
+
+        void produce()
+        {
+            while (sent < Chunks)
+            {
+                if (!stream.isWritable())
+                {
+                    ++stats->pauses;
+                    stream.onWritable([self = shared_from_this()] { self->produce(); });
+                    return;
+                }
+
+                stream.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                stream.flush().then([stats = stats](PST_SSIZE_T) { ++stats->flushed; },
+                                    Async::IgnoreException);
+                ++sent;
+
+                const size_t queued = stream.queuedBytes();
+                if (queued > stats->maxQueued)
+                    stats->maxQueued = queued;
+            }
+
+            stream.ends();
+        }
+
+        Http::ResponseStream stream;
+        std::shared_ptr<PacingStats> stats;
+        std::string payload;
+        size_t sent = 0;
+    };
+
+    class PacedHandler : public Http::Handler
+    {
+    public:
+        HTTP_PROTOTYPE(PacedHandler)
+
+        explicit PacedHandler(std::shared_ptr<PacingStats> stats)
+            : stats_(std::move(stats))
+        { }
+
+        void onRequest(const Http::Request&, Http::ResponseWriter response) override
+        {
+            PS_TIMEDBG_START_THIS;
+
+            auto producer = std::make_shared<PacedProducer>(response.stream(Http::Code::Ok), stats_);
+            producer->produce();
+        }
+
+    private:
+        std::shared_ptr<PacingStats> stats_;
+    };
+
+    // Keeps the client from reading for a while, so that the socket
+    // buffers fill up
+    auto slow_curl_callback = +[](void* ptr, size_t size, size_t nmemb,
+                                  void* userdata) -> size_t {
+        auto* chunks = static_cast<Chunks*>(userdata);
+        if (chunks->empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        chunks->emplace_back(static_cast<char*>(ptr), size * nmemb);
+        return size * nmemb;
+    };
+} // namespace
+
+TEST_F(StreamingTests, ProducerIsPacedByWaterMarks)
+{
+    PS_TIMEDBG_START;
+
+    auto stats = std::make_shared<PacingStats>();
+    Init(std::make_shared<PacedHandler>(stats));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, slow_curl_callback);
+
+    CURLcode res = curl_easy_perform(curl);
+    ASSERT_EQ(res, CURLE_OK) << curl_easy_strerror(res);
+
+    const auto body = chunksToString(chunks);
+    ASSERT_EQ(body.size(), PacedProducer::ChunkSize * PacedProducer::Chunks);
+    ASSERT_EQ(body.find_first_not_of('p'), std::string::npos);
+    EXPECT_EQ(stats->flushed, PacedProducer::Chunks);
+
+    // Held off at least once, and never queued much past the high water
+    // mark: a chunk, along with its framing
+    EXPECT_GT(stats->pauses, 0u);
+    EXPECT_LE(stats->maxQueued, PacedProducer::HighWaterMark + PacedProducer::ChunkSize + 16);
+}
+
+namespace
+{
+    struct DroppedStats
+    {
+        std::atomic<size_t> resolved { 0 };
+        std::atomic<size_t> rejected { 0 };
+        std::atomic<bool> writable { false };
+    };
+
+    // Queues much more than the socket buffers hold, for the client to go
+    // away before it is all written
+    class DroppedHandler : public Http::Handler
+    {
+    public:
+        HTTP_PROTOTYPE(DroppedHandler)
+
+        static constexpr size_t ChunkSize = 64 * 1024;
+        static constexpr size_t Chunks    = 512;
+
+        explicit DroppedHandler(std::shared_ptr<DroppedStats> stats)
+            : stats_(std::move(stats))
+        { }
+
+        void onRequest(const Http::Request&, Http::ResponseWriter response) override
+        {
+            PS_TIMEDBG_START_THIS;
+
+            auto stream = response.stream(Http::Code::Ok);
+            stream.setWaterMarks(ChunkSize, 0);
+
+            const std::string payload(ChunkSize, 'd');
+            for (size_t i = 0; i < Chunks; ++i)
+            {
+                stream.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                stream.flush().then(
+                    [stats = stats_](PST_SSIZE_T) { ++stats->resolved; },
+                    [stats = stats_](std::exception_ptr) { ++stats->rejected; });
+            }
+
+            // Only once nothing is queued anymore
+            stream.onWritable([stats = stats_] { stats->writable = true; });
+        }
+
+    private:
+        std::shared_ptr<DroppedStats> stats_;
+    };
+} // namespace
+
+TEST_F(StreamingTests, WritesDroppedOnDisconnectAreRejected)
+{
+    PS_TIMEDBG_START;
+
+    auto stats = std::make_shared<DroppedStats>();
+    Init(std::make_shared<DroppedHandler>(stats));
+
+    // Hangs up on the first bytes, the rest of them still unread
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
+                     +[](void*, size_t, size_t, void*) -> size_t { return 0; });
+    ASSERT_EQ(curl_easy_perform(curl), CURLE_WRITE_ERROR);
+
+    // Every flush settles, and the bytes they queued are released
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((stats->resolved + stats->rejected < DroppedHandler::Chunks || !stats->writable)
+           && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(stats->resolved + stats->rejected, DroppedHandler::Chunks);
+    EXPECT_GT(stats->rejected, 0u);
+    EXPECT_TRUE(stats->writable);
+}
+
 class ClientDisconnectHandler : public Http::Handler
 {
 public:
@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2026 The Pistache Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pistache/os.h>
+#include <pistache/timer_wheel.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace Pistache;
+using namespace std::chrono_literals;
+
+// Deadlines are rounded up to the next millisecond, so the wheel is always
+// advanced a little past them
+TEST(timer_wheel_test, fires_in_deadline_order)
+{
+    TimerWheel wheel;
+    const auto start = TimerWheel::Clock::now();
+
+    std::vector<int> fired;
+    wheel.scheduleAt(start + 30ms, [&] { fired.push_back(3); });
+    wheel.scheduleAt(start + 10ms, [&] { fired.push_back(1); });
+    wheel.scheduleAt(start + 20ms, [&] { fired.push_back(2); });
+    ASSERT_EQ(wheel.size(), 3u);
+
+    ASSERT_EQ(wheel.advance(start + 5ms), 0u);
+    ASSERT_TRUE(fired.empty());
+
+    ASSERT_EQ(wheel.advance(start + 21ms), 2u);
+    ASSERT_EQ(fired, (std::vector<int> { 1, 2 }));
+
+    ASSERT_EQ(wheel.advance(start + 1s), 1u);
+    ASSERT_EQ(fired, (std::vector<int> { 1, 2, 3 }));
+    ASSERT_EQ(wheel.size(), 0u);
+    ASSERT_FALSE(wheel.nextDeadline());
+}
+
+TEST(timer_wheel_test, never_fires_early)
+{
+    TimerWheel wheel;
+    const auto start = TimerWheel::Clock::now();
+
+    bool fired = false;
+    wheel.scheduleAt(start + 1500us, [&] { fired = true; });
+
+    wheel.advance(start + 1ms);
+    ASSERT_FALSE(fired);
+
+    wheel.advance(start + 3ms);
+    ASSERT_TRUE(fired);
+}
+
+TEST(timer_wheel_test, cancel)
+{
+    TimerWheel wheel;
+    const auto start = TimerWheel::Clock::now();
+
+    int fired      = 0;
+    auto kept      = wheel.scheduleAt(start + 10ms, [&] { ++fired; });
+    auto cancelled = wheel.scheduleAt(start + 10ms, [&] { fired += 100; });
+
+    ASSERT_TRUE(wheel.isScheduled(cancelled));
+    ASSERT_TRUE(wheel.cancel(cancelled));
+    ASSERT_FALSE(wheel.isScheduled(cancelled));
+    ASSERT_FALSE(wheel.cancel(cancelled));
+    ASSERT_FALSE(wheel.cancel(TimerWheel::NoTimer));
+
+    ASSERT_EQ(wheel.advance(start + 11ms), 1u);
+    ASSERT_EQ(fired, 1);
+
+    // Once fired, a timer can not be cancelled, and its id is not reused
+    ASSERT_FALSE(wheel.cancel(kept));
+    auto next = wheel.scheduleAt(start + 20ms, [] { });
+    ASSERT_NE(next, kept);
+    ASSERT_NE(next, cancelled);
+    ASSERT_FALSE(wheel.isScheduled(kept));
+}
+
+TEST(timer_wheel_test, long_delays_across_levels)
+{
+    TimerWheel wheel;
+    const auto start = TimerWheel::Clock::now();
+
+    // Spread over several levels of the wheel
+    const std::vector<std::chrono::milliseconds> delays = {
+        1ms, 63ms, 64ms, 65ms, 4095ms, 4096ms, 4097ms, 300s, 26h, 4000h
+    };
+
+    std::vector<std::chrono::milliseconds> fired;
+    wheel.scheduleAt(TimerWheel::Clock::time_point::max(), [] { FAIL(); });
+    for (auto it = delays.rbegin(); it != delays.rend(); ++it)
+    {
+        auto delay = *it;
+        wheel.scheduleAt(start + delay, [&fired, delay] { fired.push_back(delay); });
+    }
+
+    for (size_t i = 0; i < delays.size(); ++i)
+    {
+        const auto delay = delays[i];
+
+        // Due no later than the next timer, as long ones are first moved
+        // down the levels
+        auto next = wheel.nextDeadline();
+        ASSERT_TRUE(next);
+        ASSERT_LE(*next, start + delay + 1ms);
+
+        wheel.advance(start + delay - 1ms);
+        ASSERT_EQ(fired.size(), i);
+
+        wheel.advance(start + delay + 1ms);
+        ASSERT_EQ(fired.back(), delay);
+    }
+
+    ASSERT_EQ(fired, delays);
+    ASSERT_EQ(wheel.size(), 1u);
+}
+
+TEST(timer_wheel_test, callbacks_may_schedule_and_cancel)
+{
+    TimerWheel wheel;
+    const auto start = TimerWheel::Clock::now();
+
+    int fired   = 0;
+    auto victim = wheel.scheduleAt(start + 10ms, [&] { fired += 100; });
+    wheel.scheduleAt(start + 5ms, [&] {
+        ++fired;
+        wheel.cancel(victim);
+        wheel.scheduleAt(start + 10ms, [&] { ++fired; });
+    });
+
+    wheel.advance(start + 11ms);
+    ASSERT_EQ(fired, 2);
+}
+
+TEST(timer_wheel_test, overdue_timers_fire_on_next_tick)
+{
+    TimerWheel wheel;
+    const auto start = TimerWheel::Clock::now();
+
+    wheel.advance(start + 100ms);
+
+    bool fired = false;
+    wheel.scheduleAt(start + 50ms, [&] { fired = true; });
+
+    wheel.advance(start + 100ms);
+    ASSERT_FALSE(fired);
+
+    wheel.advance(start + 101ms);
+    ASSERT_TRUE(fired);
+}
+
+TEST(timer_wheel_test, drives_timer_fd)
+{
+    Polling::Epoll poller;
+    TimerWheel wheel;
+    auto tag = wheel.bind(poller);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    bool fired = false;
+    wheel.schedule(20ms, [&] { fired = true; });
+    wheel.schedule(1h, [] { });
+
+    while (!fired && std::chrono::steady_clock::now() - start < 5s)
+    {
+        std::vector<Polling::Event> events;
+        if (poller.poll(events, 1s) > 0)
+        {
+            for (const auto& event : events)
+            {
+                if (event.tag == tag)
+                    wheel.handleReady();
+            }
+        }
+    }
+
+    ASSERT_TRUE(fired);
+    ASSERT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    ASSERT_EQ(wheel.size(), 1u);
+
+    wheel.unbind(poller);
+}